@@ -152,6 +152,58 @@ mz_ulong mz_crc32(mz_ulong crc, const mz_uint8 *ptr, size_t buf_len)
 }
 #endif
 
+/* CRC-32 of a concatenation, see crc32_combine() of zlib: the CRC of the first buffer is shifted over len2 zero bytes
+ * by repeated squaring of the CRC-32 shift operator in GF(2), then the CRC of the second buffer is added. */
+static mz_uint32 mz_crc32_gf2_matrix_times(const mz_uint32 *mat, mz_uint32 vec)
+{
+    mz_uint32 sum = 0;
+    for (; vec; vec >>= 1, ++mat)
+        if (vec & 1)
+            sum ^= *mat;
+    return sum;
+}
+
+static void mz_crc32_gf2_matrix_square(mz_uint32 *square, const mz_uint32 *mat)
+{
+    int n;
+    for (n = 0; n < 32; ++n)
+        square[n] = mz_crc32_gf2_matrix_times(mat, mat[n]);
+}
+
+mz_ulong mz_crc32_combine(mz_ulong crc1, mz_ulong crc2, size_t len2)
+{
+    mz_uint32 even[32], odd[32], row = 1, crc = (mz_uint32)crc1;
+    int n;
+
+    if (len2 == 0)
+        return crc1;
+
+    /* Operator for one zero bit. */
+    odd[0] = 0xEDB88320;
+    for (n = 1; n < 32; ++n, row <<= 1)
+        odd[n] = row;
+    /* Operators for two and four zero bits. */
+    mz_crc32_gf2_matrix_square(even, odd);
+    mz_crc32_gf2_matrix_square(odd, even);
+
+    /* Apply len2 zero bytes to crc1, the first square produces the operator for one zero byte. */
+    do
+    {
+        mz_crc32_gf2_matrix_square(even, odd);
+        if (len2 & 1)
+            crc = mz_crc32_gf2_matrix_times(even, crc);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+        mz_crc32_gf2_matrix_square(odd, even);
+        if (len2 & 1)
+            crc = mz_crc32_gf2_matrix_times(odd, crc);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc ^ (mz_uint32)crc2;
+}
+
 void mz_free(void *p)
 {
     MZ_FREE(p);
@@ -6929,6 +6981,46 @@ mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context *pContext, co
     return MZ_FALSE;
 }
 
+mz_bool mz_zip_writer_add_staged_raw_deflate(mz_zip_writer_staged_context *pContext, const void *pComp_buf, size_t comp_size, mz_uint64 uncomp_size, mz_uint32 uncomp_crc32)
+{
+    mz_zip_archive *pZip = pContext->pZip;
+
+    if (! pContext->pCompressor)
+        return mz_zip_set_error(pZip, MZ_ZIP_INVALID_PARAMETER);
+
+    if (pContext->file_ofs + uncomp_size > pContext->max_size)
+    {
+        mz_zip_set_error(pZip, MZ_ZIP_FILE_READ_FAILED);
+        pZip->m_pFree(pZip->m_pAlloc_opaque, pContext->pCompressor);
+        pContext->pCompressor = NULL;
+        return MZ_FALSE;
+    }
+
+    /* Emit the pending data up to a byte boundary. The full flush also drops the dictionary, as the data compressed
+     * after the appended block must not reference the data compressed before it. */
+    if (tdefl_compress_buffer(pContext->pCompressor, NULL, 0, TDEFL_FULL_FLUSH) != TDEFL_STATUS_OKAY)
+    {
+        mz_zip_set_error(pZip, MZ_ZIP_COMPRESSION_FAILED);
+        pZip->m_pFree(pZip->m_pAlloc_opaque, pContext->pCompressor);
+        pContext->pCompressor = NULL;
+        return MZ_FALSE;
+    }
+
+    if (comp_size > 0 && pZip->m_pWrite(pZip->m_pIO_opaque, pContext->add_state.m_cur_archive_file_ofs, pComp_buf, comp_size) != comp_size)
+    {
+        mz_zip_set_error(pZip, MZ_ZIP_FILE_WRITE_FAILED);
+        pZip->m_pFree(pZip->m_pAlloc_opaque, pContext->pCompressor);
+        pContext->pCompressor = NULL;
+        return MZ_FALSE;
+    }
+
+    pContext->add_state.m_cur_archive_file_ofs += comp_size;
+    pContext->add_state.m_comp_size            += comp_size;
+    pContext->file_ofs                         += uncomp_size;
+    pContext->uncomp_crc32 = (mz_uint32)mz_crc32_combine(pContext->uncomp_crc32, uncomp_crc32, (size_t)uncomp_size);
+    return MZ_TRUE;
+}
+
 mz_bool mz_zip_writer_add_staged_finish(mz_zip_writer_staged_context *pContext)
 {
     if (! mz_zip_writer_add_staged_data(pContext, NULL, 0) ||
@@ -207,6 +207,8 @@ mz_ulong mz_adler32(mz_ulong adler, const unsigned char *ptr, size_t buf_len);
 #define MZ_CRC32_INIT (0)
 /* mz_crc32() returns the initial CRC-32 value to use when called with ptr==NULL. */
 mz_ulong mz_crc32(mz_ulong crc, const unsigned char *ptr, size_t buf_len);
+/* mz_crc32_combine() returns the CRC-32 of two concatenated buffers given their CRC-32 values and the length of the second buffer. */
+mz_ulong mz_crc32_combine(mz_ulong crc1, mz_ulong crc2, size_t len2);
 
 /* Compression strategies. */
 enum
@@ -1364,6 +1366,10 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
     const char* user_extra_data, mz_uint user_extra_data_len, const char* user_extra_data_central, mz_uint user_extra_data_central_len);
 mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context* pContext, const char* pRead_buf, size_t n);
 mz_bool mz_zip_writer_add_staged_finish(mz_zip_writer_staged_context* pContext);
+/* Appends a block of raw deflate data, which was compressed independently of the rest of the file (for example by another thread). */
+/* The block must not be final and it must end at a byte boundary (compressed with TDEFL_SYNC_FLUSH or TDEFL_FULL_FLUSH). */
+/* The data already passed to mz_zip_writer_add_staged_data() is flushed first and the history of the compressor is dropped. */
+mz_bool mz_zip_writer_add_staged_raw_deflate(mz_zip_writer_staged_context* pContext, const void* pComp_buf, size_t comp_size, mz_uint64 uncomp_size, mz_uint32 uncomp_crc32);
 
 /* Adds a file to an archive by fully cloning the data from another archive. */
 /* This function fully clones the source file's compressed data (no recompression), along with its full filename, extra data (it may add or modify the zip64 local header extra data field), and the optional descriptor following the compressed data. */
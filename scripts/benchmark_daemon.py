@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""
+Benchmark of the slicing daemon (--daemon, Linux only).
+Runs a slicing job once as a cold process, then several times through the daemon,
+and compares the latency of the warm jobs with the cold run.
+
+Example:
+    scripts/benchmark_daemon.py --slicer build/package/bin/orca-slicer -- \
+        --load_settings "machine.json;process.json" --load_filaments filament.json \
+        --slice 0 --outputdir /tmp/out model.3mf
+"""
+
+import argparse
+import json
+import os
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def send_job(socket_path, request, timeout):
+    """Send one line of json to the daemon, return its one line json reply."""
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as client:
+        client.settimeout(timeout)
+        client.connect(socket_path)
+        client.sendall((json.dumps(request) + "\n").encode())
+        reply = b""
+        while not reply.endswith(b"\n"):
+            chunk = client.recv(4096)
+            if not chunk:
+                break
+            reply += chunk
+    return json.loads(reply.decode())
+
+
+def wait_for_socket(socket_path, daemon, timeout):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        if daemon.poll() is not None:
+            raise RuntimeError(f"daemon exited with {daemon.returncode}")
+        if os.path.exists(socket_path):
+            return
+        time.sleep(0.1)
+    raise RuntimeError(f"daemon did not listen on {socket_path} within {timeout} s")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare the latency of warm daemon jobs with a cold run.")
+    parser.add_argument("--slicer", required=True, help="Path of the slicer executable")
+    parser.add_argument("--jobs", type=int, default=3, help="Number of jobs sent to the daemon (default: 3)")
+    parser.add_argument("--timeout", type=float, default=600, help="Timeout of a job in seconds (default: 600)")
+    parser.add_argument("args", nargs=argparse.REMAINDER, help="Arguments of the slicing job, after --")
+    options = parser.parse_args()
+    job_args = options.args[1:] if options.args[:1] == ["--"] else options.args
+    if not job_args:
+        parser.error("no job arguments given")
+
+    # Cold run: a new process loads the resources, the config definitions and the settings files.
+    start = time.monotonic()
+    cold = subprocess.run([options.slicer] + job_args, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=options.timeout)
+    cold_ms = (time.monotonic() - start) * 1000.
+    print(f"cold run:   {cold_ms:9.0f} ms, return code {cold.returncode}")
+
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        socket_path = os.path.join(tmp_dir, "daemon.sock")
+        daemon = subprocess.Popen([options.slicer, "--daemon", socket_path], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        try:
+            wait_for_socket(socket_path, daemon, 60)
+            job_ms = []
+            for i in range(options.jobs):
+                start = time.monotonic()
+                reply = send_job(socket_path, {"args": job_args}, options.timeout)
+                job_ms.append((time.monotonic() - start) * 1000.)
+                print(f"daemon job {i + 1}: {job_ms[-1]:7.0f} ms, in daemon {reply.get('time_ms', -1)} ms, "
+                      f"return code {reply.get('return_code')} {reply.get('message', '')}")
+            send_job(socket_path, {"command": "stop"}, 10)
+            daemon.wait(timeout=60)
+        finally:
+            if daemon.poll() is None:
+                daemon.kill()
+
+    if len(job_ms) > 1:
+        # The first daemon job loads the settings files, the next ones reuse them.
+        warm_ms = min(job_ms[1:])
+        print(f"warm job vs cold run: {warm_ms:.0f} ms vs {cold_ms:.0f} ms, {cold_ms / warm_ms:.2f}x")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
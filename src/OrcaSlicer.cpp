@@ -20,12 +20,18 @@
 #include <cstdio>
 #include <string>
 #include <cstring>
+#include <chrono>
 #include <iostream>
 #include <math.h>
 
 #if defined(__linux__) || defined(__LINUX__)
 #include <condition_variable>
 #include <mutex>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include <boost/thread.hpp>
 //add json logic
 #include "nlohmann/json.hpp"
@@ -352,6 +358,13 @@ typedef struct _cli_callback_mgr {
             close(m_pipe_fd);
             m_pipe_fd = -1;
         }
+        // The daemon mode starts the manager again for the next job.
+        lck.lock();
+        m_started = false;
+        m_exit = false;
+        m_progress = 0;
+        m_total_progress = 0;
+        lck.unlock();
         BOOST_LOG_TRIVIAL(info) << "cli_callback_mgr_t::stop successfully.";
     }
 }cli_callback_mgr_t;
@@ -369,6 +382,53 @@ void cli_status_callback(const PrintBase::SlicingStatus& slicing_status)
 }
 #endif
 
+//the setting files loaded by the previous jobs of the daemon mode, reused while the file is not modified
+typedef struct _cached_config_file {
+    std::time_t         write_time {0};
+    uintmax_t           file_size {0};
+    DynamicPrintConfig  config;
+    std::string         config_type;
+    std::string         config_name;
+    std::string         filament_id;
+    std::string         config_from;
+    // the substituted values depend on the rule the file was loaded with
+    ForwardCompatibilitySubstitutionRule substitution_rule { ForwardCompatibilitySubstitutionRule::Enable };
+}cached_config_file_t;
+static bool g_daemon_mode = false;
+//a daemon job is a single line of json, a client which sends a larger request or does not finish it in time is refused
+static constexpr size_t daemon_max_request_size = 1024 * 1024;
+static constexpr int    daemon_read_timeout_s   = 10;
+static std::map<std::string, cached_config_file_t> g_cached_config_files;
+//the printer model files and cli_config.json parsed by the previous jobs of the daemon mode, reused while the file is not modified
+typedef struct _cached_json_file {
+    std::time_t                 write_time {0};
+    uintmax_t                   file_size {0};
+    std::shared_ptr<const json> root;
+}cached_json_file_t;
+static std::map<std::string, cached_json_file_t> g_cached_json_files;
+
+//parse a json file, throws on error like the json parser does
+static std::shared_ptr<const json> load_json_file(const std::string &file)
+{
+    boost::system::error_code ec;
+    std::time_t write_time = boost::filesystem::last_write_time(file, ec);
+    uintmax_t   file_size  = ec ? 0 : boost::filesystem::file_size(file, ec);
+    if (g_daemon_mode && !ec) {
+        auto cache_iter = g_cached_json_files.find(file);
+        if ((cache_iter != g_cached_json_files.end()) && (cache_iter->second.write_time == write_time) && (cache_iter->second.file_size == file_size)) {
+            BOOST_LOG_TRIVIAL(debug) << __FUNCTION__<< ": reuse json file "<< file << " parsed by a previous job";
+            return cache_iter->second.root;
+        }
+    }
+    auto root = std::make_shared<json>();
+    boost::nowide::ifstream ifs(file);
+    ifs >> *root;
+    ifs.close();
+    if (g_daemon_mode && !ec)
+        g_cached_json_files[file] = cached_json_file_t{ write_time, file_size, root };
+    return root;
+}
+
 void default_status_callback(const PrintBase::SlicingStatus& slicing_status)
 {
     if (slicing_status.warning_step != -1) {
@@ -497,14 +557,12 @@ const float bed3d_ax3s_default_tip_length = 5.0f;
 
 static int load_key_values_from_json(const std::string &file, std::map<std::string, std::string>& key_values)
 {
-    json j;
     CNumericLocalesSetter locales_setter;
 
     BOOST_LOG_TRIVIAL(debug) << __FUNCTION__<< ": begin to parse "<<file;
     try {
-        boost::nowide::ifstream ifs(file);
-        ifs >> j;
-        ifs.close();
+        std::shared_ptr<const json> root = load_json_file(file);
+        const json &j = *root;
 
         //parse the json elements
         for (auto it = j.begin(); it != j.end(); it++) {
@@ -1136,18 +1194,16 @@ static void load_downward_settings_list_from_config(std::string config_file, std
     }
     else {
         try {
-            json root_json;
-            boost::nowide::ifstream ifs(config_file);
-            ifs >> root_json;
-            ifs.close();
+            std::shared_ptr<const json> root = load_json_file(config_file);
+            const json &root_json = *root;
 
             if (root_json.contains("printer")) {
-                json printer_json = root_json["printer"];
+                const json &printer_json = root_json["printer"];
                 if (!printer_model.empty() && printer_json.contains(printer_model)) {
-                    json printer_model_json = printer_json[printer_model];
+                    const json &printer_model_json = printer_json[printer_model];
 
                     if (printer_model_json.contains("downward_check")) {
-                        json downward_check_json = printer_model_json["downward_check"];
+                        const json &downward_check_json = printer_model_json["downward_check"];
                         if (downward_check_json.contains(printer_name)) {
                             downward_settings = downward_check_json[printer_name].get<std::vector<std::string>>();
                             BOOST_LOG_TRIVIAL(info) << boost::format("got %1% downward settings of %2% in %3%")%downward_settings.size() %printer_name %config_file;
@@ -1233,6 +1289,10 @@ int CLI::run(int argc, char **argv)
     std::string temp_path = wxFileName::GetTempDir().utf8_str().data();
     set_temporary_dir(temp_path);
 
+    std::string daemon_socket = m_config.opt_string("daemon", true);
+    if (!daemon_socket.empty())
+        return this->run_daemon(daemon_socket, argv[0]);
+
     m_extra_config.apply(m_config, true);
     m_extra_config.normalize_fdm();
 
@@ -1863,6 +1923,22 @@ int CLI::run(int argc, char **argv)
             boost::nowide::cerr << __FUNCTION__<< ": can not find setting file: " << file << std::endl;
             return CLI_FILE_NOTFOUND;
         }
+        boost::system::error_code ec;
+        std::time_t write_time = boost::filesystem::last_write_time(file, ec);
+        uintmax_t   file_size  = boost::filesystem::file_size(file, ec);
+        if (g_daemon_mode) {
+            auto cache_iter = g_cached_config_files.find(file);
+            if ((cache_iter != g_cached_config_files.end()) && (cache_iter->second.write_time == write_time) && (cache_iter->second.file_size == file_size)
+                && (cache_iter->second.substitution_rule == config_substitution_rule)) {
+                BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< ":reuse setting file "<< file << " loaded by a previous job" << std::endl;
+                config.apply(cache_iter->second.config, true);
+                config_type = cache_iter->second.config_type;
+                config_name = cache_iter->second.config_name;
+                filament_id = cache_iter->second.filament_id;
+                config_from = cache_iter->second.config_from;
+                return 0;
+            }
+        }
         ConfigSubstitutions config_substitutions;
         try {
             BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< ":load setting file "<< file << ", with rule "<< config_substitution_rule << std::endl;
@@ -1923,6 +1999,8 @@ int CLI::run(int argc, char **argv)
             boost::nowide::cerr << __FUNCTION__<< ":Loading setting file \"" << file << "\" failed: " << ex.what() << std::endl;
             return CLI_CONFIG_FILE_ERROR;
         }
+        if (g_daemon_mode && !ec)
+            g_cached_config_files[file] = cached_config_file_t{ write_time, file_size, config, config_type, config_name, filament_id, config_from, config_substitution_rule };
         return 0;
     };
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< ":before load settings, file count="<< load_configs.size() << std::endl;
@@ -2787,18 +2865,16 @@ int CLI::run(int argc, char **argv)
                 }
                 else {
                     try {
-                        json root_json;
-                        boost::nowide::ifstream ifs(cli_config_file);
-                        ifs >> root_json;
-                        ifs.close();
+                        std::shared_ptr<const json> root = load_json_file(cli_config_file);
+                        const json &root_json = *root;
 
                         if (root_json.contains("printer")) {
-                            json printer_json = root_json["printer"];
+                            const json &printer_json = root_json["printer"];
                             if (!printer_model.empty() && printer_json.contains(printer_model)) {
-                                json printer_model_json = printer_json[printer_model];
+                                const json &printer_model_json = printer_json[printer_model];
 
                                 if (printer_model_json.contains("machine_limits")) {
-                                    json machine_limits_json = printer_model_json["machine_limits"];
+                                    const json &machine_limits_json = printer_model_json["machine_limits"];
                                     printer_params = machine_limits_json.get<std::map<std::string, std::string>>();
 
                                     for (auto param_iter = printer_params.begin(); param_iter != printer_params.end(); param_iter++)
@@ -5437,6 +5513,8 @@ int CLI::run(int argc, char **argv)
     bool export_to_3mf = false, load_slicedata = false, export_slicedata = false, export_slicedata_error = false;
     bool no_check = false;
     std::string export_3mf_file, load_slice_data_dir, export_slice_data_dir, export_stls_dir;
+    std::string slice_cache_dir = m_config.opt_string("slice_cache_dir", true);
+    size_t slice_cache_hits = 0, slice_cache_misses = 0;
     std::vector<ThumbnailData*> calibration_thumbnails;
     std::vector<int> plate_object_count(partplate_list.get_plate_count(), 0);
     int max_slicing_time_per_plate = 0, max_triangle_count_per_plate = 0, sliced_plate = -1;
@@ -6058,6 +6136,18 @@ int CLI::run(int argc, char **argv)
                                         BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ": finished print::process.";
                                     }
                                 }
+                                else if (!slice_cache_dir.empty() && print_fff) {
+                                    size_t hits = 0, misses = 0;
+                                    int ret = print_fff->load_slice_cache(slice_cache_dir, hits, misses);
+                                    slice_cache_hits += hits;
+                                    slice_cache_misses += misses;
+                                    BOOST_LOG_TRIVIAL(info) << boost::format("plate %1%: slice cache hits %2%, misses %3%")%(index+1) %hits %misses;
+                                    if (ret)
+                                        print->process(&time_using_cache);
+                                    else
+                                        print->process(nullptr, true);
+                                    BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ": finished print::process.";
+                                }
                                 else {
                                     print->process(&time_using_cache);
                                     BOOST_LOG_TRIVIAL(info) << "print::process: first time_using_cache is " << time_using_cache << " secs.";
@@ -6169,6 +6259,12 @@ int CLI::run(int argc, char **argv)
                                         flush_and_exit(ret);
                                     }
                                 }
+                                if (!slice_cache_dir.empty() && print_fff && !load_slicedata) {
+                                    // A failure to store the cache is not fatal, the G-code was exported already.
+                                    int ret = print_fff->store_slice_cache(slice_cache_dir);
+                                    if (ret)
+                                        BOOST_LOG_TRIVIAL(warning) << "plate "<< index+1<< ": store slice cache error, ret=" << ret;
+                                }
                                 end_time = (long long)Slic3r::Utils::get_current_time_utc();
                                 sliced_plate_info.sliced_time = end_time - start_time;
                                 sliced_plate_info.sliced_time_with_cache = time_using_cache;
@@ -6199,6 +6295,9 @@ int CLI::run(int argc, char **argv)
                         finished = true;
                 }//end for partplate
 
+                if (!slice_cache_dir.empty())
+                    BOOST_LOG_TRIVIAL(info) << boost::format("slice cache %1%: total hits %2%, misses %3%")%slice_cache_dir %slice_cache_hits %slice_cache_misses;
+
 #if defined(__linux__) || defined(__LINUX__)
                 if (g_cli_callback_mgr.is_started()) {
                     int plate_count = (plate_to_slice== 0)?partplate_list.get_plate_count():1;
@@ -7010,6 +7109,135 @@ int CLI::run(int argc, char **argv)
     return 0;
 }
 
+int CLI::run_daemon(const std::string &socket_path, char *program_name)
+{
+#if defined(__linux__) || defined(__LINUX__)
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        BOOST_LOG_TRIVIAL(error) << boost::format("daemon: could not create socket, errno %1%, reason: %2%")%errno %strerror(errno);
+        return CLI_ENVIRONMENT_ERROR;
+    }
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        BOOST_LOG_TRIVIAL(error) << boost::format("daemon: socket path %1% is too long")%socket_path;
+        close(server_fd);
+        return CLI_INVALID_PARAMS;
+    }
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socket_path.c_str());
+    if ((bind(server_fd, (sockaddr*)&address, sizeof(address)) < 0) || (listen(server_fd, 8) < 0)) {
+        BOOST_LOG_TRIVIAL(error) << boost::format("daemon: could not listen on %1%, errno %2%, reason: %3%")%socket_path %errno %strerror(errno);
+        close(server_fd);
+        return CLI_ENVIRONMENT_ERROR;
+    }
+    // A client which disconnects before reading the reply must not kill the daemon.
+    signal(SIGPIPE, SIG_IGN);
+    g_daemon_mode = true;
+    BOOST_LOG_TRIVIAL(info) << boost::format("daemon: listening on %1%")%socket_path;
+    boost::nowide::cout << "daemon: listening on " << socket_path << std::endl;
+
+    size_t job_count = 0;
+    bool stop = false;
+    while (!stop) {
+        int client_fd = accept(server_fd, nullptr, nullptr);
+        if (client_fd < 0) {
+            if (errno == EINTR)
+                continue;
+            BOOST_LOG_TRIVIAL(error) << boost::format("daemon: accept failed, errno %1%, reason: %2%")%errno %strerror(errno);
+            break;
+        }
+
+        // One job per connection: a single line of json, answered by a single line of json.
+        timeval read_timeout { daemon_read_timeout_s, 0 };
+        if (setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &read_timeout, sizeof(read_timeout)) < 0)
+            BOOST_LOG_TRIVIAL(warning) << boost::format("daemon: could not set the read timeout, errno %1%, reason: %2%")%errno %strerror(errno);
+        std::string request;
+        std::string request_error;
+        char buffer[4096];
+        while (request.find('\n') == std::string::npos) {
+            if (request.size() > daemon_max_request_size) {
+                request_error = (boost::format("request is larger than %1% bytes")%daemon_max_request_size).str();
+                break;
+            }
+            ssize_t read_size = read(client_fd, buffer, sizeof(buffer));
+            if (read_size > 0)
+                request.append(buffer, read_size);
+            else if (read_size < 0 && errno == EINTR)
+                continue;
+            else {
+                if (read_size < 0)
+                    request_error = (errno == EAGAIN || errno == EWOULDBLOCK) ? (boost::format("request not received within %1% seconds")%daemon_read_timeout_s).str() :
+                                                                                 std::string("could not read the request: ") + strerror(errno);
+                break;
+            }
+        }
+
+        json reply;
+        try {
+            if (!request_error.empty())
+                throw Slic3r::RuntimeError(request_error);
+            json j = json::parse(request.substr(0, request.find('\n')));
+            if (j.value("command", std::string()) == "stop") {
+                stop = true;
+                reply["return_code"] = CLI_SUCCESS;
+                reply["message"] = "daemon stopped";
+            }
+            else {
+                std::vector<std::string> args { program_name };
+                if (j.contains("args"))
+                    for (const json &arg : j["args"])
+                        args.emplace_back(arg.get<std::string>());
+                if (j.contains("file"))
+                    args.emplace_back(j["file"].get<std::string>());
+                if (std::find(args.begin(), args.end(), "--daemon") != args.end())
+                    throw Slic3r::RuntimeError("--daemon is not allowed in a daemon job");
+                std::vector<char*> args_ptrs;
+                for (std::string &arg : args)
+                    args_ptrs.emplace_back(arg.data());
+                args_ptrs.emplace_back(nullptr);
+
+                ++ job_count;
+                BOOST_LOG_TRIVIAL(info) << boost::format("daemon: start job %1%: %2%")%job_count %request.substr(0, request.find('\n'));
+                g_slicing_warnings.clear();
+                auto start_time = std::chrono::steady_clock::now();
+                // The presets, the config definitions and the thread pool stay loaded, only the job state is created again.
+                int ret = CLI().run(int(args.size()), args_ptrs.data());
+                long long time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+                BOOST_LOG_TRIVIAL(info) << boost::format("daemon: job %1% finished, return %2%, cost %3% ms")%job_count %ret %time_ms;
+
+                auto error_iter = cli_errors.find(ret);
+                reply["return_code"] = ret;
+                reply["message"] = (error_iter != cli_errors.end()) ? error_iter->second : std::string();
+                reply["time_ms"] = time_ms;
+            }
+        }
+        catch (std::exception &ex) {
+            BOOST_LOG_TRIVIAL(error) << boost::format("daemon: invalid job %1%, reason: %2%")%request.substr(0, 1024) %ex.what();
+            reply["return_code"] = CLI_INVALID_PARAMS;
+            reply["message"] = ex.what();
+        }
+
+        std::string reply_str = reply.dump() + "\n";
+        if (write(client_fd, reply_str.c_str(), reply_str.size()) < 0)
+            BOOST_LOG_TRIVIAL(warning) << boost::format("daemon: could not send the reply, errno %1%, reason: %2%")%errno %strerror(errno);
+        close(client_fd);
+    }
+
+    close(server_fd);
+    unlink(socket_path.c_str());
+    g_daemon_mode = false;
+    g_cached_config_files.clear();
+    g_cached_json_files.clear();
+    BOOST_LOG_TRIVIAL(info) << boost::format("daemon: exit after %1% jobs")%job_count;
+    return CLI_SUCCESS;
+#else
+    boost::nowide::cerr << "daemon mode is only supported on linux" << std::endl;
+    return CLI_UNSUPPORTED_OPERATION;
+#endif
+}
+
 bool CLI::setup(int argc, char **argv)
 {
     // Detect the operating system flavor after SLIC3R_LOGLEVEL is set.
@@ -116,6 +116,8 @@ private:
     std::vector<Model>          m_models;
 
     bool setup(int argc, char **argv);
+    /// Serves the slicing jobs sent to a unix socket until a stop command is received.
+    int run_daemon(const std::string &socket_path, char *program_name);
 
     /// Prints usage of the CLI.
     void print_help(bool include_print_options = false, PrinterTechnology printer_technology = ptAny) const;
@@ -7,6 +7,7 @@
 #define slic3r_AABBTreeIndirect_hpp_
 
 #include <algorithm>
+#include <array>
 #include <limits>
 #include <type_traits>
 #include <vector>
@@ -787,6 +788,173 @@ inline bool intersect_ray_all_hits(
 	return ! hits.empty();
 }
 
+// Number of rays traced together by intersect_ray_packet_first_hit().
+// 8 single precision lanes fill an AVX register, 2 SSE registers or 2 NEON registers.
+static constexpr size_t RayPacketSize = 8;
+
+// Packet of up to RayPacketSize rays sharing a common origin.
+// The directions are stored as a structure of arrays, so that the ray / box and ray / triangle tests
+// are evaluated for all the rays of a packet at once by plain loops, which the compiler vectorizes.
+// Rays with a common origin are coherent, thus most of the AABB tree nodes are either entered
+// or rejected by all the rays of the packet and the tree is traversed once per packet instead of once per ray.
+struct RayPacket
+{
+    RayPacket() = default;
+    explicit RayPacket(const Vec3f &origin) : origin(origin) {}
+
+    void clear() { this->num_rays = 0; this->mean_dir = Vec3f::Zero(); }
+    bool empty() const { return this->num_rays == 0; }
+    bool full()  const { return this->num_rays == RayPacketSize; }
+    size_t size() const { return this->num_rays; }
+
+    void push_back(const Vec3f &dir) {
+        assert(! this->full());
+        const size_t i = this->num_rays ++;
+        this->dir_x[i] = dir.x();
+        this->dir_y[i] = dir.y();
+        this->dir_z[i] = dir.z();
+        this->inv_dir_x[i] = 1.f / dir.x();
+        this->inv_dir_y[i] = 1.f / dir.y();
+        this->inv_dir_z[i] = 1.f / dir.z();
+        this->mean_dir += dir;
+    }
+
+    Vec3f dir(size_t i) const { assert(i < this->num_rays); return { this->dir_x[i], this->dir_y[i], this->dir_z[i] }; }
+
+    // Common origin of all the rays.
+    Vec3f origin { Vec3f::Zero() };
+    // Sum of the directions, used for front to back ordering of the AABB tree traversal.
+    Vec3f mean_dir { Vec3f::Zero() };
+    size_t num_rays { 0 };
+    alignas(32) float dir_x[RayPacketSize];
+    alignas(32) float dir_y[RayPacketSize];
+    alignas(32) float dir_z[RayPacketSize];
+    alignas(32) float inv_dir_x[RayPacketSize];
+    alignas(32) float inv_dir_y[RayPacketSize];
+    alignas(32) float inv_dir_z[RayPacketSize];
+};
+
+// Find the first intersections of a packet of rays with an indexed triangle set.
+// In contrast to intersect_ray_first_hit(), the traversal and the intersection tests are calculated in single precision,
+// the packet is traced against the AABB tree with an explicit stack and the ray / box and ray / triangle tests
+// are evaluated for all the rays of the packet at once.
+// hits[i].id is set to the index of the first face hit by i-th ray of the packet, or to -1 if the ray misses.
+// Returns the number of rays, which hit the indexed triangle set.
+template<typename VertexType, typename IndexedFaceType>
+inline size_t intersect_ray_packet_first_hit(
+	// Indexed triangle set - 3D vertices.
+	const std::vector<VertexType> 		&vertices,
+	// Indexed triangle set - triangular faces, references to vertices.
+	const std::vector<IndexedFaceType> 	&faces,
+	// AABBTreeIndirect::Tree over vertices & faces.
+	const Tree<3, float> 				&tree,
+	// Rays sharing a common origin.
+	const RayPacket 					&packet,
+	// First intersections of the rays with the indexed triangle set, igl::Hit::id == -1 for rays that missed.
+	std::array<igl::Hit, RayPacketSize> &hits,
+	// Epsilon for the ray-triangle intersection, it should be proportional to an average triangle edge length.
+	const float 						 eps = 0.000001f)
+{
+    static_assert(std::is_same<typename VertexType::Scalar, float>::value, "intersect_ray_packet_first_hit() requires float vertices");
+    constexpr size_t N = RayPacketSize;
+    const size_t     num_rays = packet.size();
+    for (igl::Hit &hit : hits)
+        hit = igl::Hit { -1, -1, 0.f, 0.f, std::numeric_limits<float>::infinity() };
+    if (tree.empty() || num_rays == 0)
+        return 0;
+
+    // Pad the unused lanes with copies of the last ray, so that the loops below work over all the lanes
+    // without any masking. Results of the padding lanes are ignored.
+    alignas(32) float dx[N], dy[N], dz[N], ix[N], iy[N], iz[N];
+    for (size_t i = 0; i < N; ++ i) {
+        const size_t j = std::min(i, num_rays - 1);
+        dx[i] = packet.dir_x[j];     dy[i] = packet.dir_y[j];     dz[i] = packet.dir_z[j];
+        ix[i] = packet.inv_dir_x[j]; iy[i] = packet.inv_dir_y[j]; iz[i] = packet.inv_dir_z[j];
+    }
+    alignas(32) float t_best[N], u_best[N], v_best[N];
+    alignas(32) int   id_best[N];
+    for (size_t i = 0; i < N; ++ i) {
+        t_best[i]  = std::numeric_limits<float>::infinity();
+        u_best[i]  = 0.f;
+        v_best[i]  = 0.f;
+        id_best[i] = -1;
+    }
+    const Vec3f &origin = packet.origin;
+
+    // Depth first traversal grows the stack by at most one entry per level of the tree, which is at most 64 levels deep.
+    size_t stack[128];
+    size_t stack_size = 0;
+    stack[stack_size ++] = 0;
+    while (stack_size > 0) {
+        const size_t node_idx = stack[-- stack_size];
+        const auto  &node     = tree.node(node_idx);
+        assert(node.is_valid());
+
+        // Slab test of the node's bounding box against all the rays, pruned by the closest hit found so far.
+        const Vec3f bmin = node.bbox.min() - origin;
+        const Vec3f bmax = node.bbox.max() - origin;
+        int any_hit = 0;
+        for (size_t i = 0; i < N; ++ i) {
+            const float tx0 = bmin.x() * ix[i], tx1 = bmax.x() * ix[i];
+            const float ty0 = bmin.y() * iy[i], ty1 = bmax.y() * iy[i];
+            const float tz0 = bmin.z() * iz[i], tz1 = bmax.z() * iz[i];
+            const float tmin = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::min(tz0, tz1));
+            const float tmax = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1));
+            any_hit |= int(tmin <= tmax) & int(tmax > 0.f) & int(tmin < t_best[i]);
+        }
+        if (! any_hit)
+            continue;
+
+        if (node.is_leaf()) {
+            // Möller–Trumbore ray / triangle test. As all the rays share the origin, the vectors derived from
+            // the origin and the triangle only are calculated once for the whole packet.
+            const auto &face  = faces[node.idx];
+            const Vec3f v0    = vertices[face(0)];
+            const Vec3f edge1 = vertices[face(1)] - v0;
+            const Vec3f edge2 = vertices[face(2)] - v0;
+            const Vec3f tvec  = origin - v0;
+            const Vec3f qvec  = tvec.cross(edge1);
+            const float t_num = edge2.dot(qvec);
+            const int   idx   = int(node.idx);
+            for (size_t i = 0; i < N; ++ i) {
+                // pvec = dir x edge2
+                const float px  = dy[i] * edge2.z() - dz[i] * edge2.y();
+                const float py  = dz[i] * edge2.x() - dx[i] * edge2.z();
+                const float pz  = dx[i] * edge2.y() - dy[i] * edge2.x();
+                const float det = edge1.x() * px + edge1.y() * py + edge1.z() * pz;
+                const float inv_det = 1.f / det;
+                const float u = (tvec.x() * px + tvec.y() * py + tvec.z() * pz) * inv_det;
+                const float v = (dx[i] * qvec.x() + dy[i] * qvec.y() + dz[i] * qvec.z()) * inv_det;
+                const float t = t_num * inv_det;
+                const bool  hit = bool(int(std::abs(det) > eps) & int(u >= 0.f) & int(v >= 0.f) & int(u + v <= 1.f) & int(t > 0.f) & int(t < t_best[i]));
+                t_best[i]  = hit ? t   : t_best[i];
+                u_best[i]  = hit ? u   : u_best[i];
+                v_best[i]  = hit ? v   : v_best[i];
+                id_best[i] = hit ? idx : id_best[i];
+            }
+        } else {
+            // The tree was split along the longest axis of the node's bounding box, the left child being the lower one.
+            // Visit the child closer along the packet's mean direction first, so that the closer hits prune the farther subtree.
+            const size_t left  = Tree<3, float>::left_child_idx(node_idx);
+            const size_t right = left + 1;
+            int          axis;
+            (bmax - bmin).maxCoeff(&axis);
+            const bool   left_first = packet.mean_dir(axis) > 0.f;
+            assert(stack_size + 2 <= sizeof(stack) / sizeof(stack[0]));
+            stack[stack_size ++] = left_first ? right : left;
+            stack[stack_size ++] = left_first ? left  : right;
+        }
+    }
+
+    size_t num_hits = 0;
+    for (size_t i = 0; i < num_rays; ++ i)
+        if (id_best[i] != -1) {
+            hits[i] = igl::Hit { id_best[i], -1, u_best[i], v_best[i], t_best[i] };
+            ++ num_hits;
+        }
+    return num_hits;
+}
+
 // Finding a closest triangle, its closest point and squared distance to the closest point
 // on a 3D indexed triangle set using a pre-built AABBTreeIndirect::Tree.
 // Closest point to triangle test will be performed with the accuracy of VectorType::Scalar
@@ -81,7 +81,7 @@ static void export_graph_to_svg(const std::string
 
     if (transition_ends) {
         for (auto &edge : graph.edges) {
-            if (std::shared_ptr<std::list<SkeletalTrapezoidationEdge::TransitionEnd>> transitions = edge.data.getTransitionEnds(); transitions) {
+            if (std::shared_ptr<std::vector<SkeletalTrapezoidationEdge::TransitionEnd>> transitions = edge.data.getTransitionEnds(); transitions) {
                 for (auto &transition : *transitions) {
                     Line edge_line = Line(edge.to->p, edge.from->p);
                     double edge_length = edge_line.length();
@@ -99,8 +99,7 @@ SkeletalTrapezoidation::node_t &SkeletalTrapezoidation::makeNode(const VD::verte
     auto he_node_it = vd_node_to_he_node.find(&vd_node);
     if (he_node_it == vd_node_to_he_node.end())
     {
-        graph.nodes.emplace_front(SkeletalTrapezoidationJoint(), p);
-        node_t& node = graph.nodes.front();
+        node_t& node = graph.nodes.emplace_front(SkeletalTrapezoidationJoint(), p);
         vd_node_to_he_node.emplace(&vd_node, &node);
         return node;
     }
@@ -127,8 +126,7 @@ void SkeletalTrapezoidation::transferEdge(const Point &from, const Point &to, co
                 continue; //Prevent reading unallocated memory.
             }
             assert(twin);
-            graph.edges.emplace_front(SkeletalTrapezoidationEdge());
-            edge_t* edge = &graph.edges.front();
+            edge_t* edge = &graph.edges.emplace_front(SkeletalTrapezoidationEdge());
             edge->from = twin->to;
             edge->to = twin->from;
             edge->twin = twin;
@@ -184,16 +182,14 @@ void SkeletalTrapezoidation::transferEdge(const Point &from, const Point &to, co
             node_t* v1;
             if (p1_idx < discretized.size() - 1)
             {
-                graph.nodes.emplace_front(SkeletalTrapezoidationJoint(), p1);
-                v1 = &graph.nodes.front();
+                v1 = &graph.nodes.emplace_front(SkeletalTrapezoidationJoint(), p1);
             }
             else
             {
                 v1 = &makeNode(*vd_edge.vertex1(), to);
             }
 
-            graph.edges.emplace_front(SkeletalTrapezoidationEdge());
-            edge_t* edge = &graph.edges.front();
+            edge_t* edge = &graph.edges.emplace_front(SkeletalTrapezoidationEdge());
             edge->from = v0;
             edge->to = v1;
             edge->from->incident_edge = edge;
@@ -474,8 +470,7 @@ void SkeletalTrapezoidation::separatePointyQuadEndNodes()
         }
         else
         { // Needs to be duplicated
-            graph.nodes.emplace_back(*quad_start->from);
-            node_t* new_node = &graph.nodes.back();
+            node_t* new_node = &graph.nodes.emplace_back(*quad_start->from);
             new_node->incident_edge = quad_start;
             quad_start->from = new_node;
             quad_start->twin->to = new_node;
@@ -765,7 +760,7 @@ void SkeletalTrapezoidation::generateTransitioningRibs()
     export_graph_to_svg(debug_out_path("ST-generateTransitioningRibs-mids-%d.svg", iRun++), this->graph, this->outline);
 #endif
 
-    ptr_vector_t<std::list<TransitionEnd>> edge_transition_ends; // We only map the half edge in the upward direction. mapped items are not sorted
+    ptr_vector_t<std::vector<TransitionEnd>> edge_transition_ends; // We only map the half edge in the upward direction. mapped items are not sorted
     generateAllTransitionEnds(edge_transition_ends);
 
 #ifdef ARACHNE_DEBUG
@@ -881,7 +876,7 @@ void SkeletalTrapezoidation::filterTransitionMids()
         coord_t ab_size = ab.cast<int64_t>().norm();
 
         bool going_up = true;
-        std::list<TransitionMidRef> to_be_dissolved_back = dissolveNearbyTransitions(&edge, transitions.back(), ab_size - transitions.back().pos, transition_filter_dist, going_up);
+        std::vector<TransitionMidRef> to_be_dissolved_back = dissolveNearbyTransitions(&edge, transitions.back(), ab_size - transitions.back().pos, transition_filter_dist, going_up);
         bool should_dissolve_back = !to_be_dissolved_back.empty();
         for (TransitionMidRef& ref : to_be_dissolved_back)
         {
@@ -905,7 +900,7 @@ void SkeletalTrapezoidation::filterTransitionMids()
         }
 
         going_up = false;
-        std::list<TransitionMidRef> to_be_dissolved_front = dissolveNearbyTransitions(edge.twin, transitions.front(), transitions.front().pos, transition_filter_dist, going_up);
+        std::vector<TransitionMidRef> to_be_dissolved_front = dissolveNearbyTransitions(edge.twin, transitions.front(), transitions.front().pos, transition_filter_dist, going_up);
         bool should_dissolve_front = !to_be_dissolved_front.empty();
         for (TransitionMidRef& ref : to_be_dissolved_front)
         {
@@ -930,9 +925,9 @@ void SkeletalTrapezoidation::filterTransitionMids()
     }
 }
 
-std::list<SkeletalTrapezoidation::TransitionMidRef> SkeletalTrapezoidation::dissolveNearbyTransitions(edge_t* edge_to_start, TransitionMiddle& origin_transition, coord_t traveled_dist, coord_t max_dist, bool going_up)
+std::vector<SkeletalTrapezoidation::TransitionMidRef> SkeletalTrapezoidation::dissolveNearbyTransitions(edge_t* edge_to_start, TransitionMiddle& origin_transition, coord_t traveled_dist, coord_t max_dist, bool going_up)
 {
-    std::list<TransitionMidRef> to_be_dissolved;
+    std::vector<TransitionMidRef> to_be_dissolved;
     if (traveled_dist > max_dist)
         return to_be_dissolved;
 
@@ -973,12 +968,12 @@ std::list<SkeletalTrapezoidation::TransitionMidRef> SkeletalTrapezoidation::diss
             }
         }
         if (should_dissolve && !seen_transition_on_this_edge) {
-            std::list<SkeletalTrapezoidation::TransitionMidRef> to_be_dissolved_here = dissolveNearbyTransitions(edge, origin_transition, traveled_dist + ab_size, max_dist, going_up);
+            std::vector<SkeletalTrapezoidation::TransitionMidRef> to_be_dissolved_here = dissolveNearbyTransitions(edge, origin_transition, traveled_dist + ab_size, max_dist, going_up);
             if (to_be_dissolved_here.empty()) { // The region is too long to be dissolved in this direction, so it cannot be dissolved in any direction.
                 to_be_dissolved.clear();
                 return to_be_dissolved;
             }
-            to_be_dissolved.splice(to_be_dissolved.end(), to_be_dissolved_here); // Transfer to_be_dissolved_here into to_be_dissolved
+            to_be_dissolved.insert(to_be_dissolved.end(), to_be_dissolved_here.begin(), to_be_dissolved_here.end()); // Transfer to_be_dissolved_here into to_be_dissolved
             should_dissolve = should_dissolve && !to_be_dissolved.empty();
         }
     }
@@ -1037,7 +1032,7 @@ bool SkeletalTrapezoidation::filterEndOfCentralTransition(edge_t* edge_to_start,
     return should_dissolve;
 }
 
-void SkeletalTrapezoidation::generateAllTransitionEnds(ptr_vector_t<std::list<TransitionEnd>>& edge_transition_ends)
+void SkeletalTrapezoidation::generateAllTransitionEnds(ptr_vector_t<std::vector<TransitionEnd>>& edge_transition_ends)
 {
     for (edge_t& edge : graph.edges)
     {
@@ -1057,7 +1052,7 @@ void SkeletalTrapezoidation::generateAllTransitionEnds(ptr_vector_t<std::list<Tr
     }
 }
 
-void SkeletalTrapezoidation::generateTransitionEnds(edge_t& edge, coord_t mid_pos, coord_t lower_bead_count, ptr_vector_t<std::list<TransitionEnd>>& edge_transition_ends)
+void SkeletalTrapezoidation::generateTransitionEnds(edge_t& edge, coord_t mid_pos, coord_t lower_bead_count, ptr_vector_t<std::vector<TransitionEnd>>& edge_transition_ends)
 {
     const Point a = edge.from->p;
     const Point b = edge.to->p;
@@ -1094,7 +1089,7 @@ void SkeletalTrapezoidation::generateTransitionEnds(edge_t& edge, coord_t mid_po
     }
 }
 
-bool SkeletalTrapezoidation::generateTransitionEnd(edge_t& edge, coord_t start_pos, coord_t end_pos, coord_t transition_half_length, double start_rest, double end_rest, coord_t lower_bead_count, ptr_vector_t<std::list<TransitionEnd>>& edge_transition_ends)
+bool SkeletalTrapezoidation::generateTransitionEnd(edge_t& edge, coord_t start_pos, coord_t end_pos, coord_t transition_half_length, double start_rest, double end_rest, coord_t lower_bead_count, ptr_vector_t<std::vector<TransitionEnd>>& edge_transition_ends)
 {
     Point a = edge.from->p;
     Point b = edge.to->p;
@@ -1179,7 +1174,7 @@ bool SkeletalTrapezoidation::generateTransitionEnd(edge_t& edge, coord_t start_p
         if(!upward_edge->data.hasTransitionEnds())
         {
             //This edge doesn't have a data structure yet for the transition ends. Make one.
-            edge_transition_ends.emplace_back(std::make_shared<std::list<TransitionEnd>>());
+            edge_transition_ends.emplace_back(std::make_shared<std::vector<TransitionEnd>>());
             upward_edge->data.setTransitionEnds(edge_transition_ends.back());
         }
         auto transitions = upward_edge->data.getTransitionEnds();
@@ -1189,7 +1184,7 @@ bool SkeletalTrapezoidation::generateTransitionEnd(edge_t& edge, coord_t start_p
         assert(pos <= ab_size);
         if (transitions->empty() || pos < transitions->front().pos)
         { // Preorder so that sorting later on is faster
-            transitions->emplace_front(pos, lower_bead_count, is_lower_end);
+            transitions->emplace(transitions->begin(), pos, lower_bead_count, is_lower_end);
         }
         else
         {
@@ -1266,7 +1261,7 @@ static inline Point normal(const Point& p0, coord_t len)
     return (p0.cast<int64_t>() * int64_t(len) / _len).cast<coord_t>();
 };
 
-void SkeletalTrapezoidation::applyTransitions(ptr_vector_t<std::list<TransitionEnd>>& edge_transition_ends)
+void SkeletalTrapezoidation::applyTransitions(ptr_vector_t<std::vector<TransitionEnd>>& edge_transition_ends)
 {
     const auto _snap_dist = snap_dist();
     for (edge_t& edge : graph.edges)
@@ -1277,7 +1272,7 @@ void SkeletalTrapezoidation::applyTransitions(ptr_vector_t<std::list<TransitionE
             auto& twin_transition_ends = *edge.twin->data.getTransitionEnds();
             if (! edge.data.hasTransitionEnds())
             {
-                edge_transition_ends.emplace_back(std::make_shared<std::list<TransitionEnd>>());
+                edge_transition_ends.emplace_back(std::make_shared<std::vector<TransitionEnd>>());
                 edge.data.setTransitionEnds(edge_transition_ends.back());
             }
             auto& transition_ends = *edge.data.getTransitionEnds();
@@ -1299,7 +1294,7 @@ void SkeletalTrapezoidation::applyTransitions(ptr_vector_t<std::list<TransitionE
         assert(edge.data.isCentral());
 
         auto& transitions = *edge.data.getTransitionEnds();
-        transitions.sort([](const TransitionEnd& a, const TransitionEnd& b) { return a.pos < b.pos; } );
+        std::stable_sort(transitions.begin(), transitions.end(), [](const TransitionEnd& a, const TransitionEnd& b) { return a.pos < b.pos; } );
 
         node_t* from = edge.from;
         node_t* to = edge.to;
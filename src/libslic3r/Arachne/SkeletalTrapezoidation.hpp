@@ -303,7 +303,7 @@ protected:
      * optimum.
      * \return Whether the origin transition should be dissolved.
      */
-    std::list<TransitionMidRef> dissolveNearbyTransitions(edge_t* edge_to_start, TransitionMiddle& origin_transition, coord_t traveled_dist, coord_t max_dist, bool going_up);
+    std::vector<TransitionMidRef> dissolveNearbyTransitions(edge_t* edge_to_start, TransitionMiddle& origin_transition, coord_t traveled_dist, coord_t max_dist, bool going_up);
 
     /*!
      * Spread a certain bead count over a region in the graph.
@@ -332,12 +332,12 @@ protected:
      * Generate the endpoints of all transitions for all edges in the graph.
      * \param[out] edge_transition_ends The resulting transition endpoints.
      */
-    void generateAllTransitionEnds(ptr_vector_t<std::list<TransitionEnd>>& edge_transition_ends);
+    void generateAllTransitionEnds(ptr_vector_t<std::vector<TransitionEnd>>& edge_transition_ends);
 
     /*!
      * Also set the rest values at nodes in between the transition ends
      */
-    void applyTransitions(ptr_vector_t<std::list<TransitionEnd>>& edge_transition_ends);
+    void applyTransitions(ptr_vector_t<std::vector<TransitionEnd>>& edge_transition_ends);
 
     /*!
      * Create extra edges along all edges, where it needs to transition from one
@@ -360,7 +360,7 @@ protected:
      * \param[out] edge_transition_ends A list of endpoints to add the new
      * endpoints to.
      */
-    void generateTransitionEnds(edge_t& edge, coord_t mid_R, coord_t transition_lower_bead_count, ptr_vector_t<std::list<TransitionEnd>>& edge_transition_ends);
+    void generateTransitionEnds(edge_t& edge, coord_t mid_R, coord_t transition_lower_bead_count, ptr_vector_t<std::vector<TransitionEnd>>& edge_transition_ends);
 
     /*!
      * Compute a single endpoint of a transition.
@@ -382,7 +382,7 @@ protected:
      * \return Whether the given edge is going downward (i.e. towards a thinner
      * region of the polygon).
      */
-    bool generateTransitionEnd(edge_t& edge, coord_t start_pos, coord_t end_pos, coord_t transition_half_length, double start_rest, double end_rest, coord_t transition_lower_bead_count, ptr_vector_t<std::list<TransitionEnd>>& edge_transition_ends);
+    bool generateTransitionEnd(edge_t& edge, coord_t start_pos, coord_t end_pos, coord_t transition_half_length, double start_rest, double end_rest, coord_t transition_lower_bead_count, ptr_vector_t<std::vector<TransitionEnd>>& edge_transition_ends);
 
     /*!
      * Determines whether an edge is going downwards or upwards in the graph.
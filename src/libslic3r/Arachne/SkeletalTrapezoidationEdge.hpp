@@ -88,11 +88,11 @@ public:
     {
         return transition_ends.use_count() > 0 && (ignore_empty || ! transition_ends.lock()->empty());
     }
-    void setTransitionEnds(std::shared_ptr<std::list<TransitionEnd>> storage)
+    void setTransitionEnds(std::shared_ptr<std::vector<TransitionEnd>> storage)
     {
         transition_ends = storage;
     }
-    std::shared_ptr<std::list<TransitionEnd>> getTransitionEnds()
+    std::shared_ptr<std::vector<TransitionEnd>> getTransitionEnds()
     {
         return transition_ends.lock();
     }
@@ -114,7 +114,7 @@ private:
     Central is_central; //! whether the edge is significant; whether the source segments have a sharp angle; -1 is unknown
 
     std::weak_ptr<std::list<TransitionMiddle>> transitions;
-    std::weak_ptr<std::list<TransitionEnd>> transition_ends;
+    std::weak_ptr<std::vector<TransitionEnd>> transition_ends;
     std::weak_ptr<LineJunctions> extrusion_junctions;
 };
 
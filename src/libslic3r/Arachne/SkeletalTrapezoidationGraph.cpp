@@ -326,14 +326,11 @@ void SkeletalTrapezoidationGraph::makeRib(edge_t *&prev_edge, const Point &start
     prev_edge->to->data.distance_to_boundary = dist;
     assert(dist >= 0);
 
-    nodes.emplace_front(SkeletalTrapezoidationJoint(), p);
-    node_t* node = &nodes.front();
+    node_t* node = &nodes.emplace_front(SkeletalTrapezoidationJoint(), p);
     node->data.distance_to_boundary = 0;
     
-    edges.emplace_front(SkeletalTrapezoidationEdge(SkeletalTrapezoidationEdge::EdgeType::EXTRA_VD));
-    edge_t* forth_edge = &edges.front();
-    edges.emplace_front(SkeletalTrapezoidationEdge(SkeletalTrapezoidationEdge::EdgeType::EXTRA_VD));
-    edge_t* back_edge = &edges.front();
+    edge_t* forth_edge = &edges.emplace_front(SkeletalTrapezoidationEdge(SkeletalTrapezoidationEdge::EdgeType::EXTRA_VD));
+    edge_t* back_edge = &edges.emplace_front(SkeletalTrapezoidationEdge(SkeletalTrapezoidationEdge::EdgeType::EXTRA_VD));
     
     prev_edge->next = forth_edge;
     forth_edge->prev = prev_edge;
@@ -365,17 +362,13 @@ std::pair<SkeletalTrapezoidationGraph::edge_t*, SkeletalTrapezoidationGraph::edg
     mid_node->data.distance_to_boundary = dist;
     mid_node->data.transition_ratio = 0; // Both transition end should have rest = 0, because at the ends a whole number of beads fits without rest
 
-    nodes.emplace_back(SkeletalTrapezoidationJoint(), px);
-    node_t* source_node = &nodes.back();
+    node_t* source_node = &nodes.emplace_back(SkeletalTrapezoidationJoint(), px);
     source_node->data.distance_to_boundary = 0;
 
     edge_t* first = &edge;
-    edges.emplace_back(SkeletalTrapezoidationEdge());
-    edge_t* second = &edges.back();
-    edges.emplace_back(SkeletalTrapezoidationEdge(SkeletalTrapezoidationEdge::EdgeType::TRANSITION_END));
-    edge_t* outward_edge = &edges.back();
-    edges.emplace_back(SkeletalTrapezoidationEdge(SkeletalTrapezoidationEdge::EdgeType::TRANSITION_END));
-    edge_t* inward_edge = &edges.back();
+    edge_t* second = &edges.emplace_back(SkeletalTrapezoidationEdge());
+    edge_t* outward_edge = &edges.emplace_back(SkeletalTrapezoidationEdge(SkeletalTrapezoidationEdge::EdgeType::TRANSITION_END));
+    edge_t* inward_edge = &edges.emplace_back(SkeletalTrapezoidationEdge(SkeletalTrapezoidationEdge::EdgeType::TRANSITION_END));
 
     if (edge_before)
     {
@@ -433,8 +426,7 @@ SkeletalTrapezoidationGraph::edge_t* SkeletalTrapezoidationGraph::insertNode(edg
 {
     edge_t* last_edge_replacing_input = edge;
 
-    nodes.emplace_back(SkeletalTrapezoidationJoint(), mid);
-    node_t* mid_node = &nodes.back();
+    node_t* mid_node = &nodes.emplace_back(SkeletalTrapezoidationJoint(), mid);
 
     edge_t* twin = last_edge_replacing_input->twin;
     last_edge_replacing_input->twin = nullptr;
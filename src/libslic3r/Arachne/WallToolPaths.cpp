@@ -16,6 +16,7 @@
 #include "SVG.hpp"
 #include "Utils.hpp"
 
+#include <boost/functional/hash.hpp>
 #include <boost/log/trivial.hpp>
 
 //#define ARACHNE_STITCH_PATCH_DEBUG
@@ -876,4 +877,70 @@ WallToolPaths::ExtrusionLineSet WallToolPaths::getRegionOrder(const std::vector<
     return order_requirements;
 }
 
+bool WallToolPathsCache::Key::operator==(const Key &rhs) const
+{
+    return hash == rhs.hash && bead_width_0 == rhs.bead_width_0 && bead_width_x == rhs.bead_width_x && inset_count == rhs.inset_count &&
+           wall_0_inset == rhs.wall_0_inset && layer_height == rhs.layer_height &&
+           params.min_bead_width == rhs.params.min_bead_width && params.min_feature_size == rhs.params.min_feature_size &&
+           params.min_length_factor == rhs.params.min_length_factor && params.wall_transition_length == rhs.params.wall_transition_length &&
+           params.wall_transition_angle == rhs.params.wall_transition_angle &&
+           params.wall_transition_filter_deviation == rhs.params.wall_transition_filter_deviation &&
+           params.wall_distribution_count == rhs.params.wall_distribution_count && params.is_top_or_bottom_layer == rhs.params.is_top_or_bottom_layer &&
+           outline == rhs.outline;
+}
+
+std::shared_ptr<const WallToolPathsCache::Walls> WallToolPathsCache::generate(const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x, size_t inset_count, coord_t wall_0_inset, coordf_t layer_height, const WallToolPathsParams &params)
+{
+    m_lookups.fetch_add(1, std::memory_order_relaxed);
+
+    Key key { outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params, 0 };
+    size_t seed = outline.size();
+    for (const Polygon &polygon : outline) {
+        boost::hash_combine(seed, polygon.size());
+        for (const Point &pt : polygon)
+            boost::hash_combine(seed, (uint64_t(uint32_t(pt.x())) << 32) | uint64_t(uint32_t(pt.y())));
+    }
+    boost::hash_combine(seed, bead_width_0);
+    boost::hash_combine(seed, bead_width_x);
+    boost::hash_combine(seed, inset_count);
+    boost::hash_combine(seed, wall_0_inset);
+    boost::hash_combine(seed, layer_height);
+    boost::hash_combine(seed, params.min_bead_width);
+    boost::hash_combine(seed, params.is_top_or_bottom_layer);
+    key.hash = seed;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto it = m_walls.find(key); it != m_walls.end()) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            it->second.last_used = ++ m_clock;
+            return it->second.walls;
+        }
+    }
+
+    // Generate outside of the lock, the layers with different outlines are generated in parallel.
+    WallToolPaths wall_tool_paths(outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params);
+    auto walls = std::make_shared<Walls>();
+    walls->toolpaths     = wall_tool_paths.getToolPaths();
+    walls->inner_contour = wall_tool_paths.getInnerContour();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (auto it = m_walls.find(key); it != m_walls.end()) {
+        // Generated by another thread in the meantime.
+        it->second.last_used = ++ m_clock;
+        return it->second.walls;
+    }
+    if (m_walls.size() >= m_max_entries)
+        // Release the least recently used walls. A miss costs a run of WallToolPaths, which dwarfs the linear search.
+        m_walls.erase(std::min_element(m_walls.begin(), m_walls.end(),
+            [](const auto &l, const auto &r) { return l.second.last_used < r.second.last_used; }));
+    return m_walls.try_emplace(std::move(key), Entry{ std::move(walls), ++ m_clock }).first->second.walls;
+}
+
+void WallToolPathsCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_walls = {};
+}
+
 } // namespace Slic3r::Arachne
@@ -4,7 +4,10 @@
 #ifndef CURAENGINE_WALLTOOLPATHS_H
 #define CURAENGINE_WALLTOOLPATHS_H
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <ankerl/unordered_dense.h>
 
 #include "BeadingStrategy/BeadingStrategyFactory.hpp"
@@ -139,6 +142,71 @@ private:
     const WallToolPathsParams m_params;
 };
 
+/*!
+ * Walls generated by WallToolPaths, shared between the layers with the same outline and wall parameters.
+ *
+ * Prismatic objects have many consecutive layers with identical outlines, their walls are generated once
+ * and copied to the other layers. Thread safe, the same outline may be generated by two threads at once,
+ * in that case the result of the first one is kept.
+ * The layers are processed in blocks of consecutive layers, thus just the recently used walls are kept:
+ * above max_entries, the least recently used walls are released.
+ */
+class WallToolPathsCache
+{
+public:
+    struct Walls
+    {
+        std::vector<VariableWidthLines> toolpaths;
+        Polygons                        inner_contour;
+    };
+
+    explicit WallToolPathsCache(size_t max_entries = 256) : m_max_entries(std::max<size_t>(max_entries, 1)) {}
+
+    // Returns the toolpaths and the inner contour of WallToolPaths(outline, ...), generated by this call or taken from the cache.
+    std::shared_ptr<const Walls> generate(const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x, size_t inset_count, coord_t wall_0_inset, coordf_t layer_height, const WallToolPathsParams &params);
+
+    // Release the cached walls, keep the statistics.
+    void   clear();
+    // Number of the walls cached, at most max_entries.
+    size_t size() const { std::lock_guard<std::mutex> lock(m_mutex); return m_walls.size(); }
+    // Number of the calls of generate() and of the calls answered from the cache.
+    size_t lookups() const { return m_lookups.load(std::memory_order_relaxed); }
+    size_t hits()    const { return m_hits.load(std::memory_order_relaxed); }
+
+private:
+    struct Key
+    {
+        Polygons            outline;
+        coord_t             bead_width_0;
+        coord_t             bead_width_x;
+        size_t              inset_count;
+        coord_t             wall_0_inset;
+        coordf_t            layer_height;
+        WallToolPathsParams params;
+        size_t              hash;
+
+        bool operator==(const Key &rhs) const;
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const { return key.hash; }
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<const Walls> walls;
+        // Value of m_clock at the last lookup of the walls.
+        uint64_t                     last_used;
+    };
+
+    const size_t                                              m_max_entries;
+    mutable std::mutex                                        m_mutex;
+    ankerl::unordered_dense::map<Key, Entry, KeyHash>         m_walls;
+    uint64_t                                                  m_clock { 0 };
+    std::atomic<size_t>                                       m_lookups { 0 };
+    std::atomic<size_t>                                                      m_hits { 0 };
+};
+
 } // namespace Slic3r::Arachne
 
 #endif // CURAENGINE_WALLTOOLPATHS_H
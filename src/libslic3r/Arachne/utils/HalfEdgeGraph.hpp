@@ -5,8 +5,15 @@
 #define UTILS_HALF_EDGE_GRAPH_H
 
 
-#include <list>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
 
 
 
@@ -15,14 +22,174 @@
 
 namespace Slic3r::Arachne
 {
+
+/*!
+ * Storage of the nodes or edges of a HalfEdgeGraph.
+ *
+ * The elements are stored in fixed size blocks, which never move, thus the pointers between the nodes and edges stay valid
+ * while elements are added or erased. An erased element leaves an empty slot behind, which is skipped when iterating.
+ * Elements may be added at both ends and the iteration order is the same as of a std::list with the same sequence
+ * of emplace_front(), emplace_back() and erase() calls. Iterators stay valid when elements are added or erased,
+ * and an iteration visits the elements added at the back during the iteration, as with std::list.
+ *
+ * The blocks of a released storage are kept in a thread local pool and reused by the next graph built on the same thread,
+ * so that building the graphs of many perimeter regions one after the other does not allocate per element.
+ */
+template<typename T>
+class HalfEdgeGraphStorage
+{
+    static constexpr size_t BlockBits = 8;
+    static constexpr size_t BlockSize = size_t(1) << BlockBits;
+    using Block     = std::array<std::optional<T>, BlockSize>;
+    using BlockPtr  = std::unique_ptr<Block>;
+
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = T*;
+        using reference         = T&;
+
+        iterator() = default;
+
+        T&        operator*()  const { return *m_storage->slot(m_pos); }
+        T*        operator->() const { return &*m_storage->slot(m_pos); }
+        iterator& operator++() { m_pos = m_storage->next_occupied(m_pos + 1); return *this; }
+        iterator  operator++(int) { iterator it = *this; ++ *this; return it; }
+        bool      operator==(const iterator &rhs) const { return m_pos == rhs.m_pos; }
+        bool      operator!=(const iterator &rhs) const { return m_pos != rhs.m_pos; }
+
+    private:
+        friend class HalfEdgeGraphStorage;
+        iterator(HalfEdgeGraphStorage *storage, int64_t pos) : m_storage(storage), m_pos(pos) {}
+
+        HalfEdgeGraphStorage *m_storage { nullptr };
+        // Negative positions index the elements added at the front, non-negative positions the elements added at the back.
+        int64_t               m_pos { EndPos };
+    };
+
+    HalfEdgeGraphStorage() = default;
+    HalfEdgeGraphStorage(HalfEdgeGraphStorage &&rhs) { this->swap(rhs); }
+    HalfEdgeGraphStorage& operator=(HalfEdgeGraphStorage &&rhs) { this->swap(rhs); return *this; }
+    HalfEdgeGraphStorage(const HalfEdgeGraphStorage&) = delete;
+    HalfEdgeGraphStorage& operator=(const HalfEdgeGraphStorage&) = delete;
+    ~HalfEdgeGraphStorage() { this->clear(); }
+
+    template<typename... Args>
+    T& emplace_front(Args&&... args) {
+        std::optional<T> &dst = allocate_slot(m_front, m_front_size ++);
+        ++ m_size;
+        return dst.emplace(std::forward<Args>(args)...);
+    }
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        std::optional<T> &dst = allocate_slot(m_back, m_back_size ++);
+        ++ m_size;
+        return dst.emplace(std::forward<Args>(args)...);
+    }
+
+    // Returns iterator to the element following the erased one.
+    iterator erase(iterator it) {
+        std::optional<T> &dst = this->slot(it.m_pos);
+        assert(dst.has_value());
+        dst.reset();
+        -- m_size;
+        return ++ it;
+    }
+
+    iterator begin() { return iterator(this, this->next_occupied(- int64_t(m_front_size))); }
+    iterator end()   { return iterator(this, EndPos); }
+
+    size_t size()  const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+
+    // Destroy all the elements and return the blocks to the thread local pool.
+    void clear() {
+        release_blocks(m_front, m_front_size);
+        release_blocks(m_back, m_back_size);
+        m_front_size = 0;
+        m_back_size  = 0;
+        m_size       = 0;
+    }
+
+private:
+    static constexpr int64_t EndPos = std::numeric_limits<int64_t>::max();
+    // Number of blocks kept in the thread local pool at most.
+    static constexpr size_t  MaxPooledBlocks = 256;
+
+    static std::vector<BlockPtr>& block_pool() {
+        static thread_local std::vector<BlockPtr> pool;
+        return pool;
+    }
+
+    static std::optional<T>& allocate_slot(std::vector<BlockPtr> &blocks, size_t idx) {
+        if ((idx >> BlockBits) == blocks.size()) {
+            std::vector<BlockPtr> &pool = block_pool();
+            if (pool.empty())
+                blocks.emplace_back(std::make_unique<Block>());
+            else {
+                blocks.emplace_back(std::move(pool.back()));
+                pool.pop_back();
+            }
+        }
+        return (*blocks[idx >> BlockBits])[idx & (BlockSize - 1)];
+    }
+
+    static void release_blocks(std::vector<BlockPtr> &blocks, size_t size) {
+        std::vector<BlockPtr> &pool = block_pool();
+        for (size_t i = 0; i < blocks.size(); ++ i) {
+            Block &block = *blocks[i];
+            for (size_t j = 0; j < std::min(BlockSize, size - std::min(size, i * BlockSize)); ++ j)
+                block[j].reset();
+            if (pool.size() < MaxPooledBlocks)
+                pool.emplace_back(std::move(blocks[i]));
+        }
+        blocks.clear();
+    }
+
+    std::optional<T>& slot(int64_t pos) {
+        assert(pos != EndPos);
+        size_t idx = pos < 0 ? size_t(- pos - 1) : size_t(pos);
+        return (*(pos < 0 ? m_front : m_back)[idx >> BlockBits])[idx & (BlockSize - 1)];
+    }
+
+    // First occupied position starting with pos, EndPos if there is none.
+    int64_t next_occupied(int64_t pos) {
+        for (; pos < int64_t(m_back_size); ++ pos)
+            if (this->slot(pos).has_value())
+                return pos;
+        return EndPos;
+    }
+
+    void swap(HalfEdgeGraphStorage &rhs) {
+        std::swap(m_front, rhs.m_front);
+        std::swap(m_back, rhs.m_back);
+        std::swap(m_front_size, rhs.m_front_size);
+        std::swap(m_back_size, rhs.m_back_size);
+        std::swap(m_size, rhs.m_size);
+    }
+
+    // Elements added by emplace_front(), in the reverse order of iteration.
+    std::vector<BlockPtr> m_front;
+    // Elements added by emplace_back(), in the order of iteration.
+    std::vector<BlockPtr> m_back;
+    size_t                m_front_size { 0 };
+    size_t                m_back_size  { 0 };
+    // Number of elements not erased.
+    size_t                m_size       { 0 };
+};
+
 template<class node_data_t, class edge_data_t, class derived_node_t, class derived_edge_t> // types of data contained in nodes and edges
 class HalfEdgeGraph
 {
 public:
     using edge_t = derived_edge_t;
     using node_t = derived_node_t;
-    using Edges = std::list<edge_t>;
-    using Nodes = std::list<node_t>;
+    using Edges = HalfEdgeGraphStorage<edge_t>;
+    using Nodes = HalfEdgeGraphStorage<node_t>;
     Edges edges;
     Nodes nodes;
 };
@@ -2,6 +2,7 @@
 //CuraEngine is released under the terms of the AGPLv3 or higher.
 
 #include "Generator.hpp"
+#include "DistanceField.hpp"
 #include "TreeNode.hpp"
 
 #include "../../ClipperUtils.hpp"
@@ -10,6 +11,20 @@
 
 #include "ExPolygon.hpp"
 
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+// See GCode.cpp for the TBB interface differences.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 /* Possible future tasks/optimizations,etc.:
  * - Improve connecting heuristic to favor connecting to shorter trees
  * - Change which node of a tree is the root when that would be better in reconnectRoots.
@@ -63,6 +78,22 @@ Slic3r::SVG draw_two_overhangs_to_svg(size_t ts_layer, const ExPolygons& overhan
 
 namespace Slic3r::FillLightning {
 
+// Infill areas of all layers, the layers are independent of each other.
+static std::vector<Polygons> collect_infill_outlines(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+{
+    std::vector<Polygons> infill_outlines(print_object.layers().size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, infill_outlines.size()), [&print_object, &infill_outlines, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
+            throw_on_cancel_callback();
+            for (const LayerRegion *layerm : print_object.get_layer(int(layer_id))->regions())
+                for (const Surface &surface : layerm->fill_surfaces.surfaces)
+                    if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
+                        append(infill_outlines[layer_id], to_polygons(surface.expolygon));
+        }
+    });
+    return infill_outlines;
+}
+
 Generator::Generator(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
 {
     const PrintConfig         &print_config         = print_object.print()->config();
@@ -96,8 +127,9 @@ Generator::Generator(const PrintObject &print_object, const std::function<void()
     m_prune_length                                    = coord_t(layer_thickness * std::tan(lightning_infill_prune_angle));
     m_straightening_max_distance                      = coord_t(layer_thickness * std::tan(lightning_infill_straightening_angle));
 
-    generateInitialInternalOverhangs(print_object, throw_on_cancel_callback);
-    generateTrees(print_object, throw_on_cancel_callback);
+    const std::vector<Polygons> infill_outlines = collect_infill_outlines(print_object, throw_on_cancel_callback);
+    generateInitialInternalOverhangs(infill_outlines, throw_on_cancel_callback);
+    generateTrees(infill_outlines, throw_on_cancel_callback);
 }
 
 Generator::Generator(PrintObject* m_object, std::vector<Polygons>& contours, std::vector<Polygons>& overhangs, const std::function<void()> &throw_on_cancel_callback, float density)
@@ -138,36 +170,31 @@ Generator::Generator(PrintObject* m_object, std::vector<Polygons>& contours, std
 
     m_overhang_per_layer = overhangs;
 
-    generateTreesforSupport(contours, throw_on_cancel_callback);
+    generateTrees(contours, throw_on_cancel_callback);
 
     //for (size_t i = 0; i < overhangs.size(); i++)
     //{
     //    auto svg = draw_two_overhangs_to_svg(i, to_expolygons(contours[i]), to_expolygons(overhangs[i]));
-    //    for (auto& root : m_lightning_layers[i].tree_roots)
-    //        root->draw_tree(svg);
+    //    for (NodeIdx root : m_lightning_layers[i].tree_roots)
+    //        m_lightning_layers[i].nodes.draw_tree(root, svg);
     //}
 }
 
-void Generator::generateInitialInternalOverhangs(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+void Generator::generateInitialInternalOverhangs(const std::vector<Polygons> &infill_outlines, const std::function<void()> &throw_on_cancel_callback)
 {
-    m_overhang_per_layer.resize(print_object.layers().size());
-
-    Polygons infill_area_above;
-    //Iterate from top to bottom, to subtract the overhang areas above from the overhang areas on the layer below, to get only overhang in the top layer where it is overhanging.
-    for (int layer_nr = int(print_object.layers().size()) - 1; layer_nr >= 0; --layer_nr) {
-        throw_on_cancel_callback();
-        Polygons infill_area_here;
-        for (const LayerRegion* layerm : print_object.get_layer(layer_nr)->regions())
-            for (const Surface& surface : layerm->fill_surfaces.surfaces)
-                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
-                    append(infill_area_here, to_polygons(surface.expolygon));
-
-        //Remove the part of the infill area that is already supported by the walls.
-        Polygons overhang = diff(offset(infill_area_here, -float(m_wall_supporting_radius)), infill_area_above);
-
-        m_overhang_per_layer[layer_nr] = overhang;
-        infill_area_above = std::move(infill_area_here);
-    }
+    m_overhang_per_layer.assign(infill_outlines.size(), Polygons());
+
+    //Subtract the infill area above from the overhang areas on the layer below, to get only overhang in the top layer where it is overhanging.
+    //Each layer only depends on the infill areas, thus the layers are processed in parallel.
+    const Polygons no_infill_above;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, infill_outlines.size()), [this, &infill_outlines, &no_infill_above, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_nr = range.begin(); layer_nr < range.end(); ++ layer_nr) {
+            throw_on_cancel_callback();
+            const Polygons &infill_area_above = layer_nr + 1 < infill_outlines.size() ? infill_outlines[layer_nr + 1] : no_infill_above;
+            //Remove the part of the infill area that is already supported by the walls.
+            m_overhang_per_layer[layer_nr] = diff(offset(infill_outlines[layer_nr], -float(m_wall_supporting_radius)), infill_area_above);
+        }
+    });
 }
 
 const Layer& Generator::getTreesForLayer(const size_t& layer_id) const
@@ -176,110 +203,97 @@ const Layer& Generator::getTreesForLayer(const size_t& layer_id) const
     return m_lightning_layers[layer_id];
 }
 
-void Generator::generateTrees(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+void Generator::generateTrees(const std::vector<Polygons> &infill_outlines, const std::function<void()> &throw_on_cancel_callback)
 {
-    const auto _locator_cell_size = locator_cell_size();
-    m_lightning_layers.resize(print_object.layers().size());
-    bboxs.resize(print_object.layers().size());
-    std::vector<Polygons> infill_outlines(print_object.layers().size(), Polygons());
-
-    // For-each layer from top to bottom:
-    for (int layer_id = int(print_object.layers().size()) - 1; layer_id >= 0; layer_id--) {
-        throw_on_cancel_callback();
-        for (const LayerRegion *layerm : print_object.get_layer(layer_id)->regions())
-            for (const Surface &surface : layerm->fill_surfaces.surfaces)
-                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
-                    append(infill_outlines[layer_id], to_polygons(surface.expolygon));
-    }
-
-    // For various operations its beneficial to quickly locate nearby features on the polygon:
-    const size_t top_layer_id = print_object.layers().size() - 1;
-    EdgeGrid::Grid outlines_locator(get_extents(infill_outlines[top_layer_id]).inflated(SCALED_EPSILON));
-    outlines_locator.create(infill_outlines[top_layer_id], _locator_cell_size);
-
-    // For-each layer from top to bottom:
-    for (int layer_id = int(top_layer_id); layer_id >= 0; layer_id--) {
-        throw_on_cancel_callback();
-        Layer             &current_lightning_layer = m_lightning_layers[layer_id];
-        const Polygons    &current_outlines        = infill_outlines[layer_id];
-        const BoundingBox &current_outlines_bbox   = get_extents(current_outlines);
-
-        bboxs[layer_id] = get_extents(current_outlines);
-
-        // register all trees propagated from the previous layer as to-be-reconnected
-        std::vector<NodeSPtr> to_be_reconnected_tree_roots = current_lightning_layer.tree_roots;
-
-        current_lightning_layer.generateNewTrees(m_overhang_per_layer[layer_id], current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback);
-        current_lightning_layer.reconnectRoots(to_be_reconnected_tree_roots, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius);
-
-        // Initialize trees for next lower layer from the current one.
-        if (layer_id == 0)
-            return;
-
-        const Polygons &below_outlines      = infill_outlines[layer_id - 1];
-        BoundingBox     below_outlines_bbox = get_extents(below_outlines).inflated(SCALED_EPSILON);
-        if (const BoundingBox &outlines_locator_bbox = outlines_locator.bbox(); outlines_locator_bbox.defined)
-            below_outlines_bbox.merge(outlines_locator_bbox);
-
-        if (!current_lightning_layer.tree_roots.empty())
-            below_outlines_bbox.merge(get_extents(current_lightning_layer.tree_roots).inflated(SCALED_EPSILON));
-
-        outlines_locator.set_bbox(below_outlines_bbox);
-        outlines_locator.create(below_outlines, _locator_cell_size);
-
-        std::vector<NodeSPtr>& lower_trees = m_lightning_layers[layer_id - 1].tree_roots;
-        for (auto& tree : current_lightning_layer.tree_roots)
-            tree->propagateToNextLayer(lower_trees, below_outlines, outlines_locator, m_prune_length, m_straightening_max_distance, _locator_cell_size / 2);
+    if (infill_outlines.empty())
+        return;
+
+    const auto   _locator_cell_size = locator_cell_size();
+    const size_t num_layers         = infill_outlines.size();
+    m_lightning_layers.resize(num_layers);
+    bboxs.assign(num_layers, BoundingBox());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [this, &infill_outlines](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id)
+            bboxs[layer_id] = get_extents(infill_outlines[layer_id]);
+    });
+
+    // The outlines locator of a layer spans the outlines of this layer and of all the layers above,
+    // thus the trees propagated from the layers above are covered as well.
+    std::vector<BoundingBox> outlines_locator_bboxes(num_layers);
+    for (int layer_id = int(num_layers) - 1; layer_id >= 0; -- layer_id) {
+        outlines_locator_bboxes[layer_id] = bboxs[layer_id].inflated(SCALED_EPSILON);
+        if (layer_id + 1 < int(num_layers) && outlines_locator_bboxes[layer_id + 1].defined)
+            outlines_locator_bboxes[layer_id].merge(outlines_locator_bboxes[layer_id + 1]);
     }
-}
-
-void Generator::generateTreesforSupport(std::vector<Polygons>& contours, const std::function<void()> &throw_on_cancel_callback)
-{
-    if (contours.empty()) return;
-
-    m_lightning_layers.resize(contours.size());
-    bboxs.resize(contours.size());
-
-    const auto _locator_cell_size = locator_cell_size();
-    // For various operations its beneficial to quickly locate nearby features on the polygon:
-    const size_t top_layer_id = contours.size() - 1;
-    EdgeGrid::Grid outlines_locator(get_extents(contours[top_layer_id]).inflated(SCALED_EPSILON));
-    outlines_locator.create(contours[top_layer_id], _locator_cell_size);
-
-    // For-each layer from top to bottom:
-    for (int layer_id = int(top_layer_id); layer_id >= 0; layer_id--) {
-		throw_on_cancel_callback();
-        Layer& current_lightning_layer = m_lightning_layers[layer_id];
-        const Polygons& current_outlines = contours[layer_id];
-        const BoundingBox& current_outlines_bbox = get_extents(current_outlines);
-
-        bboxs[layer_id] = get_extents(current_outlines);
 
-        // register all trees propagated from the previous layer as to-be-reconnected
-        std::vector<NodeSPtr> to_be_reconnected_tree_roots = current_lightning_layer.tree_roots;
-
-        current_lightning_layer.generateNewTrees(m_overhang_per_layer[layer_id], current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback);
-        current_lightning_layer.reconnectRoots(to_be_reconnected_tree_roots, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius);
-
-        // Initialize trees for next lower layer from the current one.
-        if (layer_id == 0)
-            return;
-
-        const Polygons& below_outlines = contours[layer_id - 1];
-        BoundingBox     below_outlines_bbox = get_extents(below_outlines).inflated(SCALED_EPSILON);
-        if (const BoundingBox& outlines_locator_bbox = outlines_locator.bbox(); outlines_locator_bbox.defined)
-            below_outlines_bbox.merge(outlines_locator_bbox);
-
-        if (!current_lightning_layer.tree_roots.empty())
-            below_outlines_bbox.merge(get_extents(current_lightning_layer.tree_roots).inflated(SCALED_EPSILON));
-
-        outlines_locator.set_bbox(below_outlines_bbox);
-        outlines_locator.create(below_outlines, _locator_cell_size);
-
-        std::vector<NodeSPtr>& lower_trees = m_lightning_layers[layer_id - 1].tree_roots;
-        for (auto& tree : current_lightning_layer.tree_roots)
-            tree->propagateToNextLayer(lower_trees, below_outlines, outlines_locator, m_prune_length, m_straightening_max_distance, _locator_cell_size / 2);
-    }
+    // Data of a layer, which does not depend on the trees: For various operations its beneficial to quickly locate
+    // nearby features on the polygon, and the distance field is seeded with the overhang to be supported.
+    struct PreparedLayer
+    {
+        PreparedLayer(const Polygons &outlines, const BoundingBox &outlines_bbox, const BoundingBox &outlines_locator_bbox, const Polygons &overhang, coord_t cell_size, coord_t supporting_radius) :
+            outlines_locator(outlines_locator_bbox), distance_field(supporting_radius, outlines, outlines_bbox, overhang)
+        {
+            outlines_locator.create(outlines, cell_size);
+        }
+
+        EdgeGrid::Grid outlines_locator;
+        DistanceField  distance_field;
+    };
+    std::vector<std::unique_ptr<PreparedLayer>> prepared_layers(num_layers);
+
+    // The layers are prepared in parallel ahead of the propagation front, which runs from top to bottom layer by layer.
+    int        next_layer_id = int(num_layers) - 1;
+    const auto generator     = tbb::make_filter<void, int>(slic3r_tbb_filtermode::serial_in_order,
+        [&next_layer_id](tbb::flow_control &fc) -> int {
+            if (next_layer_id < 0) {
+                fc.stop();
+                return -1;
+            }
+            return next_layer_id --;
+        });
+    const auto prepare = tbb::make_filter<int, int>(slic3r_tbb_filtermode::parallel,
+        [this, &infill_outlines, &outlines_locator_bboxes, &prepared_layers, _locator_cell_size, &throw_on_cancel_callback](int layer_id) -> int {
+            throw_on_cancel_callback();
+            prepared_layers[layer_id] = std::make_unique<PreparedLayer>(infill_outlines[layer_id], bboxs[layer_id], outlines_locator_bboxes[layer_id],
+                m_overhang_per_layer[layer_id], _locator_cell_size, m_supporting_radius);
+            return layer_id;
+        });
+    const auto propagate = tbb::make_filter<int, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &infill_outlines, &prepared_layers, _locator_cell_size, &throw_on_cancel_callback](int layer_id) {
+            throw_on_cancel_callback();
+            // Release the prepared data together with this layer.
+            std::unique_ptr<PreparedLayer> prepared_layer   = std::move(prepared_layers[layer_id]);
+            EdgeGrid::Grid                &outlines_locator = prepared_layer->outlines_locator;
+            Layer                         &current_lightning_layer = m_lightning_layers[layer_id];
+            const Polygons                &current_outlines        = infill_outlines[layer_id];
+            const BoundingBox             &current_outlines_bbox   = bboxs[layer_id];
+
+            // Initialize trees for this layer from the one above.
+            if (layer_id + 1 < int(m_lightning_layers.size())) {
+                const Layer &upper_layer = m_lightning_layers[layer_id + 1];
+                if (! upper_layer.tree_roots.empty()) {
+                    BoundingBox trees_bbox = upper_layer.nodes.get_extents(upper_layer.tree_roots).inflated(SCALED_EPSILON);
+                    if (! outlines_locator.bbox().contains(trees_bbox)) {
+                        // Straightening moved some of the trees out of the outlines above, cover them by the locator.
+                        trees_bbox.merge(outlines_locator.bbox());
+                        outlines_locator.set_bbox(trees_bbox);
+                        outlines_locator.create(current_outlines, _locator_cell_size);
+                    }
+                    current_lightning_layer.nodes.reserve(upper_layer.nodes.size());
+                    for (NodeIdx tree : upper_layer.tree_roots)
+                        upper_layer.nodes.propagateToNextLayer(tree, current_lightning_layer.nodes, current_lightning_layer.tree_roots, current_outlines, outlines_locator, m_prune_length, m_straightening_max_distance, _locator_cell_size / 2);
+                }
+            }
+
+            // register all trees propagated from the previous layer as to-be-reconnected
+            std::vector<NodeIdx> to_be_reconnected_tree_roots = current_lightning_layer.tree_roots;
+
+            current_lightning_layer.generateNewTrees(prepared_layer->distance_field, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback);
+            current_lightning_layer.reconnectRoots(to_be_reconnected_tree_roots, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius);
+        });
+
+    // Each layer in flight holds its edge grid and distance field, thus only a few layers per thread are prepared ahead.
+    tbb::parallel_pipeline(size_t(2 * std::max(1, tbb::this_task_arena::max_concurrency())), generator & prepare & propagate);
 }
 
 } // namespace Slic3r::FillLightning
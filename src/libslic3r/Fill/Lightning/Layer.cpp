@@ -21,29 +21,46 @@ coord_t Layer::getWeightedDistance(const Point& boundary_loc, const Point& unsup
     return coord_t((boundary_loc - unsupported_location).cast<double>().norm());
 }
 
-Point GroundingLocation::p() const
+Point GroundingLocation::p(const NodePool &nodes) const
 {
-    assert(tree_node || boundary_location);
-    return tree_node ? tree_node->getLocation() : *boundary_location;
+    assert(tree_node != NoNode || boundary_location);
+    return tree_node != NoNode ? nodes[tree_node].getLocation() : *boundary_location;
 }
 
-inline static Point to_grid_point(const Point &point, const BoundingBox &bbox)
+NodeLocator::NodeLocator(const BoundingBox &bbox)
 {
-    return (point - bbox.min) / locator_cell_size();
+    if (bbox.defined) {
+        m_bbox_min = bbox.min;
+        m_cols     = (bbox.max.x() - bbox.min.x()) / locator_cell_size() + 1;
+        m_rows     = (bbox.max.y() - bbox.min.y()) / locator_cell_size() + 1;
+    } else {
+        m_bbox_min = Point::Zero();
+        m_cols     = 1;
+        m_rows     = 1;
+    }
+    m_cell_heads.assign(size_t(m_cols) * size_t(m_rows), NoEntry);
 }
 
-void Layer::fillLocator(SparseNodeGrid &tree_node_locator, const BoundingBox& current_outlines_bbox)
+void NodeLocator::insert(const Point &p, NodeIdx node)
 {
-    std::function<void(NodeSPtr)> add_node_to_locator_func = [&tree_node_locator, &current_outlines_bbox](const NodeSPtr &node) {
-        tree_node_locator.insert(std::make_pair(to_grid_point(node->getLocation(), current_outlines_bbox), node));
+    const Point c    = this->cell(p);
+    uint32_t   &head = m_cell_heads[c.y() * m_cols + c.x()];
+    m_entries.push_back({ node, head });
+    head = uint32_t(m_entries.size() - 1);
+}
+
+void Layer::fillLocator(NodeLocator &tree_node_locator) const
+{
+    std::function<void(NodeIdx)> add_node_to_locator_func = [this, &tree_node_locator](NodeIdx node) {
+        tree_node_locator.insert(nodes[node].getLocation(), node);
     };
-    for (auto& tree : tree_roots)
-        tree->visitNodes(add_node_to_locator_func);
+    for (NodeIdx tree : tree_roots)
+        nodes.visitNodes(tree, add_node_to_locator_func);
 }
 
 void Layer::generateNewTrees
 (
-    const Polygons& current_overhang,
+    DistanceField& distance_field,
     const Polygons& current_outlines,
     const BoundingBox& current_outlines_bbox,
     const EdgeGrid::Grid& outlines_locator,
@@ -52,11 +69,8 @@ void Layer::generateNewTrees
     const std::function<void()> &throw_on_cancel_callback
 )
 {
-    DistanceField distance_field(supporting_radius, current_outlines, current_outlines_bbox, current_overhang);
-    throw_on_cancel_callback();
-
-    SparseNodeGrid tree_node_locator;
-    fillLocator(tree_node_locator, current_outlines_bbox);
+    NodeLocator tree_node_locator(current_outlines_bbox);
+    fillLocator(tree_node_locator);
 
     // Until no more points need to be added to support all:
     // Determine next point from tree/outline areas via distance-field
@@ -67,20 +81,20 @@ void Layer::generateNewTrees
         GroundingLocation grounding_loc = getBestGroundingLocation(
             unsupported_location, current_outlines, current_outlines_bbox, outlines_locator, supporting_radius, wall_supporting_radius, tree_node_locator);
 
-        NodeSPtr new_parent;
-        NodeSPtr new_child;
+        NodeIdx new_parent = NoNode;
+        NodeIdx new_child  = NoNode;
         this->attach(unsupported_location, grounding_loc, new_child, new_parent);
-        tree_node_locator.insert(std::make_pair(to_grid_point(new_child->getLocation(), current_outlines_bbox), new_child));
-        if (new_parent)
-            tree_node_locator.insert(std::make_pair(to_grid_point(new_parent->getLocation(), current_outlines_bbox), new_parent));
+        tree_node_locator.insert(nodes[new_child].getLocation(), new_child);
+        if (new_parent != NoNode)
+            tree_node_locator.insert(nodes[new_parent].getLocation(), new_parent);
         // update distance field
-        distance_field.update(grounding_loc.p(), unsupported_location);
+        distance_field.update(grounding_loc.p(nodes), unsupported_location);
     }
 
 #ifdef LIGHTNING_TREE_NODE_DEBUG_OUTPUT
     {
         static int iRun = 0;
-        export_to_svg(debug_out_path("FillLightning-TreeNodes-%d.svg", iRun++), current_outlines, this->tree_roots);
+        export_to_svg(debug_out_path("FillLightning-TreeNodes-%d.svg", iRun++), current_outlines, this->nodes, this->tree_roots);
     }
 #endif /* LIGHTNING_TREE_NODE_DEBUG_OUTPUT */
 }
@@ -122,8 +136,8 @@ GroundingLocation Layer::getBestGroundingLocation
     const EdgeGrid::Grid& outline_locator,
     const coord_t supporting_radius,
     const coord_t wall_supporting_radius,
-    const SparseNodeGrid& tree_node_locator,
-    const NodeSPtr& exclude_tree
+    const NodeLocator& tree_node_locator,
+    NodeIdx exclude_tree
 )
 {
     // Closest point on current_outlines to unsupported_location:
@@ -146,34 +160,33 @@ GroundingLocation Layer::getBestGroundingLocation
 
     const auto within_dist = coord_t((node_location - unsupported_location).cast<double>().norm());
 
-    NodeSPtr sub_tree{nullptr};
+    NodeIdx  sub_tree = NoNode;
     coord_t  current_dist = getWeightedDistance(node_location, unsupported_location);
     if (current_dist >= wall_supporting_radius) { // Only reconnect tree roots to other trees if they are not already close to the outlines.
         const coord_t search_radius = std::min(current_dist, within_dist);
         BoundingBox region(unsupported_location - Point(search_radius, search_radius), unsupported_location + Point(search_radius + locator_cell_size(), search_radius + locator_cell_size()));
-        region.min = to_grid_point(region.min, current_outlines_bbox);
-        region.max = to_grid_point(region.max, current_outlines_bbox);
+        // Inclusive range of the grid cells, clamped to the grid the same way the nodes were binned.
+        region.min = tree_node_locator.cell(region.min);
+        region.max = tree_node_locator.cell(region.max - Point(1, 1));
 
         Point      current_dist_grid_addr{std::numeric_limits<coord_t>::lowest(), std::numeric_limits<coord_t>::lowest()};
         std::mutex current_dist_mutex;
-        tbb::parallel_for(tbb::blocked_range2d<coord_t>(region.min.y(), region.max.y(), region.min.x(), region.max.x()), [&current_dist, current_dist_copy = current_dist, &current_dist_mutex, &sub_tree, &current_dist_grid_addr, &exclude_tree = std::as_const(exclude_tree), &outline_locator = std::as_const(outline_locator), &supporting_radius = std::as_const(supporting_radius), &tree_node_locator = std::as_const(tree_node_locator), &unsupported_location = std::as_const(unsupported_location)](const tbb::blocked_range2d<coord_t> &range) -> void {
+        tbb::parallel_for(tbb::blocked_range2d<coord_t>(region.min.y(), region.max.y() + 1, region.min.x(), region.max.x() + 1), [this, &current_dist, current_dist_copy = current_dist, &current_dist_mutex, &sub_tree, &current_dist_grid_addr, exclude_tree, &outline_locator = std::as_const(outline_locator), &supporting_radius = std::as_const(supporting_radius), &tree_node_locator = std::as_const(tree_node_locator), &unsupported_location = std::as_const(unsupported_location)](const tbb::blocked_range2d<coord_t> &range) -> void {
             for (coord_t grid_addr_y = range.rows().begin(); grid_addr_y < range.rows().end(); ++grid_addr_y)
                 for (coord_t grid_addr_x = range.cols().begin(); grid_addr_x < range.cols().end(); ++grid_addr_x) {
                     const Point local_grid_addr{grid_addr_x, grid_addr_y};
-                    NodeSPtr    local_sub_tree{nullptr};
+                    NodeIdx     local_sub_tree     = NoNode;
                     coord_t     local_current_dist = current_dist_copy;
-                    const auto  it_range           = tree_node_locator.equal_range(local_grid_addr);
-                    for (auto it = it_range.first; it != it_range.second; ++it) {
-                        const NodeSPtr candidate_sub_tree = it->second.lock();
-                        if ((candidate_sub_tree && candidate_sub_tree != exclude_tree) &&
-                            !(exclude_tree && exclude_tree->hasOffspring(candidate_sub_tree)) &&
-                            !polygonCollidesWithLineSegment(unsupported_location, candidate_sub_tree->getLocation(), outline_locator)) {
-                            if (const coord_t candidate_dist = candidate_sub_tree->getWeightedDistance(unsupported_location, supporting_radius); candidate_dist < local_current_dist) {
+                    tree_node_locator.visit_cell(local_grid_addr, [&](NodeIdx candidate_sub_tree) {
+                        if (candidate_sub_tree != exclude_tree &&
+                            !(exclude_tree != NoNode && nodes.hasOffspring(exclude_tree, candidate_sub_tree)) &&
+                            !polygonCollidesWithLineSegment(unsupported_location, nodes[candidate_sub_tree].getLocation(), outline_locator)) {
+                            if (const coord_t candidate_dist = nodes.getWeightedDistance(candidate_sub_tree, unsupported_location, supporting_radius); candidate_dist < local_current_dist) {
                                 local_current_dist = candidate_dist;
                                 local_sub_tree     = candidate_sub_tree;
                             }
                         }
-                    }
+                    });
                     // To always get the same result in a parallel version as in a non-parallel version,
                     // we need to preserve that for the same current_dist, we select the same sub_tree
                     // as in the non-parallel version. For this purpose, inside the variable
@@ -194,32 +207,32 @@ GroundingLocation Layer::getBestGroundingLocation
         }); // end of parallel_for
     }
 
-    return ! sub_tree ?
-        GroundingLocation{ nullptr, node_location } :
+    return sub_tree == NoNode ?
+        GroundingLocation{ NoNode, node_location } :
         GroundingLocation{ sub_tree, std::optional<Point>() };
 }
 
 bool Layer::attach(
     const Point& unsupported_location,
     const GroundingLocation& grounding_loc,
-    NodeSPtr& new_child,
-    NodeSPtr& new_root)
+    NodeIdx& new_child,
+    NodeIdx& new_root)
 {
     // Update trees & distance fields.
     if (grounding_loc.boundary_location) {
-        new_root = Node::create(grounding_loc.p(), std::make_optional(grounding_loc.p()));
-        new_child = new_root->addChild(unsupported_location);
+        new_root = nodes.create(grounding_loc.p(nodes), std::make_optional(grounding_loc.p(nodes)));
+        new_child = nodes.addChild(new_root, unsupported_location);
         tree_roots.push_back(new_root);
         return true;
     } else {
-        new_child = grounding_loc.tree_node->addChild(unsupported_location);
+        new_child = nodes.addChild(grounding_loc.tree_node, unsupported_location);
         return false;
     }
 }
 
 void Layer::reconnectRoots
 (
-    std::vector<NodeSPtr>& to_be_reconnected_tree_roots,
+    const std::vector<NodeIdx>& to_be_reconnected_tree_roots,
     const Polygons& current_outlines,
     const BoundingBox& current_outlines_bbox,
     const EdgeGrid::Grid& outline_locator,
@@ -229,29 +242,29 @@ void Layer::reconnectRoots
 {
     constexpr coord_t tree_connecting_ignore_offset = 100;
 
-    SparseNodeGrid tree_node_locator;
-    fillLocator(tree_node_locator, current_outlines_bbox);
+    NodeLocator tree_node_locator(current_outlines_bbox);
+    fillLocator(tree_node_locator);
 
     const coord_t within_max_dist = outline_locator.resolution() * 2;
-    for (const auto &root_ptr : to_be_reconnected_tree_roots)
+    for (const NodeIdx root_ptr : to_be_reconnected_tree_roots)
     {
         auto old_root_it = std::find(tree_roots.begin(), tree_roots.end(), root_ptr);
 
-        if (root_ptr->getLastGroundingLocation())
+        if (nodes[root_ptr].getLastGroundingLocation())
         {
-            const Point& ground_loc = *root_ptr->getLastGroundingLocation();
-            if (ground_loc != root_ptr->getLocation())
+            const Point ground_loc = *nodes[root_ptr].getLastGroundingLocation();
+            if (ground_loc != nodes[root_ptr].getLocation())
             {
                 Point new_root_pt;
                 // Find an intersection of the line segment from root_ptr->getLocation() to ground_loc, at within_max_dist from ground_loc.
-                if (lineSegmentPolygonsIntersection(root_ptr->getLocation(), ground_loc, outline_locator, new_root_pt, within_max_dist)) {
-                    auto new_root = Node::create(new_root_pt, new_root_pt);
-                    root_ptr->addChild(new_root);
-                    new_root->reroot();
+                if (lineSegmentPolygonsIntersection(nodes[root_ptr].getLocation(), ground_loc, outline_locator, new_root_pt, within_max_dist)) {
+                    NodeIdx new_root = nodes.create(new_root_pt, new_root_pt);
+                    nodes.addChild(root_ptr, new_root);
+                    nodes.reroot(new_root);
 
-                    tree_node_locator.insert(std::make_pair(to_grid_point(new_root->getLocation(), current_outlines_bbox), new_root));
+                    tree_node_locator.insert(nodes[new_root].getLocation(), new_root);
 
-                    *old_root_it = std::move(new_root); // replace old root with new root
+                    *old_root_it = new_root; // replace old root with new root
                     continue;
                 }
             }
@@ -261,7 +274,7 @@ void Layer::reconnectRoots
         GroundingLocation ground =
             getBestGroundingLocation
             (
-                root_ptr->getLocation(),
+                nodes[root_ptr].getLocation(),
                 current_outlines,
                 current_outlines_bbox,
                 outline_locator,
@@ -272,32 +285,32 @@ void Layer::reconnectRoots
             );
         if (ground.boundary_location)
         {
-            if (*ground.boundary_location == root_ptr->getLocation())
+            if (*ground.boundary_location == nodes[root_ptr].getLocation())
                 continue; // Already on the boundary.
 
-            auto new_root = Node::create(ground.p(), ground.p());
-            auto attach_ptr = root_ptr->closestNode(new_root->getLocation());
-            attach_ptr->reroot();
+            NodeIdx new_root = nodes.create(ground.p(nodes), ground.p(nodes));
+            NodeIdx attach_ptr = nodes.closestNode(root_ptr, nodes[new_root].getLocation());
+            nodes.reroot(attach_ptr);
 
-            new_root->addChild(attach_ptr);
-            tree_node_locator.insert(std::make_pair(to_grid_point(new_root->getLocation(), current_outlines_bbox), new_root));
+            nodes.addChild(new_root, attach_ptr);
+            tree_node_locator.insert(nodes[new_root].getLocation(), new_root);
 
-            *old_root_it = std::move(new_root); // replace old root with new root
+            *old_root_it = new_root; // replace old root with new root
         }
         else
         {
-            assert(ground.tree_node);
+            assert(ground.tree_node != NoNode);
             assert(ground.tree_node != root_ptr);
-            assert(!root_ptr->hasOffspring(ground.tree_node));
-            assert(!ground.tree_node->hasOffspring(root_ptr));
+            assert(!nodes.hasOffspring(root_ptr, ground.tree_node));
+            assert(!nodes.hasOffspring(ground.tree_node, root_ptr));
 
-            auto attach_ptr = root_ptr->closestNode(ground.tree_node->getLocation());
-            attach_ptr->reroot();
+            NodeIdx attach_ptr = nodes.closestNode(root_ptr, nodes[ground.tree_node].getLocation());
+            nodes.reroot(attach_ptr);
 
-            ground.tree_node->addChild(attach_ptr);
+            nodes.addChild(ground.tree_node, attach_ptr);
 
             // remove old root
-            *old_root_it = std::move(tree_roots.back());
+            *old_root_it = tree_roots.back();
             tree_roots.pop_back();
         }
     }
@@ -439,8 +452,8 @@ Polylines Layer::convertToLines(const Polygons& limit_to_outline, const coord_t
         return {};
 
     Polylines result_lines;
-    for (const auto &tree : tree_roots)
-        tree->convertToPolylines(result_lines, line_overlap);
+    for (NodeIdx tree : tree_roots)
+        nodes.convertToPolylines(tree, result_lines, line_overlap);
 
     return intersection_pl(result_lines, limit_to_outline);
 }
@@ -6,25 +6,64 @@
 
 #include "../../EdgeGrid.hpp"
 #include "../../Polygon.hpp"
+#include "TreeNode.hpp"
 
-#include <memory>
+#include <algorithm>
+#include <limits>
 #include <vector>
-#include <list>
-#include <unordered_map>
 #include <optional>
 
 namespace Slic3r::FillLightning
 {
 
-class Node;
-using NodeSPtr = std::shared_ptr<Node>;
-using SparseNodeGrid = std::unordered_multimap<Point, std::weak_ptr<Node>, PointHash>;
+class DistanceField;
+
+/*!
+ * Tree nodes of a layer binned into the cells of a dense grid of locator_cell_size() spanning the outlines of the layer.
+ *
+ * Each cell holds a singly linked list of its nodes, the list entries are allocated from a single vector.
+ * Nodes outside of the outlines are binned into the border cells, and queries outside of the grid are clamped
+ * the same way, thus no node is missed.
+ */
+class NodeLocator
+{
+public:
+    explicit NodeLocator(const BoundingBox &bbox);
+
+    // Grid address of the cell containing the point.
+    Point cell(const Point &p) const {
+        return { std::clamp<coord_t>((p.x() - m_bbox_min.x()) / locator_cell_size(), 0, m_cols - 1),
+                 std::clamp<coord_t>((p.y() - m_bbox_min.y()) / locator_cell_size(), 0, m_rows - 1) };
+    }
+
+    void insert(const Point &p, NodeIdx node);
+
+    // Call visitor(NodeIdx) for all nodes binned into a cell returned by cell().
+    template<typename Visitor> void visit_cell(const Point &cell, Visitor &&visitor) const {
+        for (uint32_t i = m_cell_heads[cell.y() * m_cols + cell.x()]; i != NoEntry; i = m_entries[i].next)
+            visitor(m_entries[i].node);
+    }
+
+private:
+    static constexpr uint32_t NoEntry = std::numeric_limits<uint32_t>::max();
+    struct Entry {
+        NodeIdx  node;
+        uint32_t next;
+    };
+
+    Point                 m_bbox_min;
+    coord_t               m_cols;
+    coord_t               m_rows;
+    // Index of the first entry of each cell, row major.
+    std::vector<uint32_t> m_cell_heads;
+    std::vector<Entry>    m_entries;
+};
 
 struct GroundingLocation
 {
-    NodeSPtr tree_node; //!< not null if the gounding location is on a tree
+    NodeIdx tree_node { NoNode }; //!< valid if the gounding location is on a tree
     std::optional<Point> boundary_location; //!< in case the gounding location is on the boundary
-    Point p() const;
+    Point p(const NodePool &nodes) const;
 };
 
 /*!
@@ -35,11 +74,14 @@ struct GroundingLocation
 class Layer
 {
 public:
-    std::vector<NodeSPtr> tree_roots;
+    // All nodes of the trees of this layer.
+    NodePool nodes;
+    std::vector<NodeIdx> tree_roots;
 
+    // The distance field is seeded with the overhang of this layer by the caller, thus it may be prepared ahead of time.
     void generateNewTrees
     (
-        const Polygons& current_overhang,
+        DistanceField& distance_field,
         const Polygons& current_outlines,
         const BoundingBox& current_outlines_bbox,
         const EdgeGrid::Grid& outline_locator,
@@ -59,8 +101,8 @@ public:
         const EdgeGrid::Grid& outline_locator,
         coord_t supporting_radius,
         coord_t wall_supporting_radius,
-        const SparseNodeGrid& tree_node_locator,
-        const NodeSPtr& exclude_tree = nullptr
+        const NodeLocator& tree_node_locator,
+        NodeIdx exclude_tree = NoNode
     );
 
     /*!
@@ -68,11 +110,11 @@ public:
      * \param[out] new_root The new root node if one had been made
      * \return Whether a new root was added
      */
-    bool attach(const Point& unsupported_location, const GroundingLocation& ground, NodeSPtr& new_child, NodeSPtr& new_root);
+    bool attach(const Point& unsupported_location, const GroundingLocation& ground, NodeIdx& new_child, NodeIdx& new_root);
 
     void reconnectRoots
     (
-        std::vector<NodeSPtr>& to_be_reconnected_tree_roots,
+        const std::vector<NodeIdx>& to_be_reconnected_tree_roots,
         const Polygons& current_outlines,
         const BoundingBox& current_outlines_bbox,
         const EdgeGrid::Grid& outline_locator,
@@ -84,7 +126,7 @@ public:
 
     coord_t getWeightedDistance(const Point& boundary_loc, const Point& unsupported_location);
 
-    void fillLocator(SparseNodeGrid& tree_node_locator, const BoundingBox& current_outlines_bbox);
+    void fillLocator(NodeLocator& tree_node_locator) const;
 };
 
 } // namespace Slic3r::FillLightning
@@ -7,131 +7,145 @@
 
 namespace Slic3r::FillLightning {
 
-coord_t Node::getWeightedDistance(const Point& unsupported_location, const coord_t& supporting_radius) const
+coord_t NodePool::getWeightedDistance(NodeIdx node, const Point& unsupported_location, const coord_t& supporting_radius) const
 {
     constexpr coord_t min_valence_for_boost = 0;
     constexpr coord_t max_valence_for_boost = 4;
     constexpr coord_t valence_boost_multiplier = 4;
 
-    const size_t valence = (!m_is_root) + m_children.size();
+    const Node &n = m_nodes[node];
+    const size_t valence = (!n.m_is_root) + n.m_children.size();
     const coord_t valence_boost = (min_valence_for_boost < valence && valence < max_valence_for_boost) ? valence_boost_multiplier * supporting_radius : 0;
-    const auto dist_here = coord_t((getLocation() - unsupported_location).cast<double>().norm());
+    const auto dist_here = coord_t((n.getLocation() - unsupported_location).cast<double>().norm());
     return dist_here - valence_boost;
 }
 
-bool Node::hasOffspring(const NodeSPtr& to_be_checked) const
+bool NodePool::hasOffspring(NodeIdx node, NodeIdx to_be_checked) const
 {
-    if (to_be_checked == shared_from_this())
+    if (to_be_checked == node)
         return true;
 
-    for (auto& child_ptr : m_children)
-        if (child_ptr->hasOffspring(to_be_checked)) 
+    for (NodeIdx child : m_nodes[node].m_children)
+        if (hasOffspring(child, to_be_checked))
             return true;
 
     return false;
 }
 
-NodeSPtr Node::addChild(const Point& child_loc)
+NodeIdx NodePool::create(const Point& p, const std::optional<Point>& last_grounding_location /*= std::nullopt*/)
 {
-    assert(m_p != child_loc);
-    NodeSPtr child = Node::create(child_loc);
-    return addChild(child);
+    assert(m_nodes.size() < size_t(NoNode));
+    m_nodes.emplace_back(p, last_grounding_location);
+    return NodeIdx(m_nodes.size() - 1);
 }
 
-NodeSPtr Node::addChild(NodeSPtr& new_child)
+NodeIdx NodePool::addChild(NodeIdx parent, const Point& child_loc)
 {
-    assert(new_child != shared_from_this());
+    assert(m_nodes[parent].m_p != child_loc);
+    NodeIdx child = create(child_loc);
+    return addChild(parent, child);
+}
+
+NodeIdx NodePool::addChild(NodeIdx parent, NodeIdx new_child)
+{
+    assert(new_child != parent);
     //assert(p != new_child->p); // NOTE: No problem for now. Issue to solve later. Maybe even afetr final. Low prio.
-    m_children.push_back(new_child);
-    new_child->m_parent = shared_from_this();
-    new_child->m_is_root = false;
+    m_nodes[parent].m_children.push_back(new_child);
+    Node &child = m_nodes[new_child];
+    child.m_parent  = parent;
+    child.m_is_root = false;
     return new_child;
 }
 
-void Node::propagateToNextLayer(
-    std::vector<NodeSPtr>& next_trees,
+void NodePool::propagateToNextLayer(
+    NodeIdx node,
+    NodePool& next_pool,
+    std::vector<NodeIdx>& next_trees,
     const Polygons& next_outlines,
     const EdgeGrid::Grid& outline_locator,
     const coord_t prune_distance,
     const coord_t smooth_magnitude,
     const coord_t max_remove_colinear_dist) const
 {
-    auto tree_below = deepCopy();
-    tree_below->prune(prune_distance);
-    tree_below->straighten(smooth_magnitude, max_remove_colinear_dist);
-    if (tree_below->realign(next_outlines, outline_locator, next_trees))
+    NodeIdx tree_below = deepCopy(node, next_pool);
+    next_pool.prune(tree_below, prune_distance);
+    next_pool.straighten(tree_below, smooth_magnitude, max_remove_colinear_dist);
+    if (next_pool.realign(tree_below, next_outlines, outline_locator, next_trees))
         next_trees.push_back(tree_below);
 }
 
 // NOTE: Depth-first, as currently implemented.
 //       Skips the root (because that has no root itself), but all initial nodes will have the root point anyway.
-void Node::visitBranches(const std::function<void(const Point&, const Point&)>& visitor) const
+void NodePool::visitBranches(NodeIdx node, const std::function<void(const Point&, const Point&)>& visitor) const
 {
-    for (const auto& node : m_children) {
-        assert(node->m_parent.lock() == shared_from_this());
-        visitor(m_p, node->m_p);
-        node->visitBranches(visitor);
+    for (NodeIdx child : m_nodes[node].m_children) {
+        assert(m_nodes[child].m_parent == node);
+        visitor(m_nodes[node].m_p, m_nodes[child].m_p);
+        visitBranches(child, visitor);
     }
 }
 
 // NOTE: Depth-first, as currently implemented.
-void Node::visitNodes(const std::function<void(NodeSPtr)>& visitor)
+void NodePool::visitNodes(NodeIdx node, const std::function<void(NodeIdx)>& visitor) const
 {
-    visitor(shared_from_this());
-    for (const auto& node : m_children) {
-        assert(node->m_parent.lock() == shared_from_this());
-        node->visitNodes(visitor);
+    visitor(node);
+    for (NodeIdx child : m_nodes[node].m_children) {
+        assert(m_nodes[child].m_parent == node);
+        visitNodes(child, visitor);
     }
 }
 
-Node::Node(const Point& p, const std::optional<Point>& last_grounding_location /*= std::nullopt*/) : 
-    m_is_root(true), m_p(p), m_last_grounding_location(last_grounding_location)
-{}
-
-NodeSPtr Node::deepCopy() const
+NodeIdx NodePool::deepCopy(NodeIdx node, NodePool& dst) const
 {
-    NodeSPtr local_root = Node::create(m_p);
-    local_root->m_is_root = m_is_root;
-    if (m_is_root)
+    assert(&dst != this);
+    const Node &src        = m_nodes[node];
+    NodeIdx     local_root = dst.create(src.m_p);
+    Node       &copy       = dst.m_nodes[local_root];
+    copy.m_is_root = src.m_is_root;
+    if (src.m_is_root)
     {
-        local_root->m_last_grounding_location = m_last_grounding_location.value_or(m_p);
+        copy.m_last_grounding_location = src.m_last_grounding_location.value_or(src.m_p);
     }
-    local_root->m_children.reserve(m_children.size());
-    for (const auto& node : m_children)
+    // The children are copied first, the pool of the copy may grow.
+    boost::container::small_vector<NodeIdx, 2> children;
+    children.reserve(src.m_children.size());
+    for (NodeIdx child : src.m_children)
     {
-        NodeSPtr child = node->deepCopy();
-        child->m_parent = local_root;
-        local_root->m_children.push_back(child);
+        NodeIdx child_copy = deepCopy(child, dst);
+        dst.m_nodes[child_copy].m_parent = local_root;
+        children.push_back(child_copy);
     }
+    dst.m_nodes[local_root].m_children = std::move(children);
     return local_root;
 }
 
-void Node::reroot(const NodeSPtr &new_parent)
+void NodePool::reroot(NodeIdx node, NodeIdx new_parent)
 {
-    if (! m_is_root) {
-        auto old_parent = m_parent.lock();
-        old_parent->reroot(shared_from_this());
-        m_children.push_back(old_parent);
+    if (! m_nodes[node].m_is_root) {
+        NodeIdx old_parent = m_nodes[node].m_parent;
+        reroot(old_parent, node);
+        m_nodes[node].m_children.push_back(old_parent);
     }
 
-    if (new_parent) {
-        m_children.erase(std::remove(m_children.begin(), m_children.end(), new_parent), m_children.end());
-        m_is_root = false;
-        m_parent = new_parent;
+    Node &n = m_nodes[node];
+    if (new_parent != NoNode) {
+        n.m_children.erase(std::remove(n.m_children.begin(), n.m_children.end(), new_parent), n.m_children.end());
+        n.m_is_root = false;
+        n.m_parent = new_parent;
     } else {
-        m_is_root = true;
-        m_parent.reset();
+        n.m_is_root = true;
+        n.m_parent = NoNode;
     }
 }
 
-NodeSPtr Node::closestNode(const Point& loc)
+NodeIdx NodePool::closestNode(NodeIdx node, const Point& loc) const
 {
-    NodeSPtr result = shared_from_this();
-    auto closest_dist2 = coord_t((m_p - loc).cast<double>().norm());
+    NodeIdx result = node;
+    auto closest_dist2 = coord_t((m_nodes[node].m_p - loc).cast<double>().norm());
 
-    for (const auto& child : m_children) {
-        NodeSPtr candidate_node = child->closestNode(loc);
-        const auto child_dist2 = coord_t((candidate_node->m_p - loc).cast<double>().norm());
+    for (NodeIdx child : m_nodes[node].m_children) {
+        NodeIdx candidate_node = closestNode(child, loc);
+        const auto child_dist2 = coord_t((m_nodes[candidate_node].m_p - loc).cast<double>().norm());
         if (child_dist2 < closest_dist2) {
             closest_dist2 = child_dist2;
             result = candidate_node;
@@ -187,52 +201,57 @@ bool lineSegmentPolygonsIntersection(const Point& a, const Point& b, const EdgeG
     return false;
 }
 
-bool Node::realign(const Polygons& outlines, const EdgeGrid::Grid& outline_locator, std::vector<NodeSPtr>& rerooted_parts)
+bool NodePool::realign(NodeIdx node, const Polygons& outlines, const EdgeGrid::Grid& outline_locator, std::vector<NodeIdx>& rerooted_parts)
 {
     if (outlines.empty())
         return false;
 
-    if (inside(outlines, m_p)) {
+    // No nodes are created below, thus the reference stays valid.
+    Node &n = m_nodes[node];
+    if (inside(outlines, n.m_p)) {
         // Only keep children that have an unbroken connection to here, realign will put the rest in rerooted parts due to recursion:
         Point coll;
         bool reground_me = false;
-        m_children.erase(std::remove_if(m_children.begin(), m_children.end(), [&](const NodeSPtr &child) {
-            bool connect_branch = child->realign(outlines, outline_locator, rerooted_parts);
+        n.m_children.erase(std::remove_if(n.m_children.begin(), n.m_children.end(), [&](NodeIdx child_idx) {
+            bool connect_branch = realign(child_idx, outlines, outline_locator, rerooted_parts);
+            Node &child = m_nodes[child_idx];
             // Find an intersection of the line segment from p to child->p, at maximum outline_locator.resolution() * 2 distance from p.
-            if (connect_branch && lineSegmentPolygonsIntersection(child->m_p, m_p, outline_locator, coll, outline_locator.resolution() * 2)) {
-                child->m_last_grounding_location.reset();
-                child->m_parent.reset();
-                child->m_is_root = true;
-                rerooted_parts.push_back(child);
+            if (connect_branch && lineSegmentPolygonsIntersection(child.m_p, n.m_p, outline_locator, coll, outline_locator.resolution() * 2)) {
+                child.m_last_grounding_location.reset();
+                child.m_parent = NoNode;
+                child.m_is_root = true;
+                rerooted_parts.push_back(child_idx);
                 reground_me = true;
                 connect_branch = false;
             }
             return ! connect_branch;
-        }), m_children.end());
+        }), n.m_children.end());
         if (reground_me)
-            m_last_grounding_location.reset();
+            n.m_last_grounding_location.reset();
         return true;
     }
 
     // 'Lift' any decendants out of this tree:
-    for (auto& child : m_children)
-        if (child->realign(outlines, outline_locator, rerooted_parts)) {
-            child->m_last_grounding_location = m_p;
-            child->m_parent.reset();
-            child->m_is_root = true;
-            rerooted_parts.push_back(child);
+    for (NodeIdx child_idx : n.m_children)
+        if (realign(child_idx, outlines, outline_locator, rerooted_parts)) {
+            Node &child = m_nodes[child_idx];
+            child.m_last_grounding_location = n.m_p;
+            child.m_parent = NoNode;
+            child.m_is_root = true;
+            rerooted_parts.push_back(child_idx);
         }
 
-    m_children.clear();
+    n.m_children.clear();
     return false;
 }
 
-void Node::straighten(const coord_t magnitude, const coord_t max_remove_colinear_dist)
+void NodePool::straighten(NodeIdx node, const coord_t magnitude, const coord_t max_remove_colinear_dist)
 {
-    straighten(magnitude, m_p, 0, int64_t(max_remove_colinear_dist) * int64_t(max_remove_colinear_dist));
+    straighten(node, magnitude, m_nodes[node].m_p, 0, int64_t(max_remove_colinear_dist) * int64_t(max_remove_colinear_dist));
 }
 
-Node::RectilinearJunction Node::straighten(
+NodePool::RectilinearJunction NodePool::straighten(
+    NodeIdx node,
     const coord_t magnitude,
     const Point& junction_above,
     const coord_t accumulated_dist,
@@ -242,11 +261,13 @@ Node::RectilinearJunction Node::straighten(
     constexpr coord_t junction_magnitude_factor_denominator = 4;
 
     const coord_t junction_magnitude = magnitude * junction_magnitude_factor_numerator / junction_magnitude_factor_denominator;
-    if (m_children.size() == 1)
+    // No nodes are created below, thus the reference stays valid.
+    Node &n = m_nodes[node];
+    if (n.m_children.size() == 1)
     {
-        auto child_p = m_children.front();
-        auto child_dist = coord_t((m_p - child_p->m_p).cast<double>().norm());
-        RectilinearJunction junction_below = child_p->straighten(magnitude, junction_above, accumulated_dist + child_dist, max_remove_colinear_dist2);
+        NodeIdx child_p = n.m_children.front();
+        auto child_dist = coord_t((n.m_p - m_nodes[child_p].m_p).cast<double>().norm());
+        RectilinearJunction junction_below = straighten(child_p, magnitude, junction_above, accumulated_dist + child_dist, max_remove_colinear_dist2);
         coord_t total_dist_to_junction_below = junction_below.total_recti_dist;
         const Point& a = junction_above;
         Point        b = junction_below.junction_loc;
@@ -254,23 +275,23 @@ Node::RectilinearJunction Node::straighten(
         {
             Point ab = b - a;
             Point destination = (a.cast<int64_t>() + ab.cast<int64_t>() * int64_t(accumulated_dist) / std::max(int64_t(1), int64_t(total_dist_to_junction_below))).cast<coord_t>();
-            if ((destination - m_p).cast<int64_t>().squaredNorm() <= int64_t(magnitude) * int64_t(magnitude))
-                m_p = destination;
+            if ((destination - n.m_p).cast<int64_t>().squaredNorm() <= int64_t(magnitude) * int64_t(magnitude))
+                n.m_p = destination;
             else
-                m_p += ((destination - m_p).cast<double>().normalized() * magnitude).cast<coord_t>();
+                n.m_p += ((destination - n.m_p).cast<double>().normalized() * magnitude).cast<coord_t>();
         }
         { // remove nodes on linear segments
             constexpr coord_t close_enough = 10;
 
-            child_p = m_children.front(); //recursive call to straighten might have removed the child
-            const NodeSPtr& parent_node = m_parent.lock();
-            if (parent_node &&
-                (child_p->m_p - parent_node->m_p).cast<int64_t>().squaredNorm() < max_remove_colinear_dist2 &&
-                Line::distance_to_squared(m_p, parent_node->m_p, child_p->m_p) < close_enough * close_enough) {
-                child_p->m_parent = m_parent;
-                for (auto& sibling : parent_node->m_children)
+            child_p = n.m_children.front(); //recursive call to straighten might have removed the child
+            const NodeIdx parent_node = n.m_parent;
+            if (parent_node != NoNode &&
+                (m_nodes[child_p].m_p - m_nodes[parent_node].m_p).cast<int64_t>().squaredNorm() < max_remove_colinear_dist2 &&
+                Line::distance_to_squared(n.m_p, m_nodes[parent_node].m_p, m_nodes[child_p].m_p) < close_enough * close_enough) {
+                m_nodes[child_p].m_parent = n.m_parent;
+                for (NodeIdx& sibling : m_nodes[parent_node].m_children)
                 { // find this node among siblings
-                    if (sibling == shared_from_this())
+                    if (sibling == node)
                     {
                         sibling = child_p; // replace this node by child
                         break;
@@ -283,62 +304,66 @@ Node::RectilinearJunction Node::straighten(
     else
     {
         constexpr coord_t weight = 1000;
-        Point junction_moving_dir = ((junction_above - m_p).cast<double>().normalized() * weight).cast<coord_t>();
+        Point junction_moving_dir = ((junction_above - n.m_p).cast<double>().normalized() * weight).cast<coord_t>();
         bool prevent_junction_moving = false;
-        for (auto& child_p : m_children)
+        // The recursive calls may replace the children in place.
+        for (size_t i = 0; i < n.m_children.size(); ++ i)
         {
-            const auto child_dist = coord_t((m_p - child_p->m_p).cast<double>().norm());
-            RectilinearJunction below = child_p->straighten(magnitude, m_p, child_dist, max_remove_colinear_dist2);
+            const NodeIdx child_p = n.m_children[i];
+            const auto child_dist = coord_t((n.m_p - m_nodes[child_p].m_p).cast<double>().norm());
+            RectilinearJunction below = straighten(child_p, magnitude, n.m_p, child_dist, max_remove_colinear_dist2);
 
-            junction_moving_dir += ((below.junction_loc - m_p).cast<double>().normalized() * weight).cast<coord_t>();
+            junction_moving_dir += ((below.junction_loc - n.m_p).cast<double>().normalized() * weight).cast<coord_t>();
             if (below.total_recti_dist < magnitude) // TODO: make configurable?
             {
                 prevent_junction_moving = true; // prevent flipflopping in branches due to straightening and junctoin moving clashing
             }
         }
-        if (junction_moving_dir != Point(0, 0) && ! m_children.empty() && ! m_is_root && ! prevent_junction_moving)
+        if (junction_moving_dir != Point(0, 0) && ! n.m_children.empty() && ! n.m_is_root && ! prevent_junction_moving)
         {
             auto junction_moving_dir_len = coord_t(junction_moving_dir.norm());
             if (junction_moving_dir_len > junction_magnitude)
             {
                 junction_moving_dir = junction_moving_dir * junction_magnitude / junction_moving_dir_len;
             }
-            m_p += junction_moving_dir;
+            n.m_p += junction_moving_dir;
         }
-        return RectilinearJunction{ accumulated_dist, m_p };
+        return RectilinearJunction{ accumulated_dist, n.m_p };
     }
 }
 
 // Prune the tree from the extremeties (leaf-nodes) until the pruning distance is reached.
-coord_t Node::prune(const coord_t& pruning_distance)
+coord_t NodePool::prune(NodeIdx node, const coord_t& pruning_distance)
 {
     if (pruning_distance <= 0)
         return 0;
 
     coord_t max_distance_pruned = 0;
-    for (auto child_it = m_children.begin(); child_it != m_children.end(); ) {
-        auto& child = *child_it;
-        coord_t dist_pruned_child = child->prune(pruning_distance);
+    // No nodes are created below, thus the reference stays valid.
+    Node &n = m_nodes[node];
+    for (auto child_it = n.m_children.begin(); child_it != n.m_children.end(); ) {
+        Node &child = m_nodes[*child_it];
+        coord_t dist_pruned_child = prune(*child_it, pruning_distance);
         if (dist_pruned_child >= pruning_distance)
         { // pruning is finished for child; dont modify further
             max_distance_pruned = std::max(max_distance_pruned, dist_pruned_child);
             ++child_it;
         } else {
-            const Point a = getLocation();
-            const Point b = child->getLocation();
+            const Point a = n.getLocation();
+            const Point b = child.getLocation();
             const Point ba = a - b;
             const auto ab_len = coord_t(ba.cast<double>().norm());
-            if (dist_pruned_child + ab_len <= pruning_distance) { 
+            if (dist_pruned_child + ab_len <= pruning_distance) {
                 // we're still in the process of pruning
-                assert(child->m_children.empty() && "when pruning away a node all it's children must already have been pruned away");
+                assert(child.m_children.empty() && "when pruning away a node all it's children must already have been pruned away");
                 max_distance_pruned = std::max(max_distance_pruned, dist_pruned_child + ab_len);
-                child_it = m_children.erase(child_it);
+                child_it = n.m_children.erase(child_it);
             } else {
                 // pruning stops in between this node and the child
-                const Point n = b + (ba.cast<double>().normalized() * (pruning_distance - dist_pruned_child)).cast<coord_t>();
-                assert(std::abs((n - b).cast<double>().norm() + dist_pruned_child - pruning_distance) < 10 && "total pruned distance must be equal to the pruning_distance");
+                const Point pruned = b + (ba.cast<double>().normalized() * (pruning_distance - dist_pruned_child)).cast<coord_t>();
+                assert(std::abs((pruned - b).cast<double>().norm() + dist_pruned_child - pruning_distance) < 10 && "total pruned distance must be equal to the pruning_distance");
                 max_distance_pruned = std::max(max_distance_pruned, pruning_distance);
-                child->setLocation(n);
+                child.setLocation(pruned);
                 ++child_it;
             }
         }
@@ -347,36 +372,36 @@ coord_t Node::prune(const coord_t& pruning_distance)
     return max_distance_pruned;
 }
 
-void Node::convertToPolylines(Polylines &output, const coord_t line_overlap) const
+void NodePool::convertToPolylines(NodeIdx root, Polylines &output, const coord_t line_overlap) const
 {
     Polylines result;
     result.emplace_back();
-    convertToPolylines(0, result);
+    convertToPolylines(root, 0, result);
     removeJunctionOverlap(result, line_overlap);
     append(output, std::move(result));
 }
 
-void Node::convertToPolylines(size_t long_line_idx, Polylines &output) const
+void NodePool::convertToPolylines(NodeIdx node, size_t long_line_idx, Polylines &output) const
 {
-    if (m_children.empty()) {
-        output[long_line_idx].points.push_back(m_p);
+    const Node &n = m_nodes[node];
+    if (n.m_children.empty()) {
+        output[long_line_idx].points.push_back(n.m_p);
         return;
     }
-    size_t first_child_idx = rand() % m_children.size();
-    m_children[first_child_idx]->convertToPolylines(long_line_idx, output);
-    output[long_line_idx].points.push_back(m_p);
+    size_t first_child_idx = rand() % n.m_children.size();
+    convertToPolylines(n.m_children[first_child_idx], long_line_idx, output);
+    output[long_line_idx].points.push_back(n.m_p);
 
-    for (size_t idx_offset = 1; idx_offset < m_children.size(); idx_offset++) {
-        size_t child_idx = (first_child_idx + idx_offset) % m_children.size();
-        const Node& child = *m_children[child_idx];
+    for (size_t idx_offset = 1; idx_offset < n.m_children.size(); idx_offset++) {
+        size_t child_idx = (first_child_idx + idx_offset) % n.m_children.size();
         output.emplace_back();
         size_t child_line_idx = output.size() - 1;
-        child.convertToPolylines(child_line_idx, output);
-        output[child_line_idx].points.emplace_back(m_p);
+        convertToPolylines(n.m_children[child_idx], child_line_idx, output);
+        output[child_line_idx].points.emplace_back(n.m_p);
     }
 }
 
-void Node::removeJunctionOverlap(Polylines &result_lines, const coord_t line_overlap) const
+void NodePool::removeJunctionOverlap(Polylines &result_lines, const coord_t line_overlap)
 {
     const coord_t reduction    = line_overlap;
     size_t        res_line_idx = 0;
@@ -412,28 +437,38 @@ void Node::removeJunctionOverlap(Polylines &result_lines, const coord_t line_ove
     }
 }
 
+BoundingBox NodePool::get_extents(NodeIdx root) const
+{
+    BoundingBox bbox;
+    for (NodeIdx child : m_nodes[root].m_children)
+        bbox.merge(get_extents(child));
+    bbox.merge(m_nodes[root].getLocation());
+    return bbox;
+}
+
+BoundingBox NodePool::get_extents(const std::vector<NodeIdx> &tree_roots) const
+{
+    BoundingBox bbox;
+    for (NodeIdx root : tree_roots)
+        bbox.merge(get_extents(root));
+    return bbox;
+}
+
 #ifdef LIGHTNING_TREE_NODE_DEBUG_OUTPUT
-void export_to_svg(const NodeSPtr &root_node, SVG &svg)
+void export_to_svg(const NodePool &pool, NodeIdx root_node, SVG &svg)
 {
-    for (const NodeSPtr &children : root_node->m_children) {
-        svg.draw(Line(root_node->getLocation(), children->getLocation()), "red");
-        export_to_svg(children, svg);
-    }
+    pool.visitBranches(root_node, [&svg](const Point &a, const Point &b) { svg.draw(Line(a, b), "red"); });
 }
 
-void export_to_svg(const std::string &path, const Polygons &contour, const std::vector<NodeSPtr> &root_nodes) {
+void export_to_svg(const std::string &path, const Polygons &contour, const NodePool &pool, const std::vector<NodeIdx> &root_nodes) {
     BoundingBox bbox = get_extents(contour);
 
     bbox.offset(SCALED_EPSILON);
     SVG svg(path, bbox);
     svg.draw_outline(contour, "blue");
 
-    for (const NodeSPtr &root_node: root_nodes) {
-        for (const NodeSPtr &children: root_node->m_children) {
-            svg.draw(Line(root_node->getLocation(), children->getLocation()), "red");
-            export_to_svg(children, svg);
-        }
-    }
+    for (NodeIdx root_node : root_nodes)
+        export_to_svg(pool, root_node, svg);
 }
 #endif /* LIGHTNING_TREE_NODE_DEBUG_OUTPUT */
 
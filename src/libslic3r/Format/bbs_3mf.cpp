@@ -25,6 +25,7 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/endian/conversion.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/nowide/fstream.hpp>
@@ -43,6 +44,8 @@ namespace pt = boost::property_tree;
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
 
 #include <expat.h>
 #include <Eigen/Dense>
@@ -146,6 +149,8 @@ const std::string BBL_PROFILE_USER_NAME_TAG         = "ProfileUserName";
 
 const std::string MODEL_FOLDER = "3D/";
 const std::string MODEL_EXTENSION = ".model";
+// Binary copy of the meshes of a model file, stored next to it as <model file>.mesh, see MeshSidecar.
+const std::string MESH_SIDECAR_EXTENSION = ".mesh";
 const std::string MODEL_FILE = "3D/3dmodel.model"; // << this is the only format of the string which works with CURA
 const std::string MODEL_RELS_FILE = "3D/_rels/3dmodel.model.rels";
 //BBS: add metadata_folder
@@ -466,6 +471,440 @@ bool bbs_get_attribute_value_bool(const char** attributes, unsigned int attribut
     return (text != nullptr) ? (bool)::atoi(text) : true;
 }
 
+// Binary copy of the meshes of a model file, written by OrcaSlicer next to the model file to speed up loading of its own projects.
+// Other consumers of the 3MF ignore it and read the XML. The sidecar stores the CRC-32 and the size of the model file it was
+// written for, thus a sidecar is only used together with the very model file it was written with. The sidecar itself is
+// checked by the CRC-32 of its zip entry when extracted.
+// Layout, little endian:
+//   "OMSH", u32 version, u32 CRC-32 of the model file, u64 size of the model file, u32 number of meshes,
+//   for each <mesh> of the model file in the document order:
+//     u32 number of vertices, u32 number of triangles or NoTriangles, float[3] vertices, int32[3] triangles.
+// The triangles of a mesh with painting or face properties are not stored, they are decoded from the XML.
+class MeshSidecar
+{
+public:
+    static constexpr uint32_t NoTriangles = uint32_t(-1);
+
+    struct Mesh
+    {
+        std::vector<Slic3r::Vec3f>   vertices;
+        std::vector<Slic3r::Vec3i32> triangles;
+        bool                         has_triangles { false };
+    };
+
+    bool empty() const { return m_num_meshes == 0; }
+
+    // Append the next mesh of the model file being exported.
+    void add_mesh(const std::vector<Slic3r::Vec3f> &vertices, const std::vector<Slic3r::Vec3i32> *triangles)
+    {
+        this->put(uint32_t(vertices.size()));
+        this->put(triangles ? uint32_t(triangles->size()) : NoTriangles);
+        m_body.append(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Slic3r::Vec3f));
+        if (triangles)
+            m_body.append(reinterpret_cast<const char*>(triangles->data()), triangles->size() * sizeof(Slic3r::Vec3i32));
+        ++ m_num_meshes;
+    }
+
+    // Sidecar of the model file with the given CRC-32 and size. Returns an empty string if the sidecar cannot be written.
+    std::string serialize(uint32_t model_crc32, uint64_t model_size) const
+    {
+        std::string out;
+        if constexpr (boost::endian::order::native == boost::endian::order::little) {
+            out.reserve(HeaderSize + m_body.size());
+            out.append(Magic, 4);
+            put(out, Version);
+            put(out, model_crc32);
+            put(out, model_size);
+            put(out, m_num_meshes);
+            out += m_body;
+        }
+        return out;
+    }
+
+    // Decode the sidecar of a model file with the given CRC-32 and size. Returns false if the sidecar is damaged or stale.
+    static bool deserialize(const char *data, size_t size, uint32_t model_crc32, uint64_t model_size, std::vector<Mesh> &meshes)
+    {
+        if constexpr (boost::endian::order::native != boost::endian::order::little)
+            return false;
+        meshes.clear();
+        if (size < HeaderSize || memcmp(data, Magic, 4) != 0 ||
+            get<uint32_t>(data + 4) != Version || get<uint32_t>(data + 8) != model_crc32 || get<uint64_t>(data + 12) != model_size)
+            return false;
+        const char *ptr = data + HeaderSize;
+        const char *end = data + size;
+        for (uint32_t num_meshes = get<uint32_t>(data + 20); num_meshes > 0; -- num_meshes) {
+            if (end - ptr < 8)
+                return false;
+            uint32_t num_vertices  = get<uint32_t>(ptr);
+            uint32_t num_triangles = get<uint32_t>(ptr + 4);
+            ptr += 8;
+            Mesh &mesh = meshes.emplace_back();
+            mesh.has_triangles = num_triangles != NoTriangles;
+            if (! mesh.has_triangles)
+                num_triangles = 0;
+            if (uint64_t(end - ptr) < uint64_t(num_vertices) * sizeof(Slic3r::Vec3f) + uint64_t(num_triangles) * sizeof(Slic3r::Vec3i32))
+                return false;
+            mesh.vertices.resize(num_vertices);
+            mesh.triangles.resize(num_triangles);
+            // Copy into the scalars of the Eigen vectors, which are packed, see the static_assert below.
+            if (num_vertices > 0)
+                memcpy(reinterpret_cast<float*>(mesh.vertices.data()), ptr, num_vertices * sizeof(Slic3r::Vec3f));
+            ptr += num_vertices * sizeof(Slic3r::Vec3f);
+            if (num_triangles > 0)
+                memcpy(reinterpret_cast<int32_t*>(mesh.triangles.data()), ptr, num_triangles * sizeof(Slic3r::Vec3i32));
+            ptr += num_triangles * sizeof(Slic3r::Vec3i32);
+        }
+        return ptr == end;
+    }
+
+    // Read the sidecar of the model file "stat" from the archive. Returns false if there is none or if it does not match the model file.
+    static bool load(mz_zip_archive &archive, const mz_zip_archive_file_stat &stat, std::vector<Mesh> &meshes)
+    {
+        int index = mz_zip_reader_locate_file(&archive, (std::string(stat.m_filename) + MESH_SIDECAR_EXTENSION).c_str(), nullptr, 0);
+        mz_zip_archive_file_stat sidecar_stat;
+        if (index < 0 || ! mz_zip_reader_file_stat(&archive, mz_uint(index), &sidecar_stat) || sidecar_stat.m_uncomp_size > std::numeric_limits<size_t>::max())
+            return false;
+        // The sidecar is stored, thus it is extracted by a single copy. The extraction verifies the CRC-32 of the entry.
+        std::vector<char> data(size_t(sidecar_stat.m_uncomp_size));
+        return mz_zip_reader_extract_to_mem(&archive, mz_uint(index), data.data(), data.size(), 0) &&
+               deserialize(data.data(), data.size(), stat.m_crc32, stat.m_uncomp_size, meshes);
+    }
+
+private:
+    // The vertices and triangles are stored and loaded as arrays of their scalars.
+    static_assert(sizeof(Slic3r::Vec3f) == 3 * sizeof(float) && std::is_same_v<Slic3r::Vec3f::Scalar, float>, "Vec3f is expected to be packed");
+    static_assert(sizeof(Slic3r::Vec3i32) == 3 * sizeof(int32_t) && std::is_same_v<Slic3r::Vec3i32::Scalar, int32_t>, "Vec3i32 is expected to be packed");
+
+    static constexpr char     Magic[4]   = { 'O', 'M', 'S', 'H' };
+    static constexpr uint32_t Version    = 1;
+    static constexpr size_t   HeaderSize = 24;
+
+    template<typename T> static void put(std::string &out, T value) { out.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    template<typename T> void put(T value) { put(m_body, value); }
+    template<typename T> static T get(const char *ptr) { T value; memcpy(&value, ptr, sizeof(T)); return value; }
+
+    std::string m_body;
+    uint32_t    m_num_meshes { 0 };
+};
+
+// Decoder of the runs of <vertex> and <triangle> elements of a 3MF model stream.
+// The meshes make up almost all of a 3MF model file, while handing each of their elements to expat costs an attribute
+// array allocation, a lookup of each attribute by name and a conversion of a zero terminated copy of the value.
+// BulkMeshDecoder sits between the zip extraction and expat: the content of <vertices> and <triangles> is decoded
+// here directly into flat arrays, while the rest of the XML, including the <vertices> and <triangles> tags, is passed
+// to expat. The decoded elements are appended to the geometry by the XML handlers, see flush_vertices() and flush_triangles(),
+// thus the elements are kept in order even if the decoder hands over to expat in the middle of a run.
+// The decoder hands over any element it does not understand (unusual spacing, entities, comments, child elements) to expat.
+// If the model file has a valid MeshSidecar, the runs are skipped and the meshes are taken from the sidecar instead.
+class BulkMeshDecoder
+{
+public:
+    explicit BulkMeshDecoder(XML_Parser parser) : m_parser(parser) {}
+
+    // Take the meshes from the sidecar of the model file, see MeshSidecar::load().
+    void set_sidecar(std::vector<MeshSidecar::Mesh> &&meshes) { m_sidecar = std::move(meshes); }
+
+    // Process the next chunk of the model stream. Returns false if expat reported an error.
+    bool parse(const char *data, size_t len, bool is_final)
+    {
+        const char *begin = data;
+        const char *end   = data + len;
+        if (! m_tail.empty()) {
+            // Complete the element or tag split between the chunks.
+            m_tail.append(data, len);
+            begin = m_tail.data();
+            end   = begin + m_tail.size();
+        }
+        const char *ptr  = begin;
+        bool        done = false;
+        while (! done) {
+            // Expat does not see the runs decoded or skipped here, count their lines for current_line_number().
+            const char *run_begin = m_state == State::Xml ? nullptr : ptr;
+            switch (m_state) {
+            case State::Xml:        ptr = this->parse_xml(ptr, end, is_final, done); break;
+            case State::Vertices:   ptr = this->parse_run(ptr, end, is_final, done, "<vertex", "</vertices>"); break;
+            case State::Triangles:  ptr = this->parse_run(ptr, end, is_final, done, "<triangle", "</triangles>"); break;
+            case State::SkipVertices:   ptr = this->skip_run(ptr, end, is_final, done, "</vertices>"); break;
+            case State::SkipTriangles:  ptr = this->skip_run(ptr, end, is_final, done, "</triangles>"); break;
+            }
+            if (run_begin != nullptr)
+                m_skipped_lines += std::count(run_begin, ptr, '\n');
+            if (m_error)
+                return false;
+        }
+        if (is_final) {
+            // Whatever was left, expat will report it.
+            if (ptr != end && ! this->forward(ptr, end))
+                return false;
+            ptr = end;
+            if (XML_Parse(m_parser, ptr, 0, 1) == XML_STATUS_ERROR)
+                return false;
+        }
+        // Keep the unprocessed tail for the next chunk.
+        if (m_tail.empty())
+            m_tail.assign(ptr, end);
+        else
+            m_tail.erase(0, ptr - begin);
+        return true;
+    }
+
+    // Line of the model stream expat is at, including the lines of the runs expat did not see. For error messages.
+    int current_line_number() const { return int(XML_GetCurrentLineNumber(m_parser) + m_skipped_lines); }
+
+    // Move the decoded vertices to the geometry, scaled by unit_factor the same way the <vertex> handler does.
+    // The decoded vertices are dropped if there is no geometry to receive them, as the <vertex> handler does.
+    template<typename GeometryType>
+    void flush_vertices(GeometryType *geometry, float unit_factor)
+    {
+        if (geometry != nullptr) {
+            if (geometry->vertices.empty() && unit_factor == 1.f) {
+                geometry->vertices = std::move(m_vertices);
+            } else {
+                geometry->vertices.reserve(geometry->vertices.size() + m_vertices.size());
+                for (const Slic3r::Vec3f &v : m_vertices)
+                    geometry->vertices.emplace_back(unit_factor * v.x(), unit_factor * v.y(), unit_factor * v.z());
+            }
+        }
+        m_vertices.clear();
+    }
+
+    // Move the decoded triangles and their painting to the geometry.
+    template<typename GeometryType>
+    void flush_triangles(GeometryType *geometry)
+    {
+        if (geometry != nullptr) {
+            append(geometry->triangles, std::move(m_triangles));
+            append(geometry->custom_supports, std::move(m_custom_supports));
+            append(geometry->custom_seam, std::move(m_custom_seam));
+            append(geometry->mmu_segmentation, std::move(m_mmu_segmentation));
+            append(geometry->fuzzy_skin, std::move(m_fuzzy_skin));
+            append(geometry->face_properties, std::move(m_face_properties));
+        }
+        m_triangles.clear();
+        m_custom_supports.clear();
+        m_custom_seam.clear();
+        m_mmu_segmentation.clear();
+        m_fuzzy_skin.clear();
+        m_face_properties.clear();
+    }
+
+private:
+    enum class State { Xml, Vertices, Triangles, SkipVertices, SkipTriangles };
+
+    static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+    static bool starts_with(const char *ptr, const char *end, const char *str, size_t len) { return size_t(end - ptr) >= len && memcmp(ptr, str, len) == 0; }
+
+    bool forward(const char *begin, const char *end)
+    {
+        if (begin != end && XML_Parse(m_parser, begin, int(end - begin), 0) == XML_STATUS_ERROR)
+            m_error = true;
+        return ! m_error;
+    }
+
+    // Pass the XML to expat up to and including the next <vertices> or <triangles> tag.
+    const char* parse_xml(const char *ptr, const char *end, bool is_final, bool &done)
+    {
+        static constexpr const char vertices[]  = "<vertices>";
+        static constexpr const char triangles[] = "<triangles>";
+        for (const char *tag = ptr; (tag = (const char*)memchr(tag, '<', end - tag)) != nullptr; ++ tag) {
+            size_t len = 0;
+            if (starts_with(tag, end, vertices, sizeof(vertices) - 1)) {
+                len = sizeof(vertices) - 1;
+                m_state = m_vertex_runs < m_sidecar.size() ? State::SkipVertices : State::Vertices;
+                m_sidecar_mesh = m_vertex_runs ++;
+            } else if (starts_with(tag, end, triangles, sizeof(triangles) - 1)) {
+                len = sizeof(triangles) - 1;
+                m_state = m_triangle_runs < m_sidecar.size() && m_sidecar[m_triangle_runs].has_triangles ? State::SkipTriangles : State::Triangles;
+                m_sidecar_mesh = m_triangle_runs ++;
+            } else if (size_t(end - tag) < sizeof(triangles) - 1 && ! is_final) {
+                // Possibly the beginning of a tag split between the chunks.
+                this->forward(ptr, tag);
+                done = true;
+                return tag;
+            } else
+                continue;
+            this->forward(ptr, tag + len);
+            return tag + len;
+        }
+        this->forward(ptr, end);
+        done = true;
+        return end;
+    }
+
+    // Decode the <vertex> or <triangle> elements up to the closing tag of the run.
+    const char* parse_run(const char *ptr, const char *end, bool is_final, bool &done, const char *element, const char *closing_tag)
+    {
+        const size_t element_len     = strlen(element);
+        const size_t closing_tag_len = strlen(closing_tag);
+        for (;;) {
+            while (ptr != end && is_space(*ptr))
+                ++ ptr;
+            if (size_t(end - ptr) <= std::max(element_len, closing_tag_len) && ! is_final) {
+                // Not enough data to decide.
+                done = true;
+                return ptr;
+            }
+            if (starts_with(ptr, end, closing_tag, closing_tag_len)) {
+                // Leave the closing tag to expat.
+                m_state = State::Xml;
+                return ptr;
+            }
+            if (! starts_with(ptr, end, element, element_len) || ptr + element_len == end || ! is_space(ptr[element_len])) {
+                m_state = State::Xml;
+                return ptr;
+            }
+            const char *element_end = (const char*)memchr(ptr + element_len, '>', end - ptr - element_len);
+            if (element_end == nullptr) {
+                if (is_final)
+                    m_state = State::Xml;
+                else
+                    done = true;
+                return ptr;
+            }
+            if (element_end[-1] != '/' ||
+                ! (m_state == State::Vertices ? this->decode_vertex(ptr + element_len, element_end - 1) : this->decode_triangle(ptr + element_len, element_end - 1))) {
+                // Not an empty element or not understood, let expat handle the rest of the run.
+                m_state = State::Xml;
+                return ptr;
+            }
+            ptr = element_end + 1;
+        }
+    }
+
+    // Skip the run up to its closing tag, the run is taken from the sidecar.
+    const char* skip_run(const char *ptr, const char *end, bool is_final, bool &done, const char *closing_tag)
+    {
+        const size_t closing_tag_len = strlen(closing_tag);
+        const char  *tag             = std::search(ptr, end, std::boyer_moore_horspool_searcher(closing_tag, closing_tag + closing_tag_len));
+        if (tag == end) {
+            if (is_final) {
+                // Truncated file, let expat report it.
+                m_state = State::Xml;
+                return ptr;
+            }
+            // Keep what may be the beginning of the closing tag.
+            done = true;
+            return size_t(end - ptr) < closing_tag_len ? ptr : end - (closing_tag_len - 1);
+        }
+        MeshSidecar::Mesh &mesh = m_sidecar[m_sidecar_mesh];
+        if (m_state == State::SkipVertices) {
+            m_vertices = std::move(mesh.vertices);
+        } else {
+            size_t num_triangles = mesh.triangles.size();
+            m_triangles = std::move(mesh.triangles);
+            for (std::vector<std::string> *painting : { &m_custom_supports, &m_custom_seam, &m_mmu_segmentation, &m_fuzzy_skin, &m_face_properties })
+                painting->assign(num_triangles, std::string());
+        }
+        // Leave the closing tag to expat.
+        m_state = State::Xml;
+        return tag;
+    }
+
+    // Iterate over name="value" pairs of an element, returns false if the attributes are not in the simple form.
+    template<typename AttributeFn>
+    static bool for_each_attribute(const char *ptr, const char *end, AttributeFn attribute_fn)
+    {
+        for (;;) {
+            while (ptr != end && is_space(*ptr))
+                ++ ptr;
+            if (ptr == end)
+                return true;
+            const char *name = ptr;
+            while (ptr != end && *ptr != '=' && ! is_space(*ptr))
+                ++ ptr;
+            if (end - ptr < 2 || *ptr != '=' || (ptr[1] != '"' && ptr[1] != '\''))
+                return false;
+            const char *name_end = ptr;
+            const char  quote    = ptr[1];
+            const char *value    = ptr + 2;
+            const char *value_end = (const char*)memchr(value, quote, end - value);
+            // Entity and character references are left to expat.
+            if (value_end == nullptr || memchr(value, '&', value_end - value) != nullptr || memchr(value, '<', value_end - value) != nullptr)
+                return false;
+            attribute_fn(name, name_end, value, value_end);
+            ptr = value_end + 1;
+            if (ptr != end && ! is_space(*ptr))
+                return false;
+        }
+    }
+
+    static bool attribute_is(const char *name, const char *name_end, const char *attr) { return strlen(attr) == size_t(name_end - name) && memcmp(name, attr, name_end - name) == 0; }
+
+    bool decode_vertex(const char *ptr, const char *end)
+    {
+        // Missing values are set equal to ZERO.
+        Slic3r::Vec3f v = Slic3r::Vec3f::Zero();
+        bool  ok = for_each_attribute(ptr, end, [&v](const char *name, const char *name_end, const char *value, const char *value_end) {
+            if (name_end - name == 1 && (*name == 'x' || *name == 'y' || *name == 'z'))
+                fast_float::from_chars(value, value_end, v[*name - 'x']);
+        });
+        if (ok)
+            m_vertices.emplace_back(v);
+        return ok;
+    }
+
+    bool decode_triangle(const char *ptr, const char *end)
+    {
+        // Missing values are set equal to ZERO.
+        Slic3r::Vec3i32     t = Slic3r::Vec3i32::Zero();
+        std::string custom_supports, custom_seam, mmu_segmentation, fuzzy_skin, face_property;
+        bool ok = for_each_attribute(ptr, end, [&](const char *name, const char *name_end, const char *value, const char *value_end) {
+            if (name_end - name == 2 && name[0] == 'v' && name[1] >= '1' && name[1] <= '3')
+                boost::spirit::qi::parse(value, value_end, boost::spirit::qi::int_, t[name[1] - '1']);
+            else if (attribute_is(name, name_end, CUSTOM_SUPPORTS_ATTR))
+                custom_supports.assign(value, value_end);
+            else if (attribute_is(name, name_end, CUSTOM_SEAM_ATTR))
+                custom_seam.assign(value, value_end);
+            else if (attribute_is(name, name_end, MMU_SEGMENTATION_ATTR))
+                mmu_segmentation.assign(value, value_end);
+            else if (attribute_is(name, name_end, CUSTOM_FUZZY_SKIN_ATTR))
+                fuzzy_skin.assign(value, value_end);
+            else if (attribute_is(name, name_end, FACE_PROPERTY_ATTR))
+                face_property.assign(value, value_end);
+        });
+        if (ok) {
+            m_triangles.emplace_back(t);
+            m_custom_supports.emplace_back(std::move(custom_supports));
+            m_custom_seam.emplace_back(std::move(custom_seam));
+            m_mmu_segmentation.emplace_back(std::move(mmu_segmentation));
+            m_fuzzy_skin.emplace_back(std::move(fuzzy_skin));
+            m_face_properties.emplace_back(std::move(face_property));
+        }
+        return ok;
+    }
+
+    template<typename T>
+    static void append(std::vector<T> &dst, std::vector<T> &&src)
+    {
+        if (dst.empty())
+            dst = std::move(src);
+        else
+            dst.insert(dst.end(), std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+    }
+
+    XML_Parser                  m_parser;
+    State                       m_state { State::Xml };
+    bool                        m_error { false };
+    // Unprocessed end of the previous chunk.
+    std::string                 m_tail;
+    // Number of lines of the runs decoded or skipped so far.
+    XML_Size                    m_skipped_lines { 0 };
+
+    std::vector<Slic3r::Vec3f>          m_vertices;
+    std::vector<Slic3r::Vec3i32>        m_triangles;
+    std::vector<std::string>    m_custom_supports;
+    std::vector<std::string>    m_custom_seam;
+    std::vector<std::string>    m_mmu_segmentation;
+    std::vector<std::string>    m_fuzzy_skin;
+    std::vector<std::string>    m_face_properties;
+
+    // Meshes of the sidecar, indexed by the order of the <vertices> and <triangles> runs.
+    std::vector<MeshSidecar::Mesh> m_sidecar;
+    size_t                      m_vertex_runs { 0 };
+    size_t                      m_triangle_runs { 0 };
+    size_t                      m_sidecar_mesh { 0 };
+};
+
 void add_vec3(std::stringstream &stream, const Slic3r::Vec3f &tr)
 {
     for (unsigned r = 0; r < 3; ++r) {
@@ -857,6 +1296,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             int object_current_color_group{-1};
             std::map<int, std::string> object_group_id_to_color;
             bool is_bbl_3mf { false };
+            // Decoder of the mesh elements of the object file being parsed.
+            BulkMeshDecoder *mesh_decoder { nullptr };
 
             ObjectImporter(_BBS_3MF_Importer *importer, std::string file_path, std::string obj_path)
             {
@@ -1008,6 +1449,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         std::string  m_profile_user_name;
 
         XML_Parser m_xml_parser;
+        // Decoder of the mesh elements of the model file being parsed, see _extract_model_from_archive().
+        BulkMeshDecoder *m_mesh_decoder { nullptr };
         // Error code returned by the application side of the parser. In that case the expat may not reliably deliver the error state
         // after returning from XML_Parse() function, thus we keep the error state here.
         bool m_parse_error { false };
@@ -2397,6 +2840,11 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         };
 
         CallbackData data(m_xml_parser, *this, stat);
+        BulkMeshDecoder mesh_decoder(m_xml_parser);
+        if (std::vector<MeshSidecar::Mesh> meshes; MeshSidecar::load(archive, stat, meshes))
+            mesh_decoder.set_sidecar(std::move(meshes));
+        m_mesh_decoder = &mesh_decoder;
+        ScopeGuard mesh_decoder_guard([this]() { m_mesh_decoder = nullptr; });
 
         mz_bool res = 0;
 
@@ -2404,9 +2852,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         {
             mz_file_write_func callback = [](void* pOpaque, mz_uint64 file_ofs, const void* pBuf, size_t n)->size_t {
                 CallbackData* data = (CallbackData*)pOpaque;
-                if (!XML_Parse(data->parser, (const char*)pBuf, (int)n, (file_ofs + n == data->stat.m_uncomp_size) ? 1 : 0) || data->importer.parse_error()) {
+                if (!data->importer.m_mesh_decoder->parse((const char*)pBuf, n, file_ofs + n == data->stat.m_uncomp_size) || data->importer.parse_error()) {
                     char error_buf[1024];
-                    ::snprintf(error_buf, 1024, "Error (%s) while parsing '%s' at line %d", data->importer.parse_error_message(), data->stat.m_filename, (int)XML_GetCurrentLineNumber(data->parser));
+                    ::snprintf(error_buf, 1024, "Error (%s) while parsing '%s' at line %d", data->importer.parse_error_message(), data->stat.m_filename, data->importer.m_mesh_decoder->current_line_number());
                     throw Slic3r::FileIOError(error_buf);
                 }
                 return n;
@@ -3574,7 +4022,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
     bool _BBS_3MF_Importer::_handle_end_vertices()
     {
-        // do nothing
+        if (m_mesh_decoder)
+            m_mesh_decoder->flush_vertices(m_curr_object ? &m_curr_object->geometry : nullptr, m_unit_factor);
         return true;
     }
 
@@ -3582,11 +4031,15 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
     {
         // appends the vertex coordinates
         // missing values are set equal to ZERO
-        if (m_curr_object)
+        if (m_curr_object) {
+            // Vertices decoded by the bulk decoder precede this one.
+            if (m_mesh_decoder)
+                m_mesh_decoder->flush_vertices(&m_curr_object->geometry, m_unit_factor);
             m_curr_object->geometry.vertices.emplace_back(
                 m_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, X_ATTR),
                 m_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, Y_ATTR),
                 m_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, Z_ATTR));
+        }
         return true;
     }
 
@@ -3606,7 +4059,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
     bool _BBS_3MF_Importer::_handle_end_triangles()
     {
-        // do nothing
+        if (m_mesh_decoder)
+            m_mesh_decoder->flush_triangles(m_curr_object ? &m_curr_object->geometry : nullptr);
         return true;
     }
 
@@ -3622,6 +4076,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         // appends the triangle's vertices indices
         // missing values are set equal to ZERO
         if (m_curr_object) {
+            // Triangles decoded by the bulk decoder precede this one.
+            if (m_mesh_decoder)
+                m_mesh_decoder->flush_triangles(&m_curr_object->geometry);
             m_curr_object->geometry.triangles.emplace_back(
                 bbs_get_attribute_value_int(attributes, num_attributes, V1_ATTR),
                 bbs_get_attribute_value_int(attributes, num_attributes, V2_ATTR),
@@ -5250,7 +5707,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
     bool _BBS_3MF_Importer::ObjectImporter::_handle_object_end_vertices()
     {
-        // do nothing
+        if (mesh_decoder)
+            mesh_decoder->flush_vertices(current_object ? &current_object->geometry : nullptr, object_unit_factor);
         return true;
     }
 
@@ -5258,11 +5716,15 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
     {
         // appends the vertex coordinates
         // missing values are set equal to ZERO
-        if (current_object)
+        if (current_object) {
+            // Vertices decoded by the bulk decoder precede this one.
+            if (mesh_decoder)
+                mesh_decoder->flush_vertices(&current_object->geometry, object_unit_factor);
             current_object->geometry.vertices.emplace_back(
                 object_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, X_ATTR),
                 object_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, Y_ATTR),
                 object_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, Z_ATTR));
+        }
         return true;
     }
 
@@ -5282,7 +5744,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
     bool _BBS_3MF_Importer::ObjectImporter::_handle_object_end_triangles()
     {
-        // do nothing
+        if (mesh_decoder)
+            mesh_decoder->flush_triangles(current_object ? &current_object->geometry : nullptr);
         return true;
     }
 
@@ -5298,6 +5761,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         // appends the triangle's vertices indices
         // missing values are set equal to ZERO
         if (current_object) {
+            // Triangles decoded by the bulk decoder precede this one.
+            if (mesh_decoder)
+                mesh_decoder->flush_triangles(&current_object->geometry);
             current_object->geometry.triangles.emplace_back(
                 bbs_get_attribute_value_int(attributes, num_attributes, V1_ATTR),
                 bbs_get_attribute_value_int(attributes, num_attributes, V2_ATTR),
@@ -5513,6 +5979,11 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         };
 
         CallbackData data(object_xml_parser, *this, stat);
+        BulkMeshDecoder decoder(object_xml_parser);
+        if (std::vector<MeshSidecar::Mesh> meshes; MeshSidecar::load(archive, stat, meshes))
+            decoder.set_sidecar(std::move(meshes));
+        mesh_decoder = &decoder;
+        ScopeGuard mesh_decoder_guard([this]() { mesh_decoder = nullptr; });
 
         mz_bool res = 0;
 
@@ -5520,9 +5991,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         {
             mz_file_write_func callback = [](void* pOpaque, mz_uint64 file_ofs, const void* pBuf, size_t n)->size_t {
                 CallbackData* data = (CallbackData*)pOpaque;
-                if (!XML_Parse(data->parser, (const char*)pBuf, (int)n, (file_ofs + n == data->stat.m_uncomp_size) ? 1 : 0) || data->importer.object_parse_error()) {
+                if (!data->importer.mesh_decoder->parse((const char*)pBuf, n, file_ofs + n == data->stat.m_uncomp_size) || data->importer.object_parse_error()) {
                     char error_buf[1024];
-                    ::snprintf(error_buf, 1024, "Error (%s) while parsing '%s' at line %d", data->importer.object_parse_error_message(), data->stat.m_filename, (int)XML_GetCurrentLineNumber(data->parser));
+                    ::snprintf(error_buf, 1024, "Error (%s) while parsing '%s' at line %d", data->importer.object_parse_error_message(), data->stat.m_filename, data->importer.mesh_decoder->current_line_number());
                     throw Slic3r::FileIOError(error_buf);
                 }
                 return n;
@@ -5552,6 +6023,107 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
     }
 
 
+    // Compresses a large zip entry pigz style: the data is cut into blocks, which are deflated independently by the TBB
+    // workers and appended to the staged entry in order, while the caller keeps producing the next blocks.
+    // An entry shorter than a single block is compressed by the staged context itself, thus small files are not affected.
+    class ParallelDeflateWriter
+    {
+    public:
+        // The blocks do not share the deflate history, the ratio is lost only at the first 32kB of each block.
+        static constexpr size_t BlockSize = 1 << 20;
+
+        ParallelDeflateWriter(mz_zip_writer_staged_context &context, int level) :
+            m_context(context),
+            m_flags(tdefl_create_comp_flags_from_zip_params(level < 0 ? MZ_DEFAULT_LEVEL : level, -15, MZ_DEFAULT_STRATEGY)),
+            m_batch_size(size_t(tbb::this_task_arena::max_concurrency()))
+        {}
+        ~ParallelDeflateWriter() {
+            // Only reached with a batch in flight if writing failed.
+            try { m_task_group.wait(); } catch (...) {}
+        }
+
+        bool write(const char *data, size_t len) {
+            if (m_batch_size < 2)
+                return len == 0 || mz_zip_writer_add_staged_data(&m_context, data, len);
+            while (len > 0) {
+                if (m_block.empty())
+                    m_block.reserve(BlockSize);
+                size_t n = std::min(len, BlockSize - m_block.size());
+                m_block.append(data, n);
+                data += n;
+                len  -= n;
+                if (m_block.size() == BlockSize) {
+                    m_filling.push_back({ std::move(m_block) });
+                    m_block.clear();
+                    if (m_filling.size() == m_batch_size && ! this->launch())
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        // Appends all the blocks and compresses the tail with the staged context, which may still receive more data.
+        bool finish() {
+            return (m_filling.empty() || this->launch()) && this->collect() &&
+                   (m_block.empty() || mz_zip_writer_add_staged_data(&m_context, m_block.data(), m_block.size()));
+        }
+
+    private:
+        struct Block
+        {
+            std::string data;
+            std::string compressed;
+            mz_uint32   crc32 { 0 };
+            bool        ok { false };
+        };
+
+        static mz_bool put_buf(const void *buf, int len, void *user) {
+            static_cast<std::string*>(user)->append(static_cast<const char*>(buf), size_t(len));
+            return MZ_TRUE;
+        }
+
+        void compress(Block &block) const {
+            auto compressor = std::make_unique<tdefl_compressor>();
+            block.compressed.reserve(block.data.size() / 4);
+            // A sync flush ends the block at a byte boundary without marking it final.
+            block.ok = tdefl_init(compressor.get(), put_buf, &block.compressed, int(m_flags)) == TDEFL_STATUS_OKAY &&
+                       tdefl_compress_buffer(compressor.get(), block.data.data(), block.data.size(), TDEFL_SYNC_FLUSH) == TDEFL_STATUS_OKAY;
+            block.crc32 = mz_uint32(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(block.data.data()), block.data.size()));
+        }
+
+        // Waits for the batch in flight, appends it and starts compressing the batch just filled.
+        bool launch() {
+            if (! this->collect())
+                return false;
+            std::swap(m_filling, m_compressing);
+            m_task_group.run([this]() {
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, m_compressing.size(), 1), [this](const tbb::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i < range.end(); ++ i)
+                        this->compress(m_compressing[i]);
+                });
+            });
+            return true;
+        }
+
+        bool collect() {
+            m_task_group.wait();
+            bool ok = true;
+            for (const Block &block : m_compressing)
+                if (ok)
+                    ok = block.ok && mz_zip_writer_add_staged_raw_deflate(&m_context, block.compressed.data(), block.compressed.size(), block.data.size(), block.crc32);
+            m_compressing.clear();
+            return ok;
+        }
+
+        mz_zip_writer_staged_context &m_context;
+        mz_uint                       m_flags;
+        size_t                        m_batch_size;
+        std::string                   m_block;
+        std::vector<Block>            m_filling;
+        std::vector<Block>            m_compressing;
+        tbb::task_group               m_task_group;
+    };
+
     class _BBS_3MF_Exporter : public _BBS_3MF_Base
     {
         struct BuildItem
@@ -5612,6 +6184,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         bool m_skip_auxiliary { false };    // skip normal axuiliary files
         bool m_use_loaded_id { false };        // whether to use loaded id for identify_id
         bool m_share_mesh { false };        // whether to share mesh between objects
+        bool m_mesh_sidecar { false };      // whether to store a binary copy of the meshes next to the model files
+        int m_compression_level { MZ_DEFAULT_COMPRESSION }; // deflate level of the zip entries, MZ_BEST_SPEED for backups
         std::string m_thumbnail_middle = PRINTER_THUMBNAIL_MIDDLE_FILE;
         std::string m_thumbnail_small  = PRINTER_THUMBNAIL_SMALL_FILE;
         std::map<void const *, std::pair<ObjectData*, ModelVolume const *>> m_shared_meshes;
@@ -5657,10 +6231,10 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                                                 PackingTemporaryData            data    = PackingTemporaryData(),
                                                 int export_plate_idx = -1) const;
         bool _add_model_file_to_archive(const std::string& filename, mz_zip_archive& archive, const Model& model, ObjectToObjectDataMap& objects_data, Export3mfProgressFn proFn = nullptr, BBLProject* project = nullptr) const;
-        bool _add_object_to_model_stream(mz_zip_writer_staged_context &context, ObjectData const &object_data) const;
+        bool _add_object_to_model_stream(mz_zip_writer_staged_context &context, ObjectData const &object_data, MeshSidecar *sidecar) const;
         void _add_object_components_to_stream(std::stringstream &stream, ObjectData const &object_data) const;
         //BBS: change volume to seperate objects
-        bool _add_mesh_to_object_stream(std::function<bool(std::string &, bool)> const &flush, ObjectData const &object_data) const;
+        bool _add_mesh_to_object_stream(std::function<bool(std::string &, bool)> const &flush, ObjectData const &object_data, MeshSidecar *sidecar = nullptr) const;
         bool _add_build_to_model_stream(std::stringstream& stream, const BuildItemsList& build_items) const;
         bool _add_layer_height_profile_file_to_archive(mz_zip_archive& archive, Model& model);
         bool _add_layer_config_ranges_file_to_archive(mz_zip_archive& archive, Model& model);
@@ -5710,6 +6284,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         m_from_backup_save = store_params.strategy & SaveStrategy::Backup;
 
         m_use_loaded_id = store_params.strategy & SaveStrategy::UseLoadedId;
+        m_compression_level = (store_params.strategy & SaveStrategy::FastCompression) ? MZ_BEST_SPEED : MZ_DEFAULT_COMPRESSION;
+        m_mesh_sidecar = store_params.strategy & SaveStrategy::MeshSidecar;
 
         if (auto info = store_params.model->model_info) {
             if (auto iter = info->metadata_items.find("Thumbnail_Small"); iter != info->metadata_items.end())
@@ -5743,6 +6319,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
     {
         m_production_ext = true;
         m_from_backup_save = true;
+        m_compression_level = MZ_BEST_SPEED;
+        m_mesh_sidecar = true;
         Model const & model = *object.get_model();
 
         mz_zip_archive archive;
@@ -6167,7 +6745,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                     plate_data->gcode_file_md5 = std::string(md5_str);
                     std::string target_file    = (boost::format("Metadata/plate_%1%.gcode.md5") % (plate_data->plate_index + 1)).str();
                     if (!mz_zip_writer_add_mem(&archive, target_file.c_str(), (const void *) plate_data->gcode_file_md5.c_str(), plate_data->gcode_file_md5.length(),
-                                               MZ_DEFAULT_COMPRESSION)) {
+                                               m_compression_level)) {
                         BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__
                                                  << boost::format(", store  gcode md5 to 3mf's %1%,  length %2%, failed\n") %target_file %plate_data->gcode_file_md5.length();
                         return false;
@@ -6267,11 +6845,11 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         auto end = nocomp_exts + sizeof(nocomp_exts) / sizeof(nocomp_exts[0]);
         bool nocomp = std::find_if(nocomp_exts, end, [&path_in_zip](auto & ext) { return boost::algorithm::ends_with(path_in_zip, ext); }) != end;
 #if WRITE_ZIP_LANGUAGE_ENCODING
-        bool result = mz_zip_writer_add_file(&archive, path_in_zip.c_str(), encode_path(src_file_path.c_str()).c_str(), NULL, 0, nocomp ? MZ_NO_COMPRESSION : MZ_DEFAULT_LEVEL);
+        bool result = mz_zip_writer_add_file(&archive, path_in_zip.c_str(), encode_path(src_file_path.c_str()).c_str(), NULL, 0, nocomp ? MZ_NO_COMPRESSION : m_compression_level);
 #else
         std::string native_path = encode_path(path_in_zip.c_str());
         std::string extra = ZipUnicodePathExtraField::encode(path_in_zip, native_path);
-        bool result = mz_zip_writer_add_file_ex(&archive, native_path.c_str(), encode_path(src_file_path.c_str()).c_str(), NULL, 0, nocomp ? MZ_ZIP_FLAG_ASCII_FILENAME : MZ_DEFAULT_COMPRESSION,
+        bool result = mz_zip_writer_add_file_ex(&archive, native_path.c_str(), encode_path(src_file_path.c_str()).c_str(), NULL, 0, nocomp ? MZ_ZIP_FLAG_ASCII_FILENAME : m_compression_level,
                 extra.c_str(), extra.length(), extra.c_str(), extra.length());
 #endif
         if (!result) {
@@ -6292,11 +6870,13 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         stream << " <Default Extension=\"model\" ContentType=\"application/vnd.ms-package.3dmanufacturing-3dmodel+xml\"/>\n";
         stream << " <Default Extension=\"png\" ContentType=\"image/png\"/>\n";
         stream << " <Default Extension=\"gcode\" ContentType=\"text/x.gcode\"/>\n";
+        if (m_mesh_sidecar)
+            stream << " <Default Extension=\"" << MESH_SIDECAR_EXTENSION.substr(1) << "\" ContentType=\"application/octet-stream\"/>\n";
         stream << "</Types>";
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add content types file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add content types file to archive\n");
             return false;
@@ -6399,7 +6979,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         std::string out = j.dump();
 
         std::string json_file_name = (boost::format(PATTERN_CONFIG_FILE_FORMAT) % (index + 1)).str();
-        if (!mz_zip_writer_add_mem(&archive, json_file_name.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, json_file_name.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add json file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add json file to archive\n");
             return false;
@@ -6472,7 +7052,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, from.empty() ? RELATIONSHIPS_FILE.c_str() : from.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, from.empty() ? RELATIONSHIPS_FILE.c_str() : from.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add relationships file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add relationships file to archive\n");
             return false;
@@ -6511,8 +7091,10 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         std::string zip_filename = encode_path(filename.c_str());
         std::string extra = sub_model ? ZipUnicodePathExtraField::encode(filename, zip_filename) : "";
 #endif
+        const char *model_filename = sub_model ? zip_filename.c_str() : MODEL_FILE.c_str();
+        MeshSidecar sidecar;
         mz_zip_writer_staged_context context;
-        if (!mz_zip_writer_add_staged_open(&archive, &context, sub_model ? zip_filename.c_str() : MODEL_FILE.c_str(),
+        if (!mz_zip_writer_add_staged_open(&archive, &context, model_filename,
             m_zip64 ?
                 // Maximum expected and allowed 3MF file size is 16GiB.
                 // This switches the ZIP file to a 64bit mode, which adds a tiny bit of overhead to file records.
@@ -6521,9 +7103,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 // GH issue #6193.
                 (uint64_t(1) << 32) - 1,
 #if WRITE_ZIP_LANGUAGE_ENCODING
-            nullptr, nullptr, 0, MZ_DEFAULT_LEVEL, nullptr, 0, nullptr, 0)) {
+            nullptr, nullptr, 0, m_compression_level, nullptr, 0, nullptr, 0)) {
 #else
-            nullptr, nullptr, 0, MZ_DEFAULT_COMPRESSION, extra.c_str(), extra.length(), extra.c_str(), extra.length())) {
+            nullptr, nullptr, 0, m_compression_level, extra.c_str(), extra.length(), extra.c_str(), extra.length())) {
 #endif
             add_error("Unable to add model file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add model file to archive\n");
@@ -6716,7 +7298,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                     // Store geometry of all ModelVolumes contained in a single ModelObject into a single 3MF indexed triangle set object.
                     // object_it->second.volumes_objectID will contain the offsets of the ModelVolumes in that single indexed triangle set.
                     // object_id will be increased to point to the 1st instance of the next ModelObject.
-                    if (!_add_object_to_model_stream(context, object_it->second)) {
+                    if (!_add_object_to_model_stream(context, object_it->second, m_mesh_sidecar ? &sidecar : nullptr)) {
                         add_error("Unable to add object to archive");
                         BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add object to archive\n");
                         return false;
@@ -6770,6 +7352,16 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             }
         }
 
+        if (! sidecar.empty()) {
+            // Stored, the binary meshes hardly compress and the importer extracts them by a single copy.
+            std::string out = sidecar.serialize(context.uncomp_crc32, context.uncomp_size);
+            if (! out.empty() && ! mz_zip_writer_add_mem(&archive, (std::string(model_filename) + MESH_SIDECAR_EXTENSION).c_str(), out.data(), out.size(), MZ_NO_COMPRESSION)) {
+                add_error("Unable to add mesh sidecar file to archive");
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add mesh sidecar file to archive\n");
+                return false;
+            }
+        }
+
         if (m_skip_model || write_object) return true;
 
         // write model rels
@@ -6795,8 +7387,10 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                     mz_zip_zero_struct(&archive);
                     mz_zip_reader_init_mem(&archive, ppBuf, pSize, 0);
                     {
+                        // The model file, followed by its mesh sidecar if any.
                         boost::unique_lock l(mutex);
-                        mz_zip_writer_add_from_zip_reader(main, &archive, 0);
+                        for (mz_uint file_index = 0; file_index < mz_zip_reader_get_num_files(&archive); ++ file_index)
+                            mz_zip_writer_add_from_zip_reader(main, &archive, file_index);
                     }
                     mz_zip_reader_end(&archive);
                 }
@@ -6806,12 +7400,14 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         return true;
     }
 
-    bool _BBS_3MF_Exporter::_add_object_to_model_stream(mz_zip_writer_staged_context &context, ObjectData const &object_data) const
+    bool _BBS_3MF_Exporter::_add_object_to_model_stream(mz_zip_writer_staged_context &context, ObjectData const &object_data, MeshSidecar *sidecar) const
     {
         // backup: make _add_mesh_to_object_stream() reusable
-        auto flush = [this, &context](std::string & buf, bool force = false) {
+        // A large mesh is deflated by multiple threads in independent blocks.
+        ParallelDeflateWriter writer(context, m_compression_level);
+        auto flush = [this, &writer](std::string & buf, bool force = false) {
             if ((force && !buf.empty()) || buf.size() >= 65536 * 16) {
-                if (!mz_zip_writer_add_staged_data(&context, buf.data(), buf.size())) {
+                if (!writer.write(buf.data(), buf.size())) {
                     add_error("Error during writing or compression");
                     BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Error during writing or compression\n");
                     return false;
@@ -6820,7 +7416,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             }
             return true;
         };
-        if (!_add_mesh_to_object_stream(flush, object_data)) {
+        if (!_add_mesh_to_object_stream(flush, object_data, sidecar) || !writer.finish()) {
             add_error("Unable to add mesh to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add mesh to archive\n");
             return false;
@@ -6898,7 +7494,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 #endif // EXPORT_3MF_USE_SPIRIT_KARMA_FP
 
     //BBS: change volume to seperate objects
-    bool _BBS_3MF_Exporter::_add_mesh_to_object_stream(std::function<bool(std::string &, bool)> const &flush, ObjectData const &object_data) const
+    bool _BBS_3MF_Exporter::_add_mesh_to_object_stream(std::function<bool(std::string &, bool)> const &flush, ObjectData const &object_data, MeshSidecar *sidecar) const
     {
         std::string output_buffer;
 
@@ -7053,6 +7649,8 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             //triangles_count += (int)its.indices.size();
             //unsigned int last_triangle_id = triangles_count - 1;
 
+            // The triangles with painting or face properties are not stored into the sidecar.
+            bool has_triangle_attributes = false;
             for (int i = 0; i < int(its.indices.size()); ++ i) {
                 {
                     const Vec3i32 &idx = its.indices[i];
@@ -7070,6 +7668,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
                 std::string custom_supports_data_string = volume->supported_facets.get_triangle_as_string(i);
                 if (! custom_supports_data_string.empty()) {
+                    has_triangle_attributes = true;
                     output_buffer += " ";
                     output_buffer += CUSTOM_SUPPORTS_ATTR;
                     output_buffer += "=\"";
@@ -7079,6 +7678,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
                 std::string custom_seam_data_string = volume->seam_facets.get_triangle_as_string(i);
                 if (! custom_seam_data_string.empty()) {
+                    has_triangle_attributes = true;
                     output_buffer += " ";
                     output_buffer += CUSTOM_SEAM_ATTR;
                     output_buffer += "=\"";
@@ -7088,6 +7688,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
                 std::string mmu_painting_data_string = volume->mmu_segmentation_facets.get_triangle_as_string(i);
                 if (! mmu_painting_data_string.empty()) {
+                    has_triangle_attributes = true;
                     output_buffer += " ";
                     output_buffer += MMU_SEGMENTATION_ATTR;
                     output_buffer += "=\"";
@@ -7097,6 +7698,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
                 std::string fuzzy_skin_painting_data_string = volume->fuzzy_skin_facets.get_triangle_as_string(i);
                 if (!fuzzy_skin_painting_data_string.empty()) {
+                    has_triangle_attributes = true;
                     output_buffer += " ";
                     output_buffer += CUSTOM_FUZZY_SKIN_ATTR;
                     output_buffer += "=\"";
@@ -7108,6 +7710,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 if (i < its.properties.size()) {
                     std::string prop_str = its.properties[i].to_string();
                     if (!prop_str.empty()) {
+                        has_triangle_attributes = true;
                         output_buffer += " ";
                         output_buffer += FACE_PROPERTY_ATTR;
                         output_buffer += "=\"";
@@ -7121,6 +7724,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 if (! flush(output_buffer, false))
                     return false;
             }
+            if (sidecar)
+                sidecar->add_mesh(its.vertices, has_triangle_attributes ? nullptr : &its.indices);
+
             output_buffer += "    </";
             output_buffer += TRIANGLES_TAG;
             output_buffer += ">\n   </";
@@ -7228,7 +7834,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add cut information file to archive");
                 return false;
             }
@@ -7262,7 +7868,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, BBS_LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BBS_LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add layer heights profile file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add layer heights profile file to archive\n");
                 return false;
@@ -7321,7 +7927,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add layer heights profile file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add layer heights profile file to archive\n");
                 return false;
@@ -7357,7 +7963,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             out = std::string("brim_points_format_version=") + std::to_string(brim_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, BRIM_EAR_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BRIM_EAR_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add brim ear points file to archive");
                 return false;
             }
@@ -7393,7 +7999,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             //out = std::string("support_points_format_version=") + std::to_string(support_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add sla support points file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add sla support points file to archive\n");
                 return false;
@@ -7445,7 +8051,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             //out = std::string("drain_holes_format_version=") + std::to_string(drain_holes_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(MZ_DEFAULT_COMPRESSION))) {
+            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(m_compression_level))) {
                 add_error("Unable to add sla support points file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add sla support points file to archive\n");
                 return false;
@@ -7466,7 +8072,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 out += "; " + key + " = " + config.opt_serialize(key) + "\n";
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, BBS_PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BBS_PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add print config file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add print config file to archive\n");
                 return false;
@@ -7854,7 +8460,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         stream << "</" << CONFIG_TAG << ">\n";
 
         std::string out = stream.str();
-        if (!mz_zip_writer_add_mem(&archive, BBS_MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, BBS_MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add model config file to archive\n");
             add_error("Unable to add model config file to archive");
             return false;
@@ -8009,7 +8615,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, SLICE_INFO_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, SLICE_INFO_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add model config file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", store  slice-info to 3mf,  length %1%, failed\n") % out.length();
             return false;
@@ -8051,7 +8657,7 @@ bool _BBS_3MF_Exporter::_add_gcode_file_to_archive(mz_zip_archive& archive, cons
             mz_zip_writer_init_heap(&archive, 0, 1024 * 1024);
             {
                 mz_zip_writer_add_staged_open(&archive, &context, gcode_in_3mf.c_str(), m_zip64 ? (uint64_t(1) << 30) * 16 : (uint64_t(1) << 32) - 1, nullptr, nullptr, 0,
-                    MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0);
+                    m_compression_level, nullptr, 0, nullptr, 0);
                 boost::filesystem::path src_gcode_path(src_gcode_file);
                 if (!boost::filesystem::exists(src_gcode_path)) {
                     BOOST_LOG_TRIVIAL(error) << "Gcode is missing, filename = " << src_gcode_file;
@@ -8128,7 +8734,7 @@ bool _BBS_3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive(mz_zip_arc
     }
 
     if (!out.empty()) {
-        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add custom Gcodes per print_z file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add custom Gcodes per print_z file to archive\n");
             return false;
@@ -134,10 +134,12 @@ enum class SaveStrategy
     SkipAuxiliary       = 1 << 9,
     UseLoadedId         = 1 << 10,
     ShareMesh           = 1 << 11,
+    FastCompression     = 1 << 13, // deflate with the fastest level, trading file size for saving time
+    MeshSidecar         = 1 << 14, // store a binary copy of the meshes next to the model files for a fast reload by OrcaSlicer
 
     SplitModel = 0x1000 | ProductionExt,
     Encrypted  = SecureContentExt | SplitModel,
-    Backup = 0x10000 | WithGcode | Silence | SkipStatic | SplitModel,
+    Backup = 0x10000 | WithGcode | Silence | SkipStatic | SplitModel | FastCompression | MeshSidecar,
 };
 
 inline SaveStrategy operator | (SaveStrategy lhs, SaveStrategy rhs)
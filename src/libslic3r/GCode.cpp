@@ -90,6 +90,14 @@ static const float g_min_purge_volume = 100.f;
 static const float g_purge_volume_one_time = 135.f;
 static const int g_max_flush_count = 4;
 static const size_t g_max_label_object = 64;
+// Memory the deflated G-code may take during the export to be post-processed without reading the temporary file back:
+// 1/32 of the physical memory, between 64MB and 256MB. G-code deflates three to four times, thus G-codes of several
+// hundred megabytes are kept in memory. Larger G-codes are spilled into the temporary file once the limit is reached
+// and post-processed from the file, so that a large print does not hold the whole G-code in memory next to the G-code processor data.
+static size_t max_gcode_memory_buffer_size()
+{
+    return std::clamp<size_t>(total_physical_memory() / 32, size_t(64) << 20, size_t(256) << 20);
+}
 
 Vec2d travel_point_1;
 Vec2d travel_point_2;
@@ -2044,6 +2052,9 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
     m_processor.initialize(path_tmp);
     m_processor.set_print(print);
     GCodeOutputStream file(boost::nowide::fopen(path_tmp.c_str(), "wb"), m_processor);
+    // Keep the G-code in memory, so that the G-code processor writes the file with the time estimates
+    // filled in with a single pass instead of re-reading the complete file.
+    file.enable_memory_buffer(max_gcode_memory_buffer_size());
     if (! file.is_open()) {
         BOOST_LOG_TRIVIAL(error) << std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n" << std::endl;
         if (!fs::exists(folder)) {
@@ -2068,6 +2079,8 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         boost::nowide::remove(path_tmp.c_str());
         throw;
     }
+    if (file.is_memory_buffered())
+        m_processor.set_gcode_buffer(file.extract_memory_buffer());
     file.close();
 
     check_placeholder_parser_failed();
@@ -3527,6 +3540,27 @@ size_t GCode::get_extruder_id(unsigned int filament_id) const
     return 0;
 }
 
+// Layer G-code passed between the stages of the process_layers() pipeline. The G-code is tokenized once by a parallel stage,
+// the filters pass the tokenized lines to each other and the output stage concatenates their text. LayerResult::gcode is empty.
+struct TokenizedLayerResult {
+    LayerResult                     layer;
+    GCodeLines                      lines;
+};
+
+// Same as above, together with the lines pre-parsed for the CoolingBuffer by a parallel stage.
+struct CoolingLayerResult {
+    LayerResult                             layer;
+    GCodeLines                              lines;
+    std::vector<CoolingBuffer::ParsedLine>  parsed;
+};
+
+// Layer G-code passed between the stages of the process_layers() pipeline together with the PA_CHANGE tags
+// pre-scanned for the AdaptivePAProcessor by a parallel stage.
+struct PAScannedGCode {
+    GCodeLines                                      lines;
+    std::vector<AdaptivePAProcessor::PAChange>      pa_changes;
+};
+
 // Process all layers of all objects (non-sequential mode) with a parallel pipeline:
 // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
 // and export G-code into file.
@@ -3568,37 +3602,70 @@ void GCode::process_layers(
         float max_xy_smoothing = m_config.get_abs_value("spiral_mode_max_xy_smoothing", nozzle_diameter);
         this->m_spiral_vase->set_max_xy_smoothing(max_xy_smoothing);
     }
-    const auto spiral_mode = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](LayerResult in) -> LayerResult {
-        	if (in.nop_layer_result)
+    // Tokenize the layer G-code once in parallel, the following stages pass the tokenized lines to each other.
+    const auto tokenize = tbb::make_filter<LayerResult, TokenizedLayerResult>(slic3r_tbb_filtermode::parallel,
+        [](LayerResult in) -> TokenizedLayerResult {
+            CNumericLocalesSetter locales_setter;
+            TokenizedLayerResult out;
+            if (! in.nop_layer_result) {
+                out.lines = GCodeLines(std::move(in.gcode));
+                in.gcode.clear();
+            }
+            out.layer = std::move(in);
+            return out;
+        });
+    const auto spiral_mode = tbb::make_filter<TokenizedLayerResult, TokenizedLayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](TokenizedLayerResult in) -> TokenizedLayerResult {
+            if (in.layer.nop_layer_result)
                 return in;
-                
-            spiral_mode.enable(in.spiral_vase_enable);
-            bool last_layer = in.layer_id == layers_to_print.size() - 1;
-            return { spiral_mode.process_layer(std::move(in.gcode), last_layer), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush};
+            spiral_mode.enable(in.layer.spiral_vase_enable);
+            bool last_layer = in.layer.layer_id == layers_to_print.size() - 1;
+            in.lines = spiral_mode.process_layer(std::move(in.lines), last_layer);
+            return in;
+        });
+    const auto pressure_equalizer = tbb::make_filter<TokenizedLayerResult, TokenizedLayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [pressure_equalizer = this->m_pressure_equalizer.get()](TokenizedLayerResult in) -> TokenizedLayerResult {
+            TokenizedLayerResult out;
+            out.layer = pressure_equalizer->process_layer(std::move(in.layer), std::move(in.lines), out.lines);
+            return out;
         });
-    const auto pressure_equalizer = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [pressure_equalizer = this->m_pressure_equalizer.get()](LayerResult in) -> LayerResult {
-            return pressure_equalizer->process_layer(std::move(in));
+    // Parsing of the layer G-code for the cooling buffer does not depend on the cooling buffer state,
+    // thus it runs in parallel for the layers queued in the pipeline. Only the state carry stays serial.
+    const auto cooling_parse = tbb::make_filter<TokenizedLayerResult, CoolingLayerResult>(slic3r_tbb_filtermode::parallel,
+        [&cooling_buffer = *this->m_cooling_buffer.get()](TokenizedLayerResult in) -> CoolingLayerResult {
+            CoolingLayerResult out;
+            if (! in.layer.nop_layer_result)
+                out.parsed = cooling_buffer.parse_lines(in.lines);
+            out.layer = std::move(in.layer);
+            out.lines = std::move(in.lines);
+            return out;
         });
-    const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&cooling_buffer = *this->m_cooling_buffer.get()](LayerResult in) -> std::string {
-        	if (in.nop_layer_result)
-                return in.gcode;
-            return cooling_buffer.process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
+    const auto cooling = tbb::make_filter<CoolingLayerResult, GCodeLines>(slic3r_tbb_filtermode::serial_in_order,
+        [&cooling_buffer = *this->m_cooling_buffer.get()](CoolingLayerResult in) -> GCodeLines {
+            if (in.layer.nop_layer_result)
+                return std::move(in.lines);
+            return cooling_buffer.process_layer(std::move(in.lines), std::move(in.parsed), in.layer.layer_id, in.layer.cooling_buffer_flush);
+        });
+    // Same for the look-ahead of the adaptive pressure advance processor.
+    const auto pa_processor_scan = tbb::make_filter<GCodeLines, PAScannedGCode>(slic3r_tbb_filtermode::parallel,
+        [&pa_processor = *this->m_pa_processor](GCodeLines in) -> PAScannedGCode {
+            PAScannedGCode out;
+            out.pa_changes = pa_processor.scan_layer(in);
+            out.lines      = std::move(in);
+            return out;
+        });
+    const auto pa_processor_filter = tbb::make_filter<PAScannedGCode, GCodeLines>(slic3r_tbb_filtermode::serial_in_order,
+        [&pa_processor = *this->m_pa_processor](PAScannedGCode in) -> GCodeLines {
+            return pa_processor.process_layer(std::move(in.lines), in.pa_changes);
         });
-    const auto pa_processor_filter = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-            [&pa_processor = *this->m_pa_processor](std::string in) -> std::string {
-                return pa_processor.process_layer(std::move(in));
-            }
-        );
     
-    const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+    // The G-code text of a layer is concatenated just once, here.
+    const auto output = tbb::make_filter<GCodeLines, void>(slic3r_tbb_filtermode::serial_in_order,
+        [&output_stream](GCodeLines lines) { output_stream.write(lines.str()); }
     );
 
-    const auto fan_mover = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-            [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](std::string in)->std::string {
+    const auto fan_mover = tbb::make_filter<GCodeLines, GCodeLines>(slic3r_tbb_filtermode::serial_in_order,
+            [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](GCodeLines in)->GCodeLines {
 
         CNumericLocalesSetter locales_setter;
 
@@ -3612,20 +3679,20 @@ void GCode::process_layers(
                     config.fan_speedup_overhangs.value,
                     (float)config.fan_kickstart.value));
             //flush as it's a whole layer
-            return fan_mover->process_gcode(in, true);
+            return fan_mover->process_gcode(std::move(in), true);
         }
         return in;
     });
 
     // The pipeline elements are joined using const references, thus no copying is performed.
     if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, generator & tokenize & spiral_mode & pressure_equalizer & cooling_parse & cooling & fan_mover & output);
     else if (m_spiral_vase)
-    	tbb::parallel_pipeline(12, generator & spiral_mode & cooling & fan_mover & output);
+    	tbb::parallel_pipeline(12, generator & tokenize & spiral_mode & cooling_parse & cooling & fan_mover & output);
     else if	(m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(12, generator & tokenize & pressure_equalizer & cooling_parse & cooling & fan_mover & pa_processor_scan & pa_processor_filter & output);
     else
-    	tbb::parallel_pipeline(12, generator & cooling & fan_mover & pa_processor_filter & output);
+    	tbb::parallel_pipeline(12, generator & tokenize & cooling_parse & cooling & fan_mover & pa_processor_scan & pa_processor_filter & output);
 
 }
 
@@ -3669,36 +3736,70 @@ void GCode::process_layers(
         float max_xy_smoothing = m_config.get_abs_value("spiral_mode_max_xy_smoothing", nozzle_diameter);
         this->m_spiral_vase->set_max_xy_smoothing(max_xy_smoothing);
     }
-    const auto spiral_mode = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](LayerResult in)->LayerResult {
-            if (in.nop_layer_result)
+    // Tokenize the layer G-code once in parallel, the following stages pass the tokenized lines to each other.
+    const auto tokenize = tbb::make_filter<LayerResult, TokenizedLayerResult>(slic3r_tbb_filtermode::parallel,
+        [](LayerResult in) -> TokenizedLayerResult {
+            CNumericLocalesSetter locales_setter;
+            TokenizedLayerResult out;
+            if (! in.nop_layer_result) {
+                out.lines = GCodeLines(std::move(in.gcode));
+                in.gcode.clear();
+            }
+            out.layer = std::move(in);
+            return out;
+        });
+    const auto spiral_mode = tbb::make_filter<TokenizedLayerResult, TokenizedLayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [&spiral_mode = *this->m_spiral_vase.get(), &layers_to_print](TokenizedLayerResult in) -> TokenizedLayerResult {
+            if (in.layer.nop_layer_result)
                 return in;
-            spiral_mode.enable(in.spiral_vase_enable);
-            bool last_layer = in.layer_id == layers_to_print.size() - 1;
-            return { spiral_mode.process_layer(std::move(in.gcode), last_layer), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush };
+            spiral_mode.enable(in.layer.spiral_vase_enable);
+            bool last_layer = in.layer.layer_id == layers_to_print.size() - 1;
+            in.lines = spiral_mode.process_layer(std::move(in.lines), last_layer);
+            return in;
+        });
+    const auto pressure_equalizer = tbb::make_filter<TokenizedLayerResult, TokenizedLayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [pressure_equalizer = this->m_pressure_equalizer.get()](TokenizedLayerResult in) -> TokenizedLayerResult {
+            TokenizedLayerResult out;
+            out.layer = pressure_equalizer->process_layer(std::move(in.layer), std::move(in.lines), out.lines);
+            return out;
         });
-    const auto pressure_equalizer = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [pressure_equalizer = this->m_pressure_equalizer.get()](LayerResult in) -> LayerResult {
-             return pressure_equalizer->process_layer(std::move(in));
+    // Parsing of the layer G-code for the cooling buffer does not depend on the cooling buffer state,
+    // thus it runs in parallel for the layers queued in the pipeline. Only the state carry stays serial.
+    const auto cooling_parse = tbb::make_filter<TokenizedLayerResult, CoolingLayerResult>(slic3r_tbb_filtermode::parallel,
+        [&cooling_buffer = *this->m_cooling_buffer.get()](TokenizedLayerResult in) -> CoolingLayerResult {
+            CoolingLayerResult out;
+            if (! in.layer.nop_layer_result)
+                out.parsed = cooling_buffer.parse_lines(in.lines);
+            out.layer = std::move(in.layer);
+            out.lines = std::move(in.lines);
+            return out;
         });
-    const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&cooling_buffer = *this->m_cooling_buffer.get()](LayerResult in)->std::string {
-            if (in.nop_layer_result)
-                return in.gcode;
-            return cooling_buffer.process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
+    const auto cooling = tbb::make_filter<CoolingLayerResult, GCodeLines>(slic3r_tbb_filtermode::serial_in_order,
+        [&cooling_buffer = *this->m_cooling_buffer.get()](CoolingLayerResult in) -> GCodeLines {
+            if (in.layer.nop_layer_result)
+                return std::move(in.lines);
+            return cooling_buffer.process_layer(std::move(in.lines), std::move(in.parsed), in.layer.layer_id, in.layer.cooling_buffer_flush);
+        });
+    // Same for the look-ahead of the adaptive pressure advance processor.
+    const auto pa_processor_scan = tbb::make_filter<GCodeLines, PAScannedGCode>(slic3r_tbb_filtermode::parallel,
+        [&pa_processor = *this->m_pa_processor](GCodeLines in) -> PAScannedGCode {
+            PAScannedGCode out;
+            out.pa_changes = pa_processor.scan_layer(in);
+            out.lines      = std::move(in);
+            return out;
+        });
+    const auto pa_processor_filter = tbb::make_filter<PAScannedGCode, GCodeLines>(slic3r_tbb_filtermode::serial_in_order,
+        [&pa_processor = *this->m_pa_processor](PAScannedGCode in) -> GCodeLines {
+            return pa_processor.process_layer(std::move(in.lines), in.pa_changes);
         });
-    const auto pa_processor_filter = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&pa_processor = *this->m_pa_processor](std::string in) -> std::string {
-            return pa_processor.process_layer(std::move(in));
-        }
-    );
     
-    const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+    // The G-code text of a layer is concatenated just once, here.
+    const auto output = tbb::make_filter<GCodeLines, void>(slic3r_tbb_filtermode::serial_in_order,
+        [&output_stream](GCodeLines lines) { output_stream.write(lines.str()); }
     );
 
-    const auto fan_mover = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
-        [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](std::string in)->std::string {
+    const auto fan_mover = tbb::make_filter<GCodeLines, GCodeLines>(slic3r_tbb_filtermode::serial_in_order,
+            [&fan_mover = this->m_fan_mover, &config = this->config(), &writer = this->m_writer](GCodeLines in)->GCodeLines {
 
         if (config.fan_speedup_time.value != 0 || config.fan_kickstart.value > 0) {
             if (fan_mover.get() == nullptr)
@@ -3710,20 +3811,20 @@ void GCode::process_layers(
                     config.fan_speedup_overhangs.value,
                     (float)config.fan_kickstart.value));
             //flush as it's a whole layer
-            return fan_mover->process_gcode(in, true);
+            return fan_mover->process_gcode(std::move(in), true);
         }
         return in;
     });
 
     // The pipeline elements are joined using const references, thus no copying is performed.
     if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, generator & tokenize & spiral_mode & pressure_equalizer & cooling_parse & cooling & fan_mover & output);
     else if (m_spiral_vase)
-    	tbb::parallel_pipeline(12, generator & spiral_mode & cooling & fan_mover & output);
+    	tbb::parallel_pipeline(12, generator & tokenize & spiral_mode & cooling_parse & cooling & fan_mover & output);
     else if	(m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(12, generator & tokenize & pressure_equalizer & cooling_parse & cooling & fan_mover & pa_processor_scan & pa_processor_filter & output);
     else
-    	tbb::parallel_pipeline(12, generator & cooling & fan_mover & pa_processor_filter & output);
+    	tbb::parallel_pipeline(12, generator & tokenize & cooling_parse & cooling & fan_mover & pa_processor_scan & pa_processor_filter & output);
 }
 
 std::string GCode::placeholder_parser_process(const std::string &name, const std::string &templ, unsigned int current_filament_id, const DynamicConfig *config_override)
@@ -6025,8 +6126,18 @@ void GCode::GCodeOutputStream::write(const char *what)
 {
     if (what != nullptr) {
         const char* gcode = what;
-        // writes string to file
-        fwrite(gcode, 1, ::strlen(gcode), this->f);
+        if (m_memory_buffer) {
+            m_memory_buffer->append(gcode, ::strlen(gcode));
+            if (m_memory_buffer->memory_used() > m_memory_buffer_max_memory) {
+                // The G-code is too large to be kept in memory, continue writing it into the file.
+                // A write error is reported by is_error().
+                m_memory_buffer->finish();
+                m_memory_buffer->write(this->f);
+                m_memory_buffer.reset();
+            }
+        } else
+            // writes string to file
+            fwrite(gcode, 1, ::strlen(gcode), this->f);
         //FIXME don't allocate a string, maybe process a batch of lines?
         m_processor.process_buffer(std::string(gcode));
     }
@@ -324,9 +324,19 @@ private:
         // Formats and write into a file the given data.
         void write_format(const char* format, ...);
 
+        // Keep the G-code in memory instead of writing it into the file, so that the G-code post-processor does not need
+        // to read the file back. The G-code is kept deflated, once it takes more than max_memory bytes, the memory buffer
+        // is spilled into the file and the rest of the G-code is written into the file.
+        void enable_memory_buffer(size_t max_memory) { m_memory_buffer = std::make_unique<GCodeMemoryBuffer>(); m_memory_buffer_max_memory = max_memory; }
+        // Is the complete G-code held by the memory buffer?
+        bool is_memory_buffered() const { return m_memory_buffer != nullptr; }
+        std::unique_ptr<GCodeMemoryBuffer> extract_memory_buffer() { m_memory_buffer->finish(); return std::move(m_memory_buffer); }
+
     private:
         FILE *f = nullptr;
         GCodeProcessor &m_processor;
+        std::unique_ptr<GCodeMemoryBuffer>  m_memory_buffer;
+        size_t                              m_memory_buffer_max_memory { 0 };
     };
     void            _do_export(Print &print, GCodeOutputStream &file, ThumbnailsGeneratorCallback thumbnail_cb);
 
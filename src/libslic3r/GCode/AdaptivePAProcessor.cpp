@@ -9,6 +9,8 @@
 #include <iostream>
 #include <cmath>
 
+#include <boost/algorithm/string/predicate.hpp>
+
 namespace Slic3r {
 
 /**
@@ -55,84 +57,48 @@ AdaptivePAInterpolator* AdaptivePAProcessor::getInterpolator(unsigned int tool_i
 }
 
 /**
- * @brief Processes a layer of G-code and applies adaptive pressure advance.
+ * @brief Parses the PA_CHANGE tags of a layer and performs their feed rate look-ahead.
  *
- * This method processes the G-code for a single layer, identifying the appropriate
- * pressure advance settings and applying them based on the current state and configurations.
+ * For each PA_CHANGE tag, the following layer G-code lines are searched for the print speed
+ * of the upcoming island. If a G1 Fxxxx pattern is found, the new speed is identified.
+ * The search carries on to find the maximum print speed until a feature change pattern,
+ * a travel move following an extrusion or a wipe command is detected.
  *
  * @param gcode A string containing the G-code for the layer.
- * @return A string containing the processed G-code with adaptive pressure advance applied.
+ * @return The PA_CHANGE tags of the layer, sorted by their position in the layer.
  */
-std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
-    std::istringstream stream(gcode);
-    std::string line;
-    std::ostringstream output;
-    double mm3mm_value = 0.0;
-    unsigned int accel_value = 0;
-    std::string pa_change_line;
-    bool wipe_command = false;
+// Text of a G-code line without the trailing newline.
+static inline std::string_view gcode_line(const GCodeLines &gcode, size_t line_idx)
+{
+    std::string_view line = gcode.line_with_eol(line_idx);
+    if (! line.empty() && line.back() == '\n')
+        line.remove_suffix(1);
+    return line;
+}
+
+std::vector<AdaptivePAProcessor::PAChange> AdaptivePAProcessor::scan_layer(const GCodeLines &gcode) const {
+    std::vector<PAChange> out;
+    std::smatch match;
+    for (size_t line_idx = 0; line_idx < gcode.size(); ++ line_idx) {
+        if (boost::starts_with(gcode_line(gcode, line_idx), "; PA_CHANGE")) { // prune lines quickly before running regex check as regex is more expensive to run
+            const std::string line(gcode_line(gcode, line_idx));
+            if (std::regex_search(line, match, m_pa_change_pattern)) {
+                PAChange pa_change;
+                pa_change.line_idx            = line_idx;
+                pa_change.extruder_id         = std::stoi(match[1].str());
+                pa_change.mm3mm               = std::stod(match[2].str());
+                pa_change.accel               = std::stod(match[3].str());
+                pa_change.is_bridge           = std::stoi(match[4].str());
+                pa_change.is_overhang         = std::stoi(match[6].str());
+                pa_change.max_next_feedrate   = 0;
+                pa_change.next_feedrate       = 0;
+                pa_change.first_line_feedrate = 0;
 
-    // Iterate through each line of the layer G-code
-    while (std::getline(stream, line)) {
-        
-        // If a wipe start command is found, ignore all speed changes till the wipe end part is found
-        if (line.find("WIPE_START") != std::string::npos) {
-            wipe_command = true;
-        }
-                
-        // Update current feed rate (this is preceding an extrude or wipe command only). Ignore any speed changes that are emitted during a wipe move.
-        // Travel feedrate is output as part of a G1 X Y (Z) F command
-        if ( (line.find("G1 F") == 0) && (!wipe_command) ) { // prune lines quickly before running pattern matching
-            std::size_t pos = line.find('F');
-            if (pos != std::string::npos){
-                m_current_feedrate = std::stod(line.substr(pos + 1)) / 60.0; // Convert from mm/min to mm/s
-            }
-        }
-        
-        // Wipe end found, continue searching for current feed rate.
-        if (line.find("WIPE_END") != std::string::npos) {
-            wipe_command = false;
-        }
-        
-        // Reset next feedrate to zero enable searching for the first encountered
-        // feedrate change command after the PA change tag.
-        m_next_feedrate = 0;
-        
-        // Check for PA_CHANGE pattern in the line
-        // We will only find this pattern for extruders where adaptive PA is enabled.
-        // If there is mixed extruders in the layer (i.e. with adaptive PA on and off
-        // this will only update the extruders where the adaptive PA is enabled
-        // as these are the only ones where the PA pattern is output
-        // For a mixed extruder layer with both adaptive PA enabled and disabled when the new tool is selected
-        // the PA for that material is set. As no tag below will be found for this extruder, the original PA is retained.
-        if (line.find("; PA_CHANGE") == 0) { // prune lines quickly before running regex check as regex is more expensive to run
-            if (std::regex_search(line, m_match, m_pa_change_pattern)) {
-                int extruder_id = std::stoi(m_match[1].str());
-                mm3mm_value = std::stod(m_match[2].str());
-                accel_value = std::stod(m_match[3].str());
-                int isBridge = std::stoi(m_match[4].str());
-                int roleChange = std::stoi(m_match[5].str());
-                int isOverhang = std::stoi(m_match[6].str());
-                
-                // Check if the extruder ID has changed
-                bool extruder_changed = (extruder_id != m_last_extruder_id);
-                m_last_extruder_id = extruder_id;
-                
-                // Save the PA_CHANGE line to output later after finding feedrate
-                pa_change_line = line;
-                
                 // Look ahead for feedrate before any line containing both G and E commands
-                std::streampos current_pos = stream.tellg();
-                std::string next_line;
-                double temp_feed_rate = 0;
                 bool extrude_move_found = false;
                 int line_counter = 0;
-                
-                // Carry on searching on the layer gcode lines to find the print speed
-                // If a G1 Fxxxx pattern is found, the new speed is identified
-                // Carry on searching for feedrates to find the maximum print speed
-                // until a feature change pattern or a wipe command is detected
-                while (std::getline(stream, next_line)) {
+                for (size_t next_idx = line_idx + 1; next_idx < gcode.size(); ++ next_idx) {
+                    const std::string next_line(gcode_line(gcode, next_idx));
                     line_counter++;
                     // Found an extrude move, set extrude move found flag and move to the next line
                     if ((!extrude_move_found) && next_line.find("G1 ") == 0 &&
@@ -143,7 +109,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                         extrude_move_found = true;
                         continue;
                     }
-                    
+
                     // Found a travel move after we've found at least one extrude move
                     // We now need to stop searching for speeds as we're done printing this island
                     if (next_line.find("G1 ") == 0 &&
@@ -154,7 +120,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                         // First travel move after extrude move found. Stop searching
                         break;
                     }
-                    
+
                     // Found a WIPE command
                     // If we have a wipe command, usually the wipe speed is different (larger) than the max print speed
                     // for that feature. So stop searching if a wipe command is found because we do not want to overwrite the
@@ -162,7 +128,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                     if (next_line.find("WIPE") != std::string::npos) {
                         break; // Stop searching if wipe command is found
                     }
-                    
+
                     // Found another PA_CHANGE pattern
                     // If RC = 1, it means we have a role change, so stop trying to find the max speed for the feature.
                     // This is possibly redundant as a new feature would always have a travel move preceding it
@@ -176,7 +142,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                             }
                         }
                     }
-                    
+
                     // Found a Feedrate change command
                     // If the new feedrate is greater than any feedrate encountered so far after the PA change command, use that to calculate the PA value
                     // Also if this is the first feedrate we encounter, store it as the next feedrate.
@@ -186,29 +152,100 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                             double feedrate = std::stod(next_line.substr(pos + 1)) / 60.0; // Convert from mm/min to mm/s
                             if(line_counter==1){ // this is the first command after the PA change pattern, and hence before any extrusion has happened. Reset
                                                 // the current speed to this one
-                                m_current_feedrate = feedrate;
+                                pa_change.first_line_feedrate = feedrate;
                             }
-                            if (temp_feed_rate < feedrate) {
-                                temp_feed_rate = feedrate;
+                            if (pa_change.max_next_feedrate < feedrate) {
+                                pa_change.max_next_feedrate = feedrate;
                             }
-                            if(m_next_feedrate < EPSILON){ // This the first feedrate found after the PA Change command
-                                m_next_feedrate = feedrate;
+                            if(pa_change.next_feedrate < EPSILON){ // This the first feedrate found after the PA Change command
+                                pa_change.next_feedrate = feedrate;
                             }
                         }
                         continue;
                     }
                 }
+                out.emplace_back(pa_change);
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Processes a layer of G-code and applies adaptive pressure advance.
+ *
+ * This method processes the G-code for a single layer, identifying the appropriate
+ * pressure advance settings and applying them based on the current state and configurations.
+ * The PA_CHANGE tags and their feed rate look-ahead are provided by scan_layer().
+ *
+ * @param gcode The G-code lines of the layer.
+ * @param pa_changes Result of scan_layer() for the same G-code.
+ * @return The processed G-code lines with adaptive pressure advance applied. The lines not modified are passed by reference.
+ */
+GCodeLines AdaptivePAProcessor::process_layer(GCodeLines &&gcode, const std::vector<PAChange> &pa_changes) {
+    GCodeLines output;
+    bool wipe_command = false;
+    auto pa_change_it = pa_changes.begin();
+
+    // Iterate through each line of the layer G-code
+    for (size_t line_idx = 0; line_idx < gcode.size(); ++ line_idx) {
+        const std::string line(gcode_line(gcode, line_idx));
+        
+        // If a wipe start command is found, ignore all speed changes till the wipe end part is found
+        if (line.find("WIPE_START") != std::string::npos) {
+            wipe_command = true;
+        }
+                
+        // Update current feed rate (this is preceding an extrude or wipe command only). Ignore any speed changes that are emitted during a wipe move.
+        // Travel feedrate is output as part of a G1 X Y (Z) F command
+        if ( (line.find("G1 F") == 0) && (!wipe_command) ) { // prune lines quickly before running pattern matching
+            std::size_t pos = line.find('F');
+            if (pos != std::string::npos){
+                m_current_feedrate = std::stod(line.substr(pos + 1)) / 60.0; // Convert from mm/min to mm/s
+            }
+        }
+        
+        // Wipe end found, continue searching for current feed rate.
+        if (line.find("WIPE_END") != std::string::npos) {
+            wipe_command = false;
+        }
+        
+        // Reset next feedrate to zero enable searching for the first encountered
+        // feedrate change command after the PA change tag.
+        m_next_feedrate = 0;
+        
+        // Check for PA_CHANGE pattern in the line
+        // We will only find this pattern for extruders where adaptive PA is enabled.
+        // If there is mixed extruders in the layer (i.e. with adaptive PA on and off
+        // this will only update the extruders where the adaptive PA is enabled
+        // as these are the only ones where the PA pattern is output
+        // For a mixed extruder layer with both adaptive PA enabled and disabled when the new tool is selected
+        // the PA for that material is set. As no tag below will be found for this extruder, the original PA is retained.
+        if (line.find("; PA_CHANGE") == 0) {
+            // Tags not matching the PA_CHANGE pattern were not collected by scan_layer() and they are dropped.
+            if (pa_change_it != pa_changes.end() && pa_change_it->line_idx == line_idx) {
+                const PAChange &pa_change = *pa_change_it ++;
+                double mm3mm_value = pa_change.mm3mm;
+                unsigned int accel_value = pa_change.accel;
+                int isBridge = pa_change.is_bridge;
+                int isOverhang = pa_change.is_overhang;
+                
+                // Check if the extruder ID has changed
+                bool extruder_changed = (pa_change.extruder_id != m_last_extruder_id);
+                m_last_extruder_id = pa_change.extruder_id;
+                
+                // Apply the results of the look ahead for the feedrate.
+                // A feedrate set right after the PA change tag is set before any extrusion has happened, thus it becomes the current speed.
+                if (pa_change.first_line_feedrate > 0)
+                    m_current_feedrate = pa_change.first_line_feedrate;
+                m_next_feedrate = pa_change.next_feedrate;
                 
                 // If we found a new maximum feedrate after the PA change command, use it
-                if (temp_feed_rate > 0) {
-                    m_max_next_feedrate = temp_feed_rate;
+                if (pa_change.max_next_feedrate > 0) {
+                    m_max_next_feedrate = pa_change.max_next_feedrate;
                 } else // If we didnt find a new feedrate at all after the PA change command, use the current feedrate.
                     m_max_next_feedrate = m_current_feedrate;
                 
-                // Restore stream position
-                stream.clear();
-                stream.seekg(current_pos);
-                
                 // Calculate the predicted PA using the upcomming feature maximum feedrate
                 // Get the interpolator for the active tool
                 AdaptivePAInterpolator* interpolator = getInterpolator(m_last_extruder_id);
@@ -219,7 +256,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                 if(!interpolator){ // Tool not found in the interpolator map
                     // Tool not found in the PA interpolator to tool map
                     predicted_pa = m_config.enable_pressure_advance.get_at(m_last_extruder_id) ? m_config.pressure_advance.get_at(m_last_extruder_id) : 0;
-                    if(m_config.gcode_comments) output << "; APA: Tool doesnt have APA enabled\n";
+                    if(m_config.gcode_comments) output.append("; APA: Tool doesnt have APA enabled\n");
                 } else if (!interpolator->isInitialised() || (!m_config.adaptive_pressure_advance.get_at(m_last_extruder_id)) )
                     // Check if the model is not initialised by the constructor for the active extruder
                     // Also check that adaptive PA is enabled for that extruder. This should not be needed
@@ -228,7 +265,7 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                 {
                     // Model failed or adaptive pressure advance not enabled - use default value from m_config
                     predicted_pa = m_config.enable_pressure_advance.get_at(m_last_extruder_id) ? m_config.pressure_advance.get_at(m_last_extruder_id) : 0;
-                    if(m_config.gcode_comments) output << "; APA: Interpolator setup failed, using default pressure advance\n";
+                    if(m_config.gcode_comments) output.append("; APA: Interpolator setup failed, using default pressure advance\n");
                 } else { // Model setup succeeded
                     // Proceed to identify the print speed to use to calculate the adaptive PA value
                     if(isOverhang > 0){  // If we are in an overhang area, use the minimum between current print speed
@@ -253,33 +290,35 @@ std::string AdaptivePAProcessor::process_layer(std::string &&gcode) {
                     
                     if (predicted_pa < 0) { // If extrapolation fails, fall back to the default PA for the extruder.
                         predicted_pa = m_config.enable_pressure_advance.get_at(m_last_extruder_id) ? m_config.pressure_advance.get_at(m_last_extruder_id) : 0;
-                        if(m_config.gcode_comments) output << "; APA: Interpolation failed, using fallback pressure advance value\n";
+                        if(m_config.gcode_comments) output.append("; APA: Interpolation failed, using fallback pressure advance value\n");
                     }
                 }
                 if(m_config.gcode_comments) {
                     // Output debug GCode comments
-                    output << pa_change_line << '\n'; // Output PA change command tag
+                    output.append_line(line, gcode, line_idx); // Output PA change command tag
+                    std::string comments;
                     if(isBridge && m_config.adaptive_pressure_advance_bridges.get_at(m_last_extruder_id) > EPSILON)
-                        output << "; APA Model Override (bridge)\n";
-                    output << "; APA Current Speed: " << std::to_string(m_current_feedrate) << "\n";
-                    output << "; APA Next Speed: " << std::to_string(m_next_feedrate) << "\n";
-                    output << "; APA Max Next Speed: " << std::to_string(m_max_next_feedrate) << "\n";
-                    output << "; APA Speed Used: " << std::to_string(adaptive_PA_speed) << "\n";
-                    output << "; APA Flow rate: " << std::to_string(mm3mm_value * m_max_next_feedrate) << "\n";
-                    output << "; APA Prev PA: " << std::to_string(m_last_predicted_pa) << " New PA: " << std::to_string(predicted_pa) << "\n"; 
+                        comments += "; APA Model Override (bridge)\n";
+                    comments += "; APA Current Speed: " + std::to_string(m_current_feedrate) + "\n";
+                    comments += "; APA Next Speed: " + std::to_string(m_next_feedrate) + "\n";
+                    comments += "; APA Max Next Speed: " + std::to_string(m_max_next_feedrate) + "\n";
+                    comments += "; APA Speed Used: " + std::to_string(adaptive_PA_speed) + "\n";
+                    comments += "; APA Flow rate: " + std::to_string(mm3mm_value * m_max_next_feedrate) + "\n";
+                    comments += "; APA Prev PA: " + std::to_string(m_last_predicted_pa) + " New PA: " + std::to_string(predicted_pa) + "\n"; 
+                    output.append(std::move(comments));
                 }
                 if (extruder_changed || std::fabs(predicted_pa - m_last_predicted_pa) > EPSILON) {
-                    output << m_gcodegen.writer().set_pressure_advance(predicted_pa); // Use m_writer to set pressure advance
+                    output.append(m_gcodegen.writer().set_pressure_advance(predicted_pa)); // Use m_writer to set pressure advance
                     m_last_predicted_pa = predicted_pa; // Update the last predicted PA value
                 }
             }
         }else {
             // Output the current line as this isn't a PA change tag
-            output << line << '\n';
+            output.append_line(line, gcode, line_idx);
         }
     }
 
-    return output.str();
+    return output;
 }
 
 } // namespace Slic3r
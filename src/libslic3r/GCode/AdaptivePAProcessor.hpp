@@ -13,6 +13,7 @@
 #include <map>
 #include <vector>
 #include "AdaptivePAInterpolator.hpp"
+#include "GCodeLines.hpp"
 
 namespace Slic3r {
 
@@ -44,7 +45,46 @@ public:
      * @param gcode A string containing the G-code for the layer.
      * @return A string containing the processed G-code with adaptive pressure advance applied.
      */
-    std::string process_layer(std::string &&gcode);
+    std::string process_layer(std::string &&gcode) {
+        GCodeLines lines(std::move(gcode));
+        std::vector<PAChange> pa_changes = scan_layer(lines);
+        return process_layer(std::move(lines), pa_changes).str();
+    }
+
+    /**
+     * @brief A "; PA_CHANGE" tag of a layer together with the feed rates found by looking ahead of it.
+     */
+    struct PAChange {
+        size_t       line_idx;             ///< Index of the tag line in the layer G-code.
+        int          extruder_id;          ///< Tool the tag belongs to.
+        double       mm3mm;                ///< Extrusion volume per mm of the upcoming feature.
+        unsigned int accel;                ///< Acceleration of the upcoming feature.
+        int          is_bridge;            ///< Non zero if the upcoming feature is a bridge.
+        int          is_overhang;          ///< Non zero if the upcoming feature is an overhang.
+        double       max_next_feedrate;    ///< Maximum feed rate found for the upcoming island, zero if none was found.
+        double       next_feedrate;        ///< First feed rate found for the upcoming island, zero if none was found.
+        double       first_line_feedrate;  ///< Feed rate set by the line immediately following the tag, zero if none.
+    };
+
+    /**
+     * @brief Parses the PA_CHANGE tags of a layer and performs their feed rate look-ahead.
+     *
+     * The scan depends on the G-code text only, not on the state of the processor,
+     * thus it may run in parallel for the layers ahead of the one being processed.
+     *
+     * @param gcode The G-code lines of the layer.
+     * @return The PA_CHANGE tags of the layer, sorted by their position in the layer.
+     */
+    std::vector<PAChange> scan_layer(const GCodeLines &gcode) const;
+
+    /**
+     * @brief Processes a layer of G-code, which has already been scanned by scan_layer().
+     *
+     * @param gcode The G-code lines of the layer.
+     * @param pa_changes Result of scan_layer() for the same G-code.
+     * @return The processed G-code lines with adaptive pressure advance applied. The lines not modified are passed by reference.
+     */
+    GCodeLines process_layer(GCodeLines &&gcode, const std::vector<PAChange> &pa_changes);
     
     /**
      * @brief Manually sets adaptive PA internal value.
@@ -66,7 +106,6 @@ private:
 
     std::regex m_pa_change_pattern; ///< Regular expression to detect PA_CHANGE pattern.
     std::regex m_g1_f_pattern; ///< Regular expression to detect G1 F pattern.
-    std::smatch m_match; ///< Match results for regular expressions.
 
     /**
      * @brief Get the PA interpolator attached to the specified tool ID.
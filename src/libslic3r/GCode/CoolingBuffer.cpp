@@ -5,6 +5,7 @@
 #include <boost/log/trivial.hpp>
 #include <iostream>
 #include <float.h>
+#include <string_view>
 #include <system_error>
 #include <unordered_map>
 
@@ -73,8 +74,8 @@ struct CoolingLine
         TYPE_IRONING_FAN_END           = 1 << 20,
     };
 
-    CoolingLine(unsigned int type, size_t  line_start, size_t  line_end) :
-        type(type), line_start(line_start), line_end(line_end),
+    CoolingLine(unsigned int type, size_t line_idx) :
+        type(type), line_idx(line_idx),
         length(0.f), feedrate(0.f), time(0.f), time_max(0.f), slowdown(false) {}
 
     bool adjustable(bool slowdown_external_perimeters) const {
@@ -88,10 +89,8 @@ struct CoolingLine
     }
 
     size_t  type;
-    // Start of this line at the G-code snippet.
-    size_t  line_start;
-    // End of this line at the G-code snippet.
-    size_t  line_end;
+    // Index of this line in the G-code snippet.
+    size_t  line_idx;
     // XY Euclidian length of this segment.
     float   length;
     // Current feedrate, possibly adjusted.
@@ -313,29 +312,122 @@ finished:
 	return new_feedrate;
 }
 
-std::string CoolingBuffer::process_layer(std::string &&gcode, size_t layer_id, bool flush)
+GCodeLines CoolingBuffer::process_layer(GCodeLines &&gcode, std::vector<ParsedLine> &&lines, size_t layer_id, bool flush)
 {
     // Cache the input G-code.
-    if (m_gcode.empty())
+    if (m_gcode.empty()) {
         m_gcode = std::move(gcode);
-    else
-        m_gcode += gcode;
+        m_lines = std::move(lines);
+    } else {
+        // Shift the parsed lines to the end of the cached G-code.
+        size_t offset = m_gcode.size();
+        m_gcode.append(gcode);
+        m_lines.reserve(m_lines.size() + lines.size());
+        for (ParsedLine &line : lines) {
+            line.line_idx += offset;
+            m_lines.emplace_back(line);
+        }
+    }
 
-    std::string out;
+    GCodeLines out;
     if (flush) {
         // This is either an object layer or the very last print layer. Calculate cool down over the collected support layers
         // and one object layer.
-        std::vector<PerExtruderAdjustments> per_extruder_adjustments = this->parse_layer_gcode(m_gcode, m_current_pos);
+        std::vector<PerExtruderAdjustments> per_extruder_adjustments = this->parse_layer_gcode(m_lines, m_current_pos);
         float layer_time_stretched = this->calculate_layer_slowdown(per_extruder_adjustments);
         out = this->apply_layer_cooldown(m_gcode, layer_id, layer_time_stretched, per_extruder_adjustments);
         m_gcode.clear();
+        m_lines.clear();
+    }
+    return out;
+}
+
+// Classify the G-code lines of a layer and parse their axes.
+// Only the lines, which may be of interest to parse_layer_gcode() are returned.
+std::vector<CoolingBuffer::ParsedLine> CoolingBuffer::parse_lines(const GCodeLines &gcode) const
+{
+    std::vector<ParsedLine> out;
+    for (size_t line_idx = 0; line_idx < gcode.size(); ++ line_idx)
+    {
+        // sline will not contain the trailing '\n'.
+        std::string_view sline = gcode.line(line_idx);
+        ParsedLine line;
+        line.line_idx = line_idx;
+        if (boost::starts_with(sline, "G0 "))
+            line.type = CoolingLine::TYPE_G0;
+        else if (boost::starts_with(sline, "G1 "))
+            line.type = CoolingLine::TYPE_G1;
+        else if (boost::starts_with(sline, "G92 "))
+            line.type = CoolingLine::TYPE_G92;
+        else if (boost::starts_with(sline, "G2 "))
+            line.type = CoolingLine::TYPE_G2;
+        else if (boost::starts_with(sline, "G3 "))
+            line.type = CoolingLine::TYPE_G3;
+        if (line.type) {
+            // G0, G1 or G92
+            // The axes were parsed by the GCodeReader tokenizer. X, Y, Z, E, F, I, J share their indices with CoolingBuffer.
+            static_assert(X == 0 && Y == 1 && Z == 2 && E == 3 && F == 4 && I == 5 && J == 6);
+            const GCodeReader::TokenizedLine &tokens = gcode.tokens(line_idx);
+            line.axes = (unsigned char)(tokens.mask & 0x7f);
+            for (size_t axis = 0; axis < 7; ++ axis)
+                if (line.axes & (1 << axis))
+                    line.pos[axis] = tokens.axis[axis];
+            if (line.axes & (1 << 4)) {
+                // Convert mm/min to mm/sec.
+                line.pos[4] /= 60.f;
+                if ((line.type & CoolingLine::TYPE_G92) == 0)
+                    // This is G0 or G1 line and it sets the feedrate. This mark is used for reducing the duplicate F calls.
+                    line.type |= CoolingLine::TYPE_HAS_F;
+            }
+            if (boost::contains(sline, ";_EXTERNAL_PERIMETER"))
+                line.type |= CoolingLine::TYPE_EXTERNAL_PERIMETER;
+            if (boost::contains(sline, ";_WIPE"))
+                line.type |= CoolingLine::TYPE_WIPE;
+            line.extrude_set_speed = boost::contains(sline, ";_EXTRUDE_SET_SPEED");
+        } else if (boost::starts_with(sline, ";_EXTRUDE_END")) {
+            line.type = CoolingLine::TYPE_EXTRUDE_END;
+        } else if (boost::starts_with(sline, m_toolchange_prefix)) {
+            auto ret = std::from_chars(sline.data() + m_toolchange_prefix.size(), sline.data() + sline.size(), line.tool);
+            if (std::errc::invalid_argument == ret.ec)
+                continue;
+            line.type = CoolingLine::TYPE_SET_TOOL;
+        } else if (boost::starts_with(sline, ";_OVERHANG_FAN_START")) {
+            line.type = CoolingLine::TYPE_OVERHANG_FAN_START;
+        } else if (boost::starts_with(sline, ";_OVERHANG_FAN_END")) {
+            line.type = CoolingLine::TYPE_OVERHANG_FAN_END;
+        } else if (boost::starts_with(sline, ";_INTERNAL_BRIDGE_FAN_START")) { // ORCA: Add support for separate internal bridge fan speed control
+            line.type = CoolingLine::TYPE_INTERNAL_BRIDGE_FAN_START;
+        } else if (boost::starts_with(sline, ";_INTERNAL_BRIDGE_FAN_END")) { // ORCA: Add support for separate internal bridge fan speed control
+            line.type = CoolingLine::TYPE_INTERNAL_BRIDGE_FAN_END;
+        } else if (boost::starts_with(sline, ";_SUPP_INTERFACE_FAN_START")) {
+            line.type = CoolingLine::TYPE_SUPPORT_INTERFACE_FAN_START;
+        } else if (boost::starts_with(sline, ";_SUPP_INTERFACE_FAN_END")) {
+            line.type = CoolingLine::TYPE_SUPPORT_INTERFACE_FAN_END;
+        } else if (boost::starts_with(sline, ";_IRONING_FAN_START")) { // ORCA: Add support for ironing fan speed control
+            line.type = CoolingLine::TYPE_IRONING_FAN_START;
+        } else if (boost::starts_with(sline, ";_IRONING_FAN_END")) { // ORCA: Add support for ironing fan speed control
+            line.type = CoolingLine::TYPE_IRONING_FAN_END;
+        } else if (boost::starts_with(sline, "G4 ")) {
+            // Parse the wait time.
+            line.type = CoolingLine::TYPE_G4;
+            size_t pos_S = sline.find('S', 3);
+            size_t pos_P = sline.find('P', 3);
+            assert(is_decimal_separator_point()); // for atof
+            line.pos[0] = float(
+                (pos_S > 0) ? atof(sline.data() + pos_S + 1) :
+                (pos_P > 0) ? atof(sline.data() + pos_P + 1) * 0.001 : 0.);
+        } else if (boost::starts_with(sline, ";_FORCE_RESUME_FAN_SPEED")) {
+            line.type = CoolingLine::TYPE_FORCE_RESUME_FAN;
+        }
+        if (line.type != 0)
+            out.emplace_back(line);
     }
     return out;
 }
 
 // Parse the layer G-code for the moves, which could be adjusted.
 // Return the list of parsed lines, bucketed by an extruder.
-std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const
+std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::vector<ParsedLine> &parsed_lines, std::vector<float> &current_pos) const
 {
     std::vector<PerExtruderAdjustments> per_extruder_adjustments(m_extruder_ids.size());
     std::vector<size_t>                 map_extruder_to_per_extruder_adjustment(m_num_extruders, 0);
@@ -353,8 +445,6 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
 
     unsigned int      current_extruder  = m_current_extruder;
     PerExtruderAdjustments *adjustment  = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
-    const char       *line_start = gcode.c_str();
-    const char       *line_end   = line_start;
     // Index of an existing CoolingLine of the current adjustment, which holds the feedrate setting command
     // for a sequence of extrusion moves.
     size_t            active_speed_modifier = size_t(-1);
@@ -363,67 +453,24 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
     // Time of any other movements before the first extrusion will be excluded from the layer time.
     bool layer_had_extrusion = false;
 
-    for (; *line_start != 0; line_start = line_end)
+    for (const ParsedLine &parsed : parsed_lines)
     {
-        while (*line_end != '\n' && *line_end != 0)
-            ++ line_end;
-        // sline will not contain the trailing '\n'.
-        std::string sline(line_start, line_end);
-        // CoolingLine will contain the trailing '\n'.
-        if (*line_end == '\n')
-            ++ line_end;
-        CoolingLine line(0, line_start - gcode.c_str(), line_end - gcode.c_str());
-        if (boost::starts_with(sline, "G0 "))
-            line.type = CoolingLine::TYPE_G0;
-        else if (boost::starts_with(sline, "G1 "))
-            line.type = CoolingLine::TYPE_G1;
-        else if (boost::starts_with(sline, "G92 "))
-            line.type = CoolingLine::TYPE_G92;
-        else if (boost::starts_with(sline, "G2 "))
-            line.type = CoolingLine::TYPE_G2;
-        else if (boost::starts_with(sline, "G3 "))
-            line.type = CoolingLine::TYPE_G3;
-        if (line.type) {
+        CoolingLine line(parsed.type, parsed.line_idx);
+        if (line.type & (CoolingLine::TYPE_G0 | CoolingLine::TYPE_G1 | CoolingLine::TYPE_G2 | CoolingLine::TYPE_G3 | CoolingLine::TYPE_G92)) {
             // G0, G1 or G92
-            // Parse the G-code line.
             std::vector<float> new_pos(current_pos);
-            const char *c = sline.data() + 3;
-            for (;;) {
-                // Skip whitespaces.
-                for (; *c == ' ' || *c == '\t'; ++ c);
-                if (*c == 0 || *c == ';')
-                    break;
-
-                assert(is_decimal_separator_point()); // for atof
-                //BBS: Parse the axis.
-                size_t axis = (*c >= 'X' && *c <= 'Z') ? (*c - 'X') :
-                              (*c == 'E') ? 3 : (*c == 'F') ? 4 :
-                              (*c == 'I') ? 5 : (*c == 'J') ? 6 : size_t(-1);
-                if (axis != size_t(-1)) {
-                    new_pos[axis] = float(atof(++c));
-                    if (axis == 4) {
-                        // Convert mm/min to mm/sec.
-                        new_pos[4] /= 60.f;
-                        if ((line.type & CoolingLine::TYPE_G92) == 0)
-                            // This is G0 or G1 line and it sets the feedrate. This mark is used for reducing the duplicate F calls.
-                            line.type |= CoolingLine::TYPE_HAS_F;
-                    } else if (axis == 5 || axis == 6) {
+            for (size_t axis = 0; axis < 7; ++ axis)
+                if (parsed.axes & (1 << axis)) {
+                    new_pos[axis] = parsed.pos[axis];
+                    if (axis == 5 || axis == 6)
                         // BBS: get position of arc center
                         new_pos[axis] += current_pos[axis - 5];
-                    }
                 }
-                // Skip this word.
-                for (; *c != ' ' && *c != '\t' && *c != 0; ++ c);
-            }
-            bool external_perimeter = boost::contains(sline, ";_EXTERNAL_PERIMETER");
-            bool wipe               = boost::contains(sline, ";_WIPE");
-            if (external_perimeter)
-                line.type |= CoolingLine::TYPE_EXTERNAL_PERIMETER;
-            if (wipe)
-                line.type |= CoolingLine::TYPE_WIPE;
+            bool external_perimeter = (line.type & CoolingLine::TYPE_EXTERNAL_PERIMETER) != 0;
+            bool wipe               = (line.type & CoolingLine::TYPE_WIPE) != 0;
 
             // Orca: only slow down movements since the first extrusion
-            if (boost::contains(sline, ";_EXTRUDE_SET_SPEED"))
+            if (parsed.extrude_set_speed)
                 layer_had_extrusion = true;
             
             // ORCA: Dont slowdown external perimeters for layer time feature
@@ -433,7 +480,7 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
             
             // ORCA: Dont slowdown external perimeters for layer time works by not marking the external perimeter as adjustable, 
             // hence the slowdown algorithm ignores it.
-            if (boost::contains(sline, ";_EXTRUDE_SET_SPEED") && ! wipe && adjust_external) {
+            if (parsed.extrude_set_speed && ! wipe && adjust_external) {
                 line.type |= CoolingLine::TYPE_ADJUSTABLE;
                 active_speed_modifier = adjustment->lines.size();
             }
@@ -493,55 +540,26 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                 }
             }
             current_pos = std::move(new_pos);
-        } else if (boost::starts_with(sline, ";_EXTRUDE_END")) {
-            line.type = CoolingLine::TYPE_EXTRUDE_END;
+        } else if (line.type & CoolingLine::TYPE_EXTRUDE_END) {
             active_speed_modifier = size_t(-1);
-        } else if (boost::starts_with(sline, m_toolchange_prefix)) {
-            unsigned int new_extruder = 0;
-            auto ret = std::from_chars(sline.data() + m_toolchange_prefix.size(), sline.data() + sline.size(), new_extruder);
-            if (std::errc::invalid_argument != ret.ec) {
-                // Only change extruder in case the number is meaningful. User could provide an out-of-range index through custom gcodes -
-                // those shall be ignored.
-                if (new_extruder < map_extruder_to_per_extruder_adjustment.size()) {
-                    if (new_extruder != current_extruder) {
-                        // Switch the tool.
-                        line.type        = CoolingLine::TYPE_SET_TOOL;
-                        current_extruder = new_extruder;
-                        adjustment       = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
-                    }
-                } else {
-                    // Only log the error in case of MM printer. Single extruder printers likely ignore any T anyway.
-                    if (map_extruder_to_per_extruder_adjustment.size() > 1)
-                        BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: " << sline;
+        } else if (line.type & CoolingLine::TYPE_SET_TOOL) {
+            // Only change extruder in case the number is meaningful. User could provide an out-of-range index through custom gcodes -
+            // those shall be ignored.
+            line.type = 0;
+            if (parsed.tool < map_extruder_to_per_extruder_adjustment.size()) {
+                if (parsed.tool != current_extruder) {
+                    // Switch the tool.
+                    line.type        = CoolingLine::TYPE_SET_TOOL;
+                    current_extruder = parsed.tool;
+                    adjustment       = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
                 }
+            } else {
+                // Only log the error in case of MM printer. Single extruder printers likely ignore any T anyway.
+                if (map_extruder_to_per_extruder_adjustment.size() > 1)
+                    BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: " << m_toolchange_prefix << parsed.tool;
             }
-        } else if (boost::starts_with(sline, ";_OVERHANG_FAN_START")) {
-            line.type = CoolingLine::TYPE_OVERHANG_FAN_START;
-        } else if (boost::starts_with(sline, ";_OVERHANG_FAN_END")) {
-            line.type = CoolingLine::TYPE_OVERHANG_FAN_END;
-        } else if (boost::starts_with(sline, ";_INTERNAL_BRIDGE_FAN_START")) { // ORCA: Add support for separate internal bridge fan speed control
-            line.type = CoolingLine::TYPE_INTERNAL_BRIDGE_FAN_START;
-        } else if (boost::starts_with(sline, ";_INTERNAL_BRIDGE_FAN_END")) { // ORCA: Add support for separate internal bridge fan speed control
-            line.type = CoolingLine::TYPE_INTERNAL_BRIDGE_FAN_END;
-        } else if (boost::starts_with(sline, ";_SUPP_INTERFACE_FAN_START")) {
-            line.type = CoolingLine::TYPE_SUPPORT_INTERFACE_FAN_START;
-        } else if (boost::starts_with(sline, ";_SUPP_INTERFACE_FAN_END")) {
-            line.type = CoolingLine::TYPE_SUPPORT_INTERFACE_FAN_END;
-        } else if (boost::starts_with(sline, ";_IRONING_FAN_START")) { // ORCA: Add support for ironing fan speed control
-            line.type = CoolingLine::TYPE_IRONING_FAN_START;
-        } else if (boost::starts_with(sline, ";_IRONING_FAN_END")) { // ORCA: Add support for ironing fan speed control
-            line.type = CoolingLine::TYPE_IRONING_FAN_END;
-        } else if (boost::starts_with(sline, "G4 ")) {
-            // Parse the wait time.
-            line.type = CoolingLine::TYPE_G4;
-            size_t pos_S = sline.find('S', 3);
-            size_t pos_P = sline.find('P', 3);
-            assert(is_decimal_separator_point()); // for atof
-            line.time = line.time_max = float(
-                (pos_S > 0) ? atof(sline.c_str() + pos_S + 1) :
-                (pos_P > 0) ? atof(sline.c_str() + pos_P + 1) * 0.001 : 0.);
-        } else if (boost::starts_with(sline, ";_FORCE_RESUME_FAN_SPEED")) {
-            line.type = CoolingLine::TYPE_FORCE_RESUME_FAN;
+        } else if (line.type & CoolingLine::TYPE_G4) {
+            line.time = line.time_max = parsed.pos[0];
         }
 
         // Orca: For any movements before this layer's first ever extrusion, we exclude them from the layer time calculation.
@@ -694,9 +712,9 @@ float CoolingBuffer::calculate_layer_slowdown(std::vector<PerExtruderAdjustments
 
 // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
 // Returns the adjusted G-code.
-std::string CoolingBuffer::apply_layer_cooldown(
+GCodeLines CoolingBuffer::apply_layer_cooldown(
     // Source G-code for the current layer.
-    const std::string                      &gcode,
+    const GCodeLines                       &gcode,
     // ID of the current layer, used to disable fan for the first n layers.
     size_t                                  layer_id,
     // Total time of this layer after slow down, used to control the fan.
@@ -714,11 +732,10 @@ std::string CoolingBuffer::apply_layer_cooldown(
         for (const PerExtruderAdjustments &adj : per_extruder_adjustments)
             for (const CoolingLine &line : adj.lines)
                 lines.emplace_back(&line);
-        std::sort(lines.begin(), lines.end(), [](const CoolingLine *ln1, const CoolingLine *ln2) { return ln1->line_start < ln2->line_start; } );
+        std::sort(lines.begin(), lines.end(), [](const CoolingLine *ln1, const CoolingLine *ln2) { return ln1->line_idx < ln2->line_idx; } );
     }
-    // Second generate the adjusted G-code.
-    std::string new_gcode;
-    new_gcode.reserve(gcode.size() * 2);
+    // Second generate the adjusted G-code. The lines, which are not modified, are passed by reference.
+    GCodeLines new_gcode;
     bool overhang_fan_control= false;
     int  overhang_fan_speed   = 0;
     bool internal_bridge_fan_control= false; // ORCA: Add support for separate internal bridge fan speed control
@@ -806,17 +823,17 @@ std::string CoolingBuffer::apply_layer_cooldown(
             m_fan_speed = fan_speed_new;
             m_current_fan_speed = fan_speed_new;
             if (immediately_apply)
-                new_gcode  += GCodeWriter::set_fan(m_config.gcode_flavor, m_fan_speed);
+                new_gcode.append(GCodeWriter::set_fan(m_config.gcode_flavor, m_fan_speed));
         }
         //BBS
         if (additional_fan_speed_new != m_additional_fan_speed) {
             m_additional_fan_speed = additional_fan_speed_new;
             if (immediately_apply && m_config.auxiliary_fan.value)
-                new_gcode += GCodeWriter::set_additional_fan(m_additional_fan_speed);
+                new_gcode.append(GCodeWriter::set_additional_fan(m_additional_fan_speed));
         }
     };
 
-    const char         *pos               = gcode.c_str();
+    size_t              pos               = 0;
     int                 current_feedrate  = 0;
     change_extruder_set_fan(true);
 
@@ -830,10 +847,11 @@ std::string CoolingBuffer::apply_layer_cooldown(
     bool need_set_fan = false;
 
     for (const CoolingLine *line : lines) {
-        const char *line_start  = gcode.c_str() + line->line_start;
-        const char *line_end    = gcode.c_str() + line->line_end;
-        if (line_start > pos)
-            new_gcode.append(pos, line_start - pos);
+        const std::string_view src_line    = gcode.line_with_eol(line->line_idx);
+        const char            *line_start  = src_line.data();
+        const char            *line_end    = line_start + src_line.size();
+        if (line->line_idx > pos)
+            new_gcode.append(gcode, pos, line->line_idx);
         if (line->type & CoolingLine::TYPE_SET_TOOL) {
             unsigned int new_extruder = 0;
             auto ret = std::from_chars(line_start + m_toolchange_prefix.size(), line_end, new_extruder);
@@ -843,7 +861,7 @@ std::string CoolingBuffer::apply_layer_cooldown(
                     change_extruder_set_fan(true);
                 }
             }
-            new_gcode.append(line_start, line_end - line_start);
+            new_gcode.append(gcode, line->line_idx);
         } else if (line->type & CoolingLine::TYPE_OVERHANG_FAN_START) {
             if (overhang_fan_control && !fan_speed_change_requests[CoolingLine::TYPE_OVERHANG_FAN_START]) {
                 need_set_fan = true;
@@ -891,11 +909,13 @@ std::string CoolingBuffer::apply_layer_cooldown(
                 need_set_fan = true;
             }
             if (m_additional_fan_speed != -1 && m_config.auxiliary_fan.value)
-                new_gcode += GCodeWriter::set_additional_fan(m_additional_fan_speed);
+                new_gcode.append(GCodeWriter::set_additional_fan(m_additional_fan_speed));
         }
         else if (line->type & CoolingLine::TYPE_EXTRUDE_END) {
             // Just remove this comment.
         } else if (line->type & (CoolingLine::TYPE_ADJUSTABLE | CoolingLine::TYPE_EXTERNAL_PERIMETER | CoolingLine::TYPE_WIPE | CoolingLine::TYPE_HAS_F)) {
+            // The adjusted line. If it matches the source line, the source line is passed by reference.
+            std::string new_line;
             // Find the start of a comment, or roll to the end of line.
             const char *end = line_start;
             for (; end < line_end && *end != ';'; ++ end);
@@ -922,17 +942,17 @@ std::string CoolingBuffer::apply_layer_cooldown(
             } else {
                 // The F value is different from current_feedrate, but not slowed down, thus the G-code line will not be modified.
                 // Emit the line without the comment.
-                new_gcode.append(line_start, end - line_start);
+                new_line.append(line_start, end - line_start);
                 current_feedrate = new_feedrate;
             }
             if (modify || remove) {
                 if (modify) {
                     // Replace the feedrate.
-                    new_gcode.append(line_start, fpos - line_start);
+                    new_line.append(line_start, fpos - line_start);
                     current_feedrate = new_feedrate;
                     char buf[64];
                     sprintf(buf, "%d", int(current_feedrate));
-                    new_gcode += buf;
+                    new_line += buf;
                 } else {
                     // Remove the feedrate word.
                     const char *f = fpos;
@@ -943,7 +963,7 @@ std::string CoolingBuffer::apply_layer_cooldown(
                         // BBS: only remain "G1" or "G0" of this line after remove 'F' part, don't save
                     } else {
                         // Append up to the F word, without the trailing whitespace.
-                        new_gcode.append(line_start, f - line_start + 1);
+                        new_line.append(line_start, f - line_start + 1);
                     }
                 }
                 // Skip the non-whitespaces of the F parameter up the comment or end of line.
@@ -951,10 +971,10 @@ std::string CoolingBuffer::apply_layer_cooldown(
                 // Append the rest of the line without the comment.
                 if (fpos < end)
                     // The G-code line is not empty yet. Emit the rest of it.
-                    new_gcode.append(fpos, end - fpos);
-                else if (remove && new_gcode == "G1") {
+                    new_line.append(fpos, end - fpos);
+                else if (remove && new_line == "G1") {
                     // The G-code line only contained the F word, now it is empty. Remove it completely including the comments.
-                    new_gcode.resize(new_gcode.size() - 2);
+                    new_line.clear();
                     end = line_end;
                 }
             }
@@ -968,45 +988,49 @@ std::string CoolingBuffer::apply_layer_cooldown(
                         boost::replace_all(comment, ";_EXTERNAL_PERIMETER", "");
                     if (line->type & CoolingLine::TYPE_WIPE)
                         boost::replace_all(comment, ";_WIPE", "");
-                    new_gcode += comment;
+                    new_line += comment;
                 } else {
                     // Just attach the rest of the source line.
-                    new_gcode.append(end, line_end - end);
+                    new_line.append(end, line_end - end);
                 }
             }
+            if (new_line == src_line)
+                new_gcode.append(gcode, line->line_idx);
+            else
+                new_gcode.append(new_line);
         } else {
-            new_gcode.append(line_start, line_end - line_start);
+            new_gcode.append(gcode, line->line_idx);
         }
 
+
         if (need_set_fan) {
             if (fan_speed_change_requests[CoolingLine::TYPE_OVERHANG_FAN_START]){
-                new_gcode += GCodeWriter::set_fan(m_config.gcode_flavor, overhang_fan_speed);
+                new_gcode.append(GCodeWriter::set_fan(m_config.gcode_flavor, overhang_fan_speed));
                 m_current_fan_speed = overhang_fan_speed;
             } else if (fan_speed_change_requests[CoolingLine::TYPE_INTERNAL_BRIDGE_FAN_START]){ // ORCA: Add support for separate internal bridge fan speed control
-                new_gcode += GCodeWriter::set_fan(m_config.gcode_flavor, internal_bridge_fan_speed);
+                new_gcode.append(GCodeWriter::set_fan(m_config.gcode_flavor, internal_bridge_fan_speed));
                 m_current_fan_speed = internal_bridge_fan_speed;
             }
             else if (fan_speed_change_requests[CoolingLine::TYPE_SUPPORT_INTERFACE_FAN_START]){
-                new_gcode += GCodeWriter::set_fan(m_config.gcode_flavor, supp_interface_fan_speed);
+                new_gcode.append(GCodeWriter::set_fan(m_config.gcode_flavor, supp_interface_fan_speed));
                 m_current_fan_speed = supp_interface_fan_speed;
             }
             else if (fan_speed_change_requests[CoolingLine::TYPE_IRONING_FAN_START]){
-                new_gcode += GCodeWriter::set_fan(m_config.gcode_flavor, ironing_fan_speed);
+                new_gcode.append(GCodeWriter::set_fan(m_config.gcode_flavor, ironing_fan_speed));
                 m_current_fan_speed = ironing_fan_speed;
             }
             else if(fan_speed_change_requests[CoolingLine::TYPE_FORCE_RESUME_FAN] && m_current_fan_speed != -1){
-                new_gcode += GCodeWriter::set_fan(m_config.gcode_flavor, m_current_fan_speed);
+                new_gcode.append(GCodeWriter::set_fan(m_config.gcode_flavor, m_current_fan_speed));
                 fan_speed_change_requests[CoolingLine::TYPE_FORCE_RESUME_FAN] = false;
             }
             else
-                new_gcode += GCodeWriter::set_fan(m_config.gcode_flavor, m_fan_speed);
+                new_gcode.append(GCodeWriter::set_fan(m_config.gcode_flavor, m_fan_speed));
             need_set_fan = false;
         }
-        pos = line_end;
+        pos = line->line_idx + 1;
     }
-    const char *gcode_end = gcode.c_str() + gcode.size();
-    if (pos < gcode_end)
-        new_gcode.append(pos, gcode_end - pos);
+    if (pos < gcode.size())
+        new_gcode.append(gcode, pos, gcode.size());
 
     return new_gcode;
 }
@@ -2,8 +2,10 @@
 #define slic3r_CoolingBuffer_hpp_
 
 #include "../libslic3r.h"
+#include "GCodeLines.hpp"
 #include <map>
 #include <string>
+#include <vector>
 #include <cfloat>
 
 namespace Slic3r {
@@ -23,21 +25,50 @@ struct PerExtruderAdjustments;
 //
 class CoolingBuffer {
 public:
+    // A G-code line of interest for the cooling logic, with its axis words already parsed.
+    // Produced by parse_lines() from the G-code lines alone, without any state carried over from the previous layers.
+    struct ParsedLine {
+        // CoolingLine::TYPE_xxx flags, which could be deduced from the G-code text alone.
+        unsigned int    type { 0 };
+        // Bit mask of the axes X, Y, Z, E, F, I, J present at a G0 / G1 / G2 / G3 / G92 line.
+        unsigned char   axes { 0 };
+        // G0 / G1 / G2 / G3 line is marked with ";_EXTRUDE_SET_SPEED".
+        bool            extrude_set_speed { false };
+        // Extruder ID of a tool change line.
+        unsigned int    tool { 0 };
+        // Index of this line in the layer G-code.
+        size_t          line_idx { 0 };
+        // Values of the axes (F already converted to mm/sec), or the dwell time of G4 stored at pos[0].
+        float           pos[7] {};
+    };
+
     CoolingBuffer(GCode &gcodegen);
     void        reset(const Vec3d &position);
     void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = extruder_id; }
-    std::string process_layer(std::string &&gcode, size_t layer_id, bool flush);
+    // Classify the lines of a layer G-code and parse their axes. Does not touch the state of the CoolingBuffer,
+    // thus it may be called for the layers ahead of the one being processed from a parallel pipeline stage.
+    std::vector<ParsedLine> parse_lines(const GCodeLines &gcode) const;
+    std::string process_layer(std::string &&gcode, size_t layer_id, bool flush)
+    {
+        GCodeLines              gcode_lines(std::move(gcode));
+        std::vector<ParsedLine> lines = this->parse_lines(gcode_lines);
+        return this->process_layer(std::move(gcode_lines), std::move(lines), layer_id, flush).str();
+    }
+    // Same as above, with the G-code lines already parsed by parse_lines(). The lines not modified are passed to the output by reference.
+    GCodeLines  process_layer(GCodeLines &&gcode, std::vector<ParsedLine> &&lines, size_t layer_id, bool flush);
 
 private:
 	CoolingBuffer& operator=(const CoolingBuffer&) = delete;
-    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const;
+    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::vector<ParsedLine> &lines, std::vector<float> &current_pos) const;
     float       calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
     // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
     // Returns the adjusted G-code.
-    std::string apply_layer_cooldown(const std::string &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
+    GCodeLines  apply_layer_cooldown(const GCodeLines &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
 
     // G-code snippet cached for the support layers preceding an object layer.
-    std::string                 m_gcode;
+    GCodeLines                  m_gcode;
+    // Lines of m_gcode parsed by parse_lines().
+    std::vector<ParsedLine>     m_lines;
     // Internal data.
     // BBS: X,Y,Z,E,F,I,J
     std::vector<char>           m_axis;
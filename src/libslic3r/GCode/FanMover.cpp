@@ -2,7 +2,9 @@
 
 #include "GCodeReader.hpp"
 
+#include <algorithm>
 #include <iomanip>
+#include <utility>
 /*
 #include <memory.h>
 #include <string.h>
@@ -19,26 +21,63 @@
 
 namespace Slic3r {
 
-const std::string& FanMover::process_gcode(const std::string& gcode, bool flush)
+GCodeLines FanMover::process_gcode(GCodeLines&& gcode, bool flush)
 {
-    m_process_output = "";
+    m_process_output.clear();
 
     // recompute buffer time to recover from rounding
     m_buffer_time_size = 0;
     for (auto& data : m_buffer) m_buffer_time_size += data.time;
 
-    if(!gcode.empty())
-        m_parser.parse_buffer(gcode,
-            [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) { /*m_process_output += line.raw() + "\n";*/ this->_process_gcode_line(reader, line); });
+    if (!gcode.empty()) {
+        if (m_sources.empty())
+            m_sources_first_line = m_source_line;
+        m_sources.emplace_back(std::move(gcode));
+        m_parser.parse_lines(m_sources.back(),
+            [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) { this->_process_gcode_line(reader, line); ++ m_source_line; });
+    }
 
     if (flush) {
         while (!m_buffer.empty()) {
-            m_process_output += m_buffer.front().raw + "\n";
+            _output_line(m_buffer.front().raw, m_buffer.front().source_line);
             remove_from_buffer(m_buffer.begin());
         }
     }
 
-    return m_process_output;
+    // Release the input no longer referenced by the buffer.
+    size_t first_buffered = m_source_line;
+    for (const BufferData& data : m_buffer)
+        first_buffered = std::min(first_buffered, data.source_line);
+    while (!m_sources.empty() && m_sources_first_line + m_sources.front().size() <= first_buffered) {
+        m_sources_first_line += m_sources.front().size();
+        m_sources.pop_front();
+    }
+
+    return std::exchange(m_process_output, GCodeLines());
+}
+
+void FanMover::_output_line(const std::string& line, size_t source_line)
+{
+    size_t first = m_sources_first_line;
+    for (const GCodeLines& source : m_sources) {
+        if (source_line < first + source.size()) {
+            if (source_line >= first) {
+                m_process_output.append_line(line, source, source_line - first);
+                return;
+            }
+            break;
+        }
+        first += source.size();
+    }
+    m_process_output.append_line(line);
+}
+
+void FanMover::_output_text(const std::string& text, size_t source_line)
+{
+    if (!text.empty() && text.back() == '\n')
+        m_process_output.append(std::string_view(text));
+    else
+        _output_line(text, source_line);
 }
 
 bool is_end_of_word(char c) {
@@ -164,16 +203,16 @@ void FanMover::_put_in_middle_G1(std::list<BufferData>::iterator item_to_split,
     }
 }
 
-void FanMover::_print_in_middle_G1(BufferData& line_to_split, float nb_sec, const std::string &line_to_write) {
+void FanMover::_print_in_middle_G1(BufferData& line_to_split, float nb_sec, const std::string &line_to_write, size_t line_to_write_source) {
     if (nb_sec < line_to_split.time * 0.1) {
         // doesn't really need to be split, print it after
-        m_process_output += line_to_split.raw + "\n";
-        m_process_output += line_to_write + (line_to_write.back() == '\n'?"":"\n");
+        _output_line(line_to_split.raw, line_to_split.source_line);
+        _output_text(line_to_write, line_to_write_source);
     } else if (nb_sec > line_to_split.time * 0.9) {
         // doesn't really need to be split, print it before
         //will also print before if line_to_split.time == 0
-        m_process_output += line_to_write + (line_to_write.back() == '\n' ? "" : "\n");
-        m_process_output += line_to_split.raw + "\n";
+        _output_text(line_to_write, line_to_write_source);
+        _output_line(line_to_split.raw, line_to_split.source_line);
     }else if(line_to_split.raw.size() > 2
         && line_to_split.raw[0] == 'G' && line_to_split.raw[1] == '1' && line_to_split.raw[2] == ' ') {
         float percent = nb_sec / line_to_split.time;
@@ -196,14 +235,14 @@ void FanMover::_print_in_middle_G1(BufferData& line_to_split, float nb_sec, cons
                 change_axis_value(before, 'E', line_to_split.e + line_to_split.de * percent, 5);
             }
         }
-        m_process_output += before + "\n";
-        m_process_output += line_to_write + (line_to_write.back() == '\n' ? "" : "\n");
-        m_process_output += line_to_split.raw + "\n";
+        m_process_output.append_line(before);
+        _output_text(line_to_write, line_to_write_source);
+        _output_line(line_to_split.raw, line_to_split.source_line);
 
     } else {
         //not a G1, print it before
-        m_process_output += line_to_write + (line_to_write.back() == '\n' ? "" : "\n");
-        m_process_output += line_to_split.raw + "\n";
+        _output_text(line_to_write, line_to_write_source);
+        _output_line(line_to_split.raw, line_to_split.source_line);
     }
 }
 
@@ -330,7 +369,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                     _print_in_middle_G1(m_buffer.front(), m_buffer_time_size - nb_seconds_delay, _set_fan(100));//m_writer.set_fan(100, true)); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
                                     remove_from_buffer(m_buffer.begin());
                                 } else {
-                                    m_process_output += _set_fan(100);//m_writer.set_fan(100, true)); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
+                                    m_process_output.append(_set_fan(100));//m_writer.set_fan(100, true)); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
                                 }
                                 //write it in the queue if possible
                                 const float kickstart_duration = kickstart * float(fan_speed - m_front_buffer_fan_speed) / 100.f;
@@ -340,7 +379,9 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                     time_count -= it->time;
                                     if (time_count< 0) {
                                         //found something that is lower than us
-                                        _put_in_middle_G1(it, it->time + time_count, BufferData(std::string(line.raw()), 0, fan_speed, true));
+                                        BufferData kickstart_data(std::string(line.raw()), 0, fan_speed, true);
+                                        kickstart_data.source_line = m_source_line;
+                                        _put_in_middle_G1(it, it->time + time_count, std::move(kickstart_data));
                                         //found, stop
                                         break;
                                     }
@@ -358,10 +399,10 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                 _remove_slow_fan(fan_speed, m_buffer_time_size + 1);
                                 // then write the fan command
                                 if (!m_buffer.empty() && (m_buffer_time_size - m_buffer.front().time * 0.1) > nb_seconds_delay) {
-                                    _print_in_middle_G1(m_buffer.front(), m_buffer_time_size - nb_seconds_delay, line.raw());
+                                    _print_in_middle_G1(m_buffer.front(), m_buffer_time_size - nb_seconds_delay, line.raw(), m_source_line);
                                     remove_from_buffer(m_buffer.begin());
                                 } else {
-                                    m_process_output += line.raw() + "\n";
+                                    _output_line(line.raw(), m_source_line);
                                 }
                                 m_front_buffer_fan_speed = fan_speed;
                             }
@@ -433,6 +474,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
 
     if (time >= 0) {
         BufferData& new_data = put_in_buffer(BufferData(line.raw(), time, fan_speed));
+        new_data.source_line = m_source_line;
         if (line.has(Axis::X)) {
             new_data.x = reader.x();
             new_data.dx = line.dist_X(reader);
@@ -490,11 +532,11 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
             if (frontdata.fan_speed < 0 || frontdata.fan_speed != m_front_buffer_fan_speed || frontdata.is_kickstart) {
                 if (frontdata.is_kickstart && frontdata.fan_speed < m_front_buffer_fan_speed) {
                     //you have to slow down! not kickstart! rewrite the fan speed.
-                    m_process_output += _set_fan(frontdata.fan_speed);//m_writer.set_fan(frontdata.fan_speed,true); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
+                    m_process_output.append(_set_fan(frontdata.fan_speed));//m_writer.set_fan(frontdata.fan_speed,true); //FIXME extruder id (or use the gcode writer, but then you have to disable the multi-thread thing
                         
                     m_front_buffer_fan_speed = frontdata.fan_speed;
                 } else {
-                    m_process_output += frontdata.raw + "\n";
+                    _output_line(frontdata.raw, frontdata.source_line);
                     if (frontdata.fan_speed >= 0) {
                         //note that this is the only place where the fan_speed is set and we print from the buffer, as if the fan_speed >= 0 => time == 0
                         //and as this flush all time == 0 lines from the back of the queue...
@@ -9,6 +9,8 @@
 #include "../Point.hpp"
 #include "../GCodeReader.hpp"
 #include "../GCodeWriter.hpp"
+#include "GCodeLines.hpp"
+#include <deque>
 #include <regex>
 
 namespace Slic3r {
@@ -21,6 +23,8 @@ public:
     bool is_kickstart;
     float x = 0, y = 0, z = 0, e = 0;
     float dx = 0, dy = 0, dz = 0, de = 0;
+    // Index of the source line counted over all the calls of FanMover::process_gcode(), size_t(-1) for the lines generated by FanMover.
+    size_t source_line = size_t(-1);
     BufferData(std::string line, float time = 0, int16_t fan_speed = 0, float is_kickstart = false) : raw(line), time(time), fan_speed(fan_speed), is_kickstart(is_kickstart){
         //avoid double \n
         if(!line.empty() && line.back() == '\n') line.pop_back();
@@ -56,8 +60,15 @@ private:
     std::list<BufferData> m_buffer;
     double m_buffer_time_size = 0;
 
-    // The output of process_layer()
-    std::string m_process_output;
+    // The output of process_gcode()
+    GCodeLines m_process_output;
+    std::string m_process_output_text;
+    // Input of process_gcode() still referenced by m_buffer, so that the lines not modified are passed to the output by reference.
+    std::deque<GCodeLines> m_sources;
+    // Index of the first line of m_sources.front() counted over all the calls of process_gcode().
+    size_t m_sources_first_line = 0;
+    // Index of the line being processed counted over all the calls of process_gcode().
+    size_t m_source_line = 0;
 
 public:
     FanMover(const GCodeWriter& writer, const float nb_seconds_delay, const bool with_D_option, const bool relative_e,
@@ -70,7 +81,11 @@ public:
     }
 
     // Adds the gcode contained in the given string to the analysis and returns it after removing the workcodes
-    const std::string& process_gcode(const std::string& gcode, bool flush);
+    const std::string& process_gcode(const std::string& gcode, bool flush)
+        { m_process_output_text = this->process_gcode(GCodeLines(std::string(gcode)), flush).str(); return m_process_output_text; }
+    // Same as above, with the gcode already tokenized, for example by a preceding pipeline stage.
+    // The lines not modified are passed to the output by reference.
+    GCodeLines process_gcode(GCodeLines&& gcode, bool flush);
 
 private:
     BufferData& put_in_buffer(BufferData&& data) {
@@ -86,9 +101,13 @@ private:
     void _process_gcode_line(GCodeReader& reader, const GCodeReader::GCodeLine& line);
     void _process_T(const std::string_view command);
     void _put_in_middle_G1(std::list<BufferData>::iterator item_to_split, float nb_sec, BufferData&& line_to_write);
-    void _print_in_middle_G1(BufferData& line_to_split, float nb_sec, const std::string& line_to_write);
+    void _print_in_middle_G1(BufferData& line_to_split, float nb_sec, const std::string& line_to_write, size_t line_to_write_source = size_t(-1));
     void _remove_slow_fan(int16_t min_speed, float past_sec);
     std::string _set_fan(int16_t speed);
+    // Output a line followed by a newline, passing the source line by reference if the line was not modified.
+    void _output_line(const std::string& line, size_t source_line);
+    // Output a line, adding a newline if missing.
+    void _output_text(const std::string& text, size_t source_line = size_t(-1));
 };
 
 } // namespace Slic3r
@@ -0,0 +1,126 @@
+#include "GCodeLines.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace Slic3r {
+
+// Texts shorter than that are copied by append(std::string&&) into the text chunk instead of being stored as a chunk of their own.
+static constexpr size_t g_min_adopted_chunk_size = 4096;
+
+std::string& GCodeLines::text_chunk()
+{
+    if (m_text_chunk != size_t(-1)) {
+        const std::shared_ptr<std::string> &chunk = m_chunks[m_text_chunk];
+        // Don't modify text shared with other GCodeLines. Start a new chunk after a line without a newline as well:
+        // GCodeReader expects a line to be followed by an end of line or by the terminating zero.
+        if (chunk.use_count() == 1 && (chunk->empty() || chunk->back() == '\n'))
+            return *chunk;
+    }
+    m_text_chunk = m_chunks.size();
+    return *m_chunks.emplace_back(std::make_shared<std::string>());
+}
+
+size_t GCodeLines::share_chunk(const std::shared_ptr<std::string> &chunk)
+{
+    // The lines are usually appended in runs from a few chunks, thus the chunk is likely one of the last ones.
+    for (size_t i = m_chunks.size(); i > 0; -- i)
+        if (m_chunks[i - 1] == chunk)
+            return i - 1;
+    m_chunks.emplace_back(chunk);
+    return m_chunks.size() - 1;
+}
+
+void GCodeLines::tokenize(size_t chunk_idx, size_t offset)
+{
+    const std::string &chunk = *m_chunks[chunk_idx];
+    assert(chunk.size() < size_t(std::numeric_limits<uint32_t>::max()));
+    const size_t first = m_tokens.size();
+    GCodeReader::tokenize_buffer(chunk, offset, m_tokens);
+    m_lines.reserve(m_tokens.size());
+    for (size_t i = first; i < m_tokens.size(); ++ i)
+        m_lines.push_back({ uint32_t(chunk_idx), i + 1 < m_tokens.size() ? m_tokens[i + 1].begin : uint32_t(chunk.size()) });
+}
+
+void GCodeLines::append(std::string &&gcode)
+{
+    if (gcode.size() < g_min_adopted_chunk_size) {
+        this->append(std::string_view(gcode));
+        return;
+    }
+    m_text_chunk = m_chunks.size();
+    m_chunks.emplace_back(std::make_shared<std::string>(std::move(gcode)));
+    this->tokenize(m_text_chunk, 0);
+}
+
+void GCodeLines::append(std::string_view gcode)
+{
+    if (gcode.empty())
+        return;
+    std::string &chunk  = this->text_chunk();
+    const size_t offset = chunk.size();
+    chunk.append(gcode.data(), gcode.size());
+    this->tokenize(m_text_chunk, offset);
+}
+
+void GCodeLines::append(const GCodeLines &other, size_t begin, size_t end)
+{
+    assert(&other != this);
+    assert(begin <= end && end <= other.size());
+    m_tokens.insert(m_tokens.end(), other.m_tokens.begin() + begin, other.m_tokens.begin() + end);
+    m_lines.reserve(m_tokens.size());
+    size_t other_chunk = size_t(-1);
+    size_t this_chunk  = 0;
+    for (size_t i = begin; i < end; ++ i) {
+        Line line = other.m_lines[i];
+        if (line.chunk != other_chunk) {
+            other_chunk = line.chunk;
+            this_chunk  = this->share_chunk(other.m_chunks[other_chunk]);
+        }
+        line.chunk = uint32_t(this_chunk);
+        m_lines.push_back(line);
+    }
+}
+
+void GCodeLines::append_line(std::string_view line, const GCodeLines &other, size_t idx)
+{
+    if (idx < other.size()) {
+        const std::string_view other_line = other.line_with_eol(idx);
+        if (other_line.size() == line.size() + 1 && other_line.back() == '\n' && memcmp(other_line.data(), line.data(), line.size()) == 0) {
+            this->append(other, idx);
+            return;
+        }
+    }
+    this->append_line(line);
+}
+
+void GCodeLines::append_line(std::string_view line)
+{
+    std::string &chunk  = this->text_chunk();
+    const size_t offset = chunk.size();
+    chunk.append(line.data(), line.size());
+    chunk += '\n';
+    this->tokenize(m_text_chunk, offset);
+}
+
+std::string GCodeLines::str() const
+{
+    size_t len = 0;
+    for (size_t i = 0; i < m_tokens.size(); ++ i)
+        len += m_lines[i].eol_end - m_tokens[i].begin;
+    std::string out;
+    out.reserve(len);
+    // Copy the runs of consecutive lines of a chunk at once.
+    for (size_t i = 0; i < m_tokens.size();) {
+        const Line &first = m_lines[i];
+        const char *begin = this->buffer(i) + m_tokens[i].begin;
+        uint32_t    end   = first.eol_end;
+        for (++ i; i < m_tokens.size() && m_lines[i].chunk == first.chunk && m_tokens[i].begin == end; ++ i)
+            end = m_lines[i].eol_end;
+        out.append(begin, this->buffer(i - 1) + end - begin);
+    }
+    return out;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,80 @@
+#ifndef slic3r_GCode_GCodeLines_hpp_
+#define slic3r_GCode_GCodeLines_hpp_
+
+#include "../GCodeReader.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Slic3r {
+
+// G-code of a layer passed between the filters of the G-code export pipeline (vase mode, pressure equalizer, cooling buffer,
+// fan mover, adaptive pressure advance). The G-code is tokenized once and each filter passes the lines it keeps to its output
+// together with their tokens, sharing their text. Only the lines emitted or modified by a filter are tokenized again.
+// The text of the layer is concatenated once by str() at the end of the pipeline.
+class GCodeLines
+{
+public:
+    GCodeLines() = default;
+    explicit GCodeLines(std::string &&gcode) { this->append(std::move(gcode)); }
+
+    bool                empty() const { return m_tokens.empty(); }
+    size_t              size() const { return m_tokens.size(); }
+    void                clear() { m_chunks.clear(); m_tokens.clear(); m_lines.clear(); m_text_chunk = size_t(-1); }
+    // Remove the lines from idx to the end.
+    void                truncate(size_t idx) { m_tokens.resize(idx); m_lines.resize(idx); }
+
+    // Text of the idx-th line without its end of line.
+    std::string_view    line(size_t idx) const
+        { const GCodeReader::TokenizedLine &t = m_tokens[idx]; return { this->buffer(idx) + t.begin, size_t(t.end - t.begin) }; }
+    // Text of the idx-th line including its end of line, if any.
+    std::string_view    line_with_eol(size_t idx) const
+        { const GCodeReader::TokenizedLine &t = m_tokens[idx]; return { this->buffer(idx) + t.begin, size_t(m_lines[idx].eol_end - t.begin) }; }
+    const GCodeReader::TokenizedLine& tokens(size_t idx) const { return m_tokens[idx]; }
+    // Start of the text the tokens of the idx-th line refer to.
+    const char*         buffer(size_t idx) const { return m_chunks[m_lines[idx].chunk]->c_str(); }
+
+    // Append G-code text and tokenize it. A large text is taken over without copying.
+    void                append(std::string &&gcode);
+    // Append G-code text and tokenize it.
+    void                append(std::string_view gcode);
+    void                append(const char *gcode) { this->append(std::string_view(gcode)); }
+    // Append the lines <begin, end) of other. Their text is shared, their tokens are copied.
+    void                append(const GCodeLines &other, size_t begin, size_t end);
+    void                append(const GCodeLines &other, size_t idx) { this->append(other, idx, idx + 1); }
+    void                append(const GCodeLines &other) { this->append(other, 0, other.size()); }
+    // Append a line followed by a newline. If the line matches the idx-th line of other, the line of other is appended instead,
+    // thus a filter may pass its input lines to its output without checking whether it modified them.
+    void                append_line(std::string_view line, const GCodeLines &other, size_t idx);
+    // Append a line followed by a newline.
+    void                append_line(std::string_view line);
+
+    // Concatenate the text of all the lines.
+    std::string         str() const;
+
+private:
+    // Chunk to append new text to, it is never shared with other GCodeLines.
+    std::string&        text_chunk();
+    size_t              share_chunk(const std::shared_ptr<std::string> &chunk);
+    void                tokenize(size_t chunk_idx, size_t offset);
+
+    struct Line {
+        // Index into m_chunks.
+        uint32_t    chunk;
+        // End of the line including its end of line.
+        uint32_t    eol_end;
+    };
+
+    // Text of the lines, possibly shared with other GCodeLines. The text of a chunk is not modified once shared.
+    std::vector<std::shared_ptr<std::string>>   m_chunks;
+    // Chunk holding the text appended by append(), size_t(-1) if none.
+    size_t                                      m_text_chunk { size_t(-1) };
+    GCodeReader::TokenizedBuffer                m_tokens;
+    std::vector<Line>                           m_lines;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_GCode_GCodeLines_hpp_
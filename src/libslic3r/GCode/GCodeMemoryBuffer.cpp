@@ -0,0 +1,147 @@
+#include "GCodeMemoryBuffer.hpp"
+
+#include "libslic3r/Exception.hpp"
+
+#include <miniz.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <tbb/parallel_for.h>
+
+namespace Slic3r {
+
+// Uncompressed bytes allowed to wait for the TBB workers. If the workers are busy, the next block is deflated by the producer.
+static constexpr size_t g_max_pending_size = 8 * GCodeMemoryBuffer::block_size;
+// Number of chunks decompressed ahead by GCodeMemoryBuffer::Reader.
+static constexpr size_t g_read_ahead_chunks = 4;
+
+GCodeMemoryBuffer::~GCodeMemoryBuffer()
+{
+    // Don't throw from the destructor, the export is being aborted anyway.
+    try {
+        m_tasks.wait();
+    } catch (...) {
+    }
+}
+
+void GCodeMemoryBuffer::deflate_block(Block &block)
+{
+    mz_ulong len = mz_compressBound(mz_ulong(block.size));
+    block.deflated.assign(len, 0);
+    if (mz_compress2(block.deflated.data(), &len, reinterpret_cast<const unsigned char*>(block.data.data()), mz_ulong(block.size), MZ_BEST_SPEED) == MZ_OK) {
+        block.deflated.resize(len);
+        block.deflated.shrink_to_fit();
+    } else {
+        block.deflated.clear();
+        block.failed = true;
+    }
+    block.data = std::string();
+    m_deflated_size += block.deflated.size();
+}
+
+void GCodeMemoryBuffer::append(const char *data, size_t len)
+{
+    m_size += len;
+    while (len > 0) {
+        const size_t n = std::min(len, block_size - m_block.size());
+        if (m_block.empty())
+            m_block.reserve(block_size);
+        m_block.append(data, n);
+        data += n;
+        len  -= n;
+        if (m_block.size() == block_size) {
+            Block &block = m_blocks.emplace_back();
+            block.size = m_block.size();
+            block.data = std::move(m_block);
+            m_block    = std::string();
+            if (m_pending_size.load(std::memory_order_relaxed) < g_max_pending_size) {
+                m_pending_size += block.size;
+                m_tasks.run([this, &block]() {
+                    const size_t size = block.size;
+                    this->deflate_block(block);
+                    m_pending_size -= size;
+                });
+            } else
+                this->deflate_block(block);
+        }
+    }
+}
+
+void GCodeMemoryBuffer::finish()
+{
+    m_tasks.wait();
+    for (const Block &block : m_blocks)
+        if (block.failed)
+            throw Slic3r::RuntimeError("Failed to compress the G-code kept in memory.");
+}
+
+void GCodeMemoryBuffer::clear()
+{
+    m_tasks.wait();
+    m_blocks.clear();
+    m_block         = std::string();
+    m_size          = 0;
+    m_deflated_size = 0;
+    m_pending_size  = 0;
+}
+
+void GCodeMemoryBuffer::read_chunk(size_t idx, std::string &out) const
+{
+    assert(idx < this->num_chunks());
+    if (idx == m_blocks.size()) {
+        out.assign(m_block);
+        return;
+    }
+    const Block &block = m_blocks[idx];
+    out.resize(block.size);
+    mz_ulong len = mz_ulong(block.size);
+    if (mz_uncompress(reinterpret_cast<unsigned char*>(out.data()), &len, block.deflated.data(), mz_ulong(block.deflated.size())) != MZ_OK || len != block.size)
+        throw Slic3r::RuntimeError("Failed to decompress the G-code kept in memory.");
+}
+
+bool GCodeMemoryBuffer::write(FILE *f) const
+{
+    std::string chunk;
+    for (size_t i = 0; i < this->num_chunks(); ++ i) {
+        this->read_chunk(i, chunk);
+        if (::fwrite(chunk.data(), 1, chunk.size(), f) != chunk.size())
+            return false;
+    }
+    return true;
+}
+
+GCodeMemoryBuffer::Reader::~Reader()
+{
+    try {
+        m_tasks.wait();
+    } catch (...) {
+    }
+}
+
+void GCodeMemoryBuffer::Reader::read_ahead()
+{
+    const size_t begin = m_ahead_begin;
+    m_ahead.resize(std::min(g_read_ahead_chunks, m_buffer.num_chunks() - begin));
+    m_ahead_begin += m_ahead.size();
+    m_tasks.run([this, begin]() {
+        tbb::parallel_for(size_t(0), m_ahead.size(), [this, begin](size_t i) { m_buffer.read_chunk(begin + i, m_ahead[i]); });
+    });
+}
+
+const std::string& GCodeMemoryBuffer::Reader::next()
+{
+    static const std::string empty;
+    if (m_current_idx == m_current.size()) {
+        // Rethrows an exception thrown by read_chunk().
+        m_tasks.wait();
+        std::swap(m_current, m_ahead);
+        m_current_idx = 0;
+        if (m_current.empty())
+            return empty;
+        this->read_ahead();
+    }
+    return m_current[m_current_idx ++];
+}
+
+} // namespace Slic3r
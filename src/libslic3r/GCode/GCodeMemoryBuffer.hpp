@@ -0,0 +1,90 @@
+#ifndef slic3r_GCode_GCodeMemoryBuffer_hpp_
+#define slic3r_GCode_GCodeMemoryBuffer_hpp_
+
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <tbb/task_group.h>
+
+namespace Slic3r {
+
+// G-code kept in memory during the export instead of being written into the temporary file,
+// so that GCodeProcessor::run_post_process() does not read the file back.
+// The G-code is cut into blocks, which are deflated by the TBB workers while the export continues.
+// G-code compresses several times, thus a G-code of several hundred megabytes fits into a budget of tens of megabytes.
+class GCodeMemoryBuffer
+{
+public:
+    // Size of the uncompressed blocks.
+    static constexpr size_t block_size = size_t(4) << 20;
+
+    GCodeMemoryBuffer() = default;
+    ~GCodeMemoryBuffer();
+    GCodeMemoryBuffer(const GCodeMemoryBuffer &) = delete;
+    GCodeMemoryBuffer& operator=(const GCodeMemoryBuffer &) = delete;
+
+    void        append(const char *data, size_t len);
+    // Wait until all the blocks are deflated. Throws if a block could not be deflated.
+    void        finish();
+    void        clear();
+
+    bool        empty() const { return m_size == 0; }
+    // Size of the uncompressed G-code.
+    size_t      size() const { return m_size; }
+    // Memory held by the deflated blocks, by the blocks waiting to be deflated and by the block being filled.
+    size_t      memory_used() const { return m_deflated_size.load(std::memory_order_relaxed) + m_pending_size.load(std::memory_order_relaxed) + m_block.capacity(); }
+
+    // The G-code is read back in chunks, the last chunk is the block being filled. Call finish() first.
+    size_t      num_chunks() const { return m_blocks.size() + 1; }
+    // Decompress a chunk into out, reusing its memory.
+    void        read_chunk(size_t idx, std::string &out) const;
+    // Write the complete G-code into a file, returns false on a write error. Call finish() first.
+    bool        write(FILE *f) const;
+
+    // Reads the chunks in order, while the TBB workers decompress the following chunks.
+    class Reader
+    {
+    public:
+        explicit Reader(const GCodeMemoryBuffer &buffer) : m_buffer(buffer) { this->read_ahead(); }
+        ~Reader();
+        // Returns an empty chunk after the last one. The chunk is valid until the next call.
+        const std::string& next();
+
+    private:
+        void read_ahead();
+
+        const GCodeMemoryBuffer    &m_buffer;
+        std::vector<std::string>    m_current;
+        std::vector<std::string>    m_ahead;
+        size_t                      m_current_idx { 0 };
+        size_t                      m_ahead_begin { 0 };
+        tbb::task_group             m_tasks;
+    };
+
+private:
+    struct Block {
+        // Uncompressed data, released once deflated.
+        std::string                 data;
+        std::vector<unsigned char>  deflated;
+        size_t                      size { 0 };
+        bool                        failed { false };
+    };
+
+    void        deflate_block(Block &block);
+
+    // std::deque does not move its elements when growing, thus the blocks may be deflated while new ones are added.
+    std::deque<Block>               m_blocks;
+    std::string                     m_block;
+    size_t                          m_size { 0 };
+    std::atomic<size_t>             m_deflated_size { 0 };
+    // Uncompressed bytes of the blocks waiting to be deflated.
+    std::atomic<size_t>             m_pending_size { 0 };
+    tbb::task_group                 m_tasks;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_GCode_GCodeMemoryBuffer_hpp_
@@ -16,6 +16,8 @@
 #include <boost/nowide/cstdio.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <tbb/parallel_for.h>
+
 #include <fast_float/fast_float.h>
 
 #include <float.h>
@@ -365,12 +367,12 @@ static void planner_reverse_pass_kernel(GCodeProcessor::TimeBlock& curr, const G
     }
 }
 
-static void recalculate_trapezoids(std::vector<GCodeProcessor::TimeBlock>& blocks)
+static void recalculate_trapezoids(std::vector<GCodeProcessor::TimeBlock>& blocks, size_t begin, size_t end)
 {
     GCodeProcessor::TimeBlock* curr = nullptr;
     GCodeProcessor::TimeBlock* next = nullptr;
 
-    for (size_t i = 0; i < blocks.size(); ++i) {
+    for (size_t i = begin; i < end; ++i) {
       GCodeProcessor::TimeBlock& b = blocks[i];
 
         curr = next;
@@ -402,23 +404,45 @@ void GCodeProcessor::TimeMachine::calculate_time(GCodeProcessorResult& result, P
 
     assert(keep_last_n_blocks <= blocks.size());
 
+    const size_t n_blocks_process = this->simulate(result, mode, 0, blocks.size(), keep_last_n_blocks, additional_time);
+    if (keep_last_n_blocks)
+        blocks.erase(blocks.begin(), blocks.begin() + n_blocks_process);
+    else
+        blocks.clear();
+}
+
+void GCodeProcessor::TimeMachine::calculate_time(GCodeProcessorResult& result, PrintEstimatedStatistics::ETimeMode mode, const std::vector<size_t>& window_ends, size_t keep_last_n_blocks)
+{
+    if (!enabled || window_ends.empty())
+        return;
+
+    size_t begin = 0;
+    for (size_t end : window_ends) {
+        assert(begin + keep_last_n_blocks < end && end <= blocks.size());
+        begin = this->simulate(result, mode, begin, end, keep_last_n_blocks, 0.0f);
+    }
+    blocks.erase(blocks.begin(), blocks.begin() + begin);
+}
+
+size_t GCodeProcessor::TimeMachine::simulate(GCodeProcessorResult& result, PrintEstimatedStatistics::ETimeMode mode, size_t begin, size_t end, size_t keep_last_n_blocks, float additional_time)
+{
     // reverse_pass
-    for (int i = static_cast<int>(blocks.size()) - 1; i > 0; --i) {
+    for (size_t i = end - 1; i > begin; --i) {
         planner_reverse_pass_kernel(blocks[i - 1], blocks[i]);
     }
 
     // forward_pass
-    for (size_t i = 0; i + 1 < blocks.size(); ++i) {
+    for (size_t i = begin; i + 1 < end; ++i) {
         planner_forward_pass_kernel(blocks[i], blocks[i + 1]);
     }
 
-    recalculate_trapezoids(blocks);
+    recalculate_trapezoids(blocks, begin, end);
 
-    const size_t n_blocks_process = blocks.size() - keep_last_n_blocks;
-    for (size_t i = 0; i < n_blocks_process; ++i) {
+    const size_t n_blocks_process = end - begin - keep_last_n_blocks;
+    for (size_t i = begin; i < begin + n_blocks_process; ++i) {
         const TimeBlock& block = blocks[i];
         float block_time = block.time();
-        if (i == 0)
+        if (i == begin)
             block_time += additional_time;
 
         time += double(block_time);
@@ -533,19 +557,17 @@ void GCodeProcessor::TimeMachine::calculate_time(GCodeProcessorResult& result, P
     }
 
     if (keep_last_n_blocks) {
-        blocks.erase(blocks.begin(), blocks.begin() + n_blocks_process);
-
         // Ensure that the new first block's entry speed will be preserved to prevent discontinuity
         // between the erased blocks' exit speed and the new first block's entry speed.
         // Otherwise, the first block's entry speed could be recalculated on the next pass without
         // considering that there are no more blocks before this first block. This could lead
         // to discontinuity between the exit speed (of already processed blocks) and the entry
         // speed of the first block.
-        TimeBlock &first_block = blocks.front();
+        TimeBlock &first_block = blocks[begin + n_blocks_process];
         first_block.max_entry_speed = first_block.feedrate_profile.entry;
-    } else {
-        blocks.clear();
     }
+
+    return begin + n_blocks_process;
 }
 
 void GCodeProcessor::TimeProcessor::reset()
@@ -556,7 +578,7 @@ void GCodeProcessor::TimeProcessor::reset()
     filament_load_times = 0.0f;
     filament_unload_times = 0.0f;
     machine_tool_change_time = 0.0f;
-
+    planner_windows.clear();
 
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
         machines[i].reset();
@@ -911,8 +933,10 @@ private:
 
 void GCodeProcessor::run_post_process()
 {
-    FilePtr in{ boost::nowide::fopen(m_result.filename.c_str(), "rb") };
-    if (in.f == nullptr)
+    // Either read the G-code kept in memory by the producer, or read the file back.
+    const bool from_memory = m_gcode_buffer != nullptr;
+    FilePtr in{ from_memory ? nullptr : boost::nowide::fopen(m_result.filename.c_str(), "rb") };
+    if (! from_memory && in.f == nullptr)
         throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for reading.\n"));
 
     // temporary file to contain modified gcode
@@ -1320,16 +1344,28 @@ void GCodeProcessor::run_post_process()
 
     {
         // Read the input stream 64kB at a time, extract lines and process them.
-        std::vector<char> buffer(65536 * 10, 0);
+        // The G-code kept in memory is processed one decompressed block at a time.
+        std::vector<char> buffer(from_memory ? 0 : 65536 * 10, 0);
+        std::optional<GCodeMemoryBuffer::Reader> memory_reader;
+        if (from_memory)
+            memory_reader.emplace(*m_gcode_buffer);
         // Line buffer.
         assert(gcode_line.empty());
         for (;;) {
-            size_t cnt_read = ::fread(buffer.data(), 1, buffer.size(), in.f);
-            if (::ferror(in.f))
-                throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nError while reading from file.\n"));
-            bool eof       = cnt_read == 0;
-            auto it        = buffer.begin();
-            auto it_bufend = buffer.begin() + cnt_read;
+            const char *it;
+            size_t      cnt_read;
+            if (from_memory) {
+                const std::string &chunk = memory_reader->next();
+                it          = chunk.data();
+                cnt_read    = chunk.size();
+            } else {
+                it          = buffer.data();
+                cnt_read    = ::fread(buffer.data(), 1, buffer.size(), in.f);
+                if (::ferror(in.f))
+                    throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nError while reading from file.\n"));
+            }
+            bool eof              = cnt_read == 0;
+            const char *it_bufend = it + cnt_read;
             while (it != it_bufend || (eof && ! gcode_line.empty())) {
                 // Find end of line.
                 bool eol    = false;
@@ -1398,6 +1434,7 @@ void GCodeProcessor::run_post_process()
 
     out.close();
     in.close();
+    m_gcode_buffer.reset();
 
     const std::string result_filename = m_result.filename;
     export_line.synchronize_moves(m_result);
@@ -2510,7 +2547,7 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
                         if (detect_producer(std::string_view(begin, end - begin))) {
                             m_parser.quit_parsing();
                         }
-                    } else if (std::string(begin, end).find("CONFIG_BLOCK_END") != std::string::npos) {
+                    } else if (std::string_view(begin, end - begin).find("CONFIG_BLOCK_END") != std::string_view::npos) {
                         m_parser.quit_parsing();
                     }
                 }
@@ -2575,6 +2612,7 @@ void GCodeProcessor::initialize(const std::string& filename)
     // process gcode
     m_result.filename = filename;
     m_result.id = ++s_result_id;
+    m_gcode_buffer.reset();
 }
 
 void GCodeProcessor::process_buffer(const std::string &buffer)
@@ -2615,6 +2653,12 @@ void GCodeProcessor::finalize(bool post_process)
 
     if (post_process){
         run_post_process();
+    } else if (m_gcode_buffer) {
+        // No post processing, just write the G-code kept in memory into the file.
+        FilePtr out{ boost::nowide::fopen(m_result.filename.c_str(), "wb") };
+        if (out.f == nullptr || ! m_gcode_buffer->write(out.f))
+            throw Slic3r::RuntimeError(std::string("GCode processor export failed.\nIs the disk full?\n"));
+        m_gcode_buffer.reset();
     }
     //BBS: update slice warning
     update_slice_warnings();
@@ -2809,10 +2853,10 @@ void GCodeProcessor::process_gcode_line(const GCodeReader::GCodeLine& line, bool
         m_command_processor.process_comand(cmd, line);
     }
     else {
-        const std::string &comment = line.raw();
+        const std::string_view comment = line.raw_view();
         if (comment.length() > 2 && comment.front() == ';')
         {
-            std::string comment_content = comment.substr(1); // only format like ";V{cmd}" is valid
+            std::string comment_content(comment.substr(1)); // only format like ";V{cmd}" is valid
             if (comment_content[0] == 'V' || comment_content[0] == 'v') {
                 GCodeReader reader;
                 GCodeReader::GCodeLine new_line;
@@ -4084,8 +4128,13 @@ void GCodeProcessor::process_G1(const std::array<std::optional<double>, 4>& axes
         blocks.push_back(block);
     }
 
-    if (m_time_processor.machines[0].blocks.size() > TimeProcessor::Planner::refresh_threshold)
-        calculate_time(m_result, TimeProcessor::Planner::queue_size);
+    std::vector<size_t>& planner_windows = m_time_processor.planner_windows;
+    const size_t planner_window_begin = planner_windows.empty() ? 0 : planner_windows.back() - TimeProcessor::Planner::queue_size;
+    if (m_time_processor.machines[0].blocks.size() - planner_window_begin > TimeProcessor::Planner::refresh_threshold) {
+        planner_windows.push_back(m_time_processor.machines[0].blocks.size());
+        if (planner_windows.size() == TimeProcessor::Planner::max_deferred_windows)
+            calculate_time(m_result, false);
+    }
 
     const Vec3f plate_offset = {(float) m_x_offset, (float) m_y_offset, 0.0f};
 
@@ -5740,16 +5789,30 @@ void GCodeProcessor::process_filaments(CustomGCode::Type code)
     }
 }
 
-void GCodeProcessor::calculate_time(GCodeProcessorResult& result, size_t keep_last_n_blocks, float additional_time)
+void GCodeProcessor::calculate_time(GCodeProcessorResult& result, bool flush, float additional_time)
 {
     // calculate times
-    std::vector<TimeMachine::ActualSpeedMove> actual_speed_moves;
-    for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
+    // The time machines share nothing but the moves, of which each machine writes its own time slot and only the Normal machine
+    // reads the other fields and writes the actual feedrate, thus each machine simulates the deferred planner windows by a task of its own.
+    std::vector<size_t>& planner_windows = m_time_processor.planner_windows;
+    auto simulate_machine = [this, &result, &planner_windows, flush, additional_time](size_t i) {
         TimeMachine& machine = m_time_processor.machines[i];
-        machine.calculate_time(m_result, static_cast<PrintEstimatedStatistics::ETimeMode>(i), keep_last_n_blocks, additional_time);
-        if (static_cast<PrintEstimatedStatistics::ETimeMode>(i) == PrintEstimatedStatistics::ETimeMode::Normal)
-            actual_speed_moves = std::move(machine.actual_speed_moves);
-    }
+        const PrintEstimatedStatistics::ETimeMode mode = static_cast<PrintEstimatedStatistics::ETimeMode>(i);
+        machine.calculate_time(result, mode, planner_windows, TimeProcessor::Planner::queue_size);
+        if (flush)
+            machine.calculate_time(result, mode, 0, additional_time);
+    };
+    const size_t num_machines = static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count);
+    if (! planner_windows.empty() &&
+        std::count_if(m_time_processor.machines.begin(), m_time_processor.machines.end(), [](const TimeMachine& machine) { return machine.enabled; }) > 1)
+        tbb::parallel_for(size_t(0), num_machines, simulate_machine);
+    else
+        for (size_t i = 0; i < num_machines; ++i)
+            simulate_machine(i);
+    planner_windows.clear();
+
+    std::vector<TimeMachine::ActualSpeedMove> actual_speed_moves =
+        std::move(m_time_processor.machines[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].actual_speed_moves);
 
     // insert actual speed moves into the move list
     unsigned int inserted_actual_speed_moves_count = 0;
@@ -5802,7 +5865,7 @@ void GCodeProcessor::calculate_time(GCodeProcessorResult& result, size_t keep_la
 
 void GCodeProcessor::simulate_st_synchronize(float additional_time)
 {
-    calculate_time(m_result, 0, additional_time);
+    calculate_time(m_result, true, additional_time);
 }
 
 void GCodeProcessor::update_estimated_times_stats()
@@ -6,6 +6,7 @@
 #include "libslic3r/ExtrusionEntity.hpp"
 #include "libslic3r/PrintConfig.hpp"
 #include "libslic3r/CustomGCode.hpp"
+#include "libslic3r/GCode/GCodeMemoryBuffer.hpp"
 
 #include <cstdint>
 #include <array>
@@ -539,6 +540,14 @@ class Print;
             void reset();
 
             void calculate_time(GCodeProcessorResult& result, PrintEstimatedStatistics::ETimeMode mode, size_t keep_last_n_blocks = 0, float additional_time = 0.0f);
+            // Simulates the planner windows ending at window_ends, as if calculate_time(result, mode, keep_last_n_blocks)
+            // was called each time the blocks reached the end of a window.
+            void calculate_time(GCodeProcessorResult& result, PrintEstimatedStatistics::ETimeMode mode, const std::vector<size_t>& window_ends, size_t keep_last_n_blocks);
+
+        private:
+            // Simulates the blocks <begin, end), of which the last keep_last_n_blocks are only planned.
+            // Returns the index of the first block not accounted for.
+            size_t simulate(GCodeProcessorResult& result, PrintEstimatedStatistics::ETimeMode mode, size_t begin, size_t end, size_t keep_last_n_blocks, float additional_time);
         };
 
         struct UsedFilaments  // filaments per ColorChange
@@ -593,6 +602,9 @@ class Print;
                 // The firmware recalculates last planner_queue_size trapezoidal blocks each time a new block is added.
                 // We are not simulating the firmware exactly, we calculate a sequence of blocks once a reasonable number of blocks accumulate.
                 static constexpr size_t refresh_threshold = queue_size * 4;
+                // The planner windows are deferred until the firmware synchronizes or until that many windows accumulate,
+                // then the time machines simulate them in parallel.
+                static constexpr size_t max_deferred_windows = 64;
             };
 
             // extruder_id is currently used to correctly calculate filament load / unload times into the total print time.
@@ -609,6 +621,8 @@ class Print;
             float machine_tool_change_time;
 
             std::array<TimeMachine, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)> machines;
+            // Ends of the planner windows not simulated yet, indices into TimeMachine::blocks.
+            std::vector<size_t> planner_windows;
 
             void reset();
         };
@@ -831,6 +845,8 @@ class Print;
         Print* m_print{ nullptr };
 
         GCodeProcessorResult m_result;
+        // Complete G-code to be post-processed, if it was not written into m_result.filename, see set_gcode_buffer().
+        std::unique_ptr<GCodeMemoryBuffer> m_gcode_buffer;
         static unsigned int s_result_id;
 
     public:
@@ -873,6 +889,9 @@ class Print;
             m_result.moves.emplace_back(GCodeProcessorResult::MoveVertex());
         }
         void process_buffer(const std::string& buffer);
+        // The G-code passed to process_buffer() was kept in memory by the producer instead of being written into the file
+        // passed to initialize(). finalize() will write the file from this buffer in a single pass.
+        void set_gcode_buffer(std::unique_ptr<GCodeMemoryBuffer> &&gcode) { m_gcode_buffer = std::move(gcode); }
         void finalize(bool post_process);
 
         float get_time(PrintEstimatedStatistics::ETimeMode mode) const;
@@ -1057,7 +1076,7 @@ class Print;
 
         void process_filament_change(int id);
 
-        // post process the file with the given filename to:
+        // post process the file with the given filename (or the G-code kept in m_gcode_buffer) to:
         // 1) add remaining time lines M73 and update moves' gcode ids accordingly
         // 2) update used filament data
         void run_post_process();
@@ -1090,7 +1109,8 @@ class Print;
         void process_custom_gcode_time(CustomGCode::Type code);
         void process_filaments(CustomGCode::Type code);
 
-        void calculate_time(GCodeProcessorResult& result, size_t keep_last_n_blocks = 0, float additional_time = 0.0f);
+        // Simulates the deferred planner windows. If flush, simulates the remaining blocks as well, as if the firmware emptied its queue.
+        void calculate_time(GCodeProcessorResult& result, bool flush = true, float additional_time = 0.0f);
 
         // Simulates firmware st_synchronize() call
         void simulate_st_synchronize(float additional_time = 0.0f);
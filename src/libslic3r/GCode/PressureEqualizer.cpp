@@ -33,11 +33,6 @@ static constexpr long max_ignored_gap_between_extruding_segments = 3;
 
 PressureEqualizer::PressureEqualizer(const Slic3r::GCodeConfig &config) : m_use_relative_e_distances(config.use_relative_e_distances.value)
 {
-    // Preallocate some data, so that output_buffer.data() will return an empty string.
-    output_buffer.assign(32, 0);
-    output_buffer_length      = 0;
-    output_buffer_prev_length = 0;
-
     m_current_extruder = 0;
     // Zero the position of the XYZE axes + the current feed
     memset(m_current_pos, 0, sizeof(float) * 5);
@@ -87,27 +82,21 @@ PressureEqualizer::PressureEqualizer(const Slic3r::GCodeConfig &config) : m_use_
 #endif
 }
 
-void PressureEqualizer::process_layer(const std::string &gcode)
+void PressureEqualizer::process_layer(const GCodeLines &lines)
 {
-    if (!gcode.empty()) {
-        const char *gcode_begin = gcode.c_str();
-        while (*gcode_begin != 0) {
-            // Find end of the line.
-            const char *gcode_end = gcode_begin;
-            // Slic3r always generates end of lines in a Unix style.
-            for (; *gcode_end != 0 && *gcode_end != '\n'; ++gcode_end);
-
-            m_gcode_lines.emplace_back();
-            if (!this->process_line(gcode_begin, gcode_end, m_gcode_lines.back())) {
-                // The line has to be forgotten. It contains comment marks, which shall be filtered out of the target g-code.
-                m_gcode_lines.pop_back();
-            }
-            gcode_begin = gcode_end;
-            if (*gcode_begin == '\n')
-                ++gcode_begin;
-        }
-        assert(!this->opened_extrude_set_speed_block);
+    for (size_t line_idx = 0; line_idx < lines.size(); ++ line_idx) {
+        // Slic3r always generates end of lines in a Unix style, strip just the newline.
+        std::string_view line = lines.line_with_eol(line_idx);
+        if (! line.empty() && line.back() == '\n')
+            line.remove_suffix(1);
+        m_gcode_lines.emplace_back();
+        if (this->process_line(line.data(), line.data() + line.size(), lines.tokens(line_idx), m_gcode_lines.back()))
+            m_gcode_lines.back().source_line = line_idx;
+        else
+            // The line has to be forgotten. It contains comment marks, which shall be filtered out of the target g-code.
+            m_gcode_lines.pop_back();
     }
+    assert(!this->opened_extrude_set_speed_block);
     
     // at this point, we have an entire layer of gcode lines loaded into m_gcode_lines
     // now we will split the mix of travels and extrudes into segments of continous extrusion and process those
@@ -172,14 +161,26 @@ long PressureEqualizer::advance_segment_beyond_small_gap(const long idx_orig)
 }
 
 LayerResult PressureEqualizer::process_layer(LayerResult &&input)
+{
+    GCodeLines  lines(std::move(input.gcode));
+    GCodeLines  out_lines;
+    LayerResult out = this->process_layer(std::move(input), std::move(lines), out_lines);
+    if (! out_lines.empty())
+        out.gcode = out_lines.str();
+    return out;
+}
+
+LayerResult PressureEqualizer::process_layer(LayerResult &&input, GCodeLines &&lines, GCodeLines &out_lines)
 {
     const bool   is_first_layer       = m_layer_results.empty();
     const size_t next_layer_first_idx = m_gcode_lines.size();
 
+    out_lines.clear();
     if (!input.nop_layer_result) {
-        this->process_layer(input.gcode);
+        this->process_layer(lines);
         input.gcode.clear(); // GCode is already processed, so it isn't needed to store it.
         m_layer_results.emplace(new LayerResult(input));
+        m_layer_lines.emplace(std::move(lines));
     }
 
     if (is_first_layer) // Buffer previous input result and output NOP.
@@ -188,16 +189,16 @@ LayerResult PressureEqualizer::process_layer(LayerResult &&input)
     // Export previous layer.
     LayerResult *prev_layer_result = m_layer_results.front();
     m_layer_results.pop();
+    const GCodeLines prev_layer_lines = std::move(m_layer_lines.front());
+    m_layer_lines.pop();
 
-    output_buffer_length      = 0;
-    output_buffer_prev_length = 0;
+    m_output           = &out_lines;
+    m_output_prev_line = 0;
     for (size_t line_idx = 0; line_idx < next_layer_first_idx; ++line_idx)
-        output_gcode_line(line_idx);
+        output_gcode_line(line_idx, prev_layer_lines);
+    m_output = nullptr;
     m_gcode_lines.erase(m_gcode_lines.begin(), m_gcode_lines.begin() + int(next_layer_first_idx));
 
-    if (output_buffer_length > 0)
-        prev_layer_result->gcode = std::string(output_buffer.data());
-
     assert(!input.nop_layer_result || m_layer_results.empty());
     LayerResult out = *prev_layer_result;
     delete prev_layer_result;
@@ -251,7 +252,7 @@ static inline float parse_float(const char *&line, const size_t line_length)
     return result;
 }
 
-bool PressureEqualizer::process_line(const char *line, const char *line_end, GCodeLine &buf)
+bool PressureEqualizer::process_line(const char *line, const char *line_end, const GCodeReader::TokenizedLine &tokens, GCodeLine &buf)
 {
     const size_t len = line_end - line;
     if (strncmp(line, EXTRUSION_ROLE_TAG.data(), EXTRUSION_ROLE_TAG.length()) == 0) {
@@ -320,31 +321,45 @@ bool PressureEqualizer::process_line(const char *line, const char *line_end, GCo
             float new_pos[5];
             memcpy(new_pos, m_current_pos, sizeof(float)*5);
             bool  changed[5] = { false, false, false, false, false };
-            while (!is_eol(*line)) {
-                const char axis = toupper(*line++);
-                int  i = -1;
-                switch (axis) {
-                case 'X':
-                case 'Y':
-                case 'Z':
-                    i = axis - 'X';
-                    break;
-                case 'E':
-                    i = 3;
-                    break;
-                case 'F':
-                    i = 4;
-                    break;
-                default:
-                    break;
-                }
-                if (i != -1) {
-                    buf.pos_provided[i] = true;
-                    new_pos[i] = parse_float(line, line_end - line);
-                    if (i == 3 && m_use_relative_e_distances)
-                        new_pos[i] += m_current_pos[i];
-                    changed[i] = new_pos[i] != m_current_pos[i];
-                    eatws(line);
+            if ((tokens.mask & GCodeReader::GCodeLine::lower_case_word_mask) == 0) {
+                // X,Y,Z,E,F share their indices with the GCodeReader axes.
+                static_assert(X == 0 && Y == 1 && Z == 2 && E == 3 && F == 4);
+                for (int i = 0; i < 5; ++ i)
+                    if (tokens.mask & (1 << i)) {
+                        buf.pos_provided[i] = true;
+                        new_pos[i] = tokens.axis[i];
+                        if (i == 3 && m_use_relative_e_distances)
+                            new_pos[i] += m_current_pos[i];
+                        changed[i] = new_pos[i] != m_current_pos[i];
+                    }
+            } else {
+                // GCodeReader does not parse lower case axes.
+                while (!is_eol(*line)) {
+                    const char axis = toupper(*line++);
+                    int  i = -1;
+                    switch (axis) {
+                    case 'X':
+                    case 'Y':
+                    case 'Z':
+                        i = axis - 'X';
+                        break;
+                    case 'E':
+                        i = 3;
+                        break;
+                    case 'F':
+                        i = 4;
+                        break;
+                    default:
+                        break;
+                    }
+                    if (i != -1) {
+                        buf.pos_provided[i] = true;
+                        new_pos[i] = parse_float(line, line_end - line);
+                        if (i == 3 && m_use_relative_e_distances)
+                            new_pos[i] += m_current_pos[i];
+                        changed[i] = new_pos[i] != m_current_pos[i];
+                        eatws(line);
+                    }
                 }
             }
             if (changed[3]) {
@@ -468,11 +483,14 @@ bool PressureEqualizer::process_line(const char *line, const char *line_end, GCo
     return true;
 }
 
-void PressureEqualizer::output_gcode_line(const size_t line_idx)
+void PressureEqualizer::output_gcode_line(const size_t line_idx, const GCodeLines &source)
 {
     GCodeLine &line = m_gcode_lines[line_idx];
     if (!line.modified) {
-        push_to_output(line.raw.data(), line.raw_length, true);
+        // Pass the source line to the output together with its tokens.
+        if (line.raw_length != 0)
+            m_output_prev_line = m_output->size();
+        m_output->append_line(std::string_view(line.raw.data(), line.raw_length), source, line.source_line);
         return;
     }
 
@@ -865,35 +883,12 @@ inline void PressureEqualizer::push_to_output(const std::string &text, bool add_
 
 inline void PressureEqualizer::push_to_output(const char *text, const size_t len, bool add_eol)
 {
-    // New length of the output buffer content.
-    size_t len_new = output_buffer_length + len + 1;
+    if (len != 0)
+        m_output_prev_line = m_output->size();
     if (add_eol)
-        ++len_new;
-
-    // Resize the output buffer to a power of 2 higher than the required memory.
-    if (output_buffer.size() < len_new) {
-        size_t v = len_new;
-        // Compute the next highest power of 2 of 32-bit v
-        // http://graphics.stanford.edu/~seander/bithacks.html
-        v--;
-        v |= v >> 1;
-        v |= v >> 2;
-        v |= v >> 4;
-        v |= v >> 8;
-        v |= v >> 16;
-        v++;
-        output_buffer.resize(v);
-    }
-
-    // Copy the text to the output.
-    if (len != 0) {
-        memcpy(output_buffer.data() + output_buffer_length, text, len);
-        this->output_buffer_prev_length = this->output_buffer_length;
-        output_buffer_length += len;
-    }
-    if (add_eol)
-        output_buffer[output_buffer_length++] = '\n';
-    output_buffer[output_buffer_length] = 0;
+        m_output->append_line(std::string_view(text, len));
+    else
+        m_output->append(std::string_view(text, len));
 }
 
 inline bool is_just_line_with_extrude_set_speed_tag(const std::string &line)
@@ -923,11 +918,14 @@ void PressureEqualizer::push_line_to_output(const size_t line_idx, float new_fee
     // Quantize speed changes to a minimum of 1mm/sec, to reduce gcode volume for trivial speed changes.
     new_feedrate = std::round(new_feedrate / 60.0) * 60.0;
     const GCodeLine &line = m_gcode_lines[line_idx];
-    if (line_idx > 0 && output_buffer_length > 0) {
-        const std::string prev_line_str = std::string(output_buffer.begin() + int(this->output_buffer_prev_length),
-                                                      output_buffer.begin() + int(this->output_buffer_length) + 1);
+    if (line_idx > 0 && !m_output->empty()) {
+        std::string prev_line_str;
+        for (size_t i = m_output_prev_line; i < m_output->size(); ++ i)
+            prev_line_str += m_output->line_with_eol(i);
+        // Zero terminated, the parser below stops at the terminating zero.
+        prev_line_str += '\0';
         if (is_just_line_with_extrude_set_speed_tag(prev_line_str))
-            this->output_buffer_length = this->output_buffer_prev_length; // Remove the last line because it only sets the speed for an empty block of g-code lines, so it is useless.
+            m_output->truncate(m_output_prev_line); // Remove the last line because it only sets the speed for an empty block of g-code lines, so it is useless.
         else
             push_to_output(EXTRUDE_END_TAG.data(), EXTRUDE_END_TAG.length(), true);
     } else
@@ -3,6 +3,8 @@
 
 #include "../libslic3r.h"
 #include "../PrintConfig.hpp"
+#include "../GCodeReader.hpp"
+#include "GCodeLines.hpp"
 
 #include <queue>
 
@@ -28,9 +30,13 @@ public:
     // The last LayerResult must be LayerResult::make_nop_layer_result() because it always returns GCode for the previous layer.
     // When process_layer is called for the first layer, then LayerResult::make_nop_layer_result() is returned.
     LayerResult process_layer(LayerResult &&input);
+    // Same as above, with the G-code of the input already tokenized into lines, for example by a parallel pipeline stage.
+    // The moves are then not parsed again. The G-code of the previous layer is returned in out_lines instead of LayerResult::gcode,
+    // the lines not modified being shared with the input.
+    LayerResult process_layer(LayerResult &&input, GCodeLines &&lines, GCodeLines &out_lines);
 private:
 
-    void process_layer(const std::string &gcode);
+    void process_layer(const GCodeLines &lines);
 
 #ifdef PRESSURE_EQUALIZER_STATISTIC
     struct Statistics
@@ -142,6 +148,8 @@ private:
         // We try to keep the string buffer once it has been allocated, so it will not be reallocated over and over.
         std::vector<char>   raw;
         size_t              raw_length;
+        // Index of this line in the GCodeLines of its layer.
+        size_t              source_line { 0 };
         // If modified, the raw text has to be adapted by the new extrusion rate,
         // or maybe the line needs to be split into multiple lines.
         bool                modified;
@@ -175,25 +183,26 @@ private:
         bool        extrude_end_tag       = false;
     };
 
-    // Output buffer will only grow. It will not be reallocated over and over.
-    std::vector<char>               output_buffer;
-    size_t                          output_buffer_length;
-    size_t                          output_buffer_prev_length;
+    // Output of the layer being exported.
+    GCodeLines                     *m_output { nullptr };
+    // Index of the last line pushed to the output, which was not empty.
+    size_t                          m_output_prev_line { 0 };
 
 #ifdef PRESSURE_EQUALIZER_DEBUG
     // For debugging purposes. Index of the G-code line processed.
     size_t                          line_idx;
 #endif
 
-    bool process_line(const char *line, const char *line_end, GCodeLine &buf);
+    // The axes of G0 / G1 moves are taken from the tokens instead of parsing the line, unless the line contains lower case words.
+    bool process_line(const char *line, const char *line_end, const GCodeReader::TokenizedLine &tokens, GCodeLine &buf);
     long advance_segment_beyond_small_gap(long idx_cur_pos);
-    void output_gcode_line(size_t line_idx);
+    void output_gcode_line(size_t line_idx, const GCodeLines &source);
 
     // Go back from the current circular_buffer_pos and lower the feedtrate to decrease the slope of the extrusion rate changes.
     // Then go forward and adjust the feedrate to decrease the slope of the extrusion rate changes.
     void adjust_volumetric_rate(size_t first_line_idx, size_t last_line_idx);
 
-    // Push the text to the end of the output_buffer.
+    // Push the text to the end of the output.
     inline void push_to_output(GCodeG1Formatter &formatter);
     inline void push_to_output(const std::string &text, bool add_eol);
     inline void push_to_output(const char *text, size_t len, bool add_eol = true);
@@ -202,6 +211,8 @@ private:
 
 public:
     std::queue<LayerResult*> m_layer_results;
+    // Input lines of the layers in m_layer_results.
+    std::queue<GCodeLines>   m_layer_lines;
 
     std::vector<GCodeLine> m_gcode_lines;
 };
@@ -155,6 +155,7 @@ std::vector<float> raycast_visibility(const AABBTreeIndirect::Tree<3, float> &ra
                      &raycasting_tree, &result, &samples, seam_position](tbb::blocked_range<size_t> r) {
                       // Maintaining hits memory outside of the loop, so it does not have to be reallocated for each query.
                       std::vector<igl::Hit> hits;
+                      std::array<igl::Hit, AABBTreeIndirect::RayPacketSize> packet_hits;
                       for (size_t s_idx = r.begin(); s_idx < r.end(); ++s_idx) {
                         result[s_idx] = 1.0f;
                         constexpr float decrease_step = 1.0f
@@ -171,49 +172,57 @@ std::vector<float> raycast_visibility(const AABBTreeIndirect::Tree<3, float> &ra
                         Frame f;
                         f.set_from_z(normal);
 
+                        if (!model_contains_negative_parts) {
+                          // The rays share the origin, thus they are traced in packets against the AABB tree in single precision.
+                          AABBTreeIndirect::RayPacket packet(center + normal * 0.01f); // start above surface.
+                          for (size_t dir_idx = 0; dir_idx < precomputed_sample_directions.size(); ++dir_idx) {
+                            packet.push_back(f.to_world(precomputed_sample_directions[dir_idx]));
+                            if (!packet.full() && dir_idx + 1 < precomputed_sample_directions.size())
+                              continue;
+                            AABBTreeIndirect::intersect_ray_packet_first_hit(triangles.vertices, triangles.indices,
+                                                                             raycasting_tree, packet, packet_hits);
+                            for (size_t ray_idx = 0; ray_idx < packet.size(); ++ray_idx) {
+                              if (packet_hits[ray_idx].id != -1 &&
+                                  its_face_normal(triangles, packet_hits[ray_idx].id).dot(packet.dir(ray_idx)) <= 0) {
+                                result[s_idx] -= decrease_step;
+                              }
+                            }
+                            packet.clear();
+                          }
+                          continue;
+                        }
+
                         for (const auto &dir : precomputed_sample_directions) {
                           Vec3f final_ray_dir = (f.to_world(dir));
-                          if (!model_contains_negative_parts) {
-                            igl::Hit hitpoint;
-                            // FIXME: This AABBTTreeIndirect query will not compile for float ray origin and
-                            // direction.
-                            Vec3d final_ray_dir_d = final_ray_dir.cast<double>();
-                            Vec3d ray_origin_d = (center + normal * 0.01f).cast<double>(); // start above surface.
-                            bool hit = AABBTreeIndirect::intersect_ray_first_hit(triangles.vertices,
-                                                                                 triangles.indices, raycasting_tree, ray_origin_d, final_ray_dir_d, hitpoint);
-                            if (hit && its_face_normal(triangles, hitpoint.id).dot(final_ray_dir) <= 0) {
-                              result[s_idx] -= decrease_step;
-                            }
-                          } else { //TODO improve logic for order based boolean operations - consider order of volumes
-                            bool casting_from_negative_volume = samples.triangle_indices[s_idx]
-                                                                >= negative_volumes_start_index;
-
-                            Vec3d ray_origin_d = (center + normal * 0.01f).cast<double>(); // start above surface.
-                            if (casting_from_negative_volume) { // if casting from negative volume face, invert direction, change start pos
-                              final_ray_dir = -1.0 * final_ray_dir;
-                              ray_origin_d = (center - normal * 0.01f).cast<double>();
-                            }
-                            Vec3d final_ray_dir_d = final_ray_dir.cast<double>();
-                            bool some_hit = AABBTreeIndirect::intersect_ray_all_hits(triangles.vertices,
-                                                                                     triangles.indices, raycasting_tree,
-                                                                                     ray_origin_d, final_ray_dir_d, hits);
-                            if (some_hit) {
-                              int counter = 0;
-                              // NOTE: iterating in reverse, from the last hit for one simple reason: We know the state of the ray at that point;
-                              //  It cannot be inside model, and it cannot be inside negative volume
-                              for (int hit_index = int(hits.size()) - 1; hit_index >= 0; --hit_index) {
-                                Vec3f face_normal = its_face_normal(triangles, hits[hit_index].id);
-                                if (hits[hit_index].id >= int(negative_volumes_start_index)) { //negative volume hit
-                                  counter -= sgn(face_normal.dot(final_ray_dir)); // if volume face aligns with ray dir, we are leaving negative space
-                                                                                               // which in reverse hit analysis means, that we are entering negative space :) and vice versa
-                                } else {
-                                  counter += sgn(face_normal.dot(final_ray_dir));
-                                }
-                              }
-                              if (counter == 0) {
-                                result[s_idx] -= decrease_step;
+                          //TODO improve logic for order based boolean operations - consider order of volumes
+                          bool casting_from_negative_volume = samples.triangle_indices[s_idx]
+                                                              >= negative_volumes_start_index;
+
+                          Vec3d ray_origin_d = (center + normal * 0.01f).cast<double>(); // start above surface.
+                          if (casting_from_negative_volume) { // if casting from negative volume face, invert direction, change start pos
+                            final_ray_dir = -1.0 * final_ray_dir;
+                            ray_origin_d = (center - normal * 0.01f).cast<double>();
+                          }
+                          Vec3d final_ray_dir_d = final_ray_dir.cast<double>();
+                          bool some_hit = AABBTreeIndirect::intersect_ray_all_hits(triangles.vertices,
+                                                                                   triangles.indices, raycasting_tree,
+                                                                                   ray_origin_d, final_ray_dir_d, hits);
+                          if (some_hit) {
+                            int counter = 0;
+                            // NOTE: iterating in reverse, from the last hit for one simple reason: We know the state of the ray at that point;
+                            //  It cannot be inside model, and it cannot be inside negative volume
+                            for (int hit_index = int(hits.size()) - 1; hit_index >= 0; --hit_index) {
+                              Vec3f face_normal = its_face_normal(triangles, hits[hit_index].id);
+                              if (hits[hit_index].id >= int(negative_volumes_start_index)) { //negative volume hit
+                                counter -= sgn(face_normal.dot(final_ray_dir)); // if volume face aligns with ray dir, we are leaving negative space
+                                                                                             // which in reverse hit analysis means, that we are entering negative space :) and vice versa
+                              } else {
+                                counter += sgn(face_normal.dot(final_ray_dir));
                               }
                             }
+                            if (counter == 0) {
+                              result[s_idx] -= decrease_step;
+                            }
                           }
                         }
                       }
@@ -290,8 +299,51 @@ struct CoordinateFunctor {
   }
 };
 
+// Inputs of GlobalModelInfo. GlobalModelInfo of a PrintObject is kept between the G-code exports
+// and reused as long as the meshes, transformations and seam painting of the object did not change.
+struct GlobalModelInfoKey {
+  struct Volume {
+    ObjectID id;
+    ModelVolumeType type;
+    // Holding the mesh, so that its address cannot be reused by another mesh.
+    std::shared_ptr<const TriangleMesh> mesh;
+    Transform3d matrix;
+    ObjectBase::Timestamp seam_facets_timestamp;
+
+    bool operator==(const Volume &rhs) const {
+      return id == rhs.id && type == rhs.type && mesh == rhs.mesh && matrix.matrix() == rhs.matrix.matrix()
+          && seam_facets_timestamp == rhs.seam_facets_timestamp;
+    }
+  };
+
+  Transform3d trafo_centered { Transform3d::Identity() };
+  SeamPosition seam_position { spAligned };
+  bool occlusion { false };
+  std::vector<Volume> volumes;
+
+  bool operator==(const GlobalModelInfoKey &rhs) const {
+    return trafo_centered.matrix() == rhs.trafo_centered.matrix() && seam_position == rhs.seam_position
+        && occlusion == rhs.occlusion && volumes == rhs.volumes;
+  }
+};
+
+GlobalModelInfoKey global_model_info_key(const PrintObject *po, SeamPosition seam_position, bool occlusion) {
+  GlobalModelInfoKey key;
+  key.trafo_centered = po->trafo_centered();
+  key.seam_position = seam_position;
+  key.occlusion = occlusion;
+  for (const ModelVolume *mv : po->model_object()->volumes) {
+    // Only the parts and negative volumes occlude, enforcers and blockers are painted on any volume.
+    if (mv->type() == ModelVolumeType::MODEL_PART || mv->type() == ModelVolumeType::NEGATIVE_VOLUME || mv->is_seam_painted()) {
+      key.volumes.push_back({ mv->id(), mv->type(), mv->mesh_ptr(), mv->get_matrix(), mv->seam_facets.timestamp() });
+    }
+  }
+  return key;
+}
+
 // structure to store global information about the model - occlusion hits, enforcers, blockers
 struct GlobalModelInfo {
+  GlobalModelInfoKey key;
   TriangleSetSamples mesh_samples;
   std::vector<float> mesh_samples_visibility;
   CoordinateFunctor mesh_samples_coordinate_functor;
@@ -1434,13 +1486,25 @@ void SeamPlacer::init(const Print &print, std::function<void(void)> throw_if_can
     SeamComparator comparator { configured_seam_preference };
 
     {
-      GlobalModelInfo global_model_info { };
-      gather_enforcers_blockers(global_model_info, po);
-      throw_if_canceled_func();
-      if (configured_seam_preference == spAligned || configured_seam_preference == spNearest || configured_seam_preference == spAlignedBack) {
-        compute_global_occlusion(global_model_info, po, throw_if_canceled_func, configured_seam_preference);
+      const bool occlusion = configured_seam_preference == spAligned || configured_seam_preference == spNearest || configured_seam_preference == spAlignedBack;
+      GlobalModelInfoKey key = global_model_info_key(po, configured_seam_preference, occlusion);
+      std::shared_ptr<const GlobalModelInfo> cached_model_info = po->seam_model_info();
+      if (! cached_model_info || ! (cached_model_info->key == key)) {
+        auto new_model_info = std::make_shared<GlobalModelInfo>();
+        gather_enforcers_blockers(*new_model_info, po);
+        throw_if_canceled_func();
+        if (occlusion) {
+          compute_global_occlusion(*new_model_info, po, throw_if_canceled_func, configured_seam_preference);
+        }
+        throw_if_canceled_func();
+        new_model_info->key = std::move(key);
+        cached_model_info = std::move(new_model_info);
+        po->set_seam_model_info(cached_model_info);
+      } else {
+        BOOST_LOG_TRIVIAL(debug)
+            << "SeamPlacer: reusing visibility and enforcers / blockers of the previous export";
       }
-      throw_if_canceled_func();
+      const GlobalModelInfo &global_model_info = *cached_model_info;
       BOOST_LOG_TRIVIAL(debug)
           << "SeamPlacer: gather_seam_candidates: start";
       gather_seam_candidates(po, global_model_info);
@@ -1454,7 +1518,7 @@ void SeamPlacer::init(const Print &print, std::function<void(void)> throw_if_can
         BOOST_LOG_TRIVIAL(debug)
             << "SeamPlacer: calculate_candidates_visibility : end";
       }
-    } // destruction of global_model_info (large structure, no longer needed)
+    } // global_model_info (large structure) is held by the PrintObject for the next export
     throw_if_canceled_func();
     BOOST_LOG_TRIVIAL(debug)
         << "SeamPlacer: calculate_overhangs and layer embdedding : start";
@@ -63,7 +63,7 @@ SpiralVase::SpiralPoint nearest_point_on_lines(SpiralVase::SpiralPoint
 }
 } // namespace SpiralVase
 
-std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
+GCodeLines SpiralVase::process_layer(GCodeLines &&gcode, bool last_layer)
 {
     /*  This post-processor relies on several assumptions:
         - all layers are processed through it, including those that are not supposed
@@ -76,8 +76,8 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
     // If we're not going to modify G-code, just feed it to the reader
     // in order to update positions.
     if (! m_enabled) {
-        m_reader.parse_buffer(gcode);
-        return gcode;
+        m_reader.parse_lines(gcode);
+        return std::move(gcode);
     }
     
     // Get total XY length for this layer by summing all extrusion moves.
@@ -89,7 +89,7 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
         //FIXME Performance warning: This copies the GCodeConfig of the reader.
         GCodeReader r = m_reader;  // clone
         bool set_z = false;
-        r.parse_buffer(gcode, [&total_layer_length, &layer_height, &z, &set_z]
+        r.parse_lines(gcode, [&total_layer_length, &layer_height, &z, &set_z]
             (GCodeReader &reader, const GCodeReader::GCodeLine &line) {
             if (line.cmd_is("G1")) {
                 if (line.extruding(reader)) {
@@ -112,8 +112,10 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
     std::vector<SpiralVase::SpiralPoint>* previous_layer = m_previous_layer;
 
     bool smooth_spiral = m_smooth_spiral;
-    std::string new_gcode;
-    std::string transition_gcode;
+    GCodeLines new_gcode;
+    GCodeLines transition_gcode;
+    // Index of the line being processed, the lines not modified are shared with the input.
+    size_t line_idx = 0;
     float max_xy_dist_for_smoothing = m_max_xy_smoothing;
     //FIXME Tapering of the transition layer only works reliably with relative extruder distances.
     // For absolute extruder distances it will be switched off.
@@ -127,8 +129,9 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
 
     float len = 0.f;
     SpiralVase::SpiralPoint last_point = previous_layer != NULL && previous_layer->size() >0? previous_layer->at(previous_layer->size()-1): SpiralVase::SpiralPoint(0,0);
-    m_reader.parse_buffer(gcode, [&new_gcode, &z, total_layer_length, layer_height, transition_in, &len, &current_layer, &previous_layer, &transition_gcode, transition_out, smooth_spiral, &max_xy_dist_for_smoothing, &last_point, starting_flowrate, finishing_flowrate]
+    m_reader.parse_lines(gcode, [&gcode, &line_idx, &new_gcode, &z, total_layer_length, layer_height, transition_in, &len, &current_layer, &previous_layer, &transition_gcode, transition_out, smooth_spiral, &max_xy_dist_for_smoothing, &last_point, starting_flowrate, finishing_flowrate]
         (GCodeReader &reader, GCodeReader::GCodeLine line) {
+        const size_t idx = line_idx ++;
         if (line.cmd_is("G1")) {
             // Orca: Filter out retractions at layer change
             if (line.retracting(reader) || (line.extruding(reader) && line.dist_XY(reader) < EPSILON)) return;
@@ -136,7 +139,7 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
                 // If this is the initial Z move of the layer, replace it with a
                 // (redundant) move to the last Z of previous layer.
                 line.set(Z, z);
-                new_gcode += line.raw() + '\n';
+                new_gcode.append_line(line.raw(), gcode, idx);
                 return;
             } else {
                 float dist_XY = line.dist_XY(reader);
@@ -156,7 +159,7 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
                             GCodeReader::GCodeLine transitionLine(line);
                             float finishing_e_factor = finishing_flowrate + ((1.f -factor) * (1.f - finishing_flowrate));
                             transitionLine.set(E, line.e() * finishing_e_factor, 5 /*decimal_digits*/);
-                            transition_gcode += transitionLine.raw() + '\n';
+                            transition_gcode.append_line(transitionLine.raw(), gcode, idx);
                         }
                         // This line is the core of Spiral Vase mode, ramp up the Z smoothly
                         line.set(Z, z + factor * layer_height);
@@ -189,7 +192,7 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
                                 }
                             }
                         }
-                        new_gcode += line.raw() + '\n';
+                        new_gcode.append_line(line.raw(), gcode, idx);
                     }
                     return;
                     /*  Skip travel moves: the move to first perimeter point will
@@ -202,16 +205,17 @@ std::string SpiralVase::process_layer(const std::string &gcode, bool last_layer)
                 }
             }
         }
-        new_gcode += line.raw() + '\n';
+        new_gcode.append_line(line.raw(), gcode, idx);
         if(transition_out) {
-            transition_gcode += line.raw() + '\n';
+            transition_gcode.append_line(line.raw(), gcode, idx);
         }
     });
 
     delete m_previous_layer;
     m_previous_layer = current_layer;
     
-    return new_gcode + transition_gcode;
+    new_gcode.append(transition_gcode);
+    return new_gcode;
 }
 
 }
@@ -3,6 +3,7 @@
 
 #include "../libslic3r.h"
 #include "../GCodeReader.hpp"
+#include "GCodeLines.hpp"
 
 namespace Slic3r {
 
@@ -30,7 +31,11 @@ public:
     	m_enabled 		   = en;
     }
 
-    std::string process_layer(const std::string &gcode, bool last_layer);
+    std::string process_layer(const std::string &gcode, bool last_layer)
+        { return this->process_layer(GCodeLines(std::string(gcode)), last_layer).str(); }
+    // Same as above, with the gcode already tokenized, for example by a parallel pipeline stage.
+    // The lines, which are not modified, are passed to the output without being tokenized again.
+    GCodeLines  process_layer(GCodeLines &&gcode, bool last_layer);
     void set_max_xy_smoothing(float max) {
         m_max_xy_smoothing = max;
     }
@@ -4,9 +4,12 @@
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include "Utils.hpp"
 
 #include "LocalesUtils.hpp"
@@ -14,8 +17,75 @@
 #include <Shiny/Shiny.h>
 #include <fast_float/fast_float.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SLIC3R_GCODEREADER_SSE2
+    #include <emmintrin.h>
+    #ifdef __AVX2__
+        #include <immintrin.h>
+    #endif
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
 namespace Slic3r {
 
+#ifdef SLIC3R_GCODEREADER_SSE2
+static inline unsigned int count_trailing_zeros(uint32_t mask)
+{
+    assert(mask != 0);
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (unsigned int)idx;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+#endif // SLIC3R_GCODEREADER_SSE2
+
+// Find the first '\r' or '\n' (and '\0' if stop_at_zero) in [begin, end), return end if there is none.
+// Compares 32 (AVX2) or 16 (SSE2) characters at once, the rest is scanned one by one.
+// Only the end of line search is vectorized: the command and the axis words are tokenized character by character
+// and the numbers are parsed by fast_float, as before.
+template<bool stop_at_zero>
+static inline const char* find_end_of_line(const char *begin, const char *end)
+{
+    const char *c = begin;
+#ifdef SLIC3R_GCODEREADER_SSE2
+#ifdef __AVX2__
+    {
+        const __m256i cr   = _mm256_set1_epi8('\r');
+        const __m256i lf   = _mm256_set1_epi8('\n');
+        const __m256i zero = _mm256_setzero_si256();
+        for (; end - c >= 32; c += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+            __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf));
+            if (stop_at_zero)
+                m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, zero));
+            if (uint32_t mask = uint32_t(_mm256_movemask_epi8(m)); mask != 0)
+                return c + count_trailing_zeros(mask);
+        }
+    }
+#endif // __AVX2__
+    {
+        const __m128i cr   = _mm_set1_epi8('\r');
+        const __m128i lf   = _mm_set1_epi8('\n');
+        const __m128i zero = _mm_setzero_si128();
+        for (; end - c >= 16; c += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c));
+            __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf));
+            if (stop_at_zero)
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(v, zero));
+            if (uint32_t mask = uint32_t(_mm_movemask_epi8(m)); mask != 0)
+                return c + count_trailing_zeros(mask);
+        }
+    }
+#endif // SLIC3R_GCODEREADER_SSE2
+    for (; c != end && *c != '\r' && *c != '\n' && ! (stop_at_zero && *c == 0); ++ c) ;
+    return c;
+}
+
 void GCodeReader::apply_config(const GCodeConfig &config)
 {
     m_config = config;
@@ -30,6 +100,19 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
 {
     PROFILE_FUNC();
 
+    const char *c = tokenize_line_internal(ptr, end, gline, command);
+
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
+
+    if (m_verbose)
+        std::cout << gline.m_raw << std::endl;
+
+    return c;
+}
+
+const char* GCodeReader::tokenize_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+{
     assert(is_decimal_separator_point());
     
     // command and args
@@ -62,6 +145,8 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 if (*c >= 'A' && *c <= 'Z')
                 	// Unknown axis, but we still want to remember that such a axis was seen.
                 	axis = UNKNOWN_AXIS;
+                else if (*c >= 'a' && *c <= 'z')
+                    gline.m_mask |= GCodeLine::lower_case_word_mask;
                 break;
             }
             if (axis != NUM_AXES_WITH_UNKNOWN) {
@@ -82,18 +167,13 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 c = skip_word(c);
         }
     }
-    
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
 
-    // Skip the rest of the line.
-    for (; ! is_end_of_line(*c); ++ c);
+    // Skip the rest of the line, usually a comment. The line is terminated at end at the latest.
+    c = find_end_of_line<true>(c, std::max(c, end));
 
-    // Copy the raw string including the comment, without the trailing newlines.
-    if (c > ptr) {
-        PROFILE_BLOCK(copy_raw_string);
-        gline.m_raw.assign(ptr, c);
-    }
+    // Reference the raw string including the comment, without the trailing newlines.
+    // The raw string is not copied, it is only materialized by GCodeLine::raw() on demand.
+    gline.m_raw = std::string_view(ptr, c - ptr);
 
     // Skip the trailing newlines.
 	if (*c == '\r')
@@ -101,12 +181,48 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
 	if (*c == '\n')
 		++ c;
 
-    if (m_verbose)
-        std::cout << gline.m_raw << std::endl;
-
     return c;
 }
 
+GCodeReader::TokenizedBuffer GCodeReader::tokenize_buffer(const std::string &buffer)
+{
+    TokenizedBuffer lines;
+    tokenize_buffer(buffer, 0, lines);
+    return lines;
+}
+
+void GCodeReader::tokenize_buffer(const std::string &buffer, size_t offset, TokenizedBuffer &lines)
+{
+    assert(buffer.size() < size_t(std::numeric_limits<uint32_t>::max()));
+    assert(offset <= buffer.size());
+    const char *begin = buffer.c_str();
+    const char *end   = begin + buffer.size();
+    GCodeLine   gline;
+    std::pair<const char*, const char*> cmd;
+    for (const char *ptr = begin + offset; *ptr != 0;) {
+        gline.reset();
+        const char   *next = tokenize_line_internal(ptr, end, gline, cmd);
+        TokenizedLine &line = lines.emplace_back();
+        line.begin     = uint32_t(ptr - begin);
+        line.end       = uint32_t(line.begin + gline.m_raw.size());
+        line.cmd_begin = uint32_t(cmd.first - begin);
+        line.cmd_end   = uint32_t(cmd.second - begin);
+        line.mask      = gline.m_mask;
+        memcpy(line.axis, gline.m_axis, sizeof(line.axis));
+        ptr = next;
+    }
+}
+
+std::pair<const char*, const char*> GCodeReader::apply_tokenized_line(const char *begin, const TokenizedLine &line, GCodeLine &gline)
+{
+    gline.m_raw  = std::string_view(begin + line.begin, line.end - line.begin);
+    gline.m_mask = line.mask;
+    memcpy(gline.m_axis, line.axis, sizeof(line.axis));
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
+    return { begin + line.cmd_begin, begin + line.cmd_end };
+}
+
 void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command)
 {
     PROFILE_FUNC();
@@ -125,7 +241,45 @@ void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, co
 template<typename ParseLineCallback, typename LineEndCallback>
 bool GCodeReader::parse_file_raw_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback)
 {
+    // Memory map the file and parse the lines in place, without copying them into an intermediate buffer.
+    // Fall back to reading the file by chunks if the file could not be mapped (for example an empty file).
+    boost::iostreams::mapped_file_source mapped;
+    try {
+        mapped.open(boost::filesystem::path(filename));
+    } catch (const std::exception &) {
+    }
+    if (mapped.is_open() && mapped.size() > 0) {
+        const char *begin = mapped.data();
+        const char *end   = begin + mapped.size();
+        // The last line not terminated by a newline is copied to be zero terminated.
+        std::string last_line;
+        m_parsing = true;
+        for (const char *it = begin; it != end;) {
+            // Find end of line.
+            const char *it_end = find_end_of_line<false>(it, end);
+            if (it_end == end) {
+                last_line.assign(it, it_end);
+                parse_line_callback(last_line.c_str(), last_line.c_str() + last_line.size());
+            } else
+                parse_line_callback(it, it_end);
+            if (! m_parsing)
+                // The callback wishes to exit.
+                return true;
+            // Skip EOL.
+            it = it_end;
+            if (it != end && *it == '\r')
+                ++ it;
+            if (it != end && *it == '\n') {
+                line_end_callback(size_t(it - begin) + 1);
+                ++ it;
+            }
+        }
+        return true;
+    }
+
     FilePtr in{ boost::nowide::fopen(filename.c_str(), "rb") };
+    if (in.f == nullptr)
+        return false;
 
     // Read the input stream 64kB at a time, extract lines and process them.
     std::vector<char> buffer(65536 * 10, 0);
@@ -246,7 +400,7 @@ const char* GCodeReader::axis_pos(const char *raw_str, char axis)
 
 bool GCodeReader::GCodeLine::has(char axis) const
 {
-    const char *c = m_raw.c_str();
+    const char *c = m_raw.data();
     // Skip the whitespaces.
     c = skip_whitespaces(c);
     // Skip the command.
@@ -268,9 +422,8 @@ bool GCodeReader::GCodeLine::has(char axis) const
 
 std::string_view GCodeReader::GCodeLine::axis_pos(char axis) const
 {
-    const std::string &s = this->raw();
-    const char *c = GCodeReader::axis_pos(this->raw().c_str(), axis);
-    return c ? std::string_view{ c, s.size() - (c - s.data()) } : std::string_view();
+    const char *c = GCodeReader::axis_pos(m_raw.data(), axis);
+    return c ? m_raw.substr(c - m_raw.data()) : std::string_view();
 }
 
 bool GCodeReader::GCodeLine::has_value(std::string_view axis_pos, float &value)
@@ -292,7 +445,7 @@ bool GCodeReader::GCodeLine::has_value(std::string_view axis_pos, float &value)
 bool GCodeReader::GCodeLine::has_value(char axis, float &value) const
 {
     assert(is_decimal_separator_point());
-    const char *c = m_raw.c_str();
+    const char *c = m_raw.data();
     // Skip the whitespaces.
     c = skip_whitespaces(c);
     // Skip the command.
@@ -306,9 +459,9 @@ bool GCodeReader::GCodeLine::has_value(char axis, float &value) const
         // Check the name of the axis.
         if (*c == axis) {
             // Try to parse the numeric value.
-            char   *pend = nullptr;
-            double  v = strtod(++ c, &pend);
-            if (pend != nullptr && is_end_of_word(*pend)) {
+            double v = 0.;
+            auto [pend, ec] = fast_float::from_chars(++ c, m_raw.data() + m_raw.size(), v);
+            if (pend != c && is_end_of_word(*pend)) {
                 // The axis value has been parsed correctly.
                 value = float(v);
                 return true;
@@ -340,17 +493,21 @@ void GCodeReader::GCodeLine::set(const Axis axis, const float new_value, const i
         match[1] = 'E';
     }
 
+    // Modify the owned copy of the raw string.
+    this->raw();
+    std::string &raw = m_raw_storage;
     if (this->has(axis)) {
-        size_t pos = m_raw.find(match)+2;
-        size_t end = m_raw.find(' ', pos+1);
-        m_raw = m_raw.replace(pos, end-pos, ss.str());
+        size_t pos = raw.find(match)+2;
+        size_t end = raw.find(' ', pos+1);
+        raw.replace(pos, end-pos, ss.str());
     } else {
-        size_t pos = m_raw.find(' ');
+        size_t pos = raw.find(' ');
         if (pos == std::string::npos)
-            m_raw += std::string(match) + ss.str();
+            raw += std::string(match) + ss.str();
         else
-            m_raw = m_raw.replace(pos, 0, std::string(match) + ss.str());
+            raw.replace(pos, 0, std::string(match) + ss.str());
     }
+    m_raw = m_raw_storage;
     m_axis[axis] = new_value;
     m_mask |= 1 << int(axis);
 }
@@ -7,6 +7,7 @@
 #include <functional>
 #include <string>
 #include <string_view>
+#include <vector>
 #include "PrintConfig.hpp"
 
 namespace Slic3r {
@@ -16,19 +17,41 @@ public:
     class GCodeLine {
     public:
         GCodeLine() { reset(); }
-        void reset() { m_mask = 0; memset(m_axis, 0, sizeof(m_axis)); m_raw.clear(); }
+        // A copy always owns its raw string, as the source buffer of the parsed line may not outlive the copy.
+        GCodeLine(const GCodeLine &rhs) { *this = rhs; }
+        GCodeLine& operator=(const GCodeLine &rhs) {
+            if (this != &rhs) {
+                m_raw_storage.assign(rhs.m_raw.data(), rhs.m_raw.size());
+                m_raw = m_raw_storage;
+                memcpy(m_axis, rhs.m_axis, sizeof(m_axis));
+                m_mask = rhs.m_mask;
+            }
+            return *this;
+        }
+        void reset() { m_mask = 0; memset(m_axis, 0, sizeof(m_axis)); m_raw = std::string_view(""); }
 
-        const std::string&      raw() const { return m_raw; }
+        // Raw G-code line without the trailing newline. Unless the line was copied or modified by set(), it points
+        // into the buffer being parsed (for example into a memory mapped G-code file) and it is only valid inside the parser callback.
+        std::string_view        raw_view() const { return m_raw; }
+        // Raw G-code line as std::string. Copied into the line's own storage on first access, the storage is reused
+        // when the same GCodeLine is used to parse the next line.
+        const std::string&      raw() const {
+            if (m_raw.data() != m_raw_storage.data()) {
+                m_raw_storage.assign(m_raw.data(), m_raw.size());
+                m_raw = m_raw_storage;
+            }
+            return m_raw_storage;
+        }
         const std::string_view  cmd() const { 
-            const char *cmd = GCodeReader::skip_whitespaces(m_raw.c_str());
+            const char *cmd = GCodeReader::skip_whitespaces(m_raw.data());
             return std::string_view(cmd, GCodeReader::skip_word(cmd) - cmd);
         }
         const std::string_view  comment() const
-            { size_t pos = m_raw.find(';'); return (pos == std::string::npos) ? std::string_view() : std::string_view(m_raw).substr(pos + 1); }
+            { size_t pos = m_raw.find(';'); return (pos == std::string_view::npos) ? std::string_view() : m_raw.substr(pos + 1); }
 
         // Return position in this->raw() string starting with the "axis" character.
         std::string_view axis_pos(char axis) const;
-        void  clear() { m_raw.clear(); }
+        void  clear() { m_raw_storage.clear(); m_raw = m_raw_storage; }
         bool  has(Axis axis) const { return (m_mask & (1 << int(axis))) != 0; }
         float value(Axis axis) const { return m_axis[axis]; }
         bool  has(char axis) const;
@@ -49,7 +72,7 @@ public:
             float y = this->has(Y) ? (this->y() - reader.y()) : 0;
             return sqrt(x*x + y*y);
         }
-        bool cmd_is(const char *cmd_test)          const { return cmd_is(m_raw, cmd_test); }
+        bool cmd_is(const char *cmd_test)          const { return cmd_is(m_raw.data(), cmd_test); }
         //BBS: modify to support G2 and G3
         bool extruding(const GCodeReader &reader)  const { return (this->cmd_is("G1") || this->cmd_is("G2") || this->cmd_is("G3")) && this->dist_E(reader) > 0; }
         bool retracting(const GCodeReader &reader) const { return (this->cmd_is("G1") || this->cmd_is("G2") || this->cmd_is("G3")) && this->dist_E(reader) < 0; }
@@ -67,6 +90,10 @@ public:
         bool  has_p() const { return this->has(P); }
 
         bool  has_unknown_axis() const { return this->has(UNKNOWN_AXIS); }
+        // Words starting with a lower case letter are not parsed as axes. Their presence is recorded in the mask
+        // for the consumers of the tokenized lines, which accept lower case axes and parse such lines themselves.
+        static constexpr uint32_t lower_case_word_mask = uint32_t(1) << 31;
+        bool  has_lower_case_word() const { return (m_mask & lower_case_word_mask) != 0; }
         float x() const { return m_axis[X]; }
         float y() const { return m_axis[Y]; }
         float z() const { return m_axis[Z]; }
@@ -77,11 +104,7 @@ public:
         float j() const { return m_axis[J]; }
         float p() const { return m_axis[P]; }
 
-        static bool cmd_is(const std::string &gcode_line, const char *cmd_test) {
-            const char *cmd = GCodeReader::skip_whitespaces(gcode_line.c_str());
-            size_t len = strlen(cmd_test); 
-            return strncmp(cmd, cmd_test, len) == 0 && GCodeReader::is_end_of_word(cmd[len]);
-        }
+        static bool cmd_is(const std::string &gcode_line, const char *cmd_test) { return cmd_is(gcode_line.c_str(), cmd_test); }
 
         static bool cmd_starts_with(const std::string& gcode_line, const char* cmd_test) {
             return strncmp(GCodeReader::skip_whitespaces(gcode_line.c_str()), cmd_test, strlen(cmd_test)) == 0;
@@ -94,12 +117,35 @@ public:
             return { cmd.begin(), cmd.end() };
         }
     private:
-        std::string      m_raw;
+        // gcode_line has to be terminated by a newline or zero character.
+        static bool cmd_is(const char *gcode_line, const char *cmd_test) {
+            const char *cmd = GCodeReader::skip_whitespaces(gcode_line);
+            size_t len = strlen(cmd_test); 
+            return strncmp(cmd, cmd_test, len) == 0 && GCodeReader::is_end_of_word(cmd[len]);
+        }
+
+        // View of the raw line, either into the parsed buffer or into m_raw_storage.
+        // The character following the view is always a newline or zero, the scanning functions rely on it.
+        mutable std::string_view m_raw;
+        mutable std::string      m_raw_storage;
         float            m_axis[NUM_AXES];
         uint32_t         m_mask;
         friend class GCodeReader;
     };
 
+    // G-code line tokenized ahead of time by tokenize_buffer(), to be replayed by parse_buffer() without parsing the text again.
+    // Offsets are relative to the start of the tokenized buffer.
+    struct TokenizedLine {
+        uint32_t    begin;
+        // End of the line, without the trailing newline.
+        uint32_t    end;
+        uint32_t    cmd_begin;
+        uint32_t    cmd_end;
+        uint32_t    mask;
+        float       axis[NUM_AXES];
+    };
+    using TokenizedBuffer = std::vector<TokenizedLine>;
+
     typedef std::function<void(GCodeReader&, const GCodeLine&)> callback_t;
     typedef std::function<void(GCodeReader&, const char*, const char*)> raw_line_callback_t;
     
@@ -125,6 +171,48 @@ public:
     void parse_buffer(const std::string &buffer)
         { this->parse_buffer(buffer, [](GCodeReader&, const GCodeReader::GCodeLine&){}); }
 
+    // Tokenizing does not depend on the reader state, thus it may run in parallel with processing of other buffers,
+    // for example in a parallel stage of the G-code export pipeline.
+    static TokenizedBuffer tokenize_buffer(const std::string &buffer);
+    // Tokenize buffer from offset on and append the lines to lines. The offsets of the lines are relative to the start of buffer.
+    static void tokenize_buffer(const std::string &buffer, size_t offset, TokenizedBuffer &lines);
+
+    // Same as parse_buffer(buffer, callback), but the lines were already tokenized by tokenize_buffer(buffer).
+    template<typename Callback>
+    void parse_buffer(const std::string &buffer, const TokenizedBuffer &lines, Callback callback)
+    {
+        GCodeLine gline;
+        m_parsing = true;
+        for (auto it = lines.begin(); m_parsing && it != lines.end(); ++ it) {
+            gline.reset();
+            std::pair<const char*, const char*> cmd = this->apply_tokenized_line(buffer.c_str(), *it, gline);
+            callback(*this, gline);
+            update_coordinates(gline, cmd);
+        }
+    }
+
+    // Same as above for lines tokenized from multiple buffers, for example GCodeLines.
+    // Lines provide size(), tokens(idx) and buffer(idx), the start of the buffer the tokens of the idx-th line refer to.
+    template<typename Lines, typename Callback>
+    void parse_lines(const Lines &lines, Callback callback)
+    {
+        GCodeLine gline;
+        m_parsing = true;
+        for (size_t idx = 0; m_parsing && idx < lines.size(); ++ idx) {
+            gline.reset();
+            std::pair<const char*, const char*> cmd = this->apply_tokenized_line(lines.buffer(idx), lines.tokens(idx), gline);
+            callback(*this, gline);
+            update_coordinates(gline, cmd);
+        }
+    }
+
+    template<typename Lines>
+    void parse_lines(const Lines &lines)
+        { this->parse_lines(lines, [](GCodeReader&, const GCodeReader::GCodeLine&){}); }
+
+    void parse_buffer(const std::string &buffer, const TokenizedBuffer &lines)
+        { this->parse_buffer(buffer, lines, [](GCodeReader&, const GCodeReader::GCodeLine&){}); }
+
     template<typename Callback>
     const char* parse_line(const char *ptr, const char *end, GCodeLine &gline, Callback &callback)
     {
@@ -178,6 +266,9 @@ private:
     bool        parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
 
     const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // Stateless part of parse_line_internal(): Parse the command and axes of a single line, return pointer to the start of the next line.
+    static const char* tokenize_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    std::pair<const char*, const char*> apply_tokenized_line(const char *buffer, const TokenizedLine &line, GCodeLine &gline);
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
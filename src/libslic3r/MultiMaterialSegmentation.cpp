@@ -11,10 +11,10 @@
 #include <utility>
 #include <unordered_set>
 
+#include <boost/container/small_vector.hpp>
 #include <boost/log/trivial.hpp>
 #include <tbb/parallel_for.h>
-#include <mutex>
-#include <boost/thread/lock_guard.hpp>
+#include <tbb/enumerable_thread_specific.h>
 
 //#define MM_SEGMENTATION_DEBUG_GRAPH
 //#define MM_SEGMENTATION_DEBUG_REGIONS
@@ -73,8 +73,9 @@ struct MMU_Graph
 
     struct Node
     {
-        Vec2d             point;
-        std::list<size_t> arc_idxs;
+        Vec2d                                       point;
+        // Most of the nodes are Voronoi vertices with three arcs.
+        boost::container::small_vector<size_t, 4>   arc_idxs;
 
         void remove_edge(const size_t to_idx, MMU_Graph &graph)
         {
@@ -104,6 +105,16 @@ struct MMU_Graph
 
     [[nodiscard]] size_t get_global_index(const size_t poly_idx, const size_t point_idx) const { return polygon_idx_offset[poly_idx] + point_idx; }
 
+    // Clear the graph, keep the allocated memory for the next layer.
+    void clear()
+    {
+        this->nodes.clear();
+        this->arcs.clear();
+        this->all_border_points = 0;
+        this->polygon_idx_offset.clear();
+        this->polygon_sizes.clear();
+    }
+
     void append_edge(const size_t &from_idx, const size_t &to_idx, int color = -1, ARC_TYPE type = ARC_TYPE::NON_BORDER)
     {
         // Don't append duplicate edges between the same nodes.
@@ -159,9 +170,9 @@ struct MMU_Graph
     void add_contours(const std::vector<std::vector<ColoredLine>> &color_poly)
     {
         this->all_border_points = nodes.size();
-        this->polygon_sizes     = std::vector<size_t>(color_poly.size());
+        this->polygon_sizes.assign(color_poly.size(), 0);
         for (size_t polygon_idx = 0; polygon_idx < color_poly.size(); ++polygon_idx) this->polygon_sizes[polygon_idx] = color_poly[polygon_idx].size();
-        this->polygon_idx_offset    = std::vector<size_t>(color_poly.size());
+        this->polygon_idx_offset.assign(color_poly.size(), 0);
         this->polygon_idx_offset[0] = 0;
         for (size_t polygon_idx = 1; polygon_idx < color_poly.size(); ++polygon_idx) {
             this->polygon_idx_offset[polygon_idx] = this->polygon_idx_offset[polygon_idx - 1] + color_poly[polygon_idx - 1].size();
@@ -521,7 +532,7 @@ struct PaintedLine
 
 struct PaintedLineVisitor
 {
-    PaintedLineVisitor(const EdgeGrid::Grid &grid, std::vector<PaintedLine> &painted_lines, std::mutex &painted_lines_mutex, size_t reserve) : grid(grid), painted_lines(painted_lines), painted_lines_mutex(painted_lines_mutex)
+    PaintedLineVisitor(const EdgeGrid::Grid &grid, std::vector<PaintedLine> &painted_lines, size_t reserve) : grid(grid), painted_lines(painted_lines)
     {
         painted_lines_set.reserve(reserve);
     }
@@ -563,10 +574,7 @@ struct PaintedLineVisitor
                             line_to_test_projected.reverse();
 
                         painted_lines_set.insert(*it_contour_and_segment);
-                        {
-                            boost::lock_guard<std::mutex> lock(painted_lines_mutex);
-                            painted_lines.push_back({it_contour_and_segment->first, it_contour_and_segment->second, line_to_test_projected, this->color});
-                        }
+                        painted_lines.push_back({it_contour_and_segment->first, it_contour_and_segment->second, line_to_test_projected, this->color});
                     }
                 }
             }
@@ -576,8 +584,8 @@ struct PaintedLineVisitor
     }
 
     const EdgeGrid::Grid                                                                 &grid;
+    // Painted lines of a single thread, thus no locking is needed.
     std::vector<PaintedLine>                                                             &painted_lines;
-    std::mutex                                                                           &painted_lines_mutex;
     Line                                                                                  line_to_test;
     std::unordered_set<std::pair<size_t, size_t>, boost::hash<std::pair<size_t, size_t>>> painted_lines_set;
     int                                                                                   color             = -1;
@@ -1214,7 +1222,9 @@ static inline std::vector<std::vector<ExPolygons>> segmentation_top_and_bottom_l
             if (mv->is_model_part()) {
                 const Transform3d volume_trafo = object_trafo * mv->get_matrix();
                 for (size_t extruder_idx = 0; extruder_idx < num_facets_states; ++extruder_idx) {
-                    const indexed_triangle_set painted = extract_facets_info(*mv).facets_annotation.get_facets_strict(*mv, EnforcerBlockerType(extruder_idx));
+                    // The patch and its slicing index are reused if neither the painting nor the volume changed since the last segmentation.
+                    const PrintObject::PaintedPatch &painted_patch = print_object.painted_patch(*mv, extract_facets_info(*mv).facets_annotation, EnforcerBlockerType(extruder_idx), volume_trafo);
+                    const indexed_triangle_set      &painted       = painted_patch.its;
 #ifdef MM_SEGMENTATION_DEBUG_TOP_BOTTOM
                     {
                         static int iRun = 0;
@@ -1226,7 +1236,7 @@ static inline std::vector<std::vector<ExPolygons>> segmentation_top_and_bottom_l
                         if (!zs.empty() && is_volume_sinking(painted, volume_trafo)) {
                             std::vector<float> zs_sinking = {0.f};
                             Slic3r::append(zs_sinking, zs);
-                            slice_mesh_slabs(painted, zs_sinking, volume_trafo, max_top_layers > 0 ? &top : nullptr, max_bottom_layers > 0 ? &bottom : nullptr, nullptr, throw_on_cancel_callback);
+                            slice_mesh_slabs(painted, zs_sinking, *painted_patch.index, max_top_layers > 0 ? &top : nullptr, max_bottom_layers > 0 ? &bottom : nullptr, nullptr, throw_on_cancel_callback);
 
                             MeshSlicingParams slicing_params;
                             slicing_params.trafo = volume_trafo;
@@ -1237,7 +1247,7 @@ static inline std::vector<std::vector<ExPolygons>> segmentation_top_and_bottom_l
 
                             bottom[0] = union_(bottom[0], bottom_slice);
                         } else
-                            slice_mesh_slabs(painted, zs, volume_trafo, max_top_layers > 0 ? &top : nullptr, max_bottom_layers > 0 ? &bottom : nullptr, nullptr, throw_on_cancel_callback);
+                            slice_mesh_slabs(painted, zs, *painted_patch.index, max_top_layers > 0 ? &top : nullptr, max_bottom_layers > 0 ? &bottom : nullptr, nullptr, throw_on_cancel_callback);
                         auto merge = [](std::vector<Polygons> &&src, std::vector<Polygons> &dst) {
                             auto it_src = find_if(src.begin(), src.end(), [](const Polygons &p){ return ! p.empty(); });
                             if (it_src != src.end()) {
@@ -1524,7 +1534,14 @@ static inline Line clip_finite_voronoi_edge(const Voronoi::VD::edge_type &edge,
 
 static inline bool has_same_color(const ColoredLine &cl1, const ColoredLine &cl2) { return cl1.color == cl2.color; }
 
-static MMU_Graph build_graph(size_t layer_idx, const std::vector<std::vector<ColoredLine>> &color_poly)
+// Voronoi diagram and graph of a layer, reused by a thread for the next layers to avoid reallocations.
+struct MMU_GraphBuffers
+{
+    Voronoi::VD vd;
+    MMU_Graph   graph;
+};
+
+static void build_graph(size_t layer_idx, const std::vector<std::vector<ColoredLine>> &color_poly, MMU_GraphBuffers &buffers)
 {
     const Polygons color_poly_tmp = colored_points_to_polygon(color_poly);
     const Points   points         = to_points(color_poly_tmp);
@@ -1551,10 +1568,12 @@ static MMU_Graph build_graph(size_t layer_idx, const std::vector<std::vector<Col
     ColoredLines       lines_colored = to_lines(color_poly);
     const ColoredLines colored_lines = lines_colored;
 
-    Voronoi::VD vd;
+    Voronoi::VD &vd = buffers.vd;
+    vd.clear();
     vd.construct_voronoi(colored_lines.begin(), colored_lines.end());
     // boost::polygon::construct_voronoi(lines_colored.begin(), lines_colored.end(), &vd);
-    MMU_Graph graph;
+    MMU_Graph &graph = buffers.graph;
+    graph.clear();
     graph.nodes.reserve(points.size() + vd.vertices().size());
     for (const Point &point : points) graph.nodes.push_back({Vec2d(double(point.x()), double(point.y()))});
 
@@ -1586,6 +1605,7 @@ static MMU_Graph build_graph(size_t layer_idx, const std::vector<std::vector<Col
 
     // Make a copy of the input segments with the double type.
     std::vector<Voronoi::Internal::segment_type> segments;
+    segments.reserve(lines.size());
     for (const Line &line : lines)
         segments.emplace_back(Voronoi::Internal::point_type(double(line.a(0)), double(line.a(1))), Voronoi::Internal::point_type(double(line.b(0)), double(line.b(1))));
 
@@ -1738,7 +1758,6 @@ static MMU_Graph build_graph(size_t layer_idx, const std::vector<std::vector<Col
     }
 
     graph.remove_nodes_with_one_arc();
-    return graph;
 }
 
 static std::vector<std::vector<std::pair<size_t, size_t>>> get_all_segments(const std::vector<std::vector<ColoredLine>> &color_poly)
@@ -1965,7 +1984,6 @@ std::vector<std::vector<ExPolygons>> segmentation_by_painting(const PrintObject
     std::vector<std::vector<ExPolygons>>  segmented_regions(num_layers);
     segmented_regions.assign(num_layers, std::vector<ExPolygons>(num_facets_states));
     std::vector<std::vector<PaintedLine>> painted_lines(num_layers);
-    std::array<std::mutex, 64>            painted_lines_mutex;
     std::vector<EdgeGrid::Grid>           edge_grids(num_layers);
     const ConstLayerPtrsAdaptor           layers = print_object.layers();
     std::vector<ExPolygons>               input_expolygons(num_layers);
@@ -2007,30 +2025,38 @@ std::vector<std::vector<ExPolygons>> segmentation_by_painting(const PrintObject
     BOOST_LOG_TRIVIAL(debug) << "Print object segmentation - Slices preprocessing in parallel - End";
 
     std::vector<BoundingBox> layer_bboxes(num_layers);
-    for (size_t layer_idx = 0; layer_idx < num_layers; ++layer_idx) {
-        throw_on_cancel_callback();
-        layer_bboxes[layer_idx] = get_extents(layers[layer_idx]->regions());
-        layer_bboxes[layer_idx].merge(get_extents(input_expolygons[layer_idx]));
-    }
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&layers, &input_expolygons, &layer_bboxes, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
+            throw_on_cancel_callback();
+            layer_bboxes[layer_idx] = get_extents(layers[layer_idx]->regions());
+            layer_bboxes[layer_idx].merge(get_extents(input_expolygons[layer_idx]));
+        }
+    }); // end of parallel_for
 
-    for (size_t layer_idx = 0; layer_idx < num_layers; ++layer_idx) {
-        throw_on_cancel_callback();
-        BoundingBox bbox = layer_bboxes[layer_idx];
-        // Projected triangles could, in rare cases (as in GH issue #7299), belongs to polygons printed in the previous or the next layer.
-        // Let's merge the bounding box of the current layer with bounding boxes of the previous and the next layer to ensure that
-        // every projected triangle will be inside the resulting bounding box.
-        if (layer_idx > 1) bbox.merge(layer_bboxes[layer_idx - 1]);
-        if (layer_idx < num_layers - 1) bbox.merge(layer_bboxes[layer_idx + 1]);
-        // Projected triangles may slightly exceed the input polygons.
-        bbox.offset(20 * SCALED_EPSILON);
-        edge_grids[layer_idx].set_bbox(bbox);
-        edge_grids[layer_idx].create(input_expolygons[layer_idx], coord_t(scale_(10.)));
-    }
+    BOOST_LOG_TRIVIAL(debug) << "Print object segmentation - Edge grids in parallel - Begin";
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&num_layers, &input_expolygons, &layer_bboxes, &edge_grids, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
+            throw_on_cancel_callback();
+            BoundingBox bbox = layer_bboxes[layer_idx];
+            // Projected triangles could, in rare cases (as in GH issue #7299), belongs to polygons printed in the previous or the next layer.
+            // Let's merge the bounding box of the current layer with bounding boxes of the previous and the next layer to ensure that
+            // every projected triangle will be inside the resulting bounding box.
+            if (layer_idx > 1) bbox.merge(layer_bboxes[layer_idx - 1]);
+            if (layer_idx < num_layers - 1) bbox.merge(layer_bboxes[layer_idx + 1]);
+            // Projected triangles may slightly exceed the input polygons.
+            bbox.offset(20 * SCALED_EPSILON);
+            edge_grids[layer_idx].set_bbox(bbox);
+            edge_grids[layer_idx].create(input_expolygons[layer_idx], coord_t(scale_(10.)));
+        }
+    }); // end of parallel_for
+    BOOST_LOG_TRIVIAL(debug) << "Print object segmentation - Edge grids in parallel - End";
 
     BOOST_LOG_TRIVIAL(debug) << "Print object segmentation - Projection of painted triangles - Begin";
+    // Each thread collects the painted lines of all layers on its own, the lines are merged per layer afterwards.
+    tbb::enumerable_thread_specific<std::vector<std::vector<PaintedLine>>> painted_lines_per_thread([num_layers]() { return std::vector<std::vector<PaintedLine>>(num_layers); });
     for (const ModelVolume *mv : print_object.model_object()->volumes) {
         const ModelVolumeFacetsInfo facets_info = extract_facets_info(*mv);
-        tbb::parallel_for(tbb::blocked_range<size_t>(1, num_facets_states), [&mv, &print_object, &facets_info, &layers, &edge_grids, &painted_lines, &painted_lines_mutex, &input_expolygons, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(1, num_facets_states), [&mv, &print_object, &facets_info, &layers, &edge_grids, &painted_lines_per_thread, &input_expolygons, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
             for (size_t extruder_idx = range.begin(); extruder_idx < range.end(); ++extruder_idx) {
                 throw_on_cancel_callback();
                 const indexed_triangle_set custom_facets = facets_info.facets_annotation.get_facets(*mv, EnforcerBlockerType(extruder_idx));
@@ -2038,7 +2064,8 @@ std::vector<std::vector<ExPolygons>> segmentation_by_painting(const PrintObject
                     continue;
 
                 const Transform3f tr = print_object.trafo().cast<float>() * mv->get_matrix().cast<float>();
-                tbb::parallel_for(tbb::blocked_range<size_t>(0, custom_facets.indices.size()), [&tr, &custom_facets, &print_object, &layers, &edge_grids, &input_expolygons, &painted_lines, &painted_lines_mutex, &extruder_idx](const tbb::blocked_range<size_t> &range) {
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, custom_facets.indices.size()), [&tr, &custom_facets, &print_object, &layers, &edge_grids, &input_expolygons, &painted_lines_per_thread, &extruder_idx](const tbb::blocked_range<size_t> &range) {
+                    std::vector<std::vector<PaintedLine>> &painted_lines = painted_lines_per_thread.local();
                     for (size_t facet_idx = range.begin(); facet_idx < range.end(); ++facet_idx) {
                         float min_z = std::numeric_limits<float>::max();
                         float max_z = std::numeric_limits<float>::lowest();
@@ -2106,10 +2133,7 @@ std::vector<std::vector<ExPolygons>> segmentation_by_painting(const PrintObject
                                     continue;
                             }
 
-                            size_t mutex_idx = layer_idx & 0x3F;
-                            assert(mutex_idx < painted_lines_mutex.size());
-
-                            PaintedLineVisitor visitor(edge_grids[layer_idx], painted_lines[layer_idx], painted_lines_mutex[mutex_idx], 16);
+                            PaintedLineVisitor visitor(edge_grids[layer_idx], painted_lines[layer_idx], 16);
                             visitor.line_to_test = line_to_test;
                             visitor.color        = int(extruder_idx);
                             edge_grids[layer_idx].visit_cells_intersecting_line(line_to_test.a, line_to_test.b, visitor);
@@ -2119,12 +2143,19 @@ std::vector<std::vector<ExPolygons>> segmentation_by_painting(const PrintObject
             }
         }); // end of parallel_for
     }
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&painted_lines, &painted_lines_per_thread](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx)
+            for (std::vector<std::vector<PaintedLine>> &thread_painted_lines : painted_lines_per_thread)
+                Slic3r::append(painted_lines[layer_idx], std::move(thread_painted_lines[layer_idx]));
+    }); // end of parallel_for
     BOOST_LOG_TRIVIAL(debug) << "Print object segmentation - projection of painted triangles - end";
     BOOST_LOG_TRIVIAL(debug) << "Print object segmentation - painted layers count: "
                              << std::count_if(painted_lines.begin(), painted_lines.end(), [](const std::vector<PaintedLine> &pl) { return !pl.empty(); });
 
     BOOST_LOG_TRIVIAL(debug) << "Print object segmentation - layers segmentation in parallel - begin";
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&edge_grids, &input_expolygons, &painted_lines, &segmented_regions, &num_facets_states, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+    tbb::enumerable_thread_specific<MMU_GraphBuffers> graph_buffers;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&edge_grids, &input_expolygons, &painted_lines, &segmented_regions, &num_facets_states, &graph_buffers, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        MMU_GraphBuffers &buffers = graph_buffers.local();
         for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
             throw_on_cancel_callback();
             if (!painted_lines[layer_idx].empty()) {
@@ -2150,7 +2181,8 @@ std::vector<std::vector<ExPolygons>> segmentation_by_painting(const PrintObject
                     // If the whole layer is painted using the same color, it is not needed to construct a Voronoi diagram for the segmentation of this layer.
                     segmented_regions[layer_idx][size_t(color_poly.front().front().color)] = input_expolygons[layer_idx];
                 } else {
-                    MMU_Graph graph = build_graph(layer_idx, color_poly);
+                    build_graph(layer_idx, color_poly, buffers);
+                    MMU_Graph &graph = buffers.graph;
                     remove_multiple_edges_in_vertices(graph, color_poly);
                     graph.remove_nodes_with_one_arc();
                     segmented_regions[layer_idx] = extract_colored_segments(graph, num_facets_states);
@@ -2104,6 +2104,17 @@ void PerimeterGenerator::process_arachne()
     process_no_bridge(all_surfaces, perimeter_spacing, ext_perimeter_width);
     // BBS: don't simplify too much which influence arc fitting when export gcode if arc_fitting is enabled
     double surface_simplify_resolution = (print_config->enable_arc_fitting && !this->has_fuzzy_skin) ? 0.2 * m_scaled_resolution : m_scaled_resolution;
+    // Walls of the layers with the same outline are generated once if the cache is shared with the other layers.
+    auto generate_walls = [this](const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x, coord_t inset_count, coord_t wall_0_inset, coordf_t layer_height,
+                                 const Arachne::WallToolPathsParams &params) -> std::shared_ptr<const Arachne::WallToolPathsCache::Walls> {
+        if (this->wall_tool_paths_cache)
+            return this->wall_tool_paths_cache->generate(outline, bead_width_0, bead_width_x, size_t(inset_count), wall_0_inset, layer_height, params);
+        Arachne::WallToolPaths wall_tool_paths(outline, bead_width_0, bead_width_x, size_t(inset_count), wall_0_inset, layer_height, params);
+        auto walls = std::make_shared<Arachne::WallToolPathsCache::Walls>();
+        walls->toolpaths     = wall_tool_paths.getToolPaths();
+        walls->inner_contour = wall_tool_paths.getInnerContour();
+        return walls;
+    };
     // we need to process each island separately because we might have different
     // extra perimeters for each one
     for (const Surface& surface : all_surfaces) {
@@ -2150,10 +2161,10 @@ void PerimeterGenerator::process_arachne()
         Arachne::WallToolPathsParams input_params_tmp = input_params;
         
         Polygons   last_p = to_polygons(last);
-        Arachne::WallToolPaths wallToolPaths(last_p, bead_width_0, perimeter_spacing, coord_t(loop_number + 1),
+        std::shared_ptr<const Arachne::WallToolPathsCache::Walls> walls = generate_walls(last_p, bead_width_0, perimeter_spacing, coord_t(loop_number + 1),
                                                wall_0_inset, layer_height, input_params_tmp);
-        std::vector<Arachne::VariableWidthLines>   perimeters = wallToolPaths.getToolPaths();
-        ExPolygons  infill_contour = union_ex(wallToolPaths.getInnerContour());
+        std::vector<Arachne::VariableWidthLines>   perimeters = walls->toolpaths;
+        ExPolygons  infill_contour = union_ex(walls->inner_contour);
 
         // Check if there are some remaining perimeters to generate (the number of perimeters
         // is greater than one together with enabled the single perimeter on top surface feature).
@@ -2202,8 +2213,8 @@ void PerimeterGenerator::process_arachne()
                 top_expolygons = intersection_ex(top_expolygons, infill_contour);
 
                 const Polygons not_top_polygons = to_polygons(offset_ex(not_top_expolygons,wall_0_inset));
-                Arachne::WallToolPaths inner_wall_tool_paths(not_top_polygons, perimeter_spacing, perimeter_spacing, coord_t(inner_loop_number + 1), 0, layer_height, input_params_tmp);
-                std::vector<Arachne::VariableWidthLines> inner_perimeters = inner_wall_tool_paths.getToolPaths();
+                std::shared_ptr<const Arachne::WallToolPathsCache::Walls> inner_walls = generate_walls(not_top_polygons, perimeter_spacing, perimeter_spacing, coord_t(inner_loop_number + 1), 0, layer_height, input_params_tmp);
+                std::vector<Arachne::VariableWidthLines> inner_perimeters = inner_walls->toolpaths;
 
                 // Recalculate indexes of inner perimeters before merging them.
                 if (!perimeters.empty()) {
@@ -2216,13 +2227,13 @@ void PerimeterGenerator::process_arachne()
                 }
 
                 perimeters.insert(perimeters.end(), inner_perimeters.begin(), inner_perimeters.end());
-                infill_contour = union_ex(top_expolygons, inner_wall_tool_paths.getInnerContour());
+                infill_contour = union_ex(top_expolygons, inner_walls->inner_contour);
             } else {
                 // There is no top surface ExPolygon, so we call Arachne again with parameters
                 // like when the single perimeter feature is disabled.
-                Arachne::WallToolPaths no_single_perimeter_tool_paths(last_p, bead_width_0, perimeter_spacing, coord_t(inner_loop_number + 2), wall_0_inset, layer_height, input_params_tmp);
-                perimeters     = no_single_perimeter_tool_paths.getToolPaths();
-                infill_contour = union_ex(no_single_perimeter_tool_paths.getInnerContour());
+                std::shared_ptr<const Arachne::WallToolPathsCache::Walls> no_single_perimeter_walls = generate_walls(last_p, bead_width_0, perimeter_spacing, coord_t(inner_loop_number + 2), wall_0_inset, layer_height, input_params_tmp);
+                perimeters     = no_single_perimeter_walls->toolpaths;
+                infill_contour = union_ex(no_single_perimeter_walls->inner_contour);
             }
         }
         //PS
@@ -2232,7 +2243,7 @@ void PerimeterGenerator::process_arachne()
         #ifdef ARACHNE_DEBUG
         {
             static int iRun = 0;
-            export_perimeters_to_svg(debug_out_path("arachne-perimeters-%d-%d.svg", layer_id, iRun++), to_polygons(last), perimeters, union_ex(wallToolPaths.getInnerContour()));
+            export_perimeters_to_svg(debug_out_path("arachne-perimeters-%d-%d.svg", layer_id, iRun++), to_polygons(last), perimeters, union_ex(walls->inner_contour));
         }
 #endif
 
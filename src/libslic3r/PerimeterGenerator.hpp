@@ -59,6 +59,10 @@ template<> struct hash<Slic3r::FuzzySkinConfig>
 
 namespace Slic3r {
 
+namespace Arachne {
+    class WallToolPathsCache;
+} // namespace Arachne
+
 class PerimeterGenerator {
 public:
     // Inputs:
@@ -83,6 +87,8 @@ public:
     SurfaceCollection           *fill_surfaces;
     //BBS
     ExPolygons                  *fill_no_overlap;
+    // Walls of the Arachne perimeter generator shared with the other layers of the object, may be null.
+    Arachne::WallToolPathsCache *wall_tool_paths_cache { nullptr };
 
     //BBS
     Flow                        smaller_ext_perimeter_flow;
@@ -23,7 +23,15 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/locale.hpp>
 #include <boost/log/trivial.hpp>
+#include <boost/uuid/detail/md5.hpp>
+#include <boost/algorithm/hex.hpp>
 #include <miniz/miniz.h>
+#include <tbb/parallel_for.h>
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/set.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
 
 // Mark string for localization and translate.
 #define L(s) Slic3r::I18N::translate(s)
@@ -1431,6 +1439,201 @@ void PresetBundle::remove_users_preset(AppConfig &config, std::map<std::string,
 }
 
 
+// Binary snapshot of the system presets, which were loaded from the json files of the system directory by the previous start.
+// The snapshot stores the vendor profiles and the fully resolved system presets, thus neither the json files are parsed
+// nor the "inherits" chains are resolved when the snapshot is valid.
+static constexpr const char *SYSTEM_PRESETS_CACHE_FILE = "system_presets.cereal";
+// Increase when the layout of the snapshot changes.
+static constexpr const uint32_t SYSTEM_PRESETS_CACHE_VERSION = 1;
+
+static boost::filesystem::path system_presets_cache_path()
+{
+    return (boost::filesystem::path(data_dir()) / "cache" / SYSTEM_PRESETS_CACHE_FILE).make_preferred();
+}
+
+// Fingerprint of everything the system presets are derived from: the build of the application, the definitions of the configuration
+// options (the configs are stored by their serialization ordinals, the presets without a parent inherit the default values)
+// and the paths, sizes and modification times of the json files below the system directory.
+// Walking the directory costs a fraction of parsing the files.
+static std::string system_presets_fingerprint(const boost::filesystem::path &dir)
+{
+    // boost::uuids::detail::md5 is an internal namespace thus it may change in the future.
+    using boost::uuids::detail::md5;
+    md5  md5_hash;
+    // Hash the terminating zero as well to separate the strings.
+    auto process = [&md5_hash](const std::string &str) { md5_hash.process_bytes(str.c_str(), str.size() + 1); };
+
+    process(std::to_string(SYSTEM_PRESETS_CACHE_VERSION));
+    process(SLIC3R_VERSION);
+    process(GIT_COMMIT_HASH);
+    for (const auto &[opt_key, def] : print_config_def.options)
+        process(opt_key + " " + std::to_string(def.serialization_key_ordinal) + " " + std::to_string(int(def.type)) + (def.nullable ? " nullable " : " ") +
+                (def.default_value ? def.default_value->serialize() : std::string()));
+
+    process(dir.string());
+    std::vector<std::string> files;
+    for (boost::filesystem::recursive_directory_iterator it(dir), end; it != end; ++ it)
+        if (boost::filesystem::is_regular_file(it->status()) && Slic3r::is_json_file(it->path().string()))
+            files.emplace_back(it->path().lexically_relative(dir).generic_string() + " " + std::to_string(boost::filesystem::file_size(it->path())) +
+                               " " + std::to_string(boost::filesystem::last_write_time(it->path())));
+    // The order of the directory iteration is unspecified.
+    std::sort(files.begin(), files.end());
+    for (const std::string &file : files)
+        process(file);
+
+    md5::digest_type md5_digest{};
+    md5_hash.get_digest(md5_digest);
+    std::string out;
+    boost::algorithm::hex(md5_digest, md5_digest + std::size(md5_digest), std::back_inserter(out));
+    return out;
+}
+
+template<class Archive> static void save_semver(Archive &ar, const Semver &version)
+{
+    ar(version.maj(), version.min(), version.patch(), std::string(version.metadata() ? version.metadata() : ""), version.metadata() != nullptr,
+       std::string(version.prerelease() ? version.prerelease() : ""), version.prerelease() != nullptr);
+}
+
+template<class Archive> static void load_semver(Archive &ar, Semver &version)
+{
+    int         maj, min, patch;
+    std::string metadata, prerelease;
+    bool        has_metadata, has_prerelease;
+    ar(maj, min, patch, metadata, has_metadata, prerelease, has_prerelease);
+    version = Semver(maj, min, patch, has_metadata ? metadata.c_str() : nullptr, has_prerelease ? prerelease.c_str() : nullptr);
+}
+
+bool PresetBundle::load_system_presets_from_cache(const std::string &fingerprint)
+{
+    boost::filesystem::path path = system_presets_cache_path();
+    if (! boost::filesystem::exists(path))
+        return false;
+    try {
+        boost::nowide::ifstream    file(path.string(), std::ios::binary);
+        cereal::BinaryInputArchive ar(file);
+        std::string                cache_fingerprint;
+        ar(cache_fingerprint);
+        if (cache_fingerprint != fingerprint) {
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": system presets changed since " << path.string() << " was written";
+            return false;
+        }
+
+        this->reset(false);
+        size_t num_vendors;
+        ar(num_vendors);
+        for (size_t i = 0; i < num_vendors; ++ i) {
+            VendorProfile vendor;
+            ar(vendor.name, vendor.id, vendor.config_update_url, vendor.changelog_url, vendor.default_filaments, vendor.default_sla_materials);
+            load_semver(ar, vendor.config_version);
+            size_t num_models;
+            ar(num_models);
+            for (size_t j = 0; j < num_models; ++ j) {
+                VendorProfile::PrinterModel &model = vendor.models.emplace_back();
+                int                          technology;
+                std::vector<std::string>     variants;
+                ar(model.id, model.name, model.model_id, technology, model.family, variants, model.default_materials, model.not_support_bed_types,
+                   model.bed_model, model.bed_texture, model.image_bed_type, model.bottom_texture_end_name, model.use_double_extruder_default_texture,
+                   model.bottom_texture_rect, model.middle_texture_rect, model.hotend_model);
+                model.technology = PrinterTechnology(technology);
+                for (std::string &variant : variants)
+                    model.variants.emplace_back(std::move(variant));
+            }
+            std::string id = vendor.id;
+            this->vendors.emplace(std::move(id), std::move(vendor));
+        }
+
+        for (PresetCollection *presets : { &this->prints, &this->sla_prints, &this->filaments, &this->sla_materials, static_cast<PresetCollection*>(&this->printers) }) {
+            size_t num_presets;
+            ar(num_presets);
+            // The presets were stored in the order of the collection.
+            for (size_t i = 0; i < num_presets; ++ i) {
+                std::string name, vendor_id;
+                ar(name);
+                Preset &preset = presets->m_presets.emplace_back(presets->type(), name, false);
+                ar(preset.file, preset.config, vendor_id, preset.description, preset.setting_id, preset.filament_id, preset.m_from_orca_filament_lib,
+                   preset.alias, preset.renamed_from);
+                load_semver(ar, preset.version);
+                preset.loaded    = true;
+                preset.is_system = true;
+                if (! vendor_id.empty()) {
+                    auto it = this->vendors.find(vendor_id);
+                    if (it == this->vendors.end())
+                        throw Slic3r::RuntimeError("Unknown vendor " + vendor_id);
+                    preset.vendor = &it->second;
+                }
+            }
+            size_t num_printers;
+            ar(num_printers);
+            for (size_t i = 0; i < num_printers; ++ i) {
+                std::string              printer_name;
+                std::vector<std::string> aliases;
+                ar(printer_name, aliases);
+                presets->m_printer_hold_alias[printer_name].insert(aliases.begin(), aliases.end());
+            }
+        }
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": failed loading " << path.string() << ": " << ex.what();
+        this->reset(false);
+        return false;
+    }
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": loaded system presets from " << path.string();
+    return true;
+}
+
+void PresetBundle::save_system_presets_to_cache(const std::string &fingerprint) const
+{
+    boost::filesystem::path path = system_presets_cache_path();
+    // Written to a temporary file first, so that another instance starting at the same time never reads a partially written file.
+    boost::filesystem::path temp_path = path;
+    temp_path += boost::filesystem::unique_path(".%%%%-%%%%.tmp");
+    try {
+        boost::filesystem::create_directories(path.parent_path());
+        {
+            boost::nowide::ofstream     file(temp_path.string(), std::ios::binary);
+            cereal::BinaryOutputArchive ar(file);
+            ar(fingerprint);
+
+            ar(this->vendors.size());
+            for (const auto &[id, vendor] : this->vendors) {
+                ar(vendor.name, vendor.id, vendor.config_update_url, vendor.changelog_url, vendor.default_filaments, vendor.default_sla_materials);
+                save_semver(ar, vendor.config_version);
+                ar(vendor.models.size());
+                for (const VendorProfile::PrinterModel &model : vendor.models) {
+                    std::vector<std::string> variants;
+                    for (const VendorProfile::PrinterVariant &variant : model.variants)
+                        variants.emplace_back(variant.name);
+                    ar(model.id, model.name, model.model_id, int(model.technology), model.family, variants, model.default_materials, model.not_support_bed_types,
+                       model.bed_model, model.bed_texture, model.image_bed_type, model.bottom_texture_end_name, model.use_double_extruder_default_texture,
+                       model.bottom_texture_rect, model.middle_texture_rect, model.hotend_model);
+                }
+            }
+
+            for (const PresetCollection *presets : { &this->prints, &this->sla_prints, &this->filaments, &this->sla_materials, static_cast<const PresetCollection*>(&this->printers) }) {
+                // Skip the default presets.
+                ar(size_t(presets->end() - presets->begin()));
+                for (const Preset &preset : *presets) {
+                    assert(preset.is_system);
+                    ar(preset.name, preset.file, preset.config, preset.vendor ? preset.vendor->id : std::string(), preset.description, preset.setting_id,
+                       preset.filament_id, preset.m_from_orca_filament_lib, preset.alias, preset.renamed_from);
+                    save_semver(ar, preset.version);
+                }
+                ar(presets->m_printer_hold_alias.size());
+                for (const auto &[printer_name, aliases] : presets->m_printer_hold_alias)
+                    ar(printer_name, std::vector<std::string>(aliases.begin(), aliases.end()));
+            }
+            if (! file.good())
+                throw Slic3r::RuntimeError("Failed writing " + temp_path.string());
+        }
+        boost::filesystem::rename(temp_path, path);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": failed writing " << path.string() << ": " << ex.what();
+        boost::system::error_code ec;
+        boost::filesystem::remove(temp_path, ec);
+        return;
+    }
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": stored system presets into " << path.string();
+}
+
 //BBS: add json related logic, load system presets from json
 std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_presets_from_json(ForwardCompatibilitySubstitutionRule compatibility_rule)
 {
@@ -1449,6 +1652,21 @@ std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_pre
     if (validation_mode)
         dir = (boost::filesystem::path(data_dir())).make_preferred();
 
+    // Take the system presets from the snapshot of the previous start if none of the json files changed since.
+    // The validation loads the json files, the snapshot would hide their errors.
+    std::string cache_fingerprint;
+    if (! validation_mode) {
+        try {
+            cache_fingerprint = system_presets_fingerprint(dir);
+        } catch (const std::exception &ex) {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": failed scanning " << dir.string() << ": " << ex.what();
+        }
+        if (! cache_fingerprint.empty() && this->load_system_presets_from_cache(cache_fingerprint)) {
+            this->update_system_maps();
+            return {};
+        }
+    }
+
     PresetsConfigSubstitutions  substitutions;
     std::string                 errors_cummulative;
     bool                        first = true;
@@ -1473,48 +1691,83 @@ std::pair<PresetsConfigSubstitutions, std::string> PresetBundle::load_system_pre
         }
     }
 
-    for (auto &vendor_name : vendor_names)
-    {
-        if (validation_mode && !vendor_to_validate.empty() && vendor_name != vendor_to_validate && vendor_name != ORCA_FILAMENT_LIBRARY)
-            continue;
+    if (validation_mode && !vendor_to_validate.empty())
+        vendor_names.erase(std::remove_if(vendor_names.begin(), vendor_names.end(), [this](const std::string &vendor_name) {
+            return vendor_name != vendor_to_validate && vendor_name != ORCA_FILAMENT_LIBRARY;
+        }), vendor_names.end());
+
+    auto report_error = [this, &errors_cummulative](const std::runtime_error &err) {
+        if (validation_mode)
+            throw err;
+        else {
+            errors_cummulative += err.what();
+            errors_cummulative += "\n";
+        }
+    };
 
+    // Reset this PresetBundle and load the first vendor config, the other vendors may inherit from it.
+    size_t idx_vendor = 0;
+    for (; first && idx_vendor < vendor_names.size(); ++ idx_vendor) {
         try {
             // Load the config bundle, flatten it.
-            if (first) {
-                // Reset this PresetBundle and load the first vendor config.
-                append(substitutions, this->load_vendor_configs_from_json(dir.string(), vendor_name, PresetBundle::LoadSystem, compatibility_rule).first);
-                first = false;
-            } else {
-                // Load the other vendor configs, merge them with this PresetBundle.
-                // Report duplicate profiles.
-                PresetBundle other;
-                append(substitutions, other.load_vendor_configs_from_json(dir.string(), vendor_name, PresetBundle::LoadSystem, compatibility_rule, this).first);
-                std::vector<std::string> duplicates = this->merge_presets(std::move(other));
-                if (!duplicates.empty()) {
-                    errors_cummulative += "Found duplicated settings in vendor " + vendor_name + "'s json file lists: ";
-                    for (size_t i = 0; i < duplicates.size(); ++i) {
-                        if (i > 0)
-                            errors_cummulative += ", ";
-                        errors_cummulative += duplicates[i];
-                        ++m_errors;
-                        BOOST_LOG_TRIVIAL(error) << "Found duplicated preset: " + duplicates[i] + " in vendor: " + vendor_name + ": ";
-                    }
+            append(substitutions, this->load_vendor_configs_from_json(dir.string(), vendor_names[idx_vendor], PresetBundle::LoadSystem, compatibility_rule).first);
+            first = false;
+        } catch (const std::runtime_error &err) {
+            report_error(err);
+        }
+    }
+
+    // Load the other vendor configs in parallel, each into its own PresetBundle.
+    struct OtherVendor {
+        std::unique_ptr<PresetBundle> bundle;
+        PresetsConfigSubstitutions    substitutions;
+        std::exception_ptr            exception;
+    };
+    std::vector<OtherVendor> others(vendor_names.size() - idx_vendor);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, others.size(), 1), [this, &others, &vendor_names, &dir, idx_vendor, compatibility_rule](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i) {
+            OtherVendor &other = others[i];
+            try {
+                other.bundle        = std::make_unique<PresetBundle>();
+                other.substitutions = other.bundle->load_vendor_configs_from_json(dir.string(), vendor_names[idx_vendor + i], PresetBundle::LoadSystem, compatibility_rule, this).first;
+            } catch (...) {
+                other.exception = std::current_exception();
+            }
+        }
+    });
+
+    // Merge them with this PresetBundle in the order of the vendors, so that the same errors are reported on each start.
+    // Report duplicate profiles.
+    for (size_t i = 0; i < others.size(); ++ i) {
+        const std::string &vendor_name = vendor_names[idx_vendor + i];
+        try {
+            if (others[i].exception)
+                std::rethrow_exception(others[i].exception);
+            append(substitutions, std::move(others[i].substitutions));
+            std::vector<std::string> duplicates = this->merge_presets(std::move(*others[i].bundle));
+            if (!duplicates.empty()) {
+                errors_cummulative += "Found duplicated settings in vendor " + vendor_name + "'s json file lists: ";
+                for (size_t i = 0; i < duplicates.size(); ++i) {
+                    if (i > 0)
+                        errors_cummulative += ", ";
+                    errors_cummulative += duplicates[i];
+                    ++m_errors;
+                    BOOST_LOG_TRIVIAL(error) << "Found duplicated preset: " + duplicates[i] + " in vendor: " + vendor_name + ": ";
                 }
             }
         } catch (const std::runtime_error &err) {
-            if (validation_mode)
-                throw err;
-            else {
-                errors_cummulative += err.what();
-                errors_cummulative += "\n";
-            }
+            report_error(err);
         }
+        others[i].bundle.reset();
     }
 
     if (first) {
 		// No config bundle loaded, reset.
 		this->reset(false);
-	}
+	} else if (! cache_fingerprint.empty() && substitutions.empty() && errors_cummulative.empty() && m_errors == 0) {
+        // Only a clean load is stored, so that the substitutions and errors are reported on each start until the json files are fixed.
+        this->save_system_presets_to_cache(cache_fingerprint);
+    }
 
 	this->update_system_maps();
     //BBS: add config related logs
@@ -3754,8 +4007,6 @@ void PresetBundle::load_config_file_config(const std::string &name_or_path, bool
 std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_from_json(
     const std::string &path, const std::string &vendor_name, LoadConfigBundleAttributes flags, ForwardCompatibilitySubstitutionRule compatibility_rule, const PresetBundle* base_bundle)
 {
-    // Enable substitutions for user config bundle, throw an exception when loading a system profile.
-    ConfigSubstitutionContext  substitution_context { compatibility_rule };
     PresetsConfigSubstitutions substitutions;
 
     //BBS: add config related logs
@@ -3981,142 +4232,197 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
         return std::make_pair(PresetsConfigSubstitutions{}, 0);
 
     // 3) paste the process/filament/print configs
+    // The json files of a list are parsed in parallel, then the "inherits" chains are resolved in parallel level by level
+    // (a preset may only inherit from a preset listed before it), and finally the presets are inserted into the collection
+    // in the order of the list, so that the errors are reported for the same file as if the list was loaded sequentially.
+    struct VendorSubfile {
+        std::string                        name;
+        DynamicPrintConfig                 config_src;
+        std::map<std::string, std::string> key_values;
+        ConfigSubstitutions                substitutions;
+        // Set if the json file could not be parsed.
+        std::string                        reason;
+        std::exception_ptr                 exception;
+        // Parent preset: either a subfile of the same list, or a config of the base bundle or of the default preset.
+        int                                parent = -1;
+        const DynamicPrintConfig          *default_config = nullptr;
+        size_t                             depth = 0;
+        // config_src applied over the parent config.
+        DynamicPrintConfig                 config;
+        std::string                        incorrect_keys;
+        bool                               resolved = false;
+    };
+
+    auto parse_subfiles = [this, &path, &vendor_name, base_bundle, compatibility_rule](const std::vector<std::pair<std::string, std::string>> &subfiles,
+                                                                                       const PresetCollection &presets_collection) {
+        std::vector<VendorSubfile> items(subfiles.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, items.size(), 1), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                VendorSubfile            &item = items[i];
+                // Enable substitutions for user config bundle, throw an exception when loading a system profile.
+                ConfigSubstitutionContext substitution_context { compatibility_rule };
+                try {
+                    item.config_src.load_from_json(path + "/" + vendor_name + "/" + subfiles[i].second, substitution_context, false, item.key_values, item.reason);
+                } catch (nlohmann::detail::parse_error &err) {
+                    item.reason = std::string("json parse error") + err.what();
+                } catch (...) {
+                    item.exception = std::current_exception();
+                }
+                item.substitutions = std::move(substitution_context.substitutions);
+                if (auto it = item.key_values.find(BBL_JSON_KEY_NAME); it != item.key_values.end())
+                    item.name = it->second;
+            }
+        });
+
+        // Build the inheritance DAG. The parent is the first preset of the same name listed before the child.
+        std::map<std::string, int> subfile_by_name;
+        size_t                     max_depth = 0;
+        for (int i = 0; i < int(items.size()); ++ i) {
+            VendorSubfile &item = items[i];
+            if (! item.reason.empty() || item.exception)
+                continue;
+            if (auto it = item.key_values.find(BBL_JSON_KEY_INHERITS); it != item.key_values.end()) {
+                if (auto it_parent = subfile_by_name.find(it->second); it_parent != subfile_by_name.end()) {
+                    item.parent = it_parent->second;
+                    item.depth  = items[item.parent].depth + 1;
+                    max_depth   = std::max(max_depth, item.depth);
+                } else if (base_bundle != nullptr) {
+                    if (auto it_base = base_bundle->m_config_maps.find(it->second); it_base != base_bundle->m_config_maps.end())
+                        item.default_config = &it_base->second;
+                }
+                if (item.parent == -1 && item.default_config == nullptr)
+                    // Reported while inserting the presets.
+                    continue;
+            } else
+                item.default_config = presets_collection.type() == Preset::TYPE_PRINTER ?
+                    &presets_collection.default_preset_for(item.config_src).config : &presets_collection.default_preset().config;
+            subfile_by_name.emplace(item.name, i);
+        }
+
+        std::vector<std::vector<size_t>> levels(max_depth + 1);
+        for (size_t i = 0; i < items.size(); ++ i)
+            if (items[i].parent != -1 || items[i].default_config != nullptr)
+                levels[items[i].depth].emplace_back(i);
+        for (const std::vector<size_t> &level : levels)
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, level.size(), 1), [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t j = range.begin(); j < range.end(); ++ j) {
+                    VendorSubfile &item = items[level[j]];
+                    if (item.parent != -1) {
+                        // The parent failed to resolve, its error is reported first.
+                        if (! items[item.parent].resolved)
+                            continue;
+                        item.default_config = &items[item.parent].config;
+                    }
+                    try {
+                        item.config = *item.default_config;
+                        item.config.apply(item.config_src);
+                        extend_default_config_length(item.config, true, *item.default_config);
+                        auto it_instantiation = item.key_values.find(BBL_JSON_KEY_INSTANTIATION);
+                        if (it_instantiation == item.key_values.end() || it_instantiation->second != "false" || "Template" == vendor_name)
+                            Preset::normalize(item.config);
+                        // Configuration fields, which are misplaced into a wrong group, are reported while inserting the presets.
+                        item.incorrect_keys = Preset::remove_invalid_keys(item.config, *item.default_config);
+                        item.resolved = true;
+                    } catch (...) {
+                        item.exception = std::current_exception();
+                    }
+                }
+            });
+        return items;
+    };
+
     PresetCollection         *presets = nullptr;
     size_t                   presets_loaded = 0;
 
-    auto parse_subfile = [this, path, vendor_name, presets_loaded, current_vendor_profile, base_bundle](
-        ConfigSubstitutionContext& substitution_context,
-        PresetsConfigSubstitutions& substitutions,
-        LoadConfigBundleAttributes& flags,
+    auto parse_subfile = [this, path, vendor_name, current_vendor_profile, base_bundle, flags, &substitutions](
+        VendorSubfile& item,
         std::pair<std::string, std::string>& subfile_iter,
-        std::map<std::string, DynamicPrintConfig>& config_maps,
+        std::map<std::string, DynamicPrintConfig>* config_maps,
         std::map<std::string, std::string>& filament_id_maps,
         PresetCollection* presets_collection,
         size_t& count, bool is_from_lib = false) -> std::string {
 
         std::string subfile = path + "/" + vendor_name + "/" + subfile_iter.second;
         // Load the print, filament or printer preset.
-        std::string               preset_name;
-        DynamicPrintConfig        config;
+        const std::string        &preset_name = item.name;
         std::string 			  alias_name, inherits, description, instantiation, setting_id, filament_id;
         std::vector<std::string>  renamed_from;
-        const DynamicPrintConfig* default_config = nullptr;
         std::string               reason;
-        try {
-            std::map<std::string, std::string> key_values;
-            substitution_context.substitutions.clear();
-
-            //parse the json elements
-            DynamicPrintConfig config_src;
-            std::string _renamed_from_str;
-            config_src.load_from_json(subfile, substitution_context, false, key_values, reason);
-            if (!reason.empty()) {
-                ++m_errors;
-                BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load config file "<<subfile<<" Failed!";
-                return reason;
-            }
-            preset_name = key_values[BBL_JSON_KEY_NAME];
-            description     = key_values[BBL_JSON_KEY_DESCRIPTION];
-            if(key_values.find(BBL_JSON_KEY_INSTANTIATION) == key_values.end())
-            {
-                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": Missing instantiation attribute for " << preset_name;
-                ++m_errors;
-            }
-            instantiation   = key_values[BBL_JSON_KEY_INSTANTIATION];
-            if(instantiation != "false" && instantiation != "true"){
-                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": Missing instantiation attribute for " << preset_name;
-                ++m_errors;
-            }
-            auto setting_it = key_values.find(BBL_JSON_KEY_SETTING_ID);
-            if (setting_it != key_values.end())
-                setting_id = setting_it->second;
-            auto filament_it = key_values.find(BBL_JSON_KEY_FILAMENT_ID);
-            if (filament_it != key_values.end())
-                filament_id = filament_it->second;
-            //check whether it inherits other preset or not
-            auto it1 = key_values.find(BBL_JSON_KEY_INHERITS);
-            if (it1 != key_values.end()) {
-                inherits = it1->second;
-                auto it2 = config_maps.find(inherits);
-                default_config = nullptr;
-                if (it2 != config_maps.end())
-                    default_config = &(it2->second);
-                if(default_config == nullptr && base_bundle != nullptr) {
-                    auto base_it2 = base_bundle->m_config_maps.find(inherits);
-                    if (base_it2 != base_bundle->m_config_maps.end())
-                        default_config = &(base_it2->second);
-                }
-                if (default_config != nullptr) {
-                    if (filament_id.empty() && (presets_collection->type() == Preset::TYPE_FILAMENT)) {
-                        auto filament_id_map_iter = filament_id_maps.find(inherits);
-                        if (filament_id_map_iter != filament_id_maps.end()) {
+        if (item.exception)
+            std::rethrow_exception(item.exception);
+        if (!item.reason.empty()) {
+            ++m_errors;
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load config file "<<subfile<<" Failed!";
+            return item.reason;
+        }
+        std::map<std::string, std::string> &key_values = item.key_values;
+        description     = key_values[BBL_JSON_KEY_DESCRIPTION];
+        if(key_values.find(BBL_JSON_KEY_INSTANTIATION) == key_values.end())
+        {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": Missing instantiation attribute for " << preset_name;
+            ++m_errors;
+        }
+        instantiation   = key_values[BBL_JSON_KEY_INSTANTIATION];
+        if(instantiation != "false" && instantiation != "true"){
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": Missing instantiation attribute for " << preset_name;
+            ++m_errors;
+        }
+        auto setting_it = key_values.find(BBL_JSON_KEY_SETTING_ID);
+        if (setting_it != key_values.end())
+            setting_id = setting_it->second;
+        auto filament_it = key_values.find(BBL_JSON_KEY_FILAMENT_ID);
+        if (filament_it != key_values.end())
+            filament_id = filament_it->second;
+        //check whether it inherits other preset or not
+        auto it1 = key_values.find(BBL_JSON_KEY_INHERITS);
+        if (it1 != key_values.end()) {
+            inherits = it1->second;
+            if (item.parent != -1 || item.default_config != nullptr) {
+                if (filament_id.empty() && (presets_collection->type() == Preset::TYPE_FILAMENT)) {
+                    auto filament_id_map_iter = filament_id_maps.find(inherits);
+                    if (filament_id_map_iter != filament_id_maps.end()) {
+                        filament_id = filament_id_map_iter->second;
+                    }
+                    if (filament_id.empty() && base_bundle != nullptr) {
+                        auto filament_id_map_iter = base_bundle->m_filament_id_maps.find(inherits);
+                        if (filament_id_map_iter != base_bundle->m_filament_id_maps.end()) {
                             filament_id = filament_id_map_iter->second;
                         }
-                        if (filament_id.empty() && base_bundle != nullptr) {
-                            auto filament_id_map_iter = base_bundle->m_filament_id_maps.find(inherits);
-                            if (filament_id_map_iter != base_bundle->m_filament_id_maps.end()) {
-                                filament_id = filament_id_map_iter->second;
-                            }
-                        }
                     }
                 }
-                else {
-                    ++m_errors;
-                    BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": can not find inherits " << inherits << " for " << preset_name;
-                    // throw ConfigurationError(format("can not find inherits %1% for %2%", inherits, preset_name));
-                    reason = "Can not find inherits: " + inherits;
-                    return reason;
-                }
             }
             else {
-                if (presets_collection->type() == Preset::TYPE_PRINTER)
-                    default_config = &presets_collection->default_preset_for(config_src).config;
-                else
-                    default_config = &presets_collection->default_preset().config;
-            }
-            config = *default_config;
-            config.apply(config_src);
-            extend_default_config_length(config, true, *default_config);
-            if (instantiation == "false" && "Template" != vendor_name) {
-                // Report configuration fields, which are misplaced into a wrong group.
-                std::string incorrect_keys = Preset::remove_invalid_keys(config, *default_config);
-                if (!incorrect_keys.empty()) {
-                    ++m_errors;
-                    BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": The config " << subfile << " contains incorrect keys: " << incorrect_keys
-                                             << ", which were removed";
-                }
-
-                config_maps.emplace(preset_name, std::move(config));
-                if ((presets_collection->type() == Preset::TYPE_FILAMENT) && (!filament_id.empty()))
-                    filament_id_maps.emplace(preset_name, filament_id);
-                return reason;
-            }
-            if (config.has("alias"))
-                alias_name = (dynamic_cast<const ConfigOptionString *>(config.option("alias")))->value;
-
-            if (key_values.find(ORCA_JSON_KEY_RENAMED_FROM) != key_values.end()) {
-                if (!unescape_strings_cstyle(key_values[ORCA_JSON_KEY_RENAMED_FROM], renamed_from)) {
-                    BOOST_LOG_TRIVIAL(error) << "Error in a Config \"" << path << "\": The preset \"" << preset_name
-                                             << "\" contains invalid \"renamed_from\" key, which is being ignored.";
-                }
+                ++m_errors;
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": can not find inherits " << inherits << " for " << preset_name;
+                // throw ConfigurationError(format("can not find inherits %1% for %2%", inherits, preset_name));
+                return "Can not find inherits: " + inherits;
             }
-            Preset::normalize(config);
-        }
-        catch(nlohmann::detail::parse_error &err) {
-            ++m_errors;
-            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<< subfile <<" got a nlohmann::detail::parse_error, reason = " << err.what();
-            reason = std::string("json parse error") + err.what();
-            return reason;
         }
-
+        // The parents are inserted before their children, thus an unresolved config was already reported for its parent.
+        assert(item.resolved);
+        DynamicPrintConfig &config = item.config;
         // Report configuration fields, which are misplaced into a wrong group.
-        std::string incorrect_keys = Preset::remove_invalid_keys(config, *default_config);
-        if (!incorrect_keys.empty()) {
+        if (!item.incorrect_keys.empty()) {
             ++m_errors;
-            BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": The config " << subfile << " contains incorrect keys: " << incorrect_keys
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": The config " << subfile << " contains incorrect keys: " << item.incorrect_keys
                                      << ", which were removed";
         }
+        if (instantiation == "false" && "Template" != vendor_name) {
+            if (config_maps != nullptr)
+                config_maps->emplace(preset_name, config);
+            if ((presets_collection->type() == Preset::TYPE_FILAMENT) && (!filament_id.empty()))
+                filament_id_maps.emplace(preset_name, filament_id);
+            return std::string();
+        }
+        if (config.has("alias"))
+            alias_name = (dynamic_cast<const ConfigOptionString *>(config.option("alias")))->value;
 
+        if (key_values.find(ORCA_JSON_KEY_RENAMED_FROM) != key_values.end()) {
+            if (!unescape_strings_cstyle(key_values[ORCA_JSON_KEY_RENAMED_FROM], renamed_from)) {
+                BOOST_LOG_TRIVIAL(error) << "Error in a Config \"" << path << "\": The preset \"" << preset_name
+                                         << "\" contains invalid \"renamed_from\" key, which is being ignored.";
+            }
+        }
         if (presets_collection->type() == Preset::TYPE_PRINTER) {
             // Filter out printer presets, which are not mentioned in the vendor profile.
             // These presets are considered not installed.
@@ -4211,11 +4517,12 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
             filaments.set_printer_hold_alias(loaded.alias, loaded);
         }
         loaded.renamed_from = std::move(renamed_from);
-        if (! substitution_context.empty())
+        if (! item.substitutions.empty())
             substitutions.push_back({
                 preset_name, presets_collection->type(), PresetConfigSubstitutions::Source::ConfigBundle,
-                std::string(), std::move(substitution_context.substitutions) });
-        config_maps.emplace(preset_name, loaded.config);
+                std::string(), std::move(item.substitutions) });
+        if (config_maps != nullptr)
+            config_maps->emplace(preset_name, loaded.config);
         ++count;
         //BBS: add config related logs
         BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(", got preset %1%, from %2%")%loaded.name %subfile;
@@ -4224,13 +4531,15 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
 
     std::map<std::string, DynamicPrintConfig> configs;
     std::map<std::string, std::string> filament_id_maps;
+    std::vector<VendorSubfile> items;
     //3.1) paste the process
     presets = &this->prints;
-    configs.clear();
     filament_id_maps.clear();
-    for (auto& subfile : process_subfiles)
+    items = parse_subfiles(process_subfiles, *presets);
+    for (size_t i = 0; i < process_subfiles.size(); ++ i)
     {
-        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets, presets_loaded);
+        auto& subfile = process_subfiles[i];
+        std::string reason = parse_subfile(items[i], subfile, nullptr, filament_id_maps, presets, presets_loaded);
         if (!reason.empty()) {
             ++m_errors;
             //parse error
@@ -4242,12 +4551,14 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
 
     //3.2) paste the filaments
     presets = &this->filaments;
-    configs.clear();
     filament_id_maps.clear();
     const auto is_orca_lib = vendor_name == ORCA_FILAMENT_LIBRARY;
-    for (auto& subfile : filament_subfiles)
+    // Only the configs of the filament library are looked up by the other vendors.
+    items = parse_subfiles(filament_subfiles, *presets);
+    for (size_t i = 0; i < filament_subfiles.size(); ++ i)
     {
-        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets,
+        auto& subfile = filament_subfiles[i];
+        std::string reason = parse_subfile(items[i], subfile, is_orca_lib ? &configs : nullptr, filament_id_maps, presets,
                                            presets_loaded, is_orca_lib);
         if (!reason.empty()) {
             ++m_errors;
@@ -4258,17 +4569,18 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
         }
     }
     if (is_orca_lib) {
-        m_config_maps      = configs;
+        m_config_maps      = std::move(configs);
         m_filament_id_maps = filament_id_maps;
     }
 
     //3.3) paste the printers
     presets = &this->printers;
-    configs.clear();
     filament_id_maps.clear();
-    for (auto& subfile : machine_subfiles)
+    items = parse_subfiles(machine_subfiles, *presets);
+    for (size_t i = 0; i < machine_subfiles.size(); ++ i)
     {
-        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets, presets_loaded);
+        auto& subfile = machine_subfiles[i];
+        std::string reason = parse_subfile(items[i], subfile, nullptr, filament_id_maps, presets, presets_loaded);
         if (!reason.empty()) {
             ++m_errors;
             //parse error
@@ -362,6 +362,9 @@ private:
     //std::pair<PresetsConfigSubstitutions, std::string> load_system_presets(ForwardCompatibilitySubstitutionRule compatibility_rule);
     //BBS: add json related logic
     std::pair<PresetsConfigSubstitutions, std::string> load_system_presets_from_json(ForwardCompatibilitySubstitutionRule compatibility_rule);
+    // Binary snapshot of the system presets loaded from json, stored into data_dir()/cache and validated by a fingerprint of the system directory.
+    bool                        load_system_presets_from_cache(const std::string &fingerprint);
+    void                        save_system_presets_to_cache(const std::string &fingerprint) const;
     // Merge one vendor's presets with the other vendor's presets, report duplicates.
     std::vector<std::string>    merge_presets(PresetBundle &&other);
     // Update the multicolor information for filaments.
@@ -70,8 +70,10 @@ void Print::clear()
 	std::scoped_lock<std::mutex> lock(this->state_mutex());
     // The following call should stop background processing if it is running.
     this->invalidate_all_steps();
-	for (PrintObject *object : m_objects)
+	for (PrintObject *object : m_objects) {
+        object->clear_tree_support_caches();
 		delete object;
+    }
 	m_objects.clear();
     m_print_regions.clear();
     m_model.clear_objects();
@@ -4360,175 +4362,102 @@ static void from_json(const json& j, groupedVolumeSlices& firstlayer_group)
     }
 }
 
-int Print::export_cached_data(const std::string& directory, bool with_space)
+static void convert_layer_to_json(json& layer_json, const Layer* layer)
 {
-    int ret = 0;
-    boost::filesystem::path directory_path(directory);
-
-    auto convert_layer_to_json = [](json& layer_json, const Layer* layer) {
-        json slice_polygons_json = json::array(), slice_bboxs_json = json::array(), overhang_polygons_json = json::array(), layer_regions_json = json::array();
-        layer_json[JSON_LAYER_PRINT_Z] = layer->print_z;
-        layer_json[JSON_LAYER_HEIGHT] = layer->height;
-        layer_json[JSON_LAYER_SLICE_Z] = layer->slice_z;
-        layer_json[JSON_LAYER_ID] = layer->id();
-        //layer_json["slicing_errors"] = layer->slicing_errors;
+    json slice_polygons_json = json::array(), slice_bboxs_json = json::array(), overhang_polygons_json = json::array(), layer_regions_json = json::array();
+    layer_json[JSON_LAYER_PRINT_Z] = layer->print_z;
+    layer_json[JSON_LAYER_HEIGHT] = layer->height;
+    layer_json[JSON_LAYER_SLICE_Z] = layer->slice_z;
+    layer_json[JSON_LAYER_ID] = layer->id();
+    //layer_json["slicing_errors"] = layer->slicing_errors;
 
-        //sliced_polygons
-        for (const ExPolygon& slice_polygon : layer->lslices) {
-            json slice_polygon_json = slice_polygon;
-            slice_polygons_json.push_back(std::move(slice_polygon_json));
-        }
-        layer_json[JSON_LAYER_SLICED_POLYGONS] = std::move(slice_polygons_json);
-
-        //sliced_bbox
-        for (const BoundingBox& slice_bbox : layer->lslices_bboxes) {
-            json bbox_json = json::array();
-
-            bbox_json = slice_bbox;
-            slice_bboxs_json.push_back(std::move(bbox_json));
-        }
-        layer_json[JSON_LAYER_SLLICED_BBOXES] = std::move(slice_bboxs_json);
+    //sliced_polygons
+    for (const ExPolygon& slice_polygon : layer->lslices) {
+        json slice_polygon_json = slice_polygon;
+        slice_polygons_json.push_back(std::move(slice_polygon_json));
+    }
+    layer_json[JSON_LAYER_SLICED_POLYGONS] = std::move(slice_polygons_json);
 
-        //overhang_polygons
-        for (const ExPolygon& overhang_polygon : layer->loverhangs) {
-            json overhang_polygon_json = overhang_polygon;
-            overhang_polygons_json.push_back(std::move(overhang_polygon_json));
-        }
-        layer_json[JSON_LAYER_OVERHANG_POLYGONS] = std::move(overhang_polygons_json);
+    //sliced_bbox
+    for (const BoundingBox& slice_bbox : layer->lslices_bboxes) {
+        json bbox_json = json::array();
 
-        //overhang_box
-        layer_json[JSON_LAYER_OVERHANG_BBOX] = layer->loverhangs_bbox;
+        bbox_json = slice_bbox;
+        slice_bboxs_json.push_back(std::move(bbox_json));
+    }
+    layer_json[JSON_LAYER_SLLICED_BBOXES] = std::move(slice_bboxs_json);
 
-        for (const LayerRegion *layer_region : layer->regions()) {
-            json region_json = *layer_region;
+    //overhang_polygons
+    for (const ExPolygon& overhang_polygon : layer->loverhangs) {
+        json overhang_polygon_json = overhang_polygon;
+        overhang_polygons_json.push_back(std::move(overhang_polygon_json));
+    }
+    layer_json[JSON_LAYER_OVERHANG_POLYGONS] = std::move(overhang_polygons_json);
 
-            layer_regions_json.push_back(std::move(region_json));
-        }
-        layer_json[JSON_LAYER_REGIONS] = std::move(layer_regions_json);
+    //overhang_box
+    layer_json[JSON_LAYER_OVERHANG_BBOX] = layer->loverhangs_bbox;
 
-        return;
-    };
+    for (const LayerRegion *layer_region : layer->regions()) {
+        json region_json = *layer_region;
 
-    //firstly clear this directory
-    if (fs::exists(directory_path)) {
-        fs::remove_all(directory_path);
-    }
-    try {
-        if (!fs::create_directory(directory_path)) {
-            BOOST_LOG_TRIVIAL(error) << boost::format("create directory %1% failed")%directory;
-            return CLI_EXPORT_CACHE_DIRECTORY_CREATE_FAILED;
-        }
+        layer_regions_json.push_back(std::move(region_json));
     }
-    catch (...)
-    {
-        BOOST_LOG_TRIVIAL(error) << boost::format("create directory %1% failed")%directory;
-        return CLI_EXPORT_CACHE_DIRECTORY_CREATE_FAILED;
-    }
-
-    int count = 0;
-    std::vector<std::string> filename_vector;
-    std::vector<json> json_vector;
-    for (PrintObject *obj : m_objects) {
-        const ModelObject* model_obj = obj->model_object();
-        if (obj->get_shared_object()) {
-            BOOST_LOG_TRIVIAL(info) << boost::format("shared object %1%, skip directly")%model_obj->name;
-            continue;
-        }
+    layer_json[JSON_LAYER_REGIONS] = std::move(layer_regions_json);
+}
 
-        const PrintInstance &print_instance = obj->instances()[0];
-        const ModelInstance *model_instance = print_instance.model_instance;
-        size_t identify_id = (model_instance->loaded_id > 0)?model_instance->loaded_id: model_instance->id().id;
-        std::string file_name = directory +"/obj_"+std::to_string(identify_id)+".json";
+// Convert the layers, support layers and first layer groups of a sliced PrintObject to json.
+static json print_object_to_cache_json(const PrintObject *obj, size_t identify_id)
+{
+    const ModelObject* model_obj = obj->model_object();
+    json root_json, layers_json = json::array(), support_layers_json = json::array(), first_layer_groups = json::array();
 
-        BOOST_LOG_TRIVIAL(info) << boost::format("begin to dump object %1%, identify_id %2% to %3%")%model_obj->name %identify_id %file_name;
+    root_json[JSON_OBJECT_NAME] = model_obj->name;
+    root_json[JSON_IDENTIFY_ID] = identify_id;
 
-        try {
-            json root_json, layers_json = json::array(), support_layers_json = json::array(), first_layer_groups = json::array();
-
-            root_json[JSON_OBJECT_NAME] = model_obj->name;
-            root_json[JSON_IDENTIFY_ID] = identify_id;
-
-            //export the layers
-            std::vector<json> layers_json_vector(obj->layer_count());
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, obj->layer_count()),
-                [&layers_json_vector, obj, convert_layer_to_json](const tbb::blocked_range<size_t>& layer_range) {
-                    for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
-                        const Layer *layer = obj->get_layer(layer_index);
-                        json layer_json;
-                        convert_layer_to_json(layer_json, layer);
-                        layers_json_vector[layer_index] = std::move(layer_json);
-                    }
-                }
-            );
-            for (int l_index = 0; l_index < layers_json_vector.size(); l_index++) {
-                layers_json.push_back(std::move(layers_json_vector[l_index]));
-            }
-            layers_json_vector.clear();
-            /*for (const Layer *layer : obj->layers()) {
-                // for each layer
+    //export the layers
+    std::vector<json> layers_json_vector(obj->layer_count());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, obj->layer_count()),
+        [&layers_json_vector, obj](const tbb::blocked_range<size_t>& layer_range) {
+            for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
+                const Layer *layer = obj->get_layer(layer_index);
                 json layer_json;
-
                 convert_layer_to_json(layer_json, layer);
+                layers_json_vector[layer_index] = std::move(layer_json);
+            }
+        }
+    );
+    for (int l_index = 0; l_index < layers_json_vector.size(); l_index++) {
+        layers_json.push_back(std::move(layers_json_vector[l_index]));
+    }
+    layers_json_vector.clear();
+    /*for (const Layer *layer : obj->layers()) {
+        // for each layer
+        json layer_json;
 
-                layers_json.push_back(std::move(layer_json));
-            }*/
-
-            root_json[JSON_LAYERS] = std::move(layers_json);
-
-            //export the support layers
-            std::vector<json> support_layers_json_vector(obj->support_layer_count());
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, obj->support_layer_count()),
-                [&support_layers_json_vector, obj, convert_layer_to_json](const tbb::blocked_range<size_t>& support_layer_range) {
-                    for (size_t s_layer_index = support_layer_range.begin(); s_layer_index < support_layer_range.end(); ++ s_layer_index) {
-                        const SupportLayer *support_layer = obj->get_support_layer(s_layer_index);
-                        json support_layer_json, support_islands_json = json::array(), support_fills_json, supportfills_entities_json = json::array();
-
-                        convert_layer_to_json(support_layer_json, support_layer);
-
-                        support_layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID] = support_layer->interface_id();
-                        support_layer_json[JSON_SUPPORT_LAYER_TYPE] = support_layer->support_type;
+        convert_layer_to_json(layer_json, layer);
 
-                        //support_islands
-                        for (const ExPolygon& support_island : support_layer->support_islands) {
-                            json support_island_json = support_island;
-                            support_islands_json.push_back(std::move(support_island_json));
-                        }
-                        support_layer_json[JSON_SUPPORT_LAYER_ISLANDS] = std::move(support_islands_json);
-
-                        //support_fills
-                        support_fills_json[JSON_EXTRUSION_NO_SORT] = support_layer->support_fills.no_sort;
-                        support_fills_json[JSON_EXTRUSION_ENTITY_TYPE] = JSON_EXTRUSION_TYPE_COLLECTION;
-                        for (const ExtrusionEntity* extrusion_entity : support_layer->support_fills.entities) {
-                            json supportfill_entity_json, supportfill_entity_paths_json = json::array();
-                            bool ret = convert_extrusion_to_json(supportfill_entity_json, supportfill_entity_paths_json, extrusion_entity);
-                            if (!ret)
-                                continue;
-
-                            supportfills_entities_json.push_back(std::move(supportfill_entity_json));
-                        }
-                        support_fills_json[JSON_EXTRUSION_ENTITIES] = std::move(supportfills_entities_json);
-                        support_layer_json[JSON_SUPPORT_LAYER_FILLS] = std::move(support_fills_json);
+        layers_json.push_back(std::move(layer_json));
+    }*/
 
-                        support_layers_json_vector[s_layer_index] = std::move(support_layer_json);
-                    }
-                }
-            );
-            for (int s_index = 0; s_index < support_layers_json_vector.size(); s_index++) {
-                support_layers_json.push_back(std::move(support_layers_json_vector[s_index]));
-            }
-            support_layers_json_vector.clear();
+    root_json[JSON_LAYERS] = std::move(layers_json);
 
-            /*for (const SupportLayer *support_layer : obj->support_layers()) {
+    //export the support layers
+    std::vector<json> support_layers_json_vector(obj->support_layer_count());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, obj->support_layer_count()),
+        [&support_layers_json_vector, obj](const tbb::blocked_range<size_t>& support_layer_range) {
+            for (size_t s_layer_index = support_layer_range.begin(); s_layer_index < support_layer_range.end(); ++ s_layer_index) {
+                const SupportLayer *support_layer = obj->support_layers()[s_layer_index];
                 json support_layer_json, support_islands_json = json::array(), support_fills_json, supportfills_entities_json = json::array();
 
                 convert_layer_to_json(support_layer_json, support_layer);
 
                 support_layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID] = support_layer->interface_id();
+                support_layer_json[JSON_SUPPORT_LAYER_TYPE] = support_layer->support_type;
 
                 //support_islands
-                for (const ExPolygon& support_island : support_layer->support_islands.expolygons) {
+                for (const ExPolygon& support_island : support_layer->support_islands) {
                     json support_island_json = support_island;
                     support_islands_json.push_back(std::move(support_island_json));
                 }
@@ -4548,39 +4477,120 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
                 support_fills_json[JSON_EXTRUSION_ENTITIES] = std::move(supportfills_entities_json);
                 support_layer_json[JSON_SUPPORT_LAYER_FILLS] = std::move(support_fills_json);
 
-                support_layers_json.push_back(std::move(support_layer_json));
-            } // for each layer*/
-            root_json[JSON_SUPPORT_LAYERS] = std::move(support_layers_json);
+                support_layers_json_vector[s_layer_index] = std::move(support_layer_json);
+            }
+        }
+    );
+    for (int s_index = 0; s_index < support_layers_json_vector.size(); s_index++) {
+        support_layers_json.push_back(std::move(support_layers_json_vector[s_index]));
+    }
+    support_layers_json_vector.clear();
 
-            const std::vector<groupedVolumeSlices> &first_layer_obj_groups =  obj->firstLayerObjGroups();
-            for (size_t s_group_index = 0; s_group_index < first_layer_obj_groups.size(); ++ s_group_index) {
-                groupedVolumeSlices group = first_layer_obj_groups[s_group_index];
+    /*for (const SupportLayer *support_layer : obj->support_layers()) {
+        json support_layer_json, support_islands_json = json::array(), support_fills_json, supportfills_entities_json = json::array();
 
-                //convert the id
-                for (ObjectID& obj_id : group.volume_ids)
-                {
-                    const ModelVolume* currentModelVolumePtr = nullptr;
-                    //BBS: support shared object logic
-                    const PrintObject* shared_object = obj->get_shared_object();
-                    if (!shared_object)
-                        shared_object = obj;
-                    const ModelVolumePtrs& volumes_ptr = shared_object->model_object()->volumes;
-                    size_t volume_count = volumes_ptr.size();
-                    for (size_t index = 0; index < volume_count; index ++) {
-                        currentModelVolumePtr = volumes_ptr[index];
-                        if (currentModelVolumePtr->id() == obj_id) {
-                            obj_id.id = index;
-                            break;
-                        }
-                    }
-                }
+        convert_layer_to_json(support_layer_json, support_layer);
+
+        support_layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID] = support_layer->interface_id();
 
-                json first_layer_group_json;
+        //support_islands
+        for (const ExPolygon& support_island : support_layer->support_islands.expolygons) {
+            json support_island_json = support_island;
+            support_islands_json.push_back(std::move(support_island_json));
+        }
+        support_layer_json[JSON_SUPPORT_LAYER_ISLANDS] = std::move(support_islands_json);
+
+        //support_fills
+        support_fills_json[JSON_EXTRUSION_NO_SORT] = support_layer->support_fills.no_sort;
+        support_fills_json[JSON_EXTRUSION_ENTITY_TYPE] = JSON_EXTRUSION_TYPE_COLLECTION;
+        for (const ExtrusionEntity* extrusion_entity : support_layer->support_fills.entities) {
+            json supportfill_entity_json, supportfill_entity_paths_json = json::array();
+            bool ret = convert_extrusion_to_json(supportfill_entity_json, supportfill_entity_paths_json, extrusion_entity);
+            if (!ret)
+                continue;
+
+            supportfills_entities_json.push_back(std::move(supportfill_entity_json));
+        }
+        support_fills_json[JSON_EXTRUSION_ENTITIES] = std::move(supportfills_entities_json);
+        support_layer_json[JSON_SUPPORT_LAYER_FILLS] = std::move(support_fills_json);
 
-                first_layer_group_json = group;
-                first_layer_groups.push_back(std::move(first_layer_group_json));
+        support_layers_json.push_back(std::move(support_layer_json));
+    } // for each layer*/
+    root_json[JSON_SUPPORT_LAYERS] = std::move(support_layers_json);
+
+    const std::vector<groupedVolumeSlices> &first_layer_obj_groups =  obj->firstLayerObjGroups();
+    for (size_t s_group_index = 0; s_group_index < first_layer_obj_groups.size(); ++ s_group_index) {
+        groupedVolumeSlices group = first_layer_obj_groups[s_group_index];
+
+        //convert the id
+        for (ObjectID& obj_id : group.volume_ids)
+        {
+            const ModelVolume* currentModelVolumePtr = nullptr;
+            //BBS: support shared object logic
+            const PrintObject* shared_object = obj->get_shared_object();
+            if (!shared_object)
+                shared_object = obj;
+            const ModelVolumePtrs& volumes_ptr = shared_object->model_object()->volumes;
+            size_t volume_count = volumes_ptr.size();
+            for (size_t index = 0; index < volume_count; index ++) {
+                currentModelVolumePtr = volumes_ptr[index];
+                if (currentModelVolumePtr->id() == obj_id) {
+                    obj_id.id = index;
+                    break;
+                }
             }
-            root_json[JSON_FIRSTLAYER_GROUPS] = std::move(first_layer_groups);
+        }
+
+        json first_layer_group_json;
+
+        first_layer_group_json = group;
+        first_layer_groups.push_back(std::move(first_layer_group_json));
+    }
+    root_json[JSON_FIRSTLAYER_GROUPS] = std::move(first_layer_groups);
+
+    return root_json;
+}
+
+int Print::export_cached_data(const std::string& directory, bool with_space)
+{
+    int ret = 0;
+    boost::filesystem::path directory_path(directory);
+
+    //firstly clear this directory
+    if (fs::exists(directory_path)) {
+        fs::remove_all(directory_path);
+    }
+    try {
+        if (!fs::create_directory(directory_path)) {
+            BOOST_LOG_TRIVIAL(error) << boost::format("create directory %1% failed")%directory;
+            return CLI_EXPORT_CACHE_DIRECTORY_CREATE_FAILED;
+        }
+    }
+    catch (...)
+    {
+        BOOST_LOG_TRIVIAL(error) << boost::format("create directory %1% failed")%directory;
+        return CLI_EXPORT_CACHE_DIRECTORY_CREATE_FAILED;
+    }
+
+    int count = 0;
+    std::vector<std::string> filename_vector;
+    std::vector<json> json_vector;
+    for (PrintObject *obj : m_objects) {
+        const ModelObject* model_obj = obj->model_object();
+        if (obj->get_shared_object()) {
+            BOOST_LOG_TRIVIAL(info) << boost::format("shared object %1%, skip directly")%model_obj->name;
+            continue;
+        }
+
+        const PrintInstance &print_instance = obj->instances()[0];
+        const ModelInstance *model_instance = print_instance.model_instance;
+        size_t identify_id = (model_instance->loaded_id > 0)?model_instance->loaded_id: model_instance->id().id;
+        std::string file_name = directory +"/obj_"+std::to_string(identify_id)+".json";
+
+        BOOST_LOG_TRIVIAL(info) << boost::format("begin to dump object %1%, identify_id %2% to %3%")%model_obj->name %identify_id %file_name;
+
+        try {
+            json root_json = print_object_to_cache_json(obj, identify_id);
 
             filename_vector.push_back(file_name);
             json_vector.push_back(std::move(root_json));
@@ -4628,6 +4638,141 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
 }
 
 
+static const PrintRegion* find_print_region(const PrintObject* object, size_t config_hash)
+{
+    int regions_count = object->num_printing_regions();
+    for (int index = 0; index < regions_count; index++ )
+    {
+        const PrintRegion&  print_region = object->printing_region(index);
+        if (print_region.config_hash() == config_hash ) {
+            return &print_region;
+        }
+    }
+    return NULL;
+}
+
+// Create the layers, support layers and first layer groups of a PrintObject from json exported by print_object_to_cache_json().
+// return 0 means successful
+static int load_print_object_from_cache_json(PrintObject *obj, json &root_json, const std::string &file_name)
+{
+    std::string name = root_json.at(JSON_OBJECT_NAME);
+    int identify_id = root_json.at(JSON_IDENTIFY_ID);
+    int layer_count = 0, support_layer_count = 0, firstlayer_group_count = 0;
+
+    layer_count = root_json[JSON_LAYERS].size();
+    support_layer_count = root_json[JSON_SUPPORT_LAYERS].size();
+    firstlayer_group_count = root_json[JSON_FIRSTLAYER_GROUPS].size();
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(":will load %1%, identify_id %2%, layer_count %3%, support_layer_count %4%, firstlayer_group_count %5%")
+        %name %identify_id %layer_count %support_layer_count %firstlayer_group_count;
+
+    Layer* previous_layer = NULL;
+    //create layer and layer regions
+    for (int index = 0; index < layer_count; index++)
+    {
+        json& layer_json = root_json[JSON_LAYERS][index];
+        Layer* new_layer = obj->add_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z], layer_json[JSON_LAYER_SLICE_Z]);
+        if (!new_layer) {
+            BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":create_layer failed, out of memory");
+            return CLI_OUT_OF_MEMORY;
+        }
+        if (previous_layer) {
+            previous_layer->upper_layer = new_layer;
+            new_layer->lower_layer = previous_layer;
+        }
+        previous_layer = new_layer;
+
+        //layer regions
+        int layer_regions_count = layer_json[JSON_LAYER_REGIONS].size();
+        for (int region_index = 0; region_index < layer_regions_count; region_index++)
+        {
+            json& region_json = layer_json[JSON_LAYER_REGIONS][region_index];
+            size_t config_hash = region_json[JSON_LAYER_REGION_CONFIG_HASH];
+            const PrintRegion *print_region = find_print_region(obj, config_hash);
+
+            if (!print_region){
+                BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":can not find print region of object %1%, layer %2%, print_z %3%, layer_region %4%")
+                    %name % index %new_layer->print_z %region_index;
+                //delete new_layer;
+                return CLI_IMPORT_CACHE_DATA_CAN_NOT_USE;
+            }
+
+            new_layer->add_region(print_region);
+        }
+
+    }
+
+    //load the layer data parallel
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(": load the layers in parallel");
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, obj->layer_count()),
+        [&root_json, &obj](const tbb::blocked_range<size_t>& layer_range) {
+            for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
+                const json& layer_json = root_json[JSON_LAYERS][layer_index];
+                Layer* layer = obj->get_layer(layer_index);
+                extract_layer(layer_json, *layer);
+            }
+        }
+    );
+
+    //support layers
+    Layer* previous_support_layer = NULL;
+    //create support_layers
+    for (int index = 0; index < support_layer_count; index++)
+    {
+        json& layer_json = root_json[JSON_SUPPORT_LAYERS][index];
+        SupportLayer* new_support_layer = obj->add_support_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z]);
+        if (!new_support_layer) {
+            BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":add_support_layer failed, out of memory");
+            return CLI_OUT_OF_MEMORY;
+        }
+        if (previous_support_layer) {
+            previous_support_layer->upper_layer = new_support_layer;
+            new_support_layer->lower_layer = previous_support_layer;
+        }
+        previous_support_layer = new_support_layer;
+    }
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": finished load layers, start to load support_layers.");
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, obj->support_layer_count()),
+        [&root_json, &obj](const tbb::blocked_range<size_t>& support_layer_range) {
+            for (size_t layer_index = support_layer_range.begin(); layer_index < support_layer_range.end(); ++ layer_index) {
+                const json& layer_json = root_json[JSON_SUPPORT_LAYERS][layer_index];
+                SupportLayer* support_layer = obj->get_support_layer(layer_index);
+                extract_support_layer(layer_json, *support_layer);
+            }
+        }
+    );
+
+    //load first group volumes
+    std::vector<groupedVolumeSlices>& firstlayer_objgroups = obj->firstLayerObjGroupsMod();
+    for (int index = 0; index < firstlayer_group_count; index++)
+    {
+        json& firstlayer_group_json = root_json[JSON_FIRSTLAYER_GROUPS][index];
+        groupedVolumeSlices firstlayer_group = firstlayer_group_json;
+        //convert the id
+        for (ObjectID& obj_id : firstlayer_group.volume_ids)
+        {
+            ModelVolume* currentModelVolumePtr = nullptr;
+            ModelVolumePtrs& volumes_ptr = obj->model_object()->volumes;
+            size_t volume_count = volumes_ptr.size();
+            if (obj_id.id < volume_count) {
+                currentModelVolumePtr = volumes_ptr[obj_id.id];
+                obj_id = currentModelVolumePtr->id();
+            }
+            else {
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< boost::format(": can not find volume_id %1% from object file %2% in firstlayer groups, volume_count %3%!")
+                    %obj_id.id %file_name %volume_count;
+                return CLI_IMPORT_CACHE_LOAD_FAILED;
+            }
+        }
+        firstlayer_objgroups.push_back(std::move(firstlayer_group));
+    }
+
+    return 0;
+}
+
 int Print::load_cached_data(const std::string& directory)
 {
     int ret = 0;
@@ -4638,18 +4783,6 @@ int Print::load_cached_data(const std::string& directory)
         return CLI_IMPORT_CACHE_NOT_FOUND;
     }
 
-    auto find_region = [this](PrintObject* object, size_t config_hash) -> const PrintRegion* {
-        int regions_count = object->num_printing_regions();
-        for (int index = 0; index < regions_count; index++ )
-        {
-            const PrintRegion&  print_region = object->printing_region(index);
-            if (print_region.config_hash() == config_hash ) {
-                return &print_region;
-            }
-        }
-        return NULL;
-    };
-
     int count = 0;
     std::vector<std::pair<std::string, PrintObject*>> object_filenames;
     for (PrintObject *obj : m_objects) {
@@ -4710,137 +4843,200 @@ int Print::load_cached_data(const std::string& directory)
             //boost::nowide::ifstream ifs(file_name);
             //ifs >> root_json;
 
-            std::string name = root_json.at(JSON_OBJECT_NAME);
-            int identify_id = root_json.at(JSON_IDENTIFY_ID);
-            int layer_count = 0, support_layer_count = 0, firstlayer_group_count = 0;
+            int load_ret = load_print_object_from_cache_json(obj, root_json, object_filenames[obj_index].first);
+            if (load_ret)
+                return load_ret;
 
-            layer_count = root_json[JSON_LAYERS].size();
-            support_layer_count = root_json[JSON_SUPPORT_LAYERS].size();
-            firstlayer_group_count = root_json[JSON_FIRSTLAYER_GROUPS].size();
+            count ++;
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": load object %1% from %2% successfully.")%count%object_filenames[obj_index].first;
+        }
+        catch(nlohmann::detail::parse_error &err) {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<<object_filenames[obj_index].first<<" got a nlohmann::detail::parse_error, reason = " << err.what();
+            return CLI_IMPORT_CACHE_LOAD_FAILED;
+        }
+        catch(std::exception &err) {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load from "<<object_filenames[obj_index].first<<" got a generic exception, reason = " << err.what();
+            ret = CLI_IMPORT_CACHE_LOAD_FAILED;
+        }
+    }
 
-            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(":will load %1%, identify_id %2%, layer_count %3%, support_layer_count %4%, firstlayer_group_count %5%")
-                %name %identify_id %layer_count %support_layer_count %firstlayer_group_count;
+    object_jsons.clear();
+    object_filenames.clear();
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": total printobject count %1%, loaded %2%, ret=%3%")%m_objects.size() %count %ret;
+    return ret;
+}
 
-            Layer* previous_layer = NULL;
-            //create layer and layer regions
-            for (int index = 0; index < layer_count; index++)
-            {
-                json& layer_json = root_json[JSON_LAYERS][index];
-                Layer* new_layer = obj->add_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z], layer_json[JSON_LAYER_SLICE_Z]);
-                if (!new_layer) {
-                    BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":create_layer failed, out of memory");
-                    return CLI_OUT_OF_MEMORY;
-                }
-                if (previous_layer) {
-                    previous_layer->upper_layer = new_layer;
-                    new_layer->lower_layer = previous_layer;
-                }
-                previous_layer = new_layer;
+std::string Print::slice_cache_key(const PrintObject *obj) const
+{
+    MD5_CTX ctx;
+    MD5_Init(&ctx);
+    auto update = [&ctx](const void *data, size_t size) { MD5_Update(&ctx, data, size); };
+    auto update_string = [&update](const std::string &str) { update(str.data(), str.size() + 1); };
+    auto update_config = [&update_string](const ConfigBase &config) {
+        for (const std::string &key : config.keys()) {
+            update_string(key);
+            update_string(config.opt_serialize(key));
+        }
+    };
+    auto update_facets = [&update](const FacetsAnnotation &facets) {
+        const TriangleSelector::TriangleSplittingData &data = facets.get_data();
+        for (const TriangleSelector::TriangleBitStreamMapping &mapping : data.triangles_to_split) {
+            update(&mapping.triangle_idx, sizeof(mapping.triangle_idx));
+            update(&mapping.bitstream_start_idx, sizeof(mapping.bitstream_start_idx));
+        }
+        std::vector<unsigned char> bits(data.bitstream.begin(), data.bitstream.end());
+        update(bits.data(), bits.size());
+    };
 
-                //layer regions
-                int layer_regions_count = layer_json[JSON_LAYER_REGIONS].size();
-                for (int region_index = 0; region_index < layer_regions_count; region_index++)
-                {
-                    json& region_json = layer_json[JSON_LAYER_REGIONS][region_index];
-                    size_t config_hash = region_json[JSON_LAYER_REGION_CONFIG_HASH];
-                    const PrintRegion *print_region = find_region(obj, config_hash);
-
-                    if (!print_region){
-                        BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":can not find print region of object %1%, layer %2%, print_z %3%, layer_region %4%")
-                            %name % index %new_layer->print_z %region_index;
-                        //delete new_layer;
-                        return CLI_IMPORT_CACHE_DATA_CAN_NOT_USE;
-                    }
+    update_string(SLIC3R_VERSION);
+    // The whole print config is hashed, the flows and the supports depend on the printer and filament settings.
+    update_config(m_config);
+    update_config(obj->config());
+    for (int i = 0; i < obj->num_printing_regions(); ++ i)
+        update_config(obj->printing_region(i).config());
+    update(obj->trafo().data(), sizeof(double) * 16);
+
+    const ModelObject &model_object = *obj->model_object();
+    update_config(model_object.config.get());
+    const std::vector<coordf_t> &layer_height_profile = model_object.layer_height_profile.get();
+    update(layer_height_profile.data(), layer_height_profile.size() * sizeof(coordf_t));
+    // The height ranges modifiers change the layer heights and the region configs of the layers they span.
+    for (const auto &[range, config] : model_object.layer_config_ranges) {
+        update(&range.first, sizeof(range.first));
+        update(&range.second, sizeof(range.second));
+        update_config(config.get());
+    }
+    for (const ModelVolume *volume : model_object.volumes) {
+        int type = int(volume->type());
+        update(&type, sizeof(type));
+        const indexed_triangle_set &its = volume->mesh().its;
+        update(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex));
+        update(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices));
+        update(volume->get_matrix().data(), sizeof(double) * 16);
+        update_config(volume->config.get());
+        update_facets(volume->supported_facets);
+        update_facets(volume->seam_facets);
+        update_facets(volume->mmu_segmentation_facets);
+        update_facets(volume->fuzzy_skin_facets);
+    }
+
+    unsigned char digest[16];
+    MD5_Final(digest, &ctx);
+    char md5_str[33];
+    for (int j = 0; j < 16; j++) { snprintf(&md5_str[j * 2], sizeof(md5_str) - j * 2, "%02x", (unsigned int) digest[j]); }
+    return std::string(md5_str);
+}
 
-                    new_layer->add_region(print_region);
-                }
+int Print::load_slice_cache(const std::string& cache_dir, size_t &hits, size_t &misses)
+{
+    hits   = 0;
+    misses = 0;
 
-            }
+    std::vector<std::pair<std::string, PrintObject*>> object_filenames;
+    for (PrintObject *obj : m_objects) {
+        obj->clear_layers();
+        obj->clear_support_layers();
+        obj->firstLayerObjGroupsMod().clear();
 
-            //load the layer data parallel
-            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(": load the layers in parallel");
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, obj->layer_count()),
-                [&root_json, &obj](const tbb::blocked_range<size_t>& layer_range) {
-                    for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
-                        const json& layer_json = root_json[JSON_LAYERS][layer_index];
-                        Layer* layer = obj->get_layer(layer_index);
-                        extract_layer(layer_json, *layer);
-                    }
-                }
-            );
+        std::string file_name = (boost::filesystem::path(cache_dir) / (this->slice_cache_key(obj) + ".json")).string();
+        if (fs::exists(file_name))
+            object_filenames.push_back({file_name, obj});
+        else
+            ++ misses;
+    }
 
-            //support layers
-            Layer* previous_support_layer = NULL;
-            //create support_layers
-            for (int index = 0; index < support_layer_count; index++)
-            {
-                json& layer_json = root_json[JSON_SUPPORT_LAYERS][index];
-                SupportLayer* new_support_layer = obj->add_support_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_SUPPORT_LAYER_INTERFACE_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z]);
-                if (!new_support_layer) {
-                    BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":add_support_layer failed, out of memory");
-                    return CLI_OUT_OF_MEMORY;
+    std::vector<json> object_jsons(object_filenames.size());
+    std::vector<char> object_loaded(object_filenames.size(), false);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, object_filenames.size()),
+        [&object_filenames, &object_jsons, &object_loaded](const tbb::blocked_range<size_t>& filename_range) {
+            for (size_t filename_index = filename_range.begin(); filename_index < filename_range.end(); ++ filename_index) {
+                try {
+                    boost::nowide::ifstream ifs(object_filenames[filename_index].first);
+                    ifs >> object_jsons[filename_index];
+                    object_loaded[filename_index] = true;
                 }
-                if (previous_support_layer) {
-                    previous_support_layer->upper_layer = new_support_layer;
-                    new_support_layer->lower_layer = previous_support_layer;
+                catch(std::exception &err) {
+                    BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load from "<<object_filenames[filename_index].first<<" got a generic exception, reason = " << err.what();
                 }
-                previous_support_layer = new_support_layer;
             }
+        }
+    );
 
-            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": finished load layers, start to load support_layers.");
-            tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, obj->support_layer_count()),
-                [&root_json, &obj](const tbb::blocked_range<size_t>& support_layer_range) {
-                    for (size_t layer_index = support_layer_range.begin(); layer_index < support_layer_range.end(); ++ layer_index) {
-                        const json& layer_json = root_json[JSON_SUPPORT_LAYERS][layer_index];
-                        SupportLayer* support_layer = obj->get_support_layer(layer_index);
-                        extract_support_layer(layer_json, *support_layer);
-                    }
-                }
-            );
+    for (size_t obj_index = 0; obj_index < object_jsons.size(); obj_index++) {
+        PrintObject *obj = object_filenames[obj_index].second;
+        int ret = CLI_IMPORT_CACHE_LOAD_FAILED;
+        if (object_loaded[obj_index]) {
+            try {
+                ret = load_print_object_from_cache_json(obj, object_jsons[obj_index], object_filenames[obj_index].first);
+            }
+            catch(std::exception &err) {
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load from "<<object_filenames[obj_index].first<<" got a generic exception, reason = " << err.what();
+            }
+        }
+        object_jsons[obj_index] = json();
+        if (ret == 0) {
+            ++ hits;
+        } else {
+            // Slice this object again.
+            obj->clear_layers();
+            obj->clear_support_layers();
+            obj->firstLayerObjGroupsMod().clear();
+            ++ misses;
+        }
+    }
 
-            //load first group volumes
-            std::vector<groupedVolumeSlices>& firstlayer_objgroups = obj->firstLayerObjGroupsMod();
-            for (int index = 0; index < firstlayer_group_count; index++)
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": slice cache %1%, total printobject count %2%, hits %3%, misses %4%")%cache_dir %m_objects.size() %hits %misses;
+    return hits > 0 ? 0 : CLI_IMPORT_CACHE_NOT_FOUND;
+}
+
+int Print::store_slice_cache(const std::string& cache_dir)
+{
+    int ret = 0;
+    boost::filesystem::path cache_path(cache_dir);
+    try {
+        fs::create_directories(cache_path);
+    }
+    catch (...)
+    {
+        BOOST_LOG_TRIVIAL(error) << boost::format("create directory %1% failed")%cache_dir;
+        return CLI_EXPORT_CACHE_DIRECTORY_CREATE_FAILED;
+    }
+
+    size_t count = 0;
+    for (PrintObject *obj : m_objects) {
+        if (obj->get_shared_object())
+            continue;
+        boost::filesystem::path file_path = cache_path / (this->slice_cache_key(obj) + ".json");
+        if (fs::exists(file_path))
+            continue;
+        const ModelInstance *model_instance = obj->instances()[0].model_instance;
+        size_t identify_id = (model_instance->loaded_id > 0)?model_instance->loaded_id: model_instance->id().id;
+        // Write into a temporary file first, the cache directory may be shared by several slicer instances running in parallel.
+        boost::filesystem::path temp_path = file_path;
+        temp_path += boost::filesystem::unique_path(".%%%%-%%%%.tmp");
+        try {
+            json root_json = print_object_to_cache_json(obj, identify_id);
             {
-                json& firstlayer_group_json = root_json[JSON_FIRSTLAYER_GROUPS][index];
-                groupedVolumeSlices firstlayer_group = firstlayer_group_json;
-                //convert the id
-                for (ObjectID& obj_id : firstlayer_group.volume_ids)
-                {
-                    ModelVolume* currentModelVolumePtr = nullptr;
-                    ModelVolumePtrs& volumes_ptr = obj->model_object()->volumes;
-                    size_t volume_count = volumes_ptr.size();
-                    if (obj_id.id < volume_count) {
-                        currentModelVolumePtr = volumes_ptr[obj_id.id];
-                        obj_id = currentModelVolumePtr->id();
-                    }
-                    else {
-                        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< boost::format(": can not find volume_id %1% from object file %2% in firstlayer groups, volume_count %3%!")
-                            %obj_id.id %object_filenames[obj_index].first %volume_count;
-                        return CLI_IMPORT_CACHE_LOAD_FAILED;
-                    }
-                }
-                firstlayer_objgroups.push_back(std::move(firstlayer_group));
+                boost::nowide::ofstream c;
+                c.open(temp_path.string(), std::ios::out | std::ios::trunc);
+                c << root_json.dump(0) << std::endl;
+                c.close();
+                if (c.fail())
+                    throw Slic3r::RuntimeError("write failed");
             }
-
-            count ++;
-            BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": load object %1% from %2% successfully.")%count%object_filenames[obj_index].first;
-        }
-        catch(nlohmann::detail::parse_error &err) {
-            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": parse "<<object_filenames[obj_index].first<<" got a nlohmann::detail::parse_error, reason = " << err.what();
-            return CLI_IMPORT_CACHE_LOAD_FAILED;
+            fs::rename(temp_path, file_path);
+            ++ count;
         }
         catch(std::exception &err) {
-            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load from "<<object_filenames[obj_index].first<<" got a generic exception, reason = " << err.what();
-            ret = CLI_IMPORT_CACHE_LOAD_FAILED;
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": save to "<<file_path.string()<<" got a generic exception, reason = " << err.what();
+            boost::system::error_code ec;
+            fs::remove(temp_path, ec);
+            ret = CLI_EXPORT_CACHE_WRITE_FAILED;
         }
     }
 
-    object_jsons.clear();
-    object_filenames.clear();
-    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": total printobject count %1%, loaded %2%, ret=%3%")%m_objects.size() %count %ret;
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": slice cache %1%, stored %2% printobjects, ret=%3%")%cache_dir %count %ret;
     return ret;
 }
 
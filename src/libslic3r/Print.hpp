@@ -23,6 +23,7 @@
 
 #include <functional>
 #include <set>
+#include <tuple>
 
 #include "calib.hpp"
 
@@ -73,6 +74,18 @@ namespace FillLightning {
     using GeneratorPtr = std::unique_ptr<Generator, GeneratorDeleter>;
 }; // namespace FillLightning
 
+namespace SeamPlacerImpl {
+    struct GlobalModelInfo;
+}; // namespace SeamPlacerImpl
+
+namespace TreeSupport3D {
+    class TreeModelVolumes;
+}; // namespace TreeSupport3D
+
+namespace Arachne {
+    class WallToolPathsCache;
+}; // namespace Arachne
+
 // Print step IDs for keeping track of the print state.
 // The Print steps are applied in this order.
 enum PrintStep {
@@ -316,6 +329,28 @@ private: // Prevents erroneous use by other classes.
     typedef PrintObjectBaseWithState<Print, PrintObjectStep, posCount> Inherited;
 
 public:
+    // Slicing cache of a single ModelVolume, bound to the mesh of the volume.
+    struct VolumeSlicingCache {
+        std::shared_ptr<const TriangleMesh> mesh;
+        MeshSlicingCache                    cache;
+    };
+    using VolumeSlicingCaches = std::map<ObjectID, VolumeSlicingCache>;
+    // Slicing index of a single ModelVolume, bound to the mesh of the volume and to its transformation.
+    struct VolumeSlicingIndex {
+        std::shared_ptr<const TriangleMesh>     mesh;
+        std::shared_ptr<const MeshSlicingIndex> index;
+    };
+    using VolumeSlicingIndices = std::map<ObjectID, VolumeSlicingIndex>;
+    // Triangles of a single ModelVolume painted with a single state and their slicing index, see painted_patch().
+    struct PaintedPatch {
+        // Identification of the painting and of the mesh the patch was extracted from.
+        ObjectID                                facets_id;
+        uint64_t                                facets_timestamp { 0 };
+        std::shared_ptr<const TriangleMesh>     mesh;
+        indexed_triangle_set                    its;
+        std::shared_ptr<const MeshSlicingIndex> index;
+    };
+
     // Size of an object: XYZ in scaled coordinates. The size might not be quite snug in XY plane.
     const Vec3crd&               size() const			{ return m_size; }
     const PrintObjectConfig&     config() const         { return m_config; }
@@ -397,8 +432,23 @@ public:
 
     // BBS
     SupportLayer* add_tree_support_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z);
+    // Reuses the collision and avoidance areas of the cache released by clear_tree_support_preview_cache() if the object outlines did not change.
+    // The released cache is trimmed to the same memory budget as the organic tree support areas, see set_tree_model_volumes().
     std::shared_ptr<TreeSupportData> alloc_tree_support_preview_cache();
-    void clear_tree_support_preview_cache() { m_tree_support_preview_cache.reset(); }
+    void clear_tree_support_preview_cache();
+    // Collision and avoidance areas of the organic tree supports, kept between the support generations and reused by TreeModelVolumes::precalculate() if still valid.
+    // Only the collision areas are kept if all the areas do not fit into the memory budget, none if the collision areas alone do not fit.
+    std::shared_ptr<TreeSupport3D::TreeModelVolumes> tree_model_volumes() const { return m_tree_model_volumes; }
+    void set_tree_model_volumes(std::shared_ptr<TreeSupport3D::TreeModelVolumes> volumes);
+    // Release the areas kept for the next tree support generation once they cannot be reused anymore.
+    void clear_tree_support_caches() { m_tree_support_previous_cache.reset(); m_tree_model_volumes.reset(); }
+
+    // Arachne walls shared by the layers with the same outlines while generating the perimeters, keeps the hit rate statistics afterwards.
+    Arachne::WallToolPathsCache* wall_tool_paths_cache() const { return m_wall_tool_paths_cache.get(); }
+
+    // Visibility of the object's surface and its seam enforcers / blockers, kept by SeamPlacer::init() between the G-code exports.
+    std::shared_ptr<const SeamPlacerImpl::GlobalModelInfo> seam_model_info() const { return m_seam_model_info; }
+    void set_seam_model_info(std::shared_ptr<const SeamPlacerImpl::GlobalModelInfo> info) const { m_seam_model_info = std::move(info); }
 
     size_t          support_layer_count() const { return m_support_layers.size(); }
     void            clear_support_layers();
@@ -445,6 +495,10 @@ public:
     std::vector<Polygons>       slice_support_blockers() const { return this->slice_support_volumes(ModelVolumeType::SUPPORT_BLOCKER); }
     std::vector<Polygons>       slice_support_enforcers() const { return this->slice_support_volumes(ModelVolumeType::SUPPORT_ENFORCER); }
 
+    // Triangles of volume painted with state, extracted again and indexed for slicing with trafo only if the painting,
+    // the mesh or trafo changed since the last call. To be called by the steps of this object only, it is not thread safe.
+    const PaintedPatch&         painted_patch(const ModelVolume &volume, const FacetsAnnotation &facets, EnforcerBlockerType state, const Transform3d &trafo) const;
+
     // Helpers to project custom facets on slices
     void project_and_append_custom_facets(bool seam, EnforcerBlockerType type, std::vector<Polygons>& expolys, std::vector<std::pair<Vec3f,Vec3f>>* vertical_points=nullptr) const;
 
@@ -512,6 +566,7 @@ private:
     std::vector<std::set<int>> detect_extruder_geometric_unprintables() const;
 
     void slice_volumes();
+    void clear_volume_slicing_caches();
     //BBS
     ExPolygons _shrink_contour_holes(double contour_delta, double hole_delta, const ExPolygons& polys) const;
     // BBS
@@ -557,6 +612,10 @@ private:
     SupportLayerPtrs                        m_support_layers;
     // BBS
     std::shared_ptr<TreeSupportData>        m_tree_support_preview_cache;
+    // Preview cache of the previous support generation, its collision and avoidance areas are reused by alloc_tree_support_preview_cache().
+    std::shared_ptr<TreeSupportData>        m_tree_support_previous_cache;
+    std::shared_ptr<TreeSupport3D::TreeModelVolumes> m_tree_model_volumes;
+    std::shared_ptr<Arachne::WallToolPathsCache>     m_wall_tool_paths_cache;
 
     // this is set to true when LayerRegion->slices is split in top/internal/bottom
     // so that next call to make_perimeters() performs a union() before computing loops
@@ -568,6 +627,21 @@ private:
     std::vector < VolumeSlices >            firstLayerObjSliceByVolume;
     std::vector<groupedVolumeSlices>        firstLayerObjSliceByGroups;
 
+    // Slicing results of the volumes kept between the runs of slice_volumes() if Print::keep_volume_slicing_caches(),
+    // so that editing the layer heights slices again just the layers with modified slicing planes.
+    VolumeSlicingCaches                     m_volume_slicing_caches;
+    // Layer height profile the slicing caches were made with and the Z interval modified since, see slice().
+    std::vector<coordf_t>                   m_volume_slicing_caches_profile;
+    std::pair<float, float>                 m_volume_slicing_dirty_zs { mesh_slicing_no_dirty_zs() };
+    // Slicing indices of the volumes, kept between the runs of slice_volumes() even if the slicing caches are not,
+    // so that a volume with the same mesh and transformation is not indexed again. Shared with the slicing caches.
+    VolumeSlicingIndices                    m_volume_slicing_indices;
+    // Painted patches of the volumes keyed by the volume, the painting and the state, see painted_patch().
+    mutable std::map<std::tuple<ObjectID, ObjectID, int>, PaintedPatch> m_painted_patches;
+    // Cache of SeamPlacer, validated by SeamPlacer against the meshes, transformations and seam painting of the object.
+    // Released when the slices of the object are invalidated.
+    mutable std::shared_ptr<const SeamPlacerImpl::GlobalModelInfo> m_seam_model_info;
+
     // BBS: per object skirt
     ExtrusionEntityCollection               m_skirt;
 
@@ -912,6 +986,13 @@ public:
     //return 0 means successful
     int                 export_cached_data(const std::string& dir_path, bool with_space=false);
     int                 load_cached_data(const std::string& directory);
+    // Content addressed cache of the sliced objects shared by command line runs (--slice_cache_dir).
+    // The key hashes the meshes, painting and transformation of the object with the print, object and region configs.
+    std::string         slice_cache_key(const PrintObject *obj) const;
+    // Load the cached objects, the others are left empty to be sliced by process(nullptr, true). return 0 if any object was loaded.
+    int                 load_slice_cache(const std::string& cache_dir, size_t &hits, size_t &misses);
+    // Store the sliced objects, which are not in the cache yet. return 0 means successful
+    int                 store_slice_cache(const std::string& cache_dir);
 
     // methods for handling state
     bool                is_step_done(PrintStep step) const { return Inherited::is_step_done(step); }
@@ -1080,6 +1161,10 @@ public:
 
     void set_check_multi_filaments_compatibility(bool check) { m_need_check_multi_filaments_compatibility = check; }
     bool need_check_multi_filaments_compatibility() const { return m_need_check_multi_filaments_compatibility; }
+    // Keep the slices of the volumes between the slicing runs, so that editing the layer heights slices again
+    // just the layers with modified slicing planes. Off by default, the caches hold about as much data as the slices.
+    void set_keep_volume_slicing_caches(bool keep) { m_keep_volume_slicing_caches = keep; }
+    bool keep_volume_slicing_caches() const { return m_keep_volume_slicing_caches; }
 
     // scaled point
     Vec2d translate_to_print_space(const Point &point) const;
@@ -1179,6 +1264,8 @@ private:
     Calib_Params m_calib_params;
 
     bool m_need_check_multi_filaments_compatibility{true};
+    // Set by the UI thread while the background slicing may run.
+    std::atomic<bool> m_keep_volume_slicing_caches{false};
 
     // To allow GCode to set the Print's GCodeExport step status.
     friend class GCode;
@@ -9981,6 +9981,14 @@ CLIActionsConfigDef::CLIActionsConfigDef()
     def->tooltip = L("Send progress to pipe.");
     def->cli_params = "pipename";
     def->set_default_value(new ConfigOptionString());
+
+    def = this->add("daemon", coString);
+    def->label = L("Run as slicing daemon");
+    def->tooltip = L("Listen on the given unix socket and run the slicing jobs sent to it in this process. "
+                     "Each job is a line of JSON with the command line arguments, for example {\"args\": [\"--slice\", \"0\", \"--outputdir\", \"out\"], \"file\": \"model.3mf\"}. "
+                     "{\"command\": \"stop\"} stops the daemon.");
+    def->cli_params = "socket";
+    def->set_default_value(new ConfigOptionString());
 }
 
 //BBS: remove unused command currently
@@ -10212,6 +10220,12 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->cli_params = "dir";
     def->set_default_value(new ConfigOptionString());
 
+    def = this->add("slice_cache_dir", coString);
+    def->label = L("Slice cache directory");
+    def->tooltip = L("Directory of the persistent slice result cache. Objects with the same mesh and settings as in a previous run are loaded from the cache instead of being sliced again.");
+    def->cli_params = "dir";
+    def->set_default_value(new ConfigOptionString());
+
     def = this->add("debug", coInt);
     def->label = L("Debug level");
     def->tooltip = L("Sets debug logging level. 0:fatal, 1:error, 2:warning, 3:info, 4:debug, 5:trace\n");
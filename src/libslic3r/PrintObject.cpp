@@ -11,6 +11,7 @@
 #include "Support/SupportMaterial.hpp"
 #include "Support/SupportSpotsGenerator.hpp"
 #include "Support/TreeSupport.hpp"
+#include "Support/TreeModelVolumes.hpp"
 #include "Surface.hpp"
 #include "Slicing.hpp"
 #include "Tesselate.hpp"
@@ -21,6 +22,7 @@
 #include "Format/STL.hpp"
 #include "format.hpp"
 #include "AABBTreeLines.hpp"
+#include "Arachne/WallToolPaths.hpp"
 
 #include <float.h>
 #include <oneapi/tbb/blocked_range.h>
@@ -506,16 +508,28 @@ void PrintObject::make_perimeters()
     }
 
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start";
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, m_layers.size()),
-        [this](const tbb::blocked_range<size_t>& range) {
-            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
-                m_print->throw_if_canceled();
-                m_layers[layer_idx]->make_perimeters();
+    m_wall_tool_paths_cache = std::make_shared<Arachne::WallToolPathsCache>();
+    try {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, m_layers.size()),
+            [this](const tbb::blocked_range<size_t>& range) {
+                for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                    m_print->throw_if_canceled();
+                    m_layers[layer_idx]->make_perimeters();
+                }
             }
-        }
-    );
+        );
+    } catch (...) {
+        // Don't keep the walls of a canceled or failed step until the next one.
+        m_wall_tool_paths_cache->clear();
+        throw;
+    }
+    // The walls are copied to the layers, keep just the statistics.
+    m_wall_tool_paths_cache->clear();
     m_print->throw_if_canceled();
+    if (size_t lookups = m_wall_tool_paths_cache->lookups(); lookups > 0)
+        BOOST_LOG_TRIVIAL(debug) << "Arachne walls reused for " << m_wall_tool_paths_cache->hits() << " of " << lookups << " islands ("
+                                 << 100 * m_wall_tool_paths_cache->hits() / lookups << "%)";
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - end";
 
     this->set_done(posPerimeters);
@@ -756,6 +770,9 @@ void PrintObject::generate_support_material()
 {
     if (this->set_started(posSupportMaterial)) {
         this->clear_support_layers();
+        // Tree supports were switched off, their areas will not be reused.
+        if (! is_tree(m_config.support_type.value) || ! this->has_support_material())
+            this->clear_tree_support_caches();
 
         if(!has_support() && !m_print->get_no_check_flag()) {
             // BBS: pop a warning if objects have significant amount of overhangs but support material is not enabled
@@ -970,11 +987,40 @@ std::shared_ptr<TreeSupportData> PrintObject::alloc_tree_support_preview_cache()
     if (!m_tree_support_preview_cache) {
         const coordf_t xy_distance = m_config.support_object_xy_distance.value;
         m_tree_support_preview_cache = std::make_shared<TreeSupportData>(*this, xy_distance, g_config_tree_support_collision_resolution);
+        if (m_tree_support_previous_cache) {
+            m_tree_support_preview_cache->reuse_caches(std::move(*m_tree_support_previous_cache));
+            m_tree_support_previous_cache.reset();
+        }
     }
 
     return m_tree_support_preview_cache;
 }
 
+// Memory budget of the tree support areas kept by a PrintObject for the next support generation.
+static constexpr size_t tree_support_caches_max_memory = size_t(256) << 20;
+
+void PrintObject::clear_tree_support_preview_cache()
+{
+    if (m_tree_support_preview_cache) {
+        m_tree_support_previous_cache = std::move(m_tree_support_preview_cache);
+        if (m_tree_support_previous_cache->memory_used() > tree_support_caches_max_memory) {
+            m_tree_support_previous_cache->clear_all_but_collision();
+            if (m_tree_support_previous_cache->memory_used() > tree_support_caches_max_memory)
+                m_tree_support_previous_cache.reset();
+        }
+    }
+}
+
+void PrintObject::set_tree_model_volumes(std::shared_ptr<TreeSupport3D::TreeModelVolumes> volumes)
+{
+    if (volumes && volumes->memory_used() > tree_support_caches_max_memory) {
+        volumes->clear_all_but_object_collision();
+        if (volumes->memory_used() > tree_support_caches_max_memory)
+            volumes.reset();
+    }
+    m_tree_model_volumes = std::move(volumes);
+}
+
 SupportLayer* PrintObject::add_tree_support_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z)
 {
     m_support_layers.emplace_back(new SupportLayer(id, 0, this, height, print_z, slice_z));
@@ -1362,6 +1408,10 @@ bool PrintObject::invalidate_step(PrintObjectStep step)
 		invalidated |= this->invalidate_steps({ posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial, posSimplifyPath, posSimplifyInfill });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
         m_slicing_params.valid = false;
+        // The meshes or their placement may have changed, release the visibility of the surface until the next export.
+        m_seam_model_info.reset();
+        // The outlines changed, the areas of the tree supports cannot be reused.
+        this->clear_tree_support_caches();
     } else if (step == posSupportMaterial) {
         invalidated |= this->invalidate_steps({ posSimplifySupportPath });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
@@ -1383,6 +1433,8 @@ bool PrintObject::invalidate_all_steps()
     bool result = Inherited::invalidate_all_steps() | m_print->invalidate_all_steps();
 	// Then reset some of the depending values.
 	m_slicing_params.valid = false;
+    m_seam_model_info.reset();
+    this->clear_tree_support_caches();
 	return result;
 }
 
@@ -4298,23 +4350,38 @@ static void project_triangles_to_slabs(ConstLayerPtrsAdaptor layers, const index
     }
 }
 
+const PrintObject::PaintedPatch& PrintObject::painted_patch(const ModelVolume &volume, const FacetsAnnotation &facets, EnforcerBlockerType state, const Transform3d &trafo) const
+{
+    PaintedPatch &patch = m_painted_patches[{ volume.id(), facets.id(), int(state) }];
+    if (patch.facets_id != facets.id() || patch.facets_timestamp != facets.timestamp() || patch.mesh != volume.mesh_ptr()) {
+        patch.facets_id        = facets.id();
+        patch.facets_timestamp = facets.timestamp();
+        patch.mesh             = volume.mesh_ptr();
+        patch.its              = facets.get_facets_strict(volume, state);
+        patch.index.reset();
+    }
+    if (! patch.its.indices.empty() && (! patch.index || ! patch.index->matches(patch.its, trafo)))
+        patch.index = std::make_shared<const MeshSlicingIndex>(patch.its, trafo);
+    return patch;
+}
+
 void PrintObject::project_and_append_custom_facets(
         bool seam, EnforcerBlockerType type, std::vector<Polygons>& out, std::vector<std::pair<Vec3f, Vec3f>>* vertical_points) const
 {
     for (const ModelVolume* mv : this->model_object()->volumes)
         if (mv->is_model_part()) {
-            const indexed_triangle_set custom_facets = seam
-                    ? mv->seam_facets.get_facets_strict(*mv, type)
-                    : mv->supported_facets.get_facets_strict(*mv, type);
-            if (! custom_facets.indices.empty()) {
-                if (seam)
+            if (seam) {
+                const indexed_triangle_set custom_facets = mv->seam_facets.get_facets_strict(*mv, type);
+                if (! custom_facets.indices.empty())
                     project_triangles_to_slabs(this->layers(), custom_facets,
                         (this->trafo_centered() * mv->get_matrix()).cast<float>(),
                         seam, out);
-                else {
+            } else {
+                const PaintedPatch &custom_facets = this->painted_patch(*mv, mv->supported_facets, type, this->trafo_centered() * mv->get_matrix());
+                if (! custom_facets.its.indices.empty()) {
                     std::vector<Polygons> projected;
                     // Support blockers or enforcers. Project downward facing painted areas upwards to their respective slicing plane.
-                    slice_mesh_slabs(custom_facets, zs_from_layers(this->layers()), this->trafo_centered() * mv->get_matrix(), nullptr, &projected, vertical_points, [](){});
+                    slice_mesh_slabs(custom_facets.its, zs_from_layers(this->layers()), *custom_facets.index, nullptr, &projected, vertical_points, [](){});
                     // Merge these projections with the output, layer by layer.
                     assert(! projected.empty());
                     assert(out.empty() || out.size() == projected.size());
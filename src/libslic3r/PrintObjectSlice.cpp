@@ -20,6 +20,33 @@ namespace Slic3r {
 bool PrintObject::clip_multipart_objects = true;
 bool PrintObject::infill_only_where_needed = false;
 
+// Slicing caches of the volumes of an object are released if they hold more memory than that.
+static constexpr size_t volume_slicing_caches_max_memory = size_t(256) << 20;
+
+// Z interval of the object, in which the layer height profile new_profile differs from old_profile,
+// empty if the profiles are equal. The profiles are sequences of (z, layer height) pairs.
+static std::pair<float, float> layer_height_profile_dirty_zs(const std::vector<coordf_t> &old_profile, const std::vector<coordf_t> &new_profile)
+{
+    size_t begin = 0;
+    while (begin + 1 < old_profile.size() && begin + 1 < new_profile.size() &&
+           old_profile[begin] == new_profile[begin] && old_profile[begin + 1] == new_profile[begin + 1])
+        begin += 2;
+    if (begin == old_profile.size() && begin == new_profile.size())
+        return mesh_slicing_no_dirty_zs();
+    size_t end_old = old_profile.size();
+    size_t end_new = new_profile.size();
+    while (end_old >= begin + 2 && end_new >= begin + 2 &&
+           old_profile[end_old - 2] == new_profile[end_new - 2] && old_profile[end_old - 1] == new_profile[end_new - 1]) {
+        end_old -= 2;
+        end_new -= 2;
+    }
+    // The layer heights are interpolated between the samples, thus the samples around the modified ones bound the interval.
+    return {
+        begin == 0 ? std::numeric_limits<float>::lowest() : float(std::min(old_profile[begin - 2], new_profile[begin - 2])),
+        end_old == old_profile.size() || end_new == new_profile.size() ? std::numeric_limits<float>::max() : float(std::max(old_profile[end_old], new_profile[end_new]))
+    };
+}
+
 LayerPtrs new_layers(
     PrintObject                 *print_object,
     // Object layers (pairs of bottom/top Z coordinate), without the raft.
@@ -45,22 +72,44 @@ LayerPtrs new_layers(
     return out;
 }
 
-// Slice single triangle mesh.
+// Slice single triangle mesh with its slicing index, which is reused if built by the previous call for the same mesh and transformation.
+// If cache is provided, the layers sliced by the previous call with the same slicing planes outside of dirty_zs are reused.
 static std::vector<ExPolygons> slice_volume(
     const ModelVolume             &volume,
     const std::vector<float>      &zs,
     const MeshSlicingParamsEx     &params,
-    const std::function<void()>   &throw_on_cancel_callback)
+    PrintObject::VolumeSlicingIndex &index,
+    const std::function<void()>   &throw_on_cancel_callback,
+    PrintObject::VolumeSlicingCache *cache = nullptr,
+    const std::pair<float, float> &dirty_zs = mesh_slicing_no_dirty_zs())
 {
     std::vector<ExPolygons> layers;
     if (! zs.empty()) {
-        indexed_triangle_set its = volume.mesh().its;
-        if (its.indices.size() > 0) {
+        const indexed_triangle_set &its_src = volume.mesh().its;
+        if (its_src.indices.size() > 0) {
             MeshSlicingParamsEx params2 { params };
             params2.trafo = params2.trafo * volume.get_matrix();
-            if (params2.trafo.rotation().determinant() < 0.)
-                its_flip_triangles(its);
-            layers = slice_mesh_ex(its, zs, params2, throw_on_cancel_callback);
+            // Copy the mesh only if its triangles need to be flipped.
+            indexed_triangle_set its_flipped;
+            if (params2.trafo.rotation().determinant() < 0.) {
+                its_flipped = its_src;
+                its_flip_triangles(its_flipped);
+            }
+            const indexed_triangle_set &its = its_flipped.indices.empty() ? its_src : its_flipped;
+            if (index.mesh != volume.mesh_ptr() || ! index.index || ! index.index->matches(its, params2.trafo)) {
+                index.mesh  = volume.mesh_ptr();
+                index.index = std::make_shared<const MeshSlicingIndex>(its, params2.trafo);
+            }
+            if (cache) {
+                if (cache->mesh != volume.mesh_ptr()) {
+                    // Different mesh, the cache is bound to the triangles of the mesh.
+                    cache->mesh = volume.mesh_ptr();
+                    cache->cache.clear();
+                }
+                cache->cache.index = index.index;
+                layers = slice_mesh_ex(its, zs, params2, cache->cache, dirty_zs, throw_on_cancel_callback);
+            } else
+                layers = slice_mesh_ex(its, zs, params2, *index.index, throw_on_cancel_callback);
             throw_on_cancel_callback();
         }
     }
@@ -74,13 +123,16 @@ static std::vector<ExPolygons> slice_volume(
     const std::vector<float>                    &z,
     const std::vector<t_layer_height_range>     &ranges,
     const MeshSlicingParamsEx                   &params,
-    const std::function<void()>                 &throw_on_cancel_callback)
+    PrintObject::VolumeSlicingIndex             &index,
+    const std::function<void()>                 &throw_on_cancel_callback,
+    PrintObject::VolumeSlicingCache             *cache = nullptr,
+    const std::pair<float, float>               &dirty_zs = mesh_slicing_no_dirty_zs())
 {
     std::vector<ExPolygons> out;
     if (! z.empty() && ! ranges.empty()) {
         if (ranges.size() == 1 && z.front() >= ranges.front().first && z.back() < ranges.front().second) {
             // All layers fit into a single range.
-            out = slice_volume(volume, z, params, throw_on_cancel_callback);
+            out = slice_volume(volume, z, params, index, throw_on_cancel_callback, cache, dirty_zs);
         } else {
             std::vector<float>                     z_filtered;
             std::vector<std::pair<size_t, size_t>> n_filtered;
@@ -96,7 +148,7 @@ static std::vector<ExPolygons> slice_volume(
                     n_filtered.emplace_back(std::make_pair(first, i));
             }
             if (! n_filtered.empty()) {
-                std::vector<ExPolygons> layers = slice_volume(volume, z_filtered, params, throw_on_cancel_callback);
+                std::vector<ExPolygons> layers = slice_volume(volume, z_filtered, params, index, throw_on_cancel_callback, cache, dirty_zs);
                 out.assign(z.size(), ExPolygons());
                 i = 0;
                 for (const std::pair<size_t, size_t> &span : n_filtered)
@@ -124,10 +176,35 @@ static std::vector<VolumeSlices> slice_volumes_inner(
     ModelVolumePtrs                                           model_volumes,
     const std::vector<PrintObjectRegions::LayerRangeRegions> &layer_ranges,
     const std::vector<float>                                 &zs,
-    const std::function<void()>                              &throw_on_cancel_callback)
+    const std::function<void()>                              &throw_on_cancel_callback,
+    // Slicing indices of the volumes kept between the calls.
+    PrintObject::VolumeSlicingIndices                        &slicing_indices,
+    // Caches of the volumes kept between the calls, may be null.
+    PrintObject::VolumeSlicingCaches                         *slicing_caches,
+    // Slicing planes to be sliced again even if cached.
+    const std::pair<float, float>                            &dirty_zs)
 {
     model_volumes_sort_by_id(model_volumes);
 
+    // Drop the indices and the caches of the deleted volumes.
+    auto volume_deleted = [&model_volumes](const ObjectID id) {
+        return std::none_of(model_volumes.begin(), model_volumes.end(), [id](const ModelVolume *mv) { return mv->id() == id; });
+    };
+    for (auto it = slicing_indices.begin(); it != slicing_indices.end();)
+        if (volume_deleted(it->first))
+            it = slicing_indices.erase(it);
+        else
+            ++ it;
+    if (slicing_caches)
+        for (auto it = slicing_caches->begin(); it != slicing_caches->end();)
+            if (volume_deleted(it->first))
+                it = slicing_caches->erase(it);
+            else
+                ++ it;
+    auto volume_cache = [slicing_caches](const ModelVolume *model_volume) {
+        return slicing_caches ? &(*slicing_caches)[model_volume->id()] : nullptr;
+    };
+
     std::vector<VolumeSlices> out;
     out.reserve(model_volumes.size());
 
@@ -178,7 +255,7 @@ static std::vector<VolumeSlices> slice_volumes_inner(
                     }
                     out.push_back({
                         model_volume->id(),
-                        slice_volume(*model_volume, zs, params, throw_on_cancel_callback)
+                        slice_volume(*model_volume, zs, params, slicing_indices[model_volume->id()], throw_on_cancel_callback, volume_cache(model_volume), dirty_zs)
                     });
                 }
             } else {
@@ -190,7 +267,7 @@ static std::vector<VolumeSlices> slice_volumes_inner(
                 if (! slicing_ranges.empty())
                     out.push_back({
                         model_volume->id(),
-                        slice_volume(*model_volume, zs, slicing_ranges, params, throw_on_cancel_callback)
+                        slice_volume(*model_volume, zs, slicing_ranges, params, slicing_indices[model_volume->id()], throw_on_cancel_callback, volume_cache(model_volume), dirty_zs)
                     });
             }
             if (! out.empty() && out.back().slices.empty())
@@ -795,6 +872,9 @@ void PrintObject::slice()
     std::vector<coordf_t> layer_height_profile;
     this->update_layer_height_profile(*this->model_object(), m_slicing_params, layer_height_profile);
     m_print->throw_if_canceled();
+    // The layers of the volume slicing caches inside the Z interval of a layer height profile edit are sliced again.
+    m_volume_slicing_dirty_zs = layer_height_profile_dirty_zs(m_volume_slicing_caches_profile, layer_height_profile);
+    m_volume_slicing_caches_profile = layer_height_profile;
     m_typed_slices = false;
     this->clear_layers();
     m_layers = new_layers(this, generate_object_layers(m_slicing_params, layer_height_profile, m_config.precise_z_height.value));
@@ -1118,6 +1198,12 @@ void apply_fuzzy_skin_segmentation(PrintObject &print_object, ThrowOnCancel thro
 // Resulting expolygons of layer regions are marked as Internal.
 //
 // this should be idempotent
+void PrintObject::clear_volume_slicing_caches()
+{
+    m_volume_slicing_caches.clear();
+    m_volume_slicing_caches_profile.clear();
+}
+
 void PrintObject::slice_volumes()
 {
     BOOST_LOG_TRIVIAL(info) << "Slicing volumes..." << log_memory_info();
@@ -1137,12 +1223,48 @@ void PrintObject::slice_volumes()
             layer->m_regions.emplace_back(new LayerRegion(layer, pr.get()));
     }
 
+    // Drop the painted patches of the deleted volumes.
+    for (auto it = m_painted_patches.begin(); it != m_painted_patches.end();)
+        if (std::none_of(this->model_object()->volumes.begin(), this->model_object()->volumes.end(),
+                [id = std::get<0>(it->first)](const ModelVolume *mv) { return mv->id() == id; }))
+            it = m_painted_patches.erase(it);
+        else
+            ++ it;
+
     std::vector<float>                   slice_zs      = zs_from_layers(m_layers);
+    // The slicing caches are kept only if requested, they hold about as much data as the slices themselves.
+    const bool                           keep_caches   = print->keep_volume_slicing_caches();
+    if (! keep_caches)
+        this->clear_volume_slicing_caches();
     std::vector<VolumeSlices> objSliceByVolume;
     if (!slice_zs.empty()) {
-        objSliceByVolume = slice_volumes_inner(
-            print->config(), this->config(), this->trafo_centered(),
-            this->model_object()->volumes, m_shared_regions->layer_ranges, slice_zs, throw_on_cancel_callback);
+        try {
+            objSliceByVolume = slice_volumes_inner(
+                print->config(), this->config(), this->trafo_centered(),
+                this->model_object()->volumes, m_shared_regions->layer_ranges, slice_zs, throw_on_cancel_callback,
+                m_volume_slicing_indices, keep_caches ? &m_volume_slicing_caches : nullptr, m_volume_slicing_dirty_zs);
+        } catch (...) {
+            // A canceled slicing leaves the caches half updated.
+            this->clear_volume_slicing_caches();
+            throw;
+        }
+        size_t indices_memory_used = 0;
+        for (const auto &volume_index : m_volume_slicing_indices)
+            if (volume_index.second.index)
+                indices_memory_used += volume_index.second.index->memory_used();
+        if (indices_memory_used > volume_slicing_caches_max_memory) {
+            BOOST_LOG_TRIVIAL(debug) << "Slicing indices of object " << this->model_object()->name << " released, they hold " << indices_memory_used << " bytes";
+            m_volume_slicing_indices.clear();
+        }
+        if (keep_caches) {
+            size_t memory_used = 0;
+            for (const auto &volume_cache : m_volume_slicing_caches)
+                memory_used += volume_cache.second.cache.memory_used();
+            if (memory_used > volume_slicing_caches_max_memory) {
+                BOOST_LOG_TRIVIAL(debug) << "Slicing caches of object " << this->model_object()->name << " released, they hold " << memory_used << " bytes";
+                this->clear_volume_slicing_caches();
+            }
+        }
     }
 
     //BBS: "model_part" volumes are grouded according to their connections
@@ -1531,7 +1653,8 @@ std::vector<Polygons> PrintObject::slice_support_volumes(const ModelVolumeType m
         params.trafo = this->trafo_centered();
         for (; it_volume != it_volume_end; ++ it_volume)
             if ((*it_volume)->type() == model_volume_type) {
-                std::vector<ExPolygons> slices2 = slice_volume(*(*it_volume), zs, params, throw_on_cancel_callback);
+                PrintObject::VolumeSlicingIndex index;
+                std::vector<ExPolygons> slices2 = slice_volume(*(*it_volume), zs, params, index, throw_on_cancel_callback);
                 if (slices.empty()) {
                     slices.reserve(slices2.size());
                     for (ExPolygons &src : slices2)
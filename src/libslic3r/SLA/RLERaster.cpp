@@ -0,0 +1,181 @@
+#include <libslic3r/SLA/RLERaster.hpp>
+
+#include <agg/agg_color_gray.h>
+
+#include <cstring>
+
+namespace Slic3r { namespace sla {
+
+// Value of a pixel after blending white with the given coverage into it, the same as agg::pixfmt_gray8 does.
+static inline uint8_t blend_white(uint8_t dst, uint8_t cover)
+{
+    using TColor = agg::gray8;
+    return cover == agg::cover_mask ? TColor::base_mask :
+                                      TColor::lerp(dst, TColor::base_mask, TColor::mult_cover(TColor::base_mask, cover));
+}
+
+// Append a run, join it with the previous one if they touch and have the same value. Black runs are dropped.
+static inline void emit_run(std::vector<RasterGrayscaleRLE::Run> &out, uint32_t x, uint32_t len, uint8_t value)
+{
+    if (len == 0 || value == 0)
+        return;
+    if (! out.empty() && out.back().x + out.back().len == x && out.back().value == value)
+        out.back().len += len;
+    else
+        out.push_back({ x, len, value });
+}
+
+// Blend the covers of a scanline into the runs of a row. Both are sorted and not overlapping.
+static void merge_runs(const std::vector<RasterGrayscaleRLE::Run> &dst, const std::vector<RasterGrayscaleRLE::Run> &covers, std::vector<RasterGrayscaleRLE::Run> &out)
+{
+    using Run = RasterGrayscaleRLE::Run;
+    out.clear();
+    size_t i = 0, j = 0;
+    Run    a = dst.empty() ? Run{} : dst.front();
+    Run    b = covers.empty() ? Run{} : covers.front();
+    auto next_a = [&]() { if (++ i < dst.size()) a = dst[i]; };
+    auto next_b = [&]() { if (++ j < covers.size()) b = covers[j]; };
+    while (i < dst.size() || j < covers.size()) {
+        if (j == covers.size() || (i < dst.size() && a.x + a.len <= b.x)) {
+            emit_run(out, a.x, a.len, a.value);
+            next_a();
+        } else if (i == dst.size() || b.x + b.len <= a.x) {
+            emit_run(out, b.x, b.len, blend_white(0, b.value));
+            next_b();
+        } else if (a.x < b.x) {
+            emit_run(out, a.x, b.x - a.x, a.value);
+            a.len -= b.x - a.x;
+            a.x    = b.x;
+        } else if (b.x < a.x) {
+            emit_run(out, b.x, a.x - b.x, blend_white(0, b.value));
+            b.len -= a.x - b.x;
+            b.x    = a.x;
+        } else {
+            const uint32_t len = std::min(a.len, b.len);
+            emit_run(out, a.x, len, blend_white(a.value, b.value));
+            a.x += len; a.len -= len;
+            b.x += len; b.len -= len;
+            if (a.len == 0)
+                next_a();
+            if (b.len == 0)
+                next_b();
+        }
+    }
+}
+
+agg::path_storage RasterGrayscaleRLE::to_path(const Polygon &poly) const
+{
+    // The same transformation as of AGGRaster::to_path(), so that both rasters produce the same pixels.
+    auto px = [this](const Point &p) { return p(0) * m_pxdim_scaled.w_mm; };
+    auto py = [this](const Point &p) { return p(1) * m_pxdim_scaled.h_mm; };
+
+    agg::path_storage path;
+    const Points &pts = poly.points;
+    auto it = pts.begin();
+    if (m_trafo.flipXY) {
+        path.move_to(py(*it), px(*it));
+        while (++ it != pts.end()) path.line_to(py(*it), px(*it));
+        path.line_to(py(pts.front()), px(pts.front()));
+    } else {
+        path.move_to(px(*it), py(*it));
+        while (++ it != pts.end()) path.line_to(px(*it), py(*it));
+        path.line_to(px(pts.front()), py(pts.front()));
+    }
+
+    path.translate_all_paths(m_trafo.center_x * m_pxdim_scaled.w_mm,
+                             m_trafo.center_y * m_pxdim_scaled.h_mm);
+
+    if (m_trafo.mirror_x) path.flip_x(0, double(m_resolution.width_px));
+    if (m_trafo.mirror_y) path.flip_y(0, double(m_resolution.height_px));
+
+    return path;
+}
+
+void RasterGrayscaleRLE::blend_scanline(const agg::scanline_p8 &sl)
+{
+    const int y = sl.y();
+    if (y < 0 || y >= int(m_resolution.height_px))
+        return;
+
+    // Clip the spans to the raster, the runs of m_spans hold the covers, not the pixel values.
+    const int width = int(m_resolution.width_px);
+    m_spans.clear();
+    auto span = sl.begin();
+    for (unsigned num_spans = sl.num_spans(); num_spans > 0; -- num_spans, ++ span) {
+        const bool solid = span->len < 0;
+        const int  x     = span->x;
+        const int  len   = solid ? - span->len : span->len;
+        const int  x0    = std::max(x, 0);
+        const int  x1    = std::min(x + len, width);
+        if (x0 >= x1)
+            continue;
+        if (solid)
+            emit_run(m_spans, uint32_t(x0), uint32_t(x1 - x0), span->covers[0]);
+        else
+            for (int px = x0; px < x1; ++ px)
+                emit_run(m_spans, uint32_t(px), 1, span->covers[px - x]);
+    }
+
+    if (! m_spans.empty()) {
+        std::vector<Run> &row = m_rows[size_t(y)];
+        merge_runs(row, m_spans, m_merged);
+        row.swap(m_merged);
+    }
+}
+
+void RasterGrayscaleRLE::draw(const ExPolygon &poly)
+{
+    m_rasterizer.reset();
+
+    m_rasterizer.add_path(to_path(poly.contour));
+    for (const Polygon &h : poly.holes) m_rasterizer.add_path(to_path(h));
+
+    // The same as agg::render_scanlines(), the scanlines are blended into the runs.
+    if (m_rasterizer.rewind_scanlines()) {
+        m_scanline.reset(m_rasterizer.min_x(), m_rasterizer.max_x());
+        while (m_rasterizer.sweep_scanline(m_scanline))
+            this->blend_scanline(m_scanline);
+    }
+}
+
+EncodedRaster RasterGrayscaleRLE::encode(RasterEncoder encoder) const
+{
+    if (encoder.target<PNGRasterEncoder>() != nullptr)
+        return encode_png_grayscale(m_resolution.width_px, m_resolution.height_px,
+                                    [this](size_t row, uint8_t *dst) { this->decode_row(row, dst); });
+
+    std::vector<uint8_t> buf(m_resolution.pixels());
+    for (size_t row = 0; row < m_resolution.height_px; ++ row)
+        this->decode_row(row, buf.data() + row * m_resolution.width_px);
+    return encoder(buf.data(), m_resolution.width_px, m_resolution.height_px, 1);
+}
+
+uint8_t RasterGrayscaleRLE::read_pixel(size_t col, size_t row) const
+{
+    const std::vector<Run> &runs = m_rows[row];
+    auto it = std::upper_bound(runs.begin(), runs.end(), col, [](size_t x, const Run &run) { return x < run.x; });
+    return it != runs.begin() && col < (-- it)->x + it->len ? it->value : 0;
+}
+
+void RasterGrayscaleRLE::decode_row(size_t row, uint8_t *dst) const
+{
+    std::memset(dst, 0, m_resolution.width_px);
+    for (const Run &run : m_rows[row])
+        std::memset(dst + run.x, run.value, run.len);
+}
+
+size_t RasterGrayscaleRLE::memory_used() const
+{
+    size_t bytes = m_rows.capacity() * sizeof(std::vector<Run>);
+    for (const std::vector<Run> &runs : m_rows)
+        bytes += runs.capacity() * sizeof(Run);
+    return bytes;
+}
+
+void RasterGrayscaleRLE::clear()
+{
+    for (std::vector<Run> &runs : m_rows)
+        runs.clear();
+}
+
+}} // namespace Slic3r::sla
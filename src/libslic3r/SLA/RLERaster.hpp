@@ -0,0 +1,94 @@
+#ifndef SLA_RLERASTER_HPP
+#define SLA_RLERASTER_HPP
+
+#include <libslic3r/SLA/RasterBase.hpp>
+#include "libslic3r/ExPolygon.hpp"
+
+// For rasterizing
+#include <agg/agg_basics.h>
+#include <agg/agg_scanline_p.h>
+#include <agg/agg_rasterizer_scanline_aa.h>
+#include <agg/agg_path_storage.h>
+
+namespace Slic3r {
+namespace sla {
+
+/*
+ * Anti-aliased monochrome canvas producing the same pixels as RasterGrayscaleAA,
+ * but stored as runs of pixels of the same value per row instead of a frame buffer.
+ *
+ * The SLA layers are mostly black with large uniformly white areas, thus the memory
+ * and the time to draw and to compress the raster scale with the length of the contours
+ * rather than with the display resolution. The scanlines of the AGG rasterizer are blended
+ * into the runs directly and the PNG encoder is fed row by row.
+ */
+class RasterGrayscaleRLE : public RasterBase {
+public:
+    // Pixels <x, x + len) of a row have the value, pixels not covered by any run are black.
+    struct Run {
+        uint32_t x;
+        uint32_t len;
+        uint8_t  value;
+    };
+
+    template<class GammaFn>
+    RasterGrayscaleRLE(const Resolution        &res,
+                       const PixelDim          &pd,
+                       const RasterBase::Trafo &trafo,
+                       GammaFn                &&gammafn)
+        : m_resolution(res)
+        , m_pxdim_scaled(SCALING_FACTOR, SCALING_FACTOR)
+        , m_trafo(trafo)
+        , m_rows(res.height_px)
+    {
+        // Visual Studio compiler gives warnings about possible division by zero.
+        assert(pd.w_mm != 0 && pd.h_mm != 0);
+        if (pd.w_mm != 0 && pd.h_mm != 0) {
+            m_pxdim_scaled.w_mm /= pd.w_mm;
+            m_pxdim_scaled.h_mm /= pd.h_mm;
+        }
+        m_rasterizer.gamma(gammafn);
+    }
+
+    Trafo      trafo() const override { return m_trafo; }
+    Resolution resolution() const { return m_resolution; }
+    PixelDim   pixel_dimensions() const
+    {
+        return {SCALING_FACTOR / m_pxdim_scaled.w_mm,
+                SCALING_FACTOR / m_pxdim_scaled.h_mm};
+    }
+
+    void draw(const ExPolygon &poly) override;
+
+    // PNGRasterEncoder is fed row by row, the other encoders get the full frame.
+    EncodedRaster encode(RasterEncoder encoder) const override;
+
+    const std::vector<Run>& row(size_t row) const { return m_rows[row]; }
+    uint8_t read_pixel(size_t col, size_t row) const;
+    // Write the pixels of a row into dst of resolution().width_px bytes.
+    void    decode_row(size_t row, uint8_t *dst) const;
+
+    // Memory allocated for the runs.
+    size_t  memory_used() const;
+
+    void    clear();
+
+private:
+    agg::path_storage to_path(const Polygon &poly) const;
+    void              blend_scanline(const agg::scanline_p8 &sl);
+
+    Resolution                     m_resolution;
+    PixelDim                       m_pxdim_scaled;    // used for scaled coordinate polygons
+    Trafo                          m_trafo;
+    std::vector<std::vector<Run>>  m_rows;
+
+    agg::rasterizer_scanline_aa<>  m_rasterizer;
+    agg::scanline_p8               m_scanline;
+    // Spans of the current scanline and the merged row, kept to reuse their memory.
+    std::vector<Run>               m_spans;
+    std::vector<Run>               m_merged;
+};
+
+}} // namespace Slic3r::sla
+
+#endif // SLA_RLERASTER_HPP
@@ -5,6 +5,7 @@
 
 #include <libslic3r/SLA/RasterBase.hpp>
 #include <libslic3r/SLA/AGGRaster.hpp>
+#include <libslic3r/SLA/RLERaster.hpp>
 
 // minz image write:
 #include <miniz.h>
@@ -33,6 +34,61 @@ EncodedRaster PNGRasterEncoder::operator()(const void *ptr, size_t w, size_t h,
     return EncodedRaster(std::move(buf), "png");
 }
 
+EncodedRaster encode_png_grayscale(size_t w, size_t h, const std::function<void(size_t, uint8_t*)> &fill_row)
+{
+    // Follows tdefl_write_image_to_png_file_in_memory() at its default compression level,
+    // but the image rows are produced on demand and the output grows with the compressed size.
+    static constexpr mz_uint num_probes = 128;
+    static constexpr size_t  header_size = 41;
+
+    std::vector<uint8_t> buf(header_size, 0);
+    std::unique_ptr<tdefl_compressor, void(*)(tdefl_compressor*)> comp(tdefl_compressor_alloc(), tdefl_compressor_free);
+    if (! comp)
+        return EncodedRaster({}, "png");
+
+    auto putter = [](const void *data, int len, void *user) -> mz_bool {
+        auto &out = *static_cast<std::vector<uint8_t>*>(user);
+        out.insert(out.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + len);
+        return MZ_TRUE;
+    };
+    tdefl_init(comp.get(), putter, &buf, num_probes | TDEFL_WRITE_ZLIB_HEADER);
+
+    // Filter type byte followed by the pixels of the row.
+    std::vector<uint8_t> row(w + 1, 0);
+    for (size_t y = 0; y < h; ++ y) {
+        fill_row(y, row.data() + 1);
+        tdefl_compress_buffer(comp.get(), row.data(), row.size(), TDEFL_NO_FLUSH);
+    }
+    if (tdefl_compress_buffer(comp.get(), nullptr, 0, TDEFL_FINISH) != TDEFL_STATUS_DONE)
+        return EncodedRaster({}, "png");
+
+    auto put_u32 = [](uint8_t *dst, uint32_t v) {
+        for (int i = 0; i < 4; ++ i, v <<= 8)
+            dst[i] = uint8_t(v >> 24);
+    };
+    const size_t data_len = buf.size() - header_size;
+    // PNG signature, IHDR chunk of an 8 bit grayscale image and the IDAT chunk header.
+    uint8_t hdr[header_size] = { 0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00,
+                                 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x00,
+                                 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x49, 0x44, 0x41,
+                                 0x54 };
+    hdr[18] = uint8_t(w >> 8);
+    hdr[19] = uint8_t(w);
+    hdr[22] = uint8_t(h >> 8);
+    hdr[23] = uint8_t(h);
+    put_u32(hdr + 29, uint32_t(mz_crc32(MZ_CRC32_INIT, hdr + 12, 17)));
+    put_u32(hdr + 33, uint32_t(data_len));
+    std::copy(hdr, hdr + header_size, buf.begin());
+
+    // IDAT CRC-32 followed by the IEND chunk.
+    static const uint8_t footer[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82 };
+    buf.insert(buf.end(), std::begin(footer), std::end(footer));
+    put_u32(buf.data() + buf.size() - 16, uint32_t(mz_crc32(MZ_CRC32_INIT, buf.data() + header_size - 4, data_len + 4)));
+
+    return EncodedRaster(std::move(buf), "png");
+}
+
 std::ostream &operator<<(std::ostream &stream, const EncodedRaster &bytes)
 {
     stream.write(reinterpret_cast<const char *>(bytes.data()),
@@ -80,6 +136,18 @@ std::unique_ptr<RasterBase> create_raster_grayscale_aa(
     return rst;
 }
 
+std::unique_ptr<RasterBase> create_raster_grayscale_rle(
+    const Resolution        &res,
+    const PixelDim          &pxdim,
+    double                   gamma,
+    const RasterBase::Trafo &tr)
+{
+    if (gamma > 0)
+        return std::make_unique<RasterGrayscaleRLE>(res, pxdim, tr, agg::gamma_power(gamma));
+    else
+        return std::make_unique<RasterGrayscaleRLE>(res, pxdim, tr, agg::gamma_threshold(.5));
+}
+
 } // namespace sla
 } // namespace Slic3r
 
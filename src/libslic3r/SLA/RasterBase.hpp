@@ -7,6 +7,8 @@
 #include <array>
 #include <utility>
 #include <cstdint>
+#include <functional>
+#include <string>
 
 #include <libslic3r/ExPolygon.hpp>
 
@@ -104,6 +106,10 @@ struct PPMRasterEncoder {
     EncodedRaster operator()(const void *ptr, size_t w, size_t h, size_t num_components);
 };
 
+// Grayscale PNG written row by row, fill_row(row, dst) writes the width pixels of the row into dst.
+// The output is the same as of PNGRasterEncoder, without the frame buffer of the whole image.
+EncodedRaster encode_png_grayscale(size_t w, size_t h, const std::function<void(size_t, uint8_t*)> &fill_row);
+
 std::ostream& operator<<(std::ostream &stream, const EncodedRaster &bytes);
 
 // If gamma is zero, thresholding will be performed which disables AA.
@@ -113,6 +119,13 @@ std::unique_ptr<RasterBase> create_raster_grayscale_aa(
     double                   gamma = 1.0,
     const RasterBase::Trafo &tr    = {});
 
+// The same raster as create_raster_grayscale_aa(), kept as runs of pixels instead of a frame buffer.
+std::unique_ptr<RasterBase> create_raster_grayscale_rle(
+    const Resolution        &res,
+    const PixelDim          &pxdim,
+    double                   gamma = 1.0,
+    const RasterBase::Trafo &tr    = {});
+
 }} // namespace Slic3r::sla
 
 #endif // SLARASTERBASE_HPP
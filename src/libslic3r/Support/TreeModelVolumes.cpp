@@ -114,6 +114,11 @@ TreeModelVolumes::TreeModelVolumes(
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
                 outlines[layer_idx] = polygons_simplify(to_polygons(print_object.get_layer(layer_idx - num_raft_layers)->lslices), mesh_settings.resolution, polygons_strictly_simple);
         });
+        // Allocate all the layers of the caches, so that the precalculation does not need to grow them while inserting from multiple threads.
+        for (RadiusLayerPolygonCache *cache : { &m_collision_cache, &m_collision_cache_holefree, &m_avoidance_cache, &m_avoidance_cache_slow,
+                &m_avoidance_cache_to_model, &m_avoidance_cache_to_model_slow, &m_placeable_areas_cache, &m_avoidance_cache_holefree,
+                &m_avoidance_cache_holefree_to_model, &m_wall_restrictions_cache, &m_wall_restrictions_cache_min })
+            cache->allocate_layers(num_layers);
     }
 #endif
 
@@ -154,7 +159,75 @@ TreeModelVolumes::TreeModelVolumes(
 #endif
 }
 
-void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord_t max_layer, std::function<void()> throw_on_cancel)
+int TreeModelVolumes::reuse_caches(TreeModelVolumes &&previous)
+{
+    auto same_outlines = [](const std::pair<TreeSupportMeshGroupSettings, std::vector<Polygons>> &l, const std::pair<TreeSupportMeshGroupSettings, std::vector<Polygons>> &r) {
+        // Only the settings used by calculateCollision() are compared.
+        return l.first.layer_height == r.first.layer_height && l.first.resolution == r.first.resolution &&
+               l.first.support_xy_distance == r.first.support_xy_distance && 
+               l.first.support_top_distance == r.first.support_top_distance && l.first.support_bottom_distance == r.first.support_bottom_distance &&
+               l.second == r.second;
+    };
+    if (m_min_resolution != previous.m_min_resolution || m_current_outline_idx != previous.m_current_outline_idx ||
+        m_current_min_xy_dist != previous.m_current_min_xy_dist || m_current_min_xy_dist_delta != previous.m_current_min_xy_dist_delta ||
+        m_support_rests_on_model != previous.m_support_rests_on_model || m_raft_layers != previous.m_raft_layers ||
+        m_machine_border != previous.m_machine_border || m_anti_overhang != previous.m_anti_overhang ||
+        ! std::equal(m_layer_outlines.begin(), m_layer_outlines.end(), previous.m_layer_outlines.begin(), previous.m_layer_outlines.end(), same_outlines))
+        return 0;
+
+    // The placeable areas of radius zero are calculated together with the collisions.
+    m_collision_cache       = std::move(previous.m_collision_cache);
+    m_placeable_areas_cache = std::move(previous.m_placeable_areas_cache);
+    if (m_radius_0 != previous.m_radius_0 || m_ignorable_radii != previous.m_ignorable_radii ||
+        m_increase_until_radius != previous.m_increase_until_radius || m_max_move != previous.m_max_move || m_max_move_slow != previous.m_max_move_slow) {
+        m_placeable_areas_cache.clear_all_but_radius0();
+        return 1;
+    }
+
+    m_wall_restrictions_cache           = std::move(previous.m_wall_restrictions_cache);
+    m_wall_restrictions_cache_min       = std::move(previous.m_wall_restrictions_cache_min);
+    m_collision_cache_holefree          = std::move(previous.m_collision_cache_holefree);
+    m_avoidance_cache                   = std::move(previous.m_avoidance_cache);
+    m_avoidance_cache_slow              = std::move(previous.m_avoidance_cache_slow);
+    m_avoidance_cache_to_model          = std::move(previous.m_avoidance_cache_to_model);
+    m_avoidance_cache_to_model_slow     = std::move(previous.m_avoidance_cache_to_model_slow);
+    m_avoidance_cache_holefree          = std::move(previous.m_avoidance_cache_holefree);
+    m_avoidance_cache_holefree_to_model = std::move(previous.m_avoidance_cache_holefree_to_model);
+    return 2;
+}
+
+size_t TreeModelVolumes::memory_used() const
+{
+    size_t out = 0;
+    for (const RadiusLayerPolygonCache *cache : { &m_collision_cache, &m_collision_cache_holefree, &m_avoidance_cache, &m_avoidance_cache_slow,
+            &m_avoidance_cache_to_model, &m_avoidance_cache_to_model_slow, &m_placeable_areas_cache, &m_avoidance_cache_holefree,
+            &m_avoidance_cache_holefree_to_model, &m_wall_restrictions_cache, &m_wall_restrictions_cache_min })
+        out += cache->memory_used();
+    return out;
+}
+
+std::vector<coord_t> TreeModelVolumes::calculate_ignorable_radii(const TreeSupportSettings &config) const
+{
+    std::vector<coord_t> out;
+    auto ceil = [this, &out](coord_t radius) { return ceil_radius(radius, m_radius_0, out); };
+    // calculate which radius each layer in the tip may have.
+    std::vector<coord_t> possible_tip_radiis;
+    for (size_t distance_to_top = 0; distance_to_top <= config.tip_layers; ++ distance_to_top) {
+        possible_tip_radiis.emplace_back(ceil(config.getRadius(distance_to_top)));
+        possible_tip_radiis.emplace_back(ceil(config.getRadius(distance_to_top) + m_current_min_xy_dist_delta));
+    }
+    sort_remove_duplicates(possible_tip_radiis);
+    // It theoretically may happen in the tip, that the radius can change so much in-between 2 layers, 
+    // that a ceil step is skipped (as in there is a radius r so that ceilRadius(radius(dtt))<ceilRadius(r)<ceilRadius(radius(dtt+1))). 
+    // As such a radius will not reasonable happen in the tree and it will most likely not be requested,
+    // there is no need to calculate them. So just skip these.
+    for (coord_t radius_eval = m_radius_0; radius_eval <= config.branch_radius; radius_eval = ceil(radius_eval + 1))
+        if (! std::binary_search(possible_tip_radiis.begin(), possible_tip_radiis.end(), radius_eval))
+            out.emplace_back(radius_eval);
+    return out;
+}
+
+void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord_t max_layer, std::function<void()> throw_on_cancel, TreeModelVolumes *previous)
 {
     auto t_start = std::chrono::high_resolution_clock::now();
     m_precalculated = true;
@@ -164,21 +237,12 @@ void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord
     // like inital layer diameter are only done in once.
     TreeSupportSettings config(m_layer_outlines[m_current_outline_idx].first, print_object.slicing_parameters());
 
-    {
-        // calculate which radius each layer in the tip may have.
-        std::vector<coord_t> possible_tip_radiis;
-        for (size_t distance_to_top = 0; distance_to_top <= config.tip_layers; ++ distance_to_top) {
-            possible_tip_radiis.emplace_back(ceilRadius(config.getRadius(distance_to_top)));
-            possible_tip_radiis.emplace_back(ceilRadius(config.getRadius(distance_to_top) + m_current_min_xy_dist_delta));
-        }
-        sort_remove_duplicates(possible_tip_radiis);
-        // It theoretically may happen in the tip, that the radius can change so much in-between 2 layers, 
-        // that a ceil step is skipped (as in there is a radius r so that ceilRadius(radius(dtt))<ceilRadius(r)<ceilRadius(radius(dtt+1))). 
-        // As such a radius will not reasonable happen in the tree and it will most likely not be requested,
-        // there is no need to calculate them. So just skip these.
-        for (coord_t radius_eval = m_radius_0; radius_eval <= config.branch_radius; radius_eval = ceilRadius(radius_eval + 1))
-            if (! std::binary_search(possible_tip_radiis.begin(), possible_tip_radiis.end(), radius_eval))
-                m_ignorable_radii.emplace_back(radius_eval);
+    m_ignorable_radii = this->calculate_ignorable_radii(config);
+
+    // Reuse the areas of the previous support generation, now that ceilRadius() rounds the same way as it will while generating the supports.
+    if (previous != nullptr) {
+        m_reused_caches = this->reuse_caches(std::move(*previous));
+        BOOST_LOG_TRIVIAL(info) << "Tree support: " << (m_reused_caches == 0 ? "not reusing" : m_reused_caches == 1 ? "reusing the collision areas of" : "reusing all the areas of") << " the previous support generation";
     }
 
     if (throw_on_cancel)
@@ -251,7 +315,9 @@ void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord
     auto dur_avo = 0.001 * std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_coll).count();
 
 //    m_precalculated = true;
-    BOOST_LOG_TRIVIAL(info) << "Precalculating collision took" << dur_col << " ms. Precalculating avoidance took " << dur_avo << " ms.";
+    CacheStats stats = this->cache_stats();
+    BOOST_LOG_TRIVIAL(info) << "Precalculating collision took" << dur_col << " ms. Precalculating avoidance took " << dur_avo << " ms. " <<
+        stats.inserts << " cache inserts, " << stats.contended_inserts << " of them contended.";
 
 #if 0
     // Paint caches into SVGs:
@@ -832,16 +898,16 @@ void TreeModelVolumes::calculateWallRestrictions(const std::vector<RadiusLayerPa
     });
 }
 
-coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
+coord_t TreeModelVolumes::ceil_radius(const coord_t radius, const coord_t radius_0, const std::vector<coord_t> &ignorable_radii)
 {
     if (radius == 0)
         return 0;
 
-    coord_t out = m_radius_0;
-    if (radius > m_radius_0) {
+    coord_t out = radius_0;
+    if (radius > radius_0) {
         // generate SUPPORT_TREE_PRE_EXPONENTIAL_STEPS of radiis before starting to exponentially increase them.
-        coord_t initial_radius_delta = SUPPORT_TREE_EXPONENTIAL_THRESHOLD - m_radius_0;
-        auto ignore = [this](coord_t r) { return std::binary_search(m_ignorable_radii.begin(), m_ignorable_radii.end(), r); };
+        coord_t initial_radius_delta = SUPPORT_TREE_EXPONENTIAL_THRESHOLD - radius_0;
+        auto ignore = [&ignorable_radii](coord_t r) { return std::binary_search(ignorable_radii.begin(), ignorable_radii.end(), r); };
         if (initial_radius_delta > SUPPORT_TREE_COLLISION_RESOLUTION) {
             const int num_steps = round_up_divide(initial_radius_delta, SUPPORT_TREE_EXPONENTIAL_THRESHOLD);
             const int stepsize  = initial_radius_delta / num_steps;
@@ -861,25 +927,135 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
     return out;
 }
 
+bool TreeModelVolumes::RadiusLayerPolygonCache::LayerData::insert(coord_t radius, Polygons &&polygons, bool &contended)
+{
+    std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+    contended = ! lock.owns_lock();
+    if (contended)
+        lock.lock();
+    if (this->find(radius) != nullptr)
+        return false;
+    // Find or allocate the block of the new entry.
+    const size_t         idx   = m_size.load(std::memory_order_relaxed);
+    std::atomic<Block*> *link  = &m_first;
+    Block               *block = nullptr;
+    for (size_t block_begin = 0;; block_begin += BlockSize) {
+        block = link->load(std::memory_order_relaxed);
+        if (block == nullptr) {
+            block = new Block();
+            link->store(block, std::memory_order_release);
+        }
+        if (idx < block_begin + BlockSize)
+            break;
+        link = &block->next;
+    }
+    Entry &entry   = block->entries[idx % BlockSize];
+    entry.radius   = radius;
+    entry.polygons = std::move(polygons);
+    // Publish the new entry to the readers.
+    m_size.store(idx + 1, std::memory_order_release);
+    return true;
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::LayerData::clear()
+{
+    for (Block *block = m_first.load(std::memory_order_relaxed); block != nullptr;) {
+        Block *next = block->next.load(std::memory_order_relaxed);
+        delete block;
+        block = next;
+    }
+    m_first.store(nullptr, std::memory_order_relaxed);
+    m_size.store(0, std::memory_order_relaxed);
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::LayerData::clear_all_but_smallest_radius()
+{
+    coord_t  radius = 0;
+    Polygons smallest;
+    bool     found  = false;
+    this->visit([&radius, &smallest, &found](coord_t r, const Polygons &polygons) {
+        if (! found || r < radius) {
+            radius   = r;
+            smallest = polygons;
+            found    = true;
+        }
+        return true;
+    });
+    this->clear();
+    if (found) {
+        bool contended;
+        this->insert(radius, std::move(smallest), contended);
+    }
+}
+
 void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layers)
 {
-    if (num_layers > m_data.size()) {
-        if (num_layers > m_data.capacity())
-            reserve_power_of_2(m_data, num_layers);
-        m_data.resize(num_layers, {});
+    if (num_layers > m_num_layers.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> guard(m_allocate_mutex);
+        if (num_layers > m_data.size()) {
+            m_data.grow_to_at_least(num_layers);
+            m_num_layers.store(m_data.size(), std::memory_order_release);
+        }
     }
 }
 
+size_t TreeModelVolumes::RadiusLayerPolygonCache::memory_used() const
+{
+    size_t out = 0;
+    for (LayerIndex layer_idx = 0; layer_idx < LayerIndex(m_num_layers.load(std::memory_order_acquire)); ++ layer_idx)
+        m_data[layer_idx].visit([&out](coord_t, const Polygons &polygons) {
+            out += polygons.capacity() * sizeof(Polygon);
+            for (const Polygon &polygon : polygons)
+                out += polygon.points.capacity() * sizeof(Point);
+            return true;
+        });
+    return out;
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons)
+{
+    allocate_layers(layer_idx + 1);
+    bool contended = false;
+    if (m_data[layer_idx].insert(radius, std::move(polygons), contended)) {
+        m_num_inserts.fetch_add(1, std::memory_order_relaxed);
+        if (contended)
+            m_num_contended_inserts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::swap(RadiusLayerPolygonCache &rhs)
+{
+    m_data.swap(rhs.m_data);
+    m_num_layers            = rhs.m_num_layers.exchange(m_num_layers.load());
+    m_num_inserts           = rhs.m_num_inserts.exchange(m_num_inserts.load());
+    m_num_contended_inserts = rhs.m_num_contended_inserts.exchange(m_num_contended_inserts.load());
+}
+
 // For debugging purposes, sorted by layer index, then by radius.
 std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::sorted() const
 {
     std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> out;
-    for (auto &layer : m_data) {
-        auto layer_idx = LayerIndex(&layer - m_data.data());
-        for (auto &radius_polygons : layer)
-            out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
+    for (LayerIndex layer_idx = 0; layer_idx < LayerIndex(m_num_layers.load()); ++ layer_idx) {
+        size_t first = out.size();
+        m_data[layer_idx].visit([&out, layer_idx](coord_t radius, const Polygons &polygons) {
+            out.emplace_back(std::make_pair(radius, layer_idx), polygons);
+            return true;
+        });
+        std::sort(out.begin() + first, out.end(), [](auto &l, auto &r) { return l.first.first < r.first.first; });
+    }
+    return out;
+}
+
+TreeModelVolumes::CacheStats TreeModelVolumes::cache_stats() const
+{
+    CacheStats out;
+    for (const RadiusLayerPolygonCache *cache : { &m_collision_cache, &m_collision_cache_holefree, &m_avoidance_cache, &m_avoidance_cache_slow,
+            &m_avoidance_cache_to_model, &m_avoidance_cache_to_model_slow, &m_placeable_areas_cache, &m_avoidance_cache_holefree,
+            &m_avoidance_cache_holefree_to_model, &m_wall_restrictions_cache, &m_wall_restrictions_cache_min }) {
+        RadiusLayerPolygonCache::Stats stats = cache->stats();
+        out.inserts           += stats.inserts;
+        out.contended_inserts += stats.contended_inserts;
     }
-    assert(std::is_sorted(out.begin(), out.end(), [](auto &l, auto &r){ return l.first.second < r.first.second || (l.first.second == r.first.second) && l.first.first < r.first.first; }));
     return out;
 }
 
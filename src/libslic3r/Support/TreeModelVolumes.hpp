@@ -9,11 +9,15 @@
 #ifndef slic3r_TreeModelVolumes_hpp
 #define slic3r_TreeModelVolumes_hpp
 
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
 
+#include <tbb/concurrent_vector.h>
+
 #include "TreeSupportCommon.hpp"
 
 #include "../Point.hpp"
@@ -69,6 +73,8 @@ public:
         m_wall_restrictions_cache.clear();
         m_wall_restrictions_cache_min.clear();
     }
+    // Approximate memory taken by the areas of all the caches.
+    size_t memory_used() const;
 
     enum class AvoidanceType : int8_t
     {
@@ -83,8 +89,19 @@ public:
      *
      * Knowledge about branch angle is used to only calculate avoidances and collisions that may actually be needed.
      * Not calling precalculate() will cause the class to lazily calculate avoidances and collisions as needed, which will be a lot slower on systems with more then one or two cores!
+     * \param previous Volumes of a previous support generation of the same object, their caches are taken over if still valid, see reuse_caches().
      */
-    void precalculate(const PrintObject& print_object, const coord_t max_layer, std::function<void()> throw_on_cancel);
+    void precalculate(const PrintObject& print_object, const coord_t max_layer, std::function<void()> throw_on_cancel, TreeModelVolumes *previous = nullptr);
+
+    // Number of cache tiers taken over from the previous support generation by precalculate(): 0 (none), 1 (collision) or 2 (all).
+    int reused_caches() const { return m_reused_caches; }
+
+    // Inserts into all the radius and layer caches, and how many of them had to wait for another thread writing into the same layer.
+    struct CacheStats {
+        size_t inserts           { 0 };
+        size_t contended_inserts { 0 };
+    };
+    CacheStats cache_stats() const;
 
     /*!
      * \brief Provides the areas that have to be avoided by the tree's branches to prevent collision with the model on this layer.
@@ -197,43 +214,86 @@ private:
      * \brief Convenience typedef for the keys to the caches
      */
     using RadiusLayerPair             = std::pair<coord_t, LayerIndex>;
+    // Cache of one layer collision regions per layer and radius.
+    // Reading is lock free, the Polygons returned are stable to insertion and they are valid until the cache is cleared.
+    // Writing locks just the layer written to, and it publishes the new radius atomically.
     class RadiusLayerPolygonCache {
-        // Map from radius to Polygons. Cache of one layer collision regions.
-        using LayerData = std::map<coord_t, Polygons>;
-        // Vector of layers, at each layer map of radius to Polygons.
-        // Reference to Polygons returned shall be stable to insertion.
-        using Layers = std::vector<LayerData>;
+        // Append only table of radii and Polygons of one layer, allocated in blocks that never move.
+        class LayerData {
+        public:
+            LayerData() = default;
+            ~LayerData() { this->clear(); }
+            LayerData(const LayerData&) = delete;
+            LayerData& operator=(const LayerData&) = delete;
+
+            // Visit the published entries until the visitor returns false.
+            template<typename Visitor>
+            void visit(Visitor &&visitor) const {
+                const size_t size  = m_size.load(std::memory_order_acquire);
+                const Block *block = m_first.load(std::memory_order_acquire);
+                for (size_t i = 0; i < size; ++ i) {
+                    if (i > 0 && i % BlockSize == 0)
+                        block = block->next.load(std::memory_order_acquire);
+                    const Entry &entry = block->entries[i % BlockSize];
+                    if (! visitor(entry.radius, entry.polygons))
+                        return;
+                }
+            }
+            const Polygons* find(coord_t radius) const {
+                const Polygons *out = nullptr;
+                this->visit([radius, &out](coord_t r, const Polygons &polygons) { if (r == radius) out = &polygons; return out == nullptr; });
+                return out;
+            }
+            // Returns false if the radius is already present, then the polygons are not inserted.
+            // Sets contended if another thread was writing into this layer at the same time.
+            bool insert(coord_t radius, Polygons &&polygons, bool &contended);
+            // Not thread safe.
+            void clear();
+            void clear_all_but_smallest_radius();
+
+        private:
+            static constexpr size_t BlockSize = 8;
+            struct Entry {
+                coord_t  radius { 0 };
+                Polygons polygons;
+            };
+            struct Block {
+                std::array<Entry, BlockSize> entries;
+                std::atomic<Block*>          next { nullptr };
+            };
+
+            std::atomic<Block*>  m_first { nullptr };
+            std::atomic<size_t>  m_size { 0 };
+            std::mutex           m_mutex;
+        };
+
     public:
         RadiusLayerPolygonCache() = default;
-        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_data(std::move(rhs.m_data)) {}
-        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { m_data = std::move(rhs.m_data); return *this; }
+        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) { this->swap(rhs); }
+        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { this->swap(rhs); return *this; }
 
         RadiusLayerPolygonCache(const RadiusLayerPolygonCache&) = delete;
         RadiusLayerPolygonCache& operator=(const RadiusLayerPolygonCache&) = delete;
 
         void insert(std::vector<std::pair<RadiusLayerPair, Polygons>> &&in) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first.second).emplace(d.first.first, std::move(d.second));
+                this->insert(d.first.second, d.first.first, std::move(d.second));
         }
         // by layer
         void insert(std::vector<std::pair<coord_t, Polygons>> &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first).emplace(radius, std::move(d.second));
+                this->insert(d.first, radius, std::move(d.second));
         }
         void insert(std::vector<Polygons> &&in, coord_t first_layer_idx, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             allocate_layers(first_layer_idx + in.size());
             for (auto &d : in)
-                m_data[first_layer_idx ++].emplace(radius, std::move(d));
+                this->insert(first_layer_idx ++, radius, std::move(d));
         }
         void insert(LayerPolygonCache &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             LayerIndex i = in.begin();
             allocate_layers(i + LayerIndex(in.size()));
             for (auto &d : in.polygons_mutable())
-                m_data[i ++].emplace(radius, std::move(d));
+                this->insert(i ++, radius, std::move(d));
         }
         /*!
          * \brief Checks a cache for a given RadiusLayerPair and returns it if it is found
@@ -241,29 +301,28 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         std::optional<std::reference_wrapper<const Polygons>> getArea(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            if (key.second >= LayerIndex(m_num_layers.load(std::memory_order_acquire)))
                 return std::optional<std::reference_wrapper<const Polygons>>{};
-            const auto &layer = m_data[key.second];
-            auto it = layer.find(key.first);
-            return it == layer.end() ? 
-                std::optional<std::reference_wrapper<const Polygons>>{} : std::optional<std::reference_wrapper<const Polygons>>{ it->second };
+            const Polygons *polygons = m_data[key.second].find(key.first);
+            return polygons == nullptr ?
+                std::optional<std::reference_wrapper<const Polygons>>{} : std::optional<std::reference_wrapper<const Polygons>>{ *polygons };
         }
         // Get a collision area at a given layer for a radius that is a lower or equial to the key radius.
         std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            if (key.second >= LayerIndex(m_num_layers.load(std::memory_order_acquire)))
                 return {};
-            const auto &layer = m_data[key.second];
-            if (layer.empty())
+            coord_t         radius   = 0;
+            const Polygons *polygons = nullptr;
+            m_data[key.second].visit([&key, &radius, &polygons](coord_t r, const Polygons &p) {
+                if (r <= key.first && (polygons == nullptr || r > radius)) {
+                    radius   = r;
+                    polygons = &p;
+                }
+                return radius != key.first;
+            });
+            if (polygons == nullptr)
                 return {};
-            auto it = layer.lower_bound(key.first);
-            if (it == layer.end() || it->first != key.first) {
-                if (it == layer.begin())
-                    return {};
-                -- it;
-            }
-            return std::make_pair(it->first, std::reference_wrapper<const Polygons>(it->second));
+            return std::make_pair(radius, std::reference_wrapper<const Polygons>(*polygons));
         }
         /*!
          * \brief Get the highest already calculated layer in the cache.
@@ -273,10 +332,9 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         LayerIndex getMaxCalculatedLayer(coord_t radius) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            auto layer_idx = LayerIndex(m_data.size()) - 1;
+            auto layer_idx = LayerIndex(m_num_layers.load(std::memory_order_acquire)) - 1;
             for (; layer_idx > 0; -- layer_idx)
-                if (const auto &layer = m_data[layer_idx]; layer.find(radius) != layer.end())
+                if (m_data[layer_idx].find(radius) != nullptr)
                     break;
             // The placeable on model areas do not exist on layer 0, as there can not be model below it. As such it may be possible that layer 1 is available, but layer 0 does not exist.
             return layer_idx == 0 ? -1 : layer_idx;
@@ -285,25 +343,38 @@ private:
         // For debugging purposes, sorted by layer index, then by radius.
         [[nodiscard]] std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> sorted() const;
 
-        void clear() { m_data.clear(); }
-        void clear_all_but_radius0() { 
-            for (LayerData &l : m_data) {
-                auto begin = l.begin();
-                auto end = l.end();
-                if (begin != end && ++ begin != end)
-                    l.erase(begin, end);
-            }
+        // Number of inserts and of those, which had to wait for another thread writing into the same layer.
+        struct Stats {
+            size_t inserts           { 0 };
+            size_t contended_inserts { 0 };
+        };
+        Stats stats() const { return { m_num_inserts.load(std::memory_order_relaxed), m_num_contended_inserts.load(std::memory_order_relaxed) }; }
+
+        // Not thread safe.
+        void clear() { 
+            for (LayerData &l : m_data)
+                l.clear();
         }
-
-    private:
-        LayerData&          get_allocate_layer_data(LayerIndex layer_idx) {
-            allocate_layers(layer_idx + 1);
-            return m_data[layer_idx];
+        void clear_all_but_radius0() { 
+            for (LayerData &l : m_data)
+                l.clear_all_but_smallest_radius();
         }
+        // Allocate the layers ahead of the parallel inserts, so that the layers do not have to be added concurrently.
         void                allocate_layers(size_t num_layers);
+        // Approximate memory taken by the Polygons stored.
+        size_t              memory_used() const;
 
-        Layers              m_data;
-        mutable std::mutex  m_mutex;
+    private:
+        void                insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons);
+        void                swap(RadiusLayerPolygonCache &rhs);
+
+        // Vector of layers, each layer storing Polygons for a couple of radii. Elements of concurrent_vector never move.
+        tbb::concurrent_vector<LayerData> m_data;
+        // Number of layers fully constructed, the layers are added under m_allocate_mutex.
+        std::atomic<size_t>               m_num_layers { 0 };
+        std::mutex                        m_allocate_mutex;
+        std::atomic<size_t>               m_num_inserts { 0 };
+        std::atomic<size_t>               m_num_contended_inserts { 0 };
     };
 
 
@@ -326,7 +397,26 @@ private:
      *
      * \param radius The radius of the node of interest
      */
-    coord_t ceilRadius(const coord_t radius) const;
+    coord_t ceilRadius(const coord_t radius) const { return ceil_radius(radius, m_radius_0, m_ignorable_radii); }
+    static coord_t ceil_radius(coord_t radius, coord_t radius_0, const std::vector<coord_t> &ignorable_radii);
+
+    /*!
+     * \brief Radii that will never be requested, because the radius of a tip changes by more than a ceilRadius() step between two layers.
+     */
+    std::vector<coord_t> calculate_ignorable_radii(const TreeSupportSettings &config) const;
+
+    /*!
+     * \brief Take over the collision, avoidance and placeable areas calculated by a TreeModelVolumes of a previous support generation.
+     *
+     * The caches are keyed by radius and layer only, thus they are reused only if the layer outlines, support blockers, machine border
+     * and the settings the areas were calculated with are the same. Tweaking branch parameters only changes the radii requested.
+     * The collision areas and the placeable areas of radius zero are kept if the outlines and distances did not change.
+     * All the other areas are requested by radii rounded by ceilRadius() and some of them are calculated from collisions requested the same way,
+     * thus they are kept only if ceilRadius() rounds the same way, and if the maximum move distances and the hole removal radius did not change either.
+     * Called by precalculate() once m_ignorable_radii is known.
+     * \return Number of cache tiers reused: 0 (none), 1 (collision) or 2 (all).
+     */
+    int reuse_caches(TreeModelVolumes &&previous);
 
     /*!
      * \brief Creates the areas that have to be avoided by the tree's branches to prevent collision with the model on this layer.
@@ -430,6 +520,7 @@ private:
     coord_t m_min_resolution;
 
     bool m_precalculated = false;
+    int  m_reused_caches = 0;
     /*!
      * \brief The index to access the outline corresponding with the currently processing mesh
      */
@@ -3411,6 +3411,32 @@ TreeSupportData::TreeSupportData(const PrintObject &object, coordf_t xy_distance
     }
 }
 
+void TreeSupportData::reuse_caches(TreeSupportData &&previous)
+{
+    if (m_xy_distance != previous.m_xy_distance || m_radius_sample_resolution != previous.m_radius_sample_resolution ||
+        m_layer_outlines != previous.m_layer_outlines)
+        return;
+    m_collision_cache.swap(previous.m_collision_cache);
+    if (m_max_move_distances == previous.m_max_move_distances)
+        m_avoidance_cache.swap(previous.m_avoidance_cache);
+    BOOST_LOG_TRIVIAL(debug) << "TreeSupportData: reusing " << m_collision_cache.size() << " collision and " << m_avoidance_cache.size() << " avoidance areas";
+}
+
+size_t TreeSupportData::memory_used() const
+{
+    size_t out = 0;
+    for (const auto *cache : { &m_collision_cache, &m_avoidance_cache })
+        for (const auto &[key, expolys] : *cache) {
+            out += expolys.capacity() * sizeof(ExPolygon);
+            for (const ExPolygon &expoly : expolys) {
+                out += expoly.contour.points.capacity() * sizeof(Point) + expoly.holes.capacity() * sizeof(Polygon);
+                for (const Polygon &hole : expoly.holes)
+                    out += hole.points.capacity() * sizeof(Point);
+            }
+        }
+    return out;
+}
+
 const ExPolygons& TreeSupportData::get_collision(coordf_t radius, size_t layer_nr) const
 {
     profiler.tic();
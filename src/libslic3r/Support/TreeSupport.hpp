@@ -238,6 +238,18 @@ public:
      */
     const ExPolygons& get_avoidance(coordf_t radius, size_t layer_idx, int recursions=0) const;
 
+    /*!
+     * \brief Take over the collision and avoidance areas of the preview cache of a previous support generation.
+     *
+     * The collision areas are reused if the layer outlines, the xy distance and the radius sample resolution did not change,
+     * the avoidance areas if the branch angle did not change either.
+     */
+    void reuse_caches(TreeSupportData &&previous);
+    // Approximate memory taken by the collision and avoidance areas.
+    size_t memory_used() const;
+    // Release the avoidance areas, the collision areas are reused as long as the outlines did not change.
+    void clear_all_but_collision() { m_avoidance_cache.clear(); }
+
     Polygons get_contours(size_t layer_nr) const;
     Polygons get_contours_with_holes(size_t layer_nr) const;
 
@@ -23,6 +23,7 @@
 #include "TriangleMeshSlicer.hpp"
 #include "TreeSupport.hpp"
 #include "I18N.hpp"
+#include "Utils.hpp"
 
 #include <cassert>
 #include <chrono>
@@ -337,8 +338,9 @@ static std::vector<std::pair<TreeSupportSettings, std::vector<size_t>>> group_me
  *
  * \param storage[in] Background storage to access meshes.
  * \param currently_processing_meshes[in] Indexes of all meshes that are processed in this iteration
+ * \param previous_volumes[in] Volumes of the previous support generation to reuse the areas from, may be null.
  */
-[[nodiscard]] static LayerIndex precalculate(const Print &print, const std::vector<Polygons> &overhangs, const TreeSupportSettings &config, const std::vector<size_t> &object_ids, TreeModelVolumes &volumes, std::function<void()> throw_on_cancel)
+[[nodiscard]] static LayerIndex precalculate(const Print &print, const std::vector<Polygons> &overhangs, const TreeSupportSettings &config, const std::vector<size_t> &object_ids, TreeModelVolumes &volumes, std::function<void()> throw_on_cancel, TreeModelVolumes *previous_volumes)
 {
     // calculate top most layer that is relevant for support
     LayerIndex max_layer = 0;
@@ -354,7 +356,7 @@ static std::vector<std::pair<TreeSupportSettings, std::vector<size_t>>> group_me
     }
     if (max_layer > 0)
         // The actual precalculation happens in TreeModelVolumes.
-        volumes.precalculate(*print.get_object(object_ids.front()), max_layer, throw_on_cancel);
+        volumes.precalculate(*print.get_object(object_ids.front()), max_layer, throw_on_cancel, previous_volumes);
     return max_layer;
 }
 
@@ -3378,11 +3380,17 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
 #endif // SLIC3R_TREESUPPORT_PROGRESS
         PrintObject &print_object = *print.get_object(processing.second.front());
         // Generator for model collision, avoidance and internal guide volumes.
-        TreeModelVolumes volumes{ print_object, build_volume, config.maximum_move_distance, config.maximum_move_distance_slow, processing.second.front(),
+        auto volumes_ptr = std::make_shared<TreeModelVolumes>(print_object, build_volume, config.maximum_move_distance, config.maximum_move_distance_slow, processing.second.front(),
 #ifdef SLIC3R_TREESUPPORTS_PROGRESS
             m_progress_multiplier, m_progress_offset,
 #endif // SLIC3R_TREESUPPORTS_PROGRESS
-            /* additional_excluded_areas */{} };
+            /* additional_excluded_areas */ std::vector<Polygons>{});
+        TreeModelVolumes &volumes = *volumes_ptr;
+        // The collision and avoidance areas of the previous support generation are reused by precalculate() if the object outlines did not change.
+        std::shared_ptr<TreeModelVolumes> previous_volumes = print_object.tree_model_volumes();
+        print_object.set_tree_model_volumes(nullptr);
+        // Kept for the next support generation once all the areas of this one were calculated, trimmed to the memory budget by set_tree_model_volumes().
+        ScopeGuard keep_volumes([&print_object, volumes_ptr]() { print_object.set_tree_model_volumes(volumes_ptr); });
 
         //FIXME generating overhangs just for the first mesh of the group.
         assert(processing.second.size() == 1);
@@ -3422,7 +3430,8 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
         std::vector<Polygons>        overhangs = generate_overhangs(config, *print.get_object(processing.second.front()), throw_on_cancel);
 #endif
         // ### Precalculate avoidances, collision etc.
-        size_t num_support_layers = precalculate(print, overhangs, processing.first, processing.second, volumes, throw_on_cancel);
+        size_t num_support_layers = precalculate(print, overhangs, processing.first, processing.second, volumes, throw_on_cancel, previous_volumes.get());
+        previous_volumes.reset();
         bool   has_support = num_support_layers > 0;
         bool   has_raft    = config.raft_layers.size() > 0;
         num_support_layers = std::max(num_support_layers, config.raft_layers.size());
@@ -3655,8 +3664,7 @@ void organic_draw_branches(
 
     organic_smooth_branches_avoid_collisions(print_object, volumes, config, move_bounds, elements_with_link_down, linear_data_layers, throw_on_cancel);
 
-    // Reduce memory footprint. After this point only finalize_interface_and_support_areas() will use volumes and from that only collisions with zero radius will be used.
-    volumes.clear_all_but_object_collision();
+    // The volumes are not cleared to reduce the memory footprint, they are kept by the PrintObject to be reused by the next support generation.
 
     // Unmark all nodes.
     for (SupportElements &elements : move_bounds)
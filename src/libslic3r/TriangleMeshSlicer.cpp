@@ -17,6 +17,9 @@
 #include <boost/log/trivial.hpp>
 
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/task_arena.h>
 
 #ifndef NDEBUG
 //    #define EXPENSIVE_DEBUG_CHECKS
@@ -531,6 +534,166 @@ static inline std::vector<IntersectionLines> slice_make_lines(
     return lines;
 }
 
+FacetZIndex::FacetZIndex(const std::vector<Vec3f> &vertices, const std::vector<stl_triangle_vertex_indices> &indices)
+{
+    if (indices.empty())
+        return;
+
+    face_min_z.assign(indices.size(), 0.f);
+    face_max_z.assign(indices.size(), 0.f);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, indices.size()),
+        [this, &vertices, &indices](const tbb::blocked_range<size_t> &range) {
+            for (size_t face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
+                const stl_triangle_vertex_indices &face = indices[face_idx];
+                const float z0 = vertices[face(0)].z(), z1 = vertices[face(1)].z(), z2 = vertices[face(2)].z();
+                face_min_z[face_idx] = fminf(z0, fminf(z1, z2));
+                face_max_z[face_idx] = fmaxf(z0, fmaxf(z1, z2));
+            }
+        });
+
+    // Z span of the mesh and the sum of the heights of its faces, reduced deterministically to get the same buckets for the same mesh.
+    struct ZSpan {
+        float  z_min      { std::numeric_limits<float>::max() };
+        float  z_max      { std::numeric_limits<float>::lowest() };
+        double sum_height { 0. };
+    };
+    const ZSpan span = tbb::parallel_deterministic_reduce(
+        tbb::blocked_range<size_t>(0, indices.size(), 16384), ZSpan{},
+        [this](const tbb::blocked_range<size_t> &range, ZSpan span) {
+            for (size_t face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
+                span.z_min       = std::min(span.z_min, face_min_z[face_idx]);
+                span.z_max       = std::max(span.z_max, face_max_z[face_idx]);
+                span.sum_height += face_max_z[face_idx] - face_min_z[face_idx];
+            }
+            return span;
+        },
+        [](const ZSpan &l, const ZSpan &r) { return ZSpan{ std::min(l.z_min, r.z_min), std::max(l.z_max, r.z_max), l.sum_height + r.sum_height }; });
+    z_min = span.z_min;
+
+    // A bucket twice as high as an average face, so that a face is registered in about 1.5 buckets.
+    const size_t max_buckets   = 65536;
+    const float  height        = span.z_max - z_min;
+    const float  bucket_height = std::max(float(2. * span.sum_height / double(indices.size())), height / float(max_buckets));
+    const size_t num_buckets   = bucket_height > 0.f ? std::min(size_t(height / bucket_height) + 1, max_buckets) : 1;
+    inv_bucket_height = height > 0.f ? float(num_buckets) / height : 0.f;
+
+    // Counting sort of the faces into the buckets. The faces are split into blocks of consecutive faces counted and scattered in parallel,
+    // the faces of a block are placed into a bucket after the faces of the preceding blocks, thus the faces of a bucket stay sorted.
+    const size_t num_blocks = std::clamp(indices.size() / 16384, size_t(1), size_t(tbb::this_task_arena::max_concurrency()));
+    auto         block_faces = [num_blocks, num_faces = indices.size()](size_t block_idx) {
+        return std::make_pair(num_faces * block_idx / num_blocks, num_faces * (block_idx + 1) / num_blocks);
+    };
+    // Number of faces of each block in each bucket, then the position of the first of them in bucket_faces.
+    std::vector<uint32_t> block_bucket_pos(num_blocks * num_buckets, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1),
+        [this, &block_faces, &block_bucket_pos, num_buckets](const tbb::blocked_range<size_t> &range) {
+            for (size_t block_idx = range.begin(); block_idx < range.end(); ++ block_idx) {
+                uint32_t *bucket_count = block_bucket_pos.data() + block_idx * num_buckets;
+                for (auto [face_idx, face_end] = block_faces(block_idx); face_idx < face_end; ++ face_idx)
+                    for (size_t bucket = this->bucket_of(face_min_z[face_idx]), last = this->bucket_of(face_max_z[face_idx]); bucket <= last; ++ bucket)
+                        ++ bucket_count[bucket];
+            }
+        });
+    bucket_begin.assign(num_buckets + 1, 0);
+    uint32_t pos = 0;
+    for (size_t bucket = 0; bucket < num_buckets; ++ bucket) {
+        bucket_begin[bucket] = pos;
+        for (size_t block_idx = 0; block_idx < num_blocks; ++ block_idx)
+            pos += std::exchange(block_bucket_pos[block_idx * num_buckets + bucket], pos);
+    }
+    bucket_begin.back() = pos;
+    bucket_faces.assign(pos, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_blocks, 1),
+        [this, &block_faces, &block_bucket_pos, num_buckets](const tbb::blocked_range<size_t> &range) {
+            for (size_t block_idx = range.begin(); block_idx < range.end(); ++ block_idx) {
+                uint32_t *bucket_end = block_bucket_pos.data() + block_idx * num_buckets;
+                for (auto [face_idx, face_end] = block_faces(block_idx); face_idx < face_end; ++ face_idx)
+                    for (size_t bucket = this->bucket_of(face_min_z[face_idx]), last = this->bucket_of(face_max_z[face_idx]); bucket <= last; ++ bucket)
+                        bucket_faces[bucket_end[bucket] ++] = uint32_t(face_idx);
+            }
+        });
+}
+
+// Slice a single face of a mesh with its vertices already transformed with the planes zs[first_layer, last_layer).
+// The layers are owned by the calling thread, thus the lines are stored without locking.
+static inline void slice_facet_at_zs_range(
+    const std::vector<Vec3f>                         &mesh_vertices,
+    const stl_triangle_vertex_indices                &indices,
+    const Vec3i32                                    &edge_ids,
+    const std::vector<float>                         &zs,
+    size_t                                            first_layer,
+    size_t                                            last_layer,
+    std::vector<IntersectionLines>                   &lines)
+{
+    stl_vertex vertices[3] { mesh_vertices[indices(0)], mesh_vertices[indices(1)], mesh_vertices[indices(2)] };
+
+    // find facet extents
+    const float min_z = fminf(vertices[0].z(), fminf(vertices[1].z(), vertices[2].z()));
+    const float max_z = fmaxf(vertices[0].z(), fmaxf(vertices[1].z(), vertices[2].z()));
+    // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
+    if (min_z == max_z)
+        return;
+
+    // find layer extents
+    auto min_layer = std::lower_bound(zs.begin() + first_layer, zs.begin() + last_layer, min_z); // first layer whose slice_z is >= min_z
+    auto max_layer = std::upper_bound(min_layer, zs.begin() + last_layer, max_z); // first layer whose slice_z is > max_z
+    int  idx_vertex_lowest = (vertices[1].z() == min_z) ? 1 : ((vertices[2].z() == min_z) ? 2 : 0);
+
+    for (auto it = min_layer; it != max_layer; ++ it) {
+        IntersectionLine il;
+        if (slice_facet(*it, vertices, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
+            assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
+            lines[it - zs.begin()].emplace_back(il);
+        }
+    }
+}
+
+// Slice the mesh with its vertices already transformed, visiting just the faces registered in z_index around each plane.
+// The planes are split into blocks of consecutive layers, each processed by a single thread.
+template<typename ThrowOnCancel>
+static inline std::vector<IntersectionLines> slice_make_lines(
+    const std::vector<stl_vertex>                   &vertices,
+    const std::vector<stl_triangle_vertex_indices>  &indices,
+    const std::vector<Vec3i32>                      &face_edge_ids,
+    const FacetZIndex                               &z_index,
+    const std::vector<float>                        &zs,
+    const ThrowOnCancel                              throw_on_cancel_fn)
+{
+    std::vector<IntersectionLines> lines(zs.size(), IntersectionLines());
+    if (z_index.empty() || zs.empty())
+        return lines;
+
+    const size_t num_blocks = std::min(zs.size(), size_t(4 * std::max(1, tbb::this_task_arena::max_concurrency())));
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, num_blocks, 1),
+        [&vertices, &indices, &face_edge_ids, &z_index, &zs, &lines, num_blocks, throw_on_cancel_fn](const tbb::blocked_range<size_t> &range) {
+            for (size_t block = range.begin(); block < range.end(); ++ block) {
+                const size_t first_layer = block * zs.size() / num_blocks;
+                const size_t last_layer  = (block + 1) * zs.size() / num_blocks;
+                if (first_layer == last_layer)
+                    continue;
+                const float z_low  = zs[first_layer];
+                const float z_high = zs[last_layer - 1];
+                size_t      num_visited = 0;
+                for (size_t bucket = z_index.bucket_of(z_low), last_bucket = z_index.bucket_of(z_high); bucket <= last_bucket; ++ bucket)
+                    for (uint32_t i = z_index.bucket_begin[bucket]; i < z_index.bucket_begin[bucket + 1]; ++ i) {
+                        const uint32_t face_idx = z_index.bucket_faces[i];
+                        const float    min_z    = z_index.face_min_z[face_idx];
+                        const float    max_z    = z_index.face_max_z[face_idx];
+                        // Skip the faces outside of this block. A face registered in several buckets is sliced from the first bucket the block visits.
+                        if (max_z < z_low || min_z > z_high || z_index.bucket_of(std::max(min_z, z_low)) != bucket)
+                            continue;
+                        if ((++ num_visited & 0x0ffff) == 0)
+                            throw_on_cancel_fn();
+                        slice_facet_at_zs_range(vertices, indices[face_idx], face_edge_ids[face_idx], zs, first_layer, last_layer, lines);
+                    }
+            }
+        }
+    );
+    return lines;
+}
+
 template<typename TransformVertex, typename FaceFilter>
 static inline IntersectionLines slice_make_lines(
     const std::vector<stl_vertex>                   &mesh_vertices,
@@ -1480,6 +1643,35 @@ static Polygons make_loops(
     return loops;
 }
 
+static void apply_slicing_mode(Polygons &polygons, MeshSlicingParams::SlicingMode mode)
+{
+    if (! polygons.empty()) {
+        if (mode == MeshSlicingParams::SlicingMode::Positive) {
+            // Reorient all loops to be CCW.
+            for (Polygon& p : polygons)
+                p.make_counter_clockwise();
+        }
+        else if (mode == MeshSlicingParams::SlicingMode::PositiveLargestContour) {
+            // Keep just the largest polygon, make it CCW.
+            double   max_area = 0.;
+            Polygon* max_area_polygon = nullptr;
+            for (Polygon& p : polygons) {
+                double a = p.area();
+                if (std::abs(a) > std::abs(max_area)) {
+                    max_area = a;
+                    max_area_polygon = &p;
+                }
+            }
+            assert(max_area_polygon != nullptr);
+            if (max_area < 0.)
+                max_area_polygon->reverse();
+            Polygon p(std::move(*max_area_polygon));
+            polygons.clear();
+            polygons.emplace_back(std::move(p));
+        }
+    }
+}
+
 template<typename ThrowOnCancel>
 static std::vector<Polygons> make_loops(
     // Lines will have their flags modified.
@@ -1498,33 +1690,7 @@ static std::vector<Polygons> make_loops(
 
                 Polygons &polygons = layers[line_idx];
                 polygons = make_loops(lines[line_idx]);
-
-                auto this_mode = line_idx < params.slicing_mode_normal_below_layer ? params.mode_below : params.mode;
-                if (! polygons.empty()) {
-                    if (this_mode == MeshSlicingParams::SlicingMode::Positive) {
-                        // Reorient all loops to be CCW.
-                        for (Polygon& p : polygons)
-                            p.make_counter_clockwise();
-                    }
-                    else if (this_mode == MeshSlicingParams::SlicingMode::PositiveLargestContour) {
-                        // Keep just the largest polygon, make it CCW.
-                        double   max_area = 0.;
-                        Polygon* max_area_polygon = nullptr;
-                        for (Polygon& p : polygons) {
-                            double a = p.area();
-                            if (std::abs(a) > std::abs(max_area)) {
-                                max_area = a;
-                                max_area_polygon = &p;
-                            }
-                        }
-                        assert(max_area_polygon != nullptr);
-                        if (max_area < 0.)
-                            max_area_polygon->reverse();
-                        Polygon p(std::move(*max_area_polygon));
-                        polygons.clear();
-                        polygons.emplace_back(std::move(p));
-                    }
-                }
+                apply_slicing_mode(polygons, line_idx < params.slicing_mode_normal_below_layer ? params.mode_below : params.mode);
             }
         }
     );
@@ -1842,25 +2008,48 @@ static std::vector<stl_vertex> transform_mesh_vertices_for_slicing(const indexed
     // Copy and scale vertices in XY, don't scale in Z.
     // Possibly apply the transformation.
     const double   s = 1. / SCALING_FACTOR;
-    std::vector<stl_vertex>         out(mesh.vertices);
+    std::vector<stl_vertex>         out(mesh.vertices.size());
     if (is_identity(trafo)) {
         // Identity.
-        for (stl_vertex &v : out) {
-            // Scale just XY, leave Z unscaled.
-            v.x() *= float(s);
-            v.y() *= float(s);
-        }
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, out.size(), 16384), [&mesh, &out, s](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                // Scale just XY, leave Z unscaled.
+                const stl_vertex &v = mesh.vertices[i];
+                out[i] = stl_vertex(v.x() * float(s), v.y() * float(s), v.z());
+            }
+        });
     } else {
         // Transform the vertices, scale up in XY, not in Y.
         auto t = trafo;
         t.prescale(Vec3d(s, s, 1.));
-        auto tf = t.cast<float>();
-        for (stl_vertex &v : out)
-            v = tf * v;
+        Transform3f tf = t.cast<float>();
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, out.size(), 16384), [&mesh, &out, &tf](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                out[i] = tf * mesh.vertices[i];
+        });
     }
     return out;
 }
 
+MeshSlicingIndex::MeshSlicingIndex(const indexed_triangle_set &mesh, const Transform3d &trafo) :
+    num_vertices(mesh.vertices.size()), num_indices(mesh.indices.size()), trafo(trafo)
+{
+    tbb::parallel_invoke(
+        [this, &mesh]() { face_edge_ids = its_face_edge_ids(mesh); },
+        [this, &mesh, &trafo]() {
+            // Copy and scale vertices in XY, don't scale in Z. Possibly apply the transformation.
+            vertices = transform_mesh_vertices_for_slicing(mesh, trafo);
+            z_index  = FacetZIndex(vertices, mesh.indices);
+        });
+}
+
+size_t MeshSlicingIndex::memory_used() const
+{
+    return sizeof(MeshSlicingIndex) + vertices.capacity() * sizeof(Vec3f) + face_edge_ids.capacity() * sizeof(Vec3i32) +
+        (z_index.face_min_z.capacity() + z_index.face_max_z.capacity()) * sizeof(float) +
+        (z_index.bucket_begin.capacity() + z_index.bucket_faces.capacity()) * sizeof(uint32_t);
+}
+
 std::vector<Polygons> slice_mesh(
     const indexed_triangle_set       &mesh,
     // Unscaled Zs
@@ -1872,28 +2061,25 @@ std::vector<Polygons> slice_mesh(
        
     std::vector<IntersectionLines> lines;
 
-    {
+    if (zs.size() > 1) {
+        // Index the faces along Z to slice each block of layers with just the faces crossing it.
+        const MeshSlicingIndex index(mesh, params.trafo);
+        lines = slice_make_lines(index.vertices, mesh.indices, index.face_edge_ids, index.z_index, zs, throw_on_cancel);
+    } else {
         //FIXME facets_edges is likely not needed and quite costly to calculate.
         // Instead of edge identifiers, one shall use a sorted pair of edge vertex indices.
         // However facets_edges assigns a single edge ID to two triangles only, thus when factoring facets_edges out, one will have
         // to make sure that no code relies on it.
         std::vector<Vec3i32> face_edge_ids = its_face_edge_ids(mesh);
-        if (zs.size() <= 1) {
-            // It likely is not worthwile to copy the vertices. Apply the transformation in place.
-            if (is_identity(params.trafo)) {
-                lines = slice_make_lines(
-                    mesh.vertices, [](const Vec3f &p) { return Vec3f(scaled<float>(p.x()), scaled<float>(p.y()), p.z()); }, 
-                    mesh.indices, face_edge_ids, zs, throw_on_cancel);
-            } else {
-                // Transform the vertices, scale up in XY, not in Z.
-                Transform3f tf = make_trafo_for_slicing(params.trafo);
-                lines = slice_make_lines(mesh.vertices, [tf](const Vec3f &p) { return tf * p; }, mesh.indices, face_edge_ids, zs, throw_on_cancel);
-            }
-        } else {
-            // Copy and scale vertices in XY, don't scale in Z. Possibly apply the transformation.
+        // It likely is not worthwile to copy the vertices. Apply the transformation in place.
+        if (is_identity(params.trafo)) {
             lines = slice_make_lines(
-                transform_mesh_vertices_for_slicing(mesh, params.trafo), 
-                [](const Vec3f &p) { return p; },  mesh.indices, face_edge_ids, zs, throw_on_cancel);
+                mesh.vertices, [](const Vec3f &p) { return Vec3f(scaled<float>(p.x()), scaled<float>(p.y()), p.z()); }, 
+                mesh.indices, face_edge_ids, zs, throw_on_cancel);
+        } else {
+            // Transform the vertices, scale up in XY, not in Z.
+            Transform3f tf = make_trafo_for_slicing(params.trafo);
+            lines = slice_make_lines(mesh.vertices, [tf](const Vec3f &p) { return tf * p; }, mesh.indices, face_edge_ids, zs, throw_on_cancel);
         }
     }
 
@@ -1937,6 +2123,20 @@ std::vector<Polygons> slice_mesh(
     return layers;
 }
 
+std::vector<Polygons> slice_mesh(
+    const indexed_triangle_set       &mesh,
+    // Unscaled Zs
+    const std::vector<float>         &zs,
+    const MeshSlicingParams          &params,
+    const MeshSlicingIndex           &index,
+    std::function<void()>             throw_on_cancel)
+{
+    assert(index.matches(mesh, params.trafo));
+    std::vector<IntersectionLines> lines = slice_make_lines(index.vertices, mesh.indices, index.face_edge_ids, index.z_index, zs, throw_on_cancel);
+    throw_on_cancel();
+    return make_loops(lines, params, throw_on_cancel);
+}
+
 // Specialized version for a single slicing plane only, running on a single thread.
 Polygons slice_mesh(
     const indexed_triangle_set       &mesh,
@@ -2000,48 +2200,48 @@ Polygons slice_mesh(
     return layers.front();
 }
 
-std::vector<ExPolygons> slice_mesh_ex(
-    const indexed_triangle_set       &mesh,
-    const std::vector<float>         &zs,
-    const MeshSlicingParamsEx        &params,
-    std::function<void()>             throw_on_cancel)
+// Make expolygons of a single layer from loops with the slicing mode already applied.
+static void make_layer_expolygons(const Polygons &loops, MeshSlicingParams::SlicingMode mode, const MeshSlicingParamsEx &params, ExPolygons &expolygons)
 {
-    std::vector<Polygons> layers_p;
-    {
-        MeshSlicingParams slicing_params(params);
-        if (params.mode == MeshSlicingParams::SlicingMode::PositiveLargestContour)
-            slicing_params.mode = MeshSlicingParams::SlicingMode::Positive;
-        if (params.mode_below == MeshSlicingParams::SlicingMode::PositiveLargestContour)
-            slicing_params.mode_below = MeshSlicingParams::SlicingMode::Positive;
-        layers_p = slice_mesh(mesh, zs, slicing_params, throw_on_cancel);
+    Slic3r::make_expolygons(
+        loops, params.closing_radius, params.extra_offset,
+        mode == MeshSlicingParams::SlicingMode::EvenOdd ? ClipperLib::pftEvenOdd :
+        mode == MeshSlicingParams::SlicingMode::PositiveLargestContour ? ClipperLib::pftPositive : ClipperLib::pftNonZero,
+        &expolygons);
+    //FIXME simplify
+    if (mode == MeshSlicingParams::SlicingMode::PositiveLargestContour)
+        keep_largest_contour_only(expolygons);
+    if (auto resolution = scaled<float>(params.resolution); resolution != 0.) {
+        ExPolygons simplified;
+        simplified.reserve(expolygons.size());
+        for (const ExPolygon &ex : expolygons)
+            append(simplified, ex.simplify(resolution));
+        expolygons = std::move(simplified);
     }
-    
+}
+
+// Slicing parameters of the loops to be turned into expolygons by make_layer_expolygons().
+static MeshSlicingParams slicing_params_for_expolygons(const MeshSlicingParamsEx &params)
+{
+    MeshSlicingParams slicing_params(params);
+    if (params.mode == MeshSlicingParams::SlicingMode::PositiveLargestContour)
+        slicing_params.mode = MeshSlicingParams::SlicingMode::Positive;
+    if (params.mode_below == MeshSlicingParams::SlicingMode::PositiveLargestContour)
+        slicing_params.mode_below = MeshSlicingParams::SlicingMode::Positive;
+    return slicing_params;
+}
+
+static std::vector<ExPolygons> make_layers_expolygons(const std::vector<Polygons> &layers_p, const MeshSlicingParamsEx &params, const std::function<void()> &throw_on_cancel)
+{
 //    BOOST_LOG_TRIVIAL(debug) << "slice_mesh make_expolygons in parallel - start";
     std::vector<ExPolygons> layers(layers_p.size(), ExPolygons{});
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, layers_p.size()),
-        [&layers_p, &params, &layers, throw_on_cancel]
+        [&layers_p, &params, &layers, &throw_on_cancel]
         (const tbb::blocked_range<size_t>& range) {
-            auto resolution = scaled<float>(params.resolution);
             for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
                 throw_on_cancel();
-                ExPolygons &expolygons = layers[layer_id];
-                const auto this_mode = layer_id < params.slicing_mode_normal_below_layer ? params.mode_below : params.mode;
-                Slic3r::make_expolygons(
-                    layers_p[layer_id], params.closing_radius, params.extra_offset,
-                    this_mode == MeshSlicingParams::SlicingMode::EvenOdd ? ClipperLib::pftEvenOdd : 
-                    this_mode == MeshSlicingParams::SlicingMode::PositiveLargestContour ? ClipperLib::pftPositive : ClipperLib::pftNonZero,
-                    &expolygons);
-                //FIXME simplify
-                if (this_mode == MeshSlicingParams::SlicingMode::PositiveLargestContour)
-                    keep_largest_contour_only(expolygons);
-                if (resolution != 0.) {
-                    ExPolygons simplified;
-                    simplified.reserve(expolygons.size());
-                    for (const ExPolygon &ex : expolygons)
-                        append(simplified, ex.simplify(resolution));
-                    expolygons = std::move(simplified);
-                }
+                make_layer_expolygons(layers_p[layer_id], layer_id < params.slicing_mode_normal_below_layer ? params.mode_below : params.mode, params, layers[layer_id]);
             }
         });
 //    BOOST_LOG_TRIVIAL(debug) << "slice_mesh make_expolygons in parallel - end";
@@ -2049,6 +2249,226 @@ std::vector<ExPolygons> slice_mesh_ex(
     return layers;
 }
 
+std::vector<ExPolygons> slice_mesh_ex(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    std::function<void()>             throw_on_cancel)
+{
+    return make_layers_expolygons(slice_mesh(mesh, zs, slicing_params_for_expolygons(params), throw_on_cancel), params, throw_on_cancel);
+}
+
+std::vector<ExPolygons> slice_mesh_ex(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    const MeshSlicingIndex           &index,
+    std::function<void()>             throw_on_cancel)
+{
+    return make_layers_expolygons(slice_mesh(mesh, zs, slicing_params_for_expolygons(params), index, throw_on_cancel), params, throw_on_cancel);
+}
+
+// Update the cache for slicing with the planes zs: move the cached layers accepted by reusable() and outside of dirty_zs
+// to the positions of zs, slice the missing ones. Returns with cache.layers matching zs.
+template<typename ReusableFn>
+static void update_mesh_slicing_cache(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const Transform3d                &trafo,
+    MeshSlicingCache                 &cache,
+    ReusableFn                        reusable,
+    const std::pair<float, float>    &dirty_zs,
+    const std::function<void()>      &throw_on_cancel)
+{
+    if (cache.num_vertices != mesh.vertices.size() || cache.num_indices != mesh.indices.size() || cache.trafo.matrix() != trafo.matrix()) {
+        // Keep the index if the caller assigned one for the new mesh or transformation.
+        std::shared_ptr<const MeshSlicingIndex> index = std::move(cache.index);
+        cache.clear();
+        cache.index        = std::move(index);
+        cache.num_vertices = mesh.vertices.size();
+        cache.num_indices  = mesh.indices.size();
+        cache.trafo        = trafo;
+    }
+    if (! cache.index || ! cache.index->matches(mesh, trafo))
+        cache.index = std::make_shared<const MeshSlicingIndex>(mesh, trafo);
+    const MeshSlicingIndex &index = *cache.index;
+
+    std::vector<MeshSlicingCache::Layer> layers(zs.size());
+    std::vector<float>                   zs_missing;
+    std::vector<size_t>                  layers_missing;
+    auto                                 it_cached = cache.layers.begin();
+    for (size_t layer_id = 0; layer_id < zs.size(); ++ layer_id) {
+        const float z = zs[layer_id];
+        it_cached = std::lower_bound(it_cached, cache.layers.end(), z, [](const MeshSlicingCache::Layer &l, float z) { return l.z < z; });
+        if (it_cached != cache.layers.end() && it_cached->z == z && ! (z >= dirty_zs.first && z <= dirty_zs.second) && reusable(*it_cached, layer_id)) {
+            layers[layer_id] = std::move(*it_cached);
+            ++ it_cached;
+        } else {
+            layers[layer_id].z = z;
+            zs_missing.emplace_back(z);
+            layers_missing.emplace_back(layer_id);
+        }
+    }
+    cache.hits   = zs.size() - zs_missing.size();
+    cache.misses = zs_missing.size();
+
+    if (! zs_missing.empty()) {
+        std::vector<IntersectionLines> lines = slice_make_lines(index.vertices, mesh.indices, index.face_edge_ids, index.z_index, zs_missing, throw_on_cancel);
+        throw_on_cancel();
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, lines.size()),
+            [&lines, &layers, &layers_missing, &throw_on_cancel](const tbb::blocked_range<size_t> &range) {
+                for (size_t line_idx = range.begin(); line_idx < range.end(); ++ line_idx) {
+                    if ((line_idx & 0x0ffff) == 0)
+                        throw_on_cancel();
+                    layers[layers_missing[line_idx]].loops = make_loops(lines[line_idx]);
+                }
+            });
+    }
+    cache.layers = std::move(layers);
+}
+
+size_t MeshSlicingCache::memory_used() const
+{
+    size_t out = sizeof(MeshSlicingCache) + layers.capacity() * sizeof(Layer);
+    for (const Layer &layer : layers) {
+        for (const Polygon &loop : layer.loops)
+            out += sizeof(Polygon) + loop.points.capacity() * sizeof(Point);
+        for (const ExPolygon &expoly : layer.expolygons) {
+            out += sizeof(ExPolygon) + expoly.contour.points.capacity() * sizeof(Point);
+            for (const Polygon &hole : expoly.holes)
+                out += sizeof(Polygon) + hole.points.capacity() * sizeof(Point);
+        }
+    }
+    return out;
+}
+
+std::vector<Polygons> slice_mesh(
+    const indexed_triangle_set       &mesh,
+    // Unscaled Zs
+    const std::vector<float>         &zs,
+    const MeshSlicingParams          &params,
+    MeshSlicingCache                 &cache,
+    const std::pair<float, float>    &dirty_zs,
+    std::function<void()>             throw_on_cancel)
+{
+    // Layers holding expolygons no more hold their loops, they are sliced again.
+    update_mesh_slicing_cache(mesh, zs, params.trafo, cache,
+        [](const MeshSlicingCache::Layer &layer, size_t) { return ! layer.expolygons_valid; }, dirty_zs, throw_on_cancel);
+    BOOST_LOG_TRIVIAL(debug) << "slice_mesh to polygons, cached layers " << cache.hits << ", sliced layers " << cache.misses;
+
+    std::vector<Polygons> layers(zs.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, zs.size()),
+        [&cache, &layers, &params](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
+                layers[layer_id] = cache.layers[layer_id].loops;
+                apply_slicing_mode(layers[layer_id], layer_id < params.slicing_mode_normal_below_layer ? params.mode_below : params.mode);
+            }
+        });
+    return layers;
+}
+
+std::vector<ExPolygons> slice_mesh_ex(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    MeshSlicingCache                 &cache,
+    const std::pair<float, float>    &dirty_zs,
+    std::function<void()>             throw_on_cancel)
+{
+    auto layer_mode = [&params](size_t layer_id) { return layer_id < params.slicing_mode_normal_below_layer ? params.mode_below : params.mode; };
+    const bool same_params = cache.closing_radius == params.closing_radius && cache.extra_offset == params.extra_offset && cache.resolution == params.resolution;
+    // Layers holding loops are reused, layers holding expolygons only if the expolygons were made the same way.
+    update_mesh_slicing_cache(mesh, zs, params.trafo, cache,
+        [&layer_mode, same_params](const MeshSlicingCache::Layer &layer, size_t layer_id) {
+            return ! layer.expolygons_valid || (same_params && layer.expolygons_mode == layer_mode(layer_id));
+        }, dirty_zs, throw_on_cancel);
+    BOOST_LOG_TRIVIAL(debug) << "slice_mesh_ex, cached layers " << cache.hits << ", sliced layers " << cache.misses;
+    cache.closing_radius = params.closing_radius;
+    cache.extra_offset   = params.extra_offset;
+    cache.resolution     = params.resolution;
+
+    std::vector<ExPolygons> layers(zs.size(), ExPolygons{});
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, zs.size()),
+        [&cache, &params, &layers, &layer_mode, throw_on_cancel](const tbb::blocked_range<size_t>& range) {
+            for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
+                throw_on_cancel();
+                MeshSlicingCache::Layer &layer     = cache.layers[layer_id];
+                const auto               this_mode = layer_mode(layer_id);
+                if (! layer.expolygons_valid) {
+                    // Consume the loops, the cache keeps just the expolygons.
+                    apply_slicing_mode(layer.loops, this_mode == MeshSlicingParams::SlicingMode::PositiveLargestContour ? MeshSlicingParams::SlicingMode::Positive : this_mode);
+                    make_layer_expolygons(layer.loops, this_mode, params, layer.expolygons);
+                    layer.loops            = Polygons();
+                    layer.expolygons_mode  = this_mode;
+                    layer.expolygons_valid = true;
+                }
+                layers[layer_id] = layer.expolygons;
+            }
+        });
+    return layers;
+}
+
+// Slicing into slabs of a mesh with its vertices already transformed, see the public slice_mesh_slabs() below.
+static void slice_mesh_slabs(
+    const indexed_triangle_set       &mesh,
+    // Unscaled Zs
+    const std::vector<float>         &zs,
+    const Transform3d                &trafo,
+    // Vertices of mesh transformed by trafo and scaled in XY.
+    const std::vector<stl_vertex>    &vertices_transformed,
+    std::vector<Polygons>            *out_top,
+    std::vector<Polygons>            *out_bottom,
+    std::vector<std::pair<Vec3f, Vec3f>>   *vertical_points,
+    const std::function<void()>      &throw_on_cancel)
+{
+    const auto mirrored_sign = int64_t(trafo.matrix().block(0, 0, 3, 3).determinant() < 0 ? -1 : 1);
+
+    std::vector<FaceOrientation> face_orientation(mesh.indices.size(), FaceOrientation::Up);
+    for (const stl_triangle_vertex_indices &tri : mesh.indices) {
+        const Vec3f   fa = vertices_transformed[tri(0)];
+        const Vec3f   fb = vertices_transformed[tri(1)];
+        const Vec3f   fc = vertices_transformed[tri(2)];
+        assert(fa != fb && fa != fc && fb != fc);
+        const Point   a = to_2d(fa).cast<coord_t>();
+        const Point   b = to_2d(fb).cast<coord_t>();
+        const Point   c = to_2d(fc).cast<coord_t>();
+        const int64_t d = cross2((b - a).cast<int64_t>(), (c - b).cast<int64_t>()) * mirrored_sign;
+        FaceOrientation fo = FaceOrientation::Vertical;
+        if (d > 0)
+            fo = FaceOrientation::Up;
+        else if (d < 0)
+            fo = FaceOrientation::Down;
+        else {
+            // Is the triangle vertical or degenerate?
+            assert(d == 0);
+            fo = fa == fb || fa == fc || fb == fc ? FaceOrientation::Degenerate : FaceOrientation::Vertical;
+            if(vertical_points && fo==FaceOrientation::Vertical)
+            {
+                Vec3f normal = (fb - fa).cross(fc - fa).normalized();
+                vertical_points->push_back({ (fa + fb + fc) / 3,normal });
+            }
+        }
+        face_orientation[&tri - mesh.indices.data()] = fo;
+    }
+
+    std::vector<Vec3i32> face_neighbors = its_face_neighbors_par(mesh);
+    int                num_edges;
+    std::vector<Vec3i32> face_edge_ids  = its_face_edge_ids(mesh, face_neighbors, true, &num_edges);
+    std::pair<SlabLines, SlabLines> lines = slice_slabs_make_lines(
+        vertices_transformed, mesh.indices, face_neighbors, face_edge_ids, num_edges, face_orientation, zs, 
+        out_top != nullptr, out_bottom != nullptr, throw_on_cancel);
+
+    throw_on_cancel();
+
+    if (out_top)
+        *out_top = make_slab_loops<true>(lines.first, num_edges, throw_on_cancel);
+    if (out_bottom)
+        *out_bottom = make_slab_loops<false>(lines.second, num_edges, throw_on_cancel);
+}
+
 // Slice a triangle set with a set of Z slabs (thick layers).
 // The effect is similar to producing the usual top / bottom layers from a sliced mesh by 
 // subtracting layer[i] from layer[i - 1] for the top surfaces resp.
@@ -2111,50 +2531,21 @@ void slice_mesh_slabs(
     }
 #endif // EXPENSIVE_DEBUG_CHECKS
 
-    std::vector<stl_vertex> vertices_transformed = transform_mesh_vertices_for_slicing(mesh, trafo);
-    const auto mirrored_sign = int64_t(trafo.matrix().block(0, 0, 3, 3).determinant() < 0 ? -1 : 1);
-
-    std::vector<FaceOrientation> face_orientation(mesh.indices.size(), FaceOrientation::Up);
-    for (const stl_triangle_vertex_indices &tri : mesh.indices) {
-        const Vec3f   fa = vertices_transformed[tri(0)];
-        const Vec3f   fb = vertices_transformed[tri(1)];
-        const Vec3f   fc = vertices_transformed[tri(2)];
-        assert(fa != fb && fa != fc && fb != fc);
-        const Point   a = to_2d(fa).cast<coord_t>();
-        const Point   b = to_2d(fb).cast<coord_t>();
-        const Point   c = to_2d(fc).cast<coord_t>();
-        const int64_t d = cross2((b - a).cast<int64_t>(), (c - b).cast<int64_t>()) * mirrored_sign;
-        FaceOrientation fo = FaceOrientation::Vertical;
-        if (d > 0)
-            fo = FaceOrientation::Up;
-        else if (d < 0)
-            fo = FaceOrientation::Down;
-        else {
-            // Is the triangle vertical or degenerate?
-            assert(d == 0);
-            fo = fa == fb || fa == fc || fb == fc ? FaceOrientation::Degenerate : FaceOrientation::Vertical;
-            if(vertical_points && fo==FaceOrientation::Vertical)
-            {
-                Vec3f normal = (fb - fa).cross(fc - fa).normalized();
-                vertical_points->push_back({ (fa + fb + fc) / 3,normal });
-            }
-        }
-        face_orientation[&tri - mesh.indices.data()] = fo;
-    }
-
-    std::vector<Vec3i32> face_neighbors = its_face_neighbors_par(mesh);
-    int                num_edges;
-    std::vector<Vec3i32> face_edge_ids  = its_face_edge_ids(mesh, face_neighbors, true, &num_edges);
-    std::pair<SlabLines, SlabLines> lines = slice_slabs_make_lines(
-        vertices_transformed, mesh.indices, face_neighbors, face_edge_ids, num_edges, face_orientation, zs, 
-        out_top != nullptr, out_bottom != nullptr, throw_on_cancel);
-
-    throw_on_cancel();
+    slice_mesh_slabs(mesh, zs, trafo, transform_mesh_vertices_for_slicing(mesh, trafo), out_top, out_bottom, vertical_points, throw_on_cancel);
+}
 
-    if (out_top)
-        *out_top = make_slab_loops<true>(lines.first, num_edges, throw_on_cancel);
-    if (out_bottom)
-        *out_bottom = make_slab_loops<false>(lines.second, num_edges, throw_on_cancel);
+void slice_mesh_slabs(
+    const indexed_triangle_set       &mesh,
+    // Unscaled Zs
+    const std::vector<float>         &zs,
+    const MeshSlicingIndex           &index,
+    std::vector<Polygons>            *out_top,
+    std::vector<Polygons>            *out_bottom,
+    std::vector<std::pair<Vec3f, Vec3f>>   *vertical_points,
+    std::function<void()>             throw_on_cancel)
+{
+    assert(index.matches(mesh, index.trafo));
+    slice_mesh_slabs(mesh, zs, index.trafo, index.vertices, out_top, out_bottom, vertical_points, throw_on_cancel);
 }
 
 // Remove duplicates of slice_vertices, optionally triangulate the cut.
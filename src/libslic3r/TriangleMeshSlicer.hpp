@@ -2,6 +2,8 @@
 #define slic3r_TriangleMeshSlicer_hpp_
 
 #include <functional>
+#include <limits>
+#include <memory>
 #include <vector>
 #include "Polygon.hpp"
 #include "ExPolygon.hpp"
@@ -46,6 +48,99 @@ struct MeshSlicingParamsEx : public MeshSlicingParams
     double        resolution { 0 };
 };
 
+// Index of the faces of a mesh along Z, so that slicing a set of planes visits just the faces crossing them.
+// The Z span of the mesh is split into buckets, each face is registered in all the buckets its Z span overlaps.
+// The faces of a bucket are stored in the order of their indices to keep the access to the vertices coherent.
+// Built from the vertices already transformed for slicing.
+struct FacetZIndex
+{
+    FacetZIndex() = default;
+    FacetZIndex(const std::vector<Vec3f> &vertices, const std::vector<stl_triangle_vertex_indices> &indices);
+
+    bool   empty() const { return bucket_begin.empty(); }
+    size_t num_buckets() const { return bucket_begin.empty() ? 0 : bucket_begin.size() - 1; }
+    size_t bucket_of(float z) const {
+        float b = (z - z_min) * inv_bucket_height;
+        return b <= 0.f ? 0 : std::min(size_t(b), this->num_buckets() - 1);
+    }
+
+    float                   z_min { 0 };
+    float                   inv_bucket_height { 0 };
+    // Lowest and highest Z of each face.
+    std::vector<float>      face_min_z;
+    std::vector<float>      face_max_z;
+    // Faces of bucket i are bucket_faces[bucket_begin[i], bucket_begin[i + 1]).
+    std::vector<uint32_t>   bucket_begin;
+    std::vector<uint32_t>   bucket_faces;
+};
+
+// Vertices of a mesh transformed and scaled in XY for slicing, edge IDs of its faces and their index along Z,
+// shared by the slicing calls with the same mesh and the same transformation.
+// The index is bound to the triangles of the mesh, it is built again if its vertices or triangles changed.
+struct MeshSlicingIndex
+{
+    MeshSlicingIndex() = default;
+    // Built in parallel.
+    MeshSlicingIndex(const indexed_triangle_set &mesh, const Transform3d &trafo);
+
+    bool matches(const indexed_triangle_set &mesh, const Transform3d &trafo) const
+        { return num_vertices == mesh.vertices.size() && num_indices == mesh.indices.size() && this->trafo.matrix() == trafo.matrix(); }
+    // Estimate of the memory held by the index in bytes.
+    size_t memory_used() const;
+
+    // Identification of the mesh and of the transformation the index was created for.
+    size_t                  num_vertices { 0 };
+    size_t                  num_indices { 0 };
+    Transform3d             trafo { Transform3d::Identity() };
+    std::vector<Vec3f>      vertices;
+    std::vector<Vec3i32>    face_edge_ids;
+    FacetZIndex             z_index;
+};
+
+// Slicing results of a single mesh with a single transformation kept between the calls of slice_mesh() resp. slice_mesh_ex(),
+// so that only the new slicing planes and the slicing planes inside a dirty Z interval are sliced again,
+// for example after the variable layer height profile or a layer range was edited.
+// The cache is bound to the mesh: call clear() if its vertices or triangles changed.
+// A layer keeps either the closed loops (slice_mesh()) or the expolygons (slice_mesh_ex()), not both,
+// thus the cache holds about the same amount of data as the slices produced by the last call.
+struct MeshSlicingCache
+{
+    struct Layer
+    {
+        // Unscaled slicing plane.
+        float                           z { 0 };
+        // Closed loops before applying MeshSlicingParams::SlicingMode, valid if ! expolygons_valid.
+        Polygons                        loops;
+        // Output of slice_mesh_ex() for this layer, valid if expolygons_valid. The loops were consumed to produce them.
+        ExPolygons                      expolygons;
+        MeshSlicingParams::SlicingMode  expolygons_mode { MeshSlicingParams::SlicingMode::Regular };
+        bool                            expolygons_valid { false };
+    };
+
+    // Identification of the mesh and of the transformation the cached layers were created for.
+    size_t                  num_vertices { 0 };
+    size_t                  num_indices { 0 };
+    Transform3d             trafo { Transform3d::Identity() };
+    // Slicing index of the mesh, built by the first call if not assigned by the caller.
+    std::shared_ptr<const MeshSlicingIndex> index;
+    // Parameters of slice_mesh_ex() the cached expolygons were created with.
+    float                   closing_radius { 0 };
+    float                   extra_offset { 0 };
+    double                  resolution { 0 };
+    // Layers of the last call, sorted by z.
+    std::vector<Layer>      layers;
+    // Statistics of the last call: number of layers reused from the cache and number of layers sliced.
+    size_t                  hits { 0 };
+    size_t                  misses { 0 };
+
+    void clear() { *this = MeshSlicingCache(); }
+    // Estimate of the memory held by the cached layers in bytes, not counting the shared index.
+    size_t memory_used() const;
+};
+
+// Empty interval of slicing planes to be sliced again, see MeshSlicingCache.
+inline std::pair<float, float> mesh_slicing_no_dirty_zs() { return { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest() }; }
+
 // All the following slicing functions shall produce consistent results with the same mesh, same transformation matrix and slicing parameters.
 // Namely, slice_mesh_slabs() shall produce consistent results with slice_mesh() and slice_mesh_ex() in the sense, that projections made by 
 // slice_mesh_slabs() shall fall onto slicing planes produced by slice_mesh().
@@ -63,6 +158,24 @@ std::vector<Polygons>           slice_mesh(
     const MeshSlicingParams          &params,
     std::function<void()>             throw_on_cancel = []{});
 
+// Slicing with an index built for the same mesh and params.trafo, see MeshSlicingIndex.
+std::vector<Polygons>           slice_mesh(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParams          &params,
+    const MeshSlicingIndex           &index,
+    std::function<void()>             throw_on_cancel = []{});
+
+// Slicing with the results of the previous call cached, see MeshSlicingCache. Layers with their slicing plane inside the closed
+// interval dirty_zs (unscaled) are sliced again even if cached, an interval with first > second is empty.
+std::vector<Polygons>           slice_mesh(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParams          &params,
+    MeshSlicingCache                 &cache,
+    const std::pair<float, float>    &dirty_zs = mesh_slicing_no_dirty_zs(),
+    std::function<void()>             throw_on_cancel = []{});
+
 // Specialized version for a single slicing plane only, running on a single thread.
 Polygons                        slice_mesh(
     const indexed_triangle_set       &mesh,
@@ -75,6 +188,21 @@ std::vector<ExPolygons>         slice_mesh_ex(
     const MeshSlicingParamsEx        &params,
     std::function<void()>             throw_on_cancel = []{});
 
+std::vector<ExPolygons>         slice_mesh_ex(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    const MeshSlicingIndex           &index,
+    std::function<void()>             throw_on_cancel = []{});
+
+std::vector<ExPolygons>         slice_mesh_ex(
+    const indexed_triangle_set       &mesh,
+    const std::vector<float>         &zs,
+    const MeshSlicingParamsEx        &params,
+    MeshSlicingCache                 &cache,
+    const std::pair<float, float>    &dirty_zs = mesh_slicing_no_dirty_zs(),
+    std::function<void()>             throw_on_cancel = []{});
+
 inline std::vector<ExPolygons>  slice_mesh_ex(
     const indexed_triangle_set       &mesh,
     const std::vector<float>         &zs,
@@ -110,6 +238,17 @@ void slice_mesh_slabs(
     std::vector<std::pair<Vec3f, Vec3f>>   *vertical_points,
     std::function<void()>             throw_on_cancel);
 
+// Slicing into slabs reusing the vertices of an index built for the same mesh and trafo.
+void slice_mesh_slabs(
+    const indexed_triangle_set       &mesh,
+    // Unscaled Zs
+    const std::vector<float>         &zs,
+    const MeshSlicingIndex           &index,
+    std::vector<Polygons>            *out_top,
+    std::vector<Polygons>            *out_bottom,
+    std::vector<std::pair<Vec3f, Vec3f>>   *vertical_points,
+    std::function<void()>             throw_on_cancel);
+
 // Project mesh upwards pointing surfaces / downwards pointing surfaces into 2D polygons.
 void project_mesh(
     const indexed_triangle_set       &mesh,
@@ -1794,6 +1794,10 @@ void GLCanvas3D::smooth_layer_height_profile(const HeightProfileSmoothingParams&
 void GLCanvas3D::enable_layers_editing(bool enable)
 {
     m_layers_editing.set_enabled(enable);
+    // While the layer heights are being edited, keep the slices of the volumes, so that a modified layer height profile
+    // slices again just the layers it modified. The caches are released by the next slicing once the editing ends.
+    if (Plater *plater = wxGetApp().plater(); plater != nullptr && m_canvas_type == ECanvasType::CanvasView3D)
+        plater->get_partplate_list().get_current_fff_print().set_keep_volume_slicing_caches(enable);
     set_as_dirty();
 }
 
@@ -1,10 +1,17 @@
 #include <catch2/catch_all.hpp>
 
+#include <chrono>
+#include <fstream>
 #include <numeric>
 #include <sstream>
 
+#include <boost/algorithm/string/predicate.hpp>
+#include <tbb/task_arena.h>
+
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Fill/Fill.hpp"
+#include "libslic3r/Fill/FillLightning.hpp"
+#include "libslic3r/Fill/Lightning/Generator.hpp"
 #include "libslic3r/Flow.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/Print.hpp"
@@ -476,3 +483,137 @@ bool test_if_solid_surface_filled(const ExPolygon& expolygon, double flow_spacin
 
     return uncovered.empty(); // solid surface is fully filled
 }
+
+TEST_CASE("Lightning infill trees support the overhangs of a sphere", "[Fill]") {
+    // The infill below the top shells of the upper half of a sphere overhangs.
+    Slic3r::Print print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print({ Slic3r::Test::TestMesh::sphere_50mm }, print, model, {
+        { "layer_height",           0.3 },
+        { "sparse_infill_pattern",  "lightning" },
+        { "sparse_infill_density",  "20%" }
+        });
+    print.process();
+    const PrintObject &object = *print.objects().front();
+    FillLightning::GeneratorPtr generator = FillLightning::build_generator(object, []() {});
+
+    // Each overhanging point shall be closer to a tree of its layer than the supporting radius of the generator.
+    const PrintRegionConfig &region_config = object.shared_regions()->all_regions.front()->config();
+    const double  line_width        = region_config.sparse_infill_line_width.get_abs_value(print.config().nozzle_diameter.get_at(0));
+    REQUIRE(line_width > 0.);
+    const coord_t supporting_radius = coord_t(scaled<double>(line_width) * 100. * region_config.fill_multiline.value / region_config.sparse_infill_density.value);
+    // The generator samples the overhangs on a grid of a sixth of the supporting radius.
+    const coord_t cell_size         = supporting_radius / 6;
+    // The trees are not clipped.
+    const Polygons no_clipping { Polygon::new_scale({ { -1000., -1000. }, { 1000., -1000. }, { 1000., 1000. }, { -1000., 1000. } }) };
+
+    size_t num_overhang_layers = 0;
+    size_t num_points          = 0;
+    size_t num_unsupported     = 0;
+    for (size_t layer_id = 0; layer_id < object.layers().size(); ++ layer_id) {
+        // Sampled away from the boundary of the overhang, where the generator may sample it differently.
+        const ExPolygons overhang = offset_ex(union_ex(generator->Overhangs()[layer_id]), - float(cell_size));
+        if (overhang.empty())
+            continue;
+        ++ num_overhang_layers;
+        // The branches are shortened at the junctions by a negligible amount.
+        const Lines trees = to_lines(generator->getTreesForLayer(layer_id).convertToLines(no_clipping, SCALED_EPSILON));
+        for (const ExPolygon &expoly : overhang) {
+            const BoundingBox bbox = get_extents(expoly);
+            for (coord_t y = bbox.min.y(); y <= bbox.max.y(); y += cell_size)
+                for (coord_t x = bbox.min.x(); x <= bbox.max.x(); x += cell_size)
+                    if (const Point pt(x, y); expoly.contains(pt)) {
+                        ++ num_points;
+                        if (std::none_of(trees.begin(), trees.end(), [&pt, max_dist = double(supporting_radius + cell_size)](const Line &line) { return line.distance_to(pt) <= max_dist; }))
+                            ++ num_unsupported;
+                    }
+        }
+    }
+    REQUIRE(num_overhang_layers > 0);
+    REQUIRE(num_points > 0);
+    REQUIRE(num_unsupported == 0);
+}
+
+TEST_CASE("Lightning infill trees prepared in a pipeline match a single threaded run", "[Fill]") {
+    Slic3r::Print print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print({ Slic3r::Test::TestMesh::sphere_50mm }, print, model, {
+        { "layer_height",           0.3 },
+        { "sparse_infill_pattern",  "lightning" },
+        { "sparse_infill_density",  "20%" }
+        });
+    print.process();
+    const PrintObject &object = *print.objects().front();
+
+    // With a single thread, each layer is prepared just before its trees are propagated.
+    FillLightning::GeneratorPtr serial, pipelined;
+    tbb::task_arena(1).execute([&object, &serial]() { serial = FillLightning::build_generator(object, []() {}); });
+    // With several threads, the layers below are prepared while the trees of the layers above are propagated.
+    tbb::task_arena(4).execute([&object, &pipelined]() { pipelined = FillLightning::build_generator(object, []() {}); });
+
+    size_t num_nodes = 0;
+    for (size_t layer_id = 0; layer_id < object.layers().size(); ++ layer_id) {
+        const FillLightning::Layer &layer_serial    = serial->getTreesForLayer(layer_id);
+        const FillLightning::Layer &layer_pipelined = pipelined->getTreesForLayer(layer_id);
+        REQUIRE(layer_pipelined.tree_roots == layer_serial.tree_roots);
+        REQUIRE(layer_pipelined.nodes.size() == layer_serial.nodes.size());
+        for (FillLightning::NodeIdx node = 0; node < FillLightning::NodeIdx(layer_serial.nodes.size()); ++ node) {
+            REQUIRE(layer_pipelined.nodes[node].getLocation() == layer_serial.nodes[node].getLocation());
+            REQUIRE(layer_pipelined.nodes[node].isRoot() == layer_serial.nodes[node].isRoot());
+        }
+        num_nodes += layer_serial.nodes.size();
+    }
+    REQUIRE(num_nodes > 0);
+}
+
+// Resident memory of the process in kB, the current one for "VmRSS:", the peak one for "VmHWM:". Linux only.
+static size_t resident_memory_kB(const std::string &key)
+{
+    size_t out = 0;
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);)
+        if (boost::starts_with(line, key))
+            out = size_t(std::stoull(line.substr(key.size())));
+#endif // __linux__
+    return out;
+}
+
+static void reset_peak_resident_memory()
+{
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif // __linux__
+}
+
+// Uses only the interface of the generator, which did not change when its trees were moved into the node pools,
+// so that the figures may be compared with the shared_ptr trees by running the same test case on the older tree.
+TEST_CASE("Benchmark Lightning infill generator", "[Fill][Benchmark][.]") {
+    // Many thin layers of a sphere, so that the trees are propagated through a large number of layers.
+    Slic3r::Print print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print({ Slic3r::Test::TestMesh::sphere_50mm }, print, model, {
+        { "layer_height",           0.1 },
+        { "sparse_infill_pattern",  "lightning" },
+        { "sparse_infill_density",  "20%" }
+        });
+    print.process();
+    const PrintObject &object = *print.objects().front();
+
+    reset_peak_resident_memory();
+    const size_t memory_before = resident_memory_kB("VmRSS:");
+    auto t_start = std::chrono::high_resolution_clock::now();
+    FillLightning::GeneratorPtr generator = FillLightning::build_generator(object, []() {});
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+    const size_t memory_peak = resident_memory_kB("VmHWM:");
+
+    const Polygons no_clipping { Polygon::new_scale({ { -1000., -1000. }, { 1000., -1000. }, { 1000., 1000. }, { -1000., 1000. } }) };
+    size_t num_points = 0;
+    for (size_t layer_id = 0; layer_id < object.layers().size(); ++ layer_id)
+        for (const Polyline &polyline : generator->getTreesForLayer(layer_id).convertToLines(no_clipping, SCALED_EPSILON))
+            num_points += polyline.size();
+    WARN("Lightning generator: " << object.layers().size() << " layers, " << num_points << " tree polyline points, " << seconds << " s, "
+        "peak resident memory " << memory_peak / 1024 << " MB, before " << memory_before / 1024 << " MB");
+
+    BENCHMARK("build_generator") { return FillLightning::build_generator(object, []() {}); };
+}
@@ -1,8 +1,18 @@
 #include <catch2/catch_all.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <memory>
 
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/GCodeLines.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+#include "libslic3r/GCode/PressureEqualizer.hpp"
+#include "libslic3r/LocalesUtils.hpp"
+
+#include <tbb/task_arena.h>
 
 using namespace Slic3r;
 
@@ -20,3 +30,177 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+TEST_CASE("PressureEqualizer produces the same G-code from tokenized lines", "[GCode]") {
+    CNumericLocalesSetter locales_setter;
+
+    GCodeConfig config;
+    config.filament_diameter.values = { 1.75 };
+    config.max_volumetric_extrusion_rate_slope.value = 1.5;
+    config.max_volumetric_extrusion_rate_slope_segment_length.value = 3.;
+
+    // Layers of extrusions alternating between slow and fast feed rates, so that the transitions get smoothed.
+    std::vector<std::string> layers;
+    for (size_t layer_id = 0; layer_id < 4; ++ layer_id) {
+        std::string gcode = "G1 Z" + std::to_string(0.2 * double(layer_id + 1)) + " F600\n;_EXTRUSION_ROLE:1\n";
+        float e = 0.f;
+        for (int i = 0; i < 20; ++ i) {
+            e += 0.05f;
+            gcode += std::string(i == 0 ? ";_EXTRUDE_SET_SPEED\n" : "") +
+                     "G1 X" + std::to_string(10 + (i % 2) * 20) + " Y" + std::to_string(10 + i) +
+                     " E" + std::to_string(e) + " F" + std::to_string(i % 4 < 2 ? 600 : 9000) + "\n";
+        }
+        gcode += ";_EXTRUDE_END\nG92 E0\nG1 E-0.8 F2100\nG1 X5 Y5 F12000\nG1 E0 F2100\n";
+        layers.emplace_back(std::move(gcode));
+    }
+
+    auto run = [&config](const std::vector<std::string> &layers, bool tokenized) {
+        PressureEqualizer pressure_equalizer(config);
+        std::string out;
+        for (size_t layer_id = 0; layer_id <= layers.size(); ++ layer_id) {
+            LayerResult in = layer_id < layers.size() ? LayerResult{ layers[layer_id], layer_id, false, false, false } : LayerResult::make_nop_layer_result();
+            if (tokenized) {
+                GCodeLines lines(std::string(in.gcode));
+                GCodeLines out_lines;
+                pressure_equalizer.process_layer(std::move(in), std::move(lines), out_lines);
+                out += out_lines.str();
+            } else
+                out += pressure_equalizer.process_layer(std::move(in)).gcode;
+        }
+        return out;
+    };
+    const std::string text   = run(layers, false);
+    const std::string tokens = run(layers, true);
+    REQUIRE(! text.empty());
+    REQUIRE(tokens == text);
+
+    SECTION("Lower case axes are recognized") {
+        auto to_upper = [](std::string s) { std::transform(s.begin(), s.end(), s.begin(), [](char c) { return char(::toupper(c)); }); return s; };
+        std::vector<std::string> lower_case_layers;
+        for (std::string gcode : layers) {
+            for (size_t i = 1; i < gcode.size(); ++ i)
+                if (gcode[i - 1] == ' ' && strchr("XYZEF", gcode[i]) != nullptr)
+                    gcode[i] = char(::tolower(gcode[i]));
+            lower_case_layers.emplace_back(std::move(gcode));
+        }
+        REQUIRE(to_upper(run(lower_case_layers, true)) == to_upper(text));
+        REQUIRE(to_upper(run(lower_case_layers, false)) == to_upper(text));
+    }
+}
+
+TEST_CASE("G-code kept in memory is deflated in blocks and read back unchanged", "[GCode]") {
+    std::string gcode;
+    GCodeMemoryBuffer buffer;
+    for (int i = 0; gcode.size() < 3 * GCodeMemoryBuffer::block_size + 12345; ++ i) {
+        const std::string line = "G1 X" + std::to_string(10 + i % 200) + " Y" + std::to_string(20 + i % 170) + " E" + std::to_string(0.001 * i) + "\n";
+        gcode  += line;
+        buffer.append(line.data(), line.size());
+    }
+    buffer.finish();
+    REQUIRE(buffer.size() == gcode.size());
+    REQUIRE(buffer.num_chunks() == 4);
+    REQUIRE(buffer.memory_used() < gcode.size() / 2);
+
+    std::string read_back, chunk;
+    for (size_t i = 0; i < buffer.num_chunks(); ++ i) {
+        buffer.read_chunk(i, chunk);
+        read_back += chunk;
+    }
+    REQUIRE(read_back == gcode);
+
+    // The reader decompresses the following chunks in parallel.
+    read_back.clear();
+    GCodeMemoryBuffer::Reader reader(buffer);
+    for (;;) {
+        const std::string &chunk = reader.next();
+        if (chunk.empty())
+            break;
+        read_back += chunk;
+    }
+    REQUIRE(read_back == gcode);
+}
+
+// Layers of short extrusions alternating between slow and fast feed rates, so that the planner has work to do.
+static std::string time_estimation_gcode(int num_layers, bool dwell)
+{
+    std::string gcode = "G90\nM83\n";
+    char buf[256];
+    for (int layer = 0; layer < num_layers; ++ layer) {
+        snprintf(buf, sizeof(buf), ";LAYER_CHANGE\n;Z:%.2f\nG1 Z%.2f F600\n", 0.2 * (layer + 1), 0.2 * (layer + 1));
+        gcode += buf;
+        for (int i = 0; i < 2000; ++ i) {
+            const double a = i * 0.05 + layer;
+            const double r = 20. + 10. * std::sin(i * 0.37);
+            snprintf(buf, sizeof(buf), "G1 X%.3f Y%.3f E%.5f F%d\n", 100. + r * std::cos(a), 100. + r * std::sin(a), 0.02 + 0.01 * (i % 3), i % 7 < 3 ? 1800 : 9000);
+            gcode += buf;
+        }
+        if (dwell && layer % 4 == 3)
+            // Flush the planner in the middle of the deferred windows.
+            gcode += "G4 P500\n";
+    }
+    return gcode;
+}
+
+TEST_CASE("GCodeProcessor time machines simulated in parallel", "[GCode]") {
+    CNumericLocalesSetter locales_setter;
+    const std::string gcode = time_estimation_gcode(40, true);
+
+    auto process = [&gcode](bool stealth, std::vector<GCodeProcessorResult::MoveVertex> &moves) {
+        GCodeProcessor processor;
+        processor.apply_config(static_cast<const PrintConfig&>(FullPrintConfig::defaults()));
+        processor.enable_stealth_time_estimator(stealth);
+        processor.initialize("test.gcode");
+        processor.initialize_result_moves();
+        processor.process_buffer(gcode);
+        processor.finalize(false);
+        moves = processor.get_result().moves;
+        return processor.get_time(PrintEstimatedStatistics::ETimeMode::Normal);
+    };
+    // The Normal time machine simulated alone serves as a reference for the one simulated together with the Stealth machine.
+    std::vector<GCodeProcessorResult::MoveVertex> moves_normal;
+    const float time_normal = process(false, moves_normal);
+    std::vector<GCodeProcessorResult::MoveVertex> moves_stealth;
+    float time_stealth = 0.f;
+    tbb::task_arena arena(4);
+    arena.execute([&]() { time_stealth = process(true, moves_stealth); });
+
+    REQUIRE(time_normal > 0.f);
+    REQUIRE(time_stealth == time_normal);
+    REQUIRE(moves_stealth.size() == moves_normal.size());
+    size_t num_mismatches = 0;
+    size_t num_stealth_times = 0;
+    for (size_t i = 0; i < moves_normal.size(); ++ i) {
+        const GCodeProcessorResult::MoveVertex &a = moves_normal[i];
+        const GCodeProcessorResult::MoveVertex &b = moves_stealth[i];
+        if (a.time[0] != b.time[0] || a.actual_feedrate != b.actual_feedrate || a.position != b.position)
+            ++ num_mismatches;
+        if (b.time[1] > 0.f)
+            ++ num_stealth_times;
+    }
+    CHECK(num_mismatches == 0);
+    // Each extrusion got its Stealth time.
+    CHECK(num_stealth_times >= 40 * 2000);
+}
+
+TEST_CASE("Benchmark GCodeProcessor time estimation", "[GCode][Benchmark][.]") {
+    CNumericLocalesSetter locales_setter;
+    const std::string gcode = time_estimation_gcode(200, false);
+
+    // The stealth time machine simulates the same blocks with its own limits, compare the cost with and without it.
+    auto process = [&gcode](bool stealth) {
+        GCodeProcessor processor;
+        processor.apply_config(static_cast<const PrintConfig&>(FullPrintConfig::defaults()));
+        processor.enable_stealth_time_estimator(stealth);
+        processor.initialize("benchmark.gcode");
+        processor.initialize_result_moves();
+        processor.process_buffer(gcode);
+        processor.finalize(false);
+        return processor.get_time(PrintEstimatedStatistics::ETimeMode::Normal);
+    };
+    for (bool stealth : { false, true }) {
+        auto   t_start = std::chrono::high_resolution_clock::now();
+        float  time    = process(stealth);
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+        WARN("GCodeProcessor, " << (stealth ? "normal and stealth" : "normal") << " time machine: " << seconds << " s, estimated print time " << time << " s");
+    }
+}
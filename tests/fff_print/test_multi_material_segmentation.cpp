@@ -0,0 +1,89 @@
+#include <catch2/catch_all.hpp>
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/Layer.hpp"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/MultiMaterialSegmentation.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/TriangleSelector.hpp"
+
+#include "test_data.hpp"
+
+#include <chrono>
+
+using namespace Slic3r;
+using namespace Slic3r::Test;
+
+static DynamicPrintConfig multi_material_config(size_t num_filaments, double layer_height)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({ { "layer_height", layer_height } });
+    config.set_key_value("nozzle_diameter", new ConfigOptionFloats(num_filaments, 0.4));
+    config.set_key_value("filament_colour", new ConfigOptionStrings(num_filaments, "#FFFFFF"));
+    return config;
+}
+
+// Paint each facet of the single volume of the single object with the filament returned by facet_filament,
+// and process the print with the painted model.
+template<typename FacetFilament>
+static void init_painted_print(TriangleMesh &&mesh, Print &print, Model &model, const DynamicPrintConfig &config, FacetFilament facet_filament)
+{
+    std::vector<TriangleMesh> meshes;
+    meshes.emplace_back(std::move(mesh));
+    init_print(std::move(meshes), print, model, config);
+
+    ModelVolume            &volume = *model.objects.front()->volumes.front();
+    const TriangleMesh     &painted_mesh = volume.mesh();
+    const BoundingBoxf3     bbox         = painted_mesh.bounding_box();
+    TriangleSelector        selector(painted_mesh);
+    for (size_t facet_idx = 0; facet_idx < painted_mesh.its.indices.size(); ++ facet_idx) {
+        const stl_triangle_vertex_indices &facet = painted_mesh.its.indices[facet_idx];
+        const Vec3d centroid = (painted_mesh.its.vertices[facet(0)] + painted_mesh.its.vertices[facet(1)] + painted_mesh.its.vertices[facet(2)]).cast<double>() / 3.;
+        selector.set_facet(int(facet_idx), EnforcerBlockerType(facet_filament(Vec3d(centroid - bbox.center()), bbox.size())));
+    }
+    volume.mmu_segmentation_facets.set(selector);
+
+    print.apply(model, config);
+    print.process();
+}
+
+TEST_CASE("Painted halves of a sphere are segmented into two regions", "[MultiMaterialSegmentation]") {
+    Print print;
+    Model model;
+    init_painted_print(make_sphere(10., 2. * PI / 90.), print, model, multi_material_config(2, 0.2),
+        [](const Vec3d &p, const Vec3d &) { return p.x() > 0. ? 2 : 1; });
+
+    const PrintObject                   &object       = *print.objects().front();
+    std::vector<std::vector<ExPolygons>> segmentation = multi_material_segmentation_by_painting(object, []() {});
+    REQUIRE(segmentation.size() == object.layers().size());
+
+    // A layer in the middle of the sphere is split into two halves of about the same area.
+    const size_t layer_idx  = object.layers().size() / 2;
+    const double layer_area = area(object.get_layer(int(layer_idx))->lslices);
+    REQUIRE(segmentation[layer_idx].size() == 2);
+    for (const ExPolygons &region : segmentation[layer_idx])
+        REQUIRE(area(region) == Catch::Approx(0.5 * layer_area).epsilon(0.1));
+}
+
+TEST_CASE("Benchmark multi-material segmentation of a painted sphere", "[MultiMaterialSegmentation][Benchmark][.]") {
+    // A finely tessellated sphere painted with a checkerboard of four filaments, thin layers.
+    Print print;
+    Model model;
+    init_painted_print(make_sphere(25., 2. * PI / 360.), print, model, multi_material_config(4, 0.1),
+        [](const Vec3d &p, const Vec3d &size) {
+            const int band_z     = int((p.z() + 0.5 * size.z()) / 2.);
+            const int band_angle = int((std::atan2(p.y(), p.x()) + PI) / (PI / 8.));
+            return 1 + (band_z + band_angle) % 4;
+        });
+    const PrintObject &object = *print.objects().front();
+
+    auto   t_start = std::chrono::high_resolution_clock::now();
+    size_t num_painted_layers = 0;
+    for (const std::vector<ExPolygons> &layer : multi_material_segmentation_by_painting(object, []() {}))
+        num_painted_layers += std::count_if(layer.begin(), layer.end(), [](const ExPolygons &region) { return !region.empty(); }) > 1;
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+    WARN("multi_material_segmentation_by_painting: " << object.layers().size() << " layers, " << num_painted_layers << " multi-colored, " << seconds << " s");
+
+    BENCHMARK("multi_material_segmentation_by_painting") { return multi_material_segmentation_by_painting(object, []() {}); };
+}
@@ -4,6 +4,8 @@
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
 
+#include <boost/filesystem.hpp>
+
 #include "test_data.hpp"
 
 using namespace Slic3r;
@@ -138,3 +140,85 @@ SCENARIO("Print: Brim generation", "[Print][.]") {
         }
     }
 }
+
+SCENARIO("Print: Slice cache keys follow the height range modifiers", "[Print]") {
+    GIVEN("20mm cube with a height range modifier, sliced and stored in the slice cache") {
+        const boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slice_cache_%%%%-%%%%");
+        const DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        Slic3r::Model model;
+        Slic3r::Print print;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        ModelObject &object = *model.objects.front();
+        ModelConfig range_config;
+        range_config.set_key_value("wall_loops", new ConfigOptionInt(4));
+        object.layer_config_ranges[{ 2., 6. }] = range_config;
+        print.apply(model, config);
+        print.process();
+        REQUIRE(print.store_slice_cache(cache_dir.string()) == 0);
+
+        size_t hits = 0, misses = 0;
+        WHEN("the unchanged object is loaded from the cache") {
+            print.load_slice_cache(cache_dir.string(), hits, misses);
+            THEN("the cache is hit") {
+                REQUIRE(hits == 1);
+                REQUIRE(misses == 0);
+            }
+        }
+        WHEN("the height range is moved") {
+            const std::string key = print.slice_cache_key(print.objects().front());
+            object.layer_config_ranges.clear();
+            object.layer_config_ranges[{ 8., 12. }] = range_config;
+            print.apply(model, config);
+            print.load_slice_cache(cache_dir.string(), hits, misses);
+            THEN("the cache key changes and the cache is missed") {
+                REQUIRE(print.slice_cache_key(print.objects().front()) != key);
+                REQUIRE(hits == 0);
+                REQUIRE(misses == 1);
+            }
+        }
+        boost::filesystem::remove_all(cache_dir);
+    }
+}
+
+SCENARIO("Print: SeamPlacer model visibility is kept between exports", "[Print]") {
+    GIVEN("20mm cube with aligned seams, exported once") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "seam_position", "aligned" } });
+        Slic3r::Model model;
+        Slic3r::Print print;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        Slic3r::Test::gcode(print);
+        const auto model_info = print.objects().front()->seam_model_info();
+        REQUIRE(model_info);
+
+        WHEN("a setting unrelated to the seams changes and the G-code is exported again") {
+            config.set_deserialize_strict({ { "outer_wall_speed", "33" } });
+            print.apply(model, config);
+            Slic3r::Test::gcode(print);
+            THEN("the model visibility is reused") {
+                REQUIRE(print.objects().front()->seam_model_info() == model_info);
+            }
+        }
+        WHEN("the seam position changes and the G-code is exported again") {
+            config.set_deserialize_strict({ { "seam_position", "back" } });
+            print.apply(model, config);
+            Slic3r::Test::gcode(print);
+            THEN("the model visibility is computed again") {
+                REQUIRE(print.objects().front()->seam_model_info());
+                REQUIRE(print.objects().front()->seam_model_info() != model_info);
+            }
+        }
+        WHEN("the part is scaled") {
+            model.objects.front()->volumes.front()->set_scaling_factor(Vec3d(1., 1., 0.5));
+            print.apply(model, config);
+            THEN("the model visibility is released with the slices") {
+                REQUIRE(! print.objects().front()->seam_model_info());
+            }
+            Slic3r::Test::gcode(print);
+            THEN("the next export computes it again") {
+                REQUIRE(print.objects().front()->seam_model_info());
+                REQUIRE(print.objects().front()->seam_model_info() != model_info);
+            }
+        }
+    }
+}
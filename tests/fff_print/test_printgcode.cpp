@@ -16,7 +16,11 @@
 #include "test_data.hpp"
 
 #include <algorithm>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
 #include <boost/regex.hpp>
+#include <tbb/global_control.h>
 
 using namespace Slic3r;
 using namespace Slic3r::Test;
@@ -279,3 +283,28 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode][.]") {
         }
     }
 }
+
+TEST_CASE("Benchmark G-code export vs. number of threads", "[PrintGCode][Benchmark][.]") {
+    // Several objects with many thin layers, so that the per layer post-processing of process_layers() dominates.
+    Slic3r::Print print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print({ TestMesh::cube_20x20x20, TestMesh::pyramid, TestMesh::ipadstand, TestMesh::overhang }, print, model, {
+        { "layer_height",                   0.05 },
+        { "initial_layer_print_height",     0.2 },
+        { "slow_down_for_layer_cooling",    "1" },
+        { "wall_loops",                     3 }
+        });
+    print.process();
+
+    const size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (size_t num_threads : { 1, 2, 4, 8, 16, 32 }) {
+        if (num_threads > max_threads)
+            break;
+        tbb::global_control control(tbb::global_control::max_allowed_parallelism, num_threads);
+        BENCHMARK("export_gcode, " + std::to_string(num_threads) + " threads") {
+            boost::filesystem::path temp = boost::filesystem::unique_path();
+            print.export_gcode(temp.string(), nullptr, nullptr);
+            boost::nowide::remove(temp.string().c_str());
+        };
+    }
+}
@@ -3,6 +3,7 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Arachne/WallToolPaths.hpp"
 
 #include "test_data.hpp"
 
@@ -87,3 +88,49 @@ SCENARIO("PrintObject: object layer heights", "[PrintObject][.]") {
 #endif
     }
 }
+
+TEST_CASE("PrintObject: Arachne walls are reused for layers with the same outline", "[PrintObject]") {
+    Slic3r::Print print;
+    Slic3r::Test::init_and_process_print({TestMesh::cube_with_hole}, print, {
+        { "wall_generator", "arachne" },
+        { "layer_height",   0.2 },
+        { "wall_loops",     3 }
+    });
+    const PrintObject &object = *print.objects().front();
+    const Arachne::WallToolPathsCache *cache = object.wall_tool_paths_cache();
+    REQUIRE(cache != nullptr);
+    // The outlines of the layers of the prism are the same except for the first and the top most layers,
+    // some of the other layers are generated twice by the threads starting at the same time.
+    REQUIRE(cache->lookups() >= object.layer_count());
+    REQUIRE(cache->hits() * 2 >= cache->lookups());
+    WARN("Arachne walls reused for " << cache->hits() << " of " << cache->lookups() << " islands");
+
+    // The reused walls are the same as the generated ones.
+    const ExtrusionEntityCollection &generated = object.get_layer(int(object.layer_count() / 2))->regions().front()->perimeters;
+    const ExtrusionEntityCollection &reused    = object.get_layer(int(object.layer_count() / 2) + 1)->regions().front()->perimeters;
+    REQUIRE(generated.flatten().entities.size() == reused.flatten().entities.size());
+    REQUIRE(generated.length() == Catch::Approx(reused.length()));
+    // The walls are released once copied to the layers.
+    REQUIRE(cache->size() == 0);
+}
+
+TEST_CASE("PrintObject: Arachne walls cache keeps the recently used walls only", "[PrintObject]") {
+    const Arachne::WallToolPathsParams params = Arachne::make_paths_params(1, PrintObjectConfig::defaults(), PrintConfig::defaults());
+    auto square = [](double size) { return Polygons{ Polygon::new_scale({ { 0., 0. }, { size, 0. }, { size, size }, { 0., size } }) }; };
+    auto generate = [&params](Arachne::WallToolPathsCache &cache, const Polygons &outline) {
+        return cache.generate(outline, scaled<coord_t>(0.4), scaled<coord_t>(0.4), 2, 0, 0.2, params);
+    };
+    Arachne::WallToolPathsCache cache(2);
+    generate(cache, square(10.));
+    generate(cache, square(11.));
+    // Refresh the first square, the second one becomes the least recently used.
+    generate(cache, square(10.));
+    generate(cache, square(12.));
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.hits() == 1);
+    generate(cache, square(10.));
+    REQUIRE(cache.hits() == 2);
+    generate(cache, square(11.));
+    REQUIRE(cache.hits() == 2);
+    REQUIRE(cache.size() == 2);
+}
@@ -1,10 +1,17 @@
 #include <catch2/catch_all.hpp>
 
+#include "libslic3r/BuildVolume.hpp"
 #include "libslic3r/GCodeReader.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Support/TreeModelVolumes.hpp"
+#include "libslic3r/Support/TreeSupportCommon.hpp"
 
 #include "test_data.hpp" // get access to init_print, etc
 
+#include <chrono>
+
+#include <tbb/global_control.h>
+
 using namespace Slic3r::Test;
 using namespace Slic3r;
 
@@ -236,3 +243,96 @@ SCENARIO("SupportMaterial: Checking bridge speed", "[SupportMaterial]")
 }
 
 #endif
+
+SCENARIO("SupportMaterial: tree support volumes are reused when the geometry did not change", "[SupportMaterial]")
+{
+    auto support_islands = [](const Print &print) {
+        std::vector<ExPolygons> out;
+        for (const SupportLayer *layer : print.objects().front()->support_layers())
+            out.emplace_back(layer->support_islands);
+        return out;
+    };
+    // The supports generated with the reused volumes are the same as the supports generated from scratch.
+    auto require_same_as_fresh_print = [&support_islands](const Print &print, const DynamicPrintConfig &config) {
+        Slic3r::Model model;
+        Slic3r::Print fresh;
+        Slic3r::Test::init_print({ TestMesh::overhang }, fresh, model, config);
+        fresh.process();
+        REQUIRE(fresh.objects().front()->tree_model_volumes()->reused_caches() == 0);
+        REQUIRE(support_islands(print) == support_islands(fresh));
+    };
+
+    GIVEN("an overhang supported by organic tree supports") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "enable_support", 1 },
+            { "support_type", "tree(auto)" },
+            { "support_style", "organic" }
+            });
+        Slic3r::Model model;
+        Slic3r::Print print;
+        Slic3r::Test::init_print({ TestMesh::overhang }, print, model, config);
+        print.process();
+        REQUIRE(print.objects().front()->tree_model_volumes());
+        REQUIRE(print.objects().front()->tree_model_volumes()->cache_stats().inserts > 0);
+        REQUIRE(! print.objects().front()->support_layers().empty());
+
+        WHEN("the branch distance changes and the supports are generated again") {
+            config.set_deserialize_strict({ { "tree_support_branch_distance_organic", "2" } });
+            print.apply(model, config);
+            print.process();
+            THEN("both the collision and the avoidance areas are reused") {
+                REQUIRE(print.objects().front()->tree_model_volumes()->reused_caches() == 2);
+                require_same_as_fresh_print(print, config);
+            }
+        }
+        WHEN("the branch diameter changes and the supports are generated again") {
+            config.set_deserialize_strict({ { "tree_support_branch_diameter_organic", "5" } });
+            print.apply(model, config);
+            print.process();
+            THEN("the collision areas are reused") {
+                REQUIRE(print.objects().front()->tree_model_volumes()->reused_caches() == 1);
+                require_same_as_fresh_print(print, config);
+            }
+        }
+        WHEN("the object is scaled") {
+            model.objects.front()->scale(1.1);
+            print.apply(model, config);
+            THEN("the volumes of the previous support generation are released") {
+                REQUIRE(! print.objects().front()->tree_model_volumes());
+            }
+        }
+    }
+}
+
+TEST_CASE("Benchmark tree support collision and avoidance precalculation", "[SupportMaterial][Benchmark][.]")
+{
+    // The bottom half of the sphere overhangs, thin layers make for many layers of the collision and avoidance caches.
+    Slic3r::Print print;
+    Slic3r::Test::init_and_process_print({ TestMesh::sphere_50mm }, print, {
+        { "layer_height", 0.1 },
+        { "enable_support", 1 },
+        { "support_type", "tree(auto)" },
+        { "support_style", "organic" }
+        });
+    const PrintObject &object = *print.objects().front();
+
+    TreeSupport3D::TreeSupportMeshGroupSettings mesh_settings(object);
+    const TreeSupport3D::TreeSupportSettings    config{ mesh_settings, object.slicing_parameters() };
+    const BuildVolume                           build_volume{ { { 0., 0. }, { 250., 0. }, { 250., 250. }, { 0., 250. } }, 250., {}, {} };
+
+    auto precalculate = [&]() {
+        TreeSupport3D::TreeModelVolumes volumes{ object, build_volume, config.maximum_move_distance, config.maximum_move_distance_slow, 0, {} };
+        auto t_start = std::chrono::high_resolution_clock::now();
+        volumes.precalculate(object, coord_t(object.layer_count()) - 1, []() {});
+        return std::make_pair(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count(), volumes.cache_stats());
+    };
+    for (size_t num_threads : { 1, 4, 16, 32 }) {
+        tbb::global_control limit(tbb::global_control::max_allowed_parallelism, num_threads);
+        auto [seconds, stats] = precalculate();
+        WARN("TreeModelVolumes::precalculate, " << num_threads << " threads: " << seconds << " s, " <<
+            stats.inserts << " cache inserts, " << stats.contended_inserts << " contended");
+    }
+
+    BENCHMARK("TreeModelVolumes::precalculate") { return precalculate().first; };
+}
@@ -11,6 +11,8 @@
 #include <future>
 #include <chrono>
 
+#include <tbb/task_arena.h>
+
 //#include "test_options.hpp"
 #include "test_data.hpp"
 
@@ -177,6 +179,155 @@ SCENARIO( "TriangleMesh: slice behavior.") {
     }
 }
 
+SCENARIO( "TriangleMeshSlicer: cached slicing behavior.") {
+    GIVEN( "A sphere and a slicing cache") {
+        const TriangleMesh  sphere = make_sphere(10., 2. * PI / 90.);
+        MeshSlicingParamsEx params;
+        params.trafo = Transform3d(Eigen::Translation3d(0., 0., 10.));
+        MeshSlicingCache    cache;
+        auto make_zs = [](float first, float last, float step) {
+            std::vector<float> zs;
+            for (float z = first; z < last; z += step)
+                zs.emplace_back(z);
+            return zs;
+        };
+        auto area = [](const ExPolygons &expolygons) {
+            double a = 0;
+            for (const ExPolygon &expoly : expolygons)
+                a += expoly.area();
+            return a;
+        };
+        std::vector<float>      zs     = make_zs(0.1f, 20.f, 0.2f);
+        std::vector<ExPolygons> layers = slice_mesh_ex(sphere.its, zs, params, cache);
+        THEN( "The first slicing slices all the layers, the result matches slicing without the cache.") {
+            REQUIRE(cache.hits == 0);
+            REQUIRE(cache.misses == zs.size());
+            std::vector<ExPolygons> reference = slice_mesh_ex(sphere.its, zs, params);
+            REQUIRE(layers.size() == reference.size());
+            for (size_t i = 0; i < layers.size(); ++ i)
+                REQUIRE(area(layers[i]) == Catch::Approx(area(reference[i])));
+        }
+        WHEN( "The layers above 10mm are sliced with a different layer height") {
+            std::vector<float> zs2 = make_zs(0.1f, 20.f, 0.2f);
+            zs2.erase(std::upper_bound(zs2.begin(), zs2.end(), 10.f), zs2.end());
+            size_t num_reused = zs2.size();
+            for (float z = zs2.back() + 0.1f; z < 20.f; z += 0.1f)
+                zs2.emplace_back(z);
+            std::vector<ExPolygons> layers2 = slice_mesh_ex(sphere.its, zs2, params, cache);
+            THEN( "Only the modified layers are sliced again") {
+                REQUIRE(cache.hits == num_reused);
+                REQUIRE(cache.misses == zs2.size() - num_reused);
+                std::vector<ExPolygons> reference = slice_mesh_ex(sphere.its, zs2, params);
+                for (size_t i = 0; i < layers2.size(); ++ i)
+                    REQUIRE(area(layers2[i]) == Catch::Approx(area(reference[i])));
+            }
+        }
+        WHEN( "The same layers are sliced with a dirty interval") {
+            slice_mesh_ex(sphere.its, zs, params, cache, { 5.f, 7.f });
+            THEN( "Only the layers inside the dirty interval are sliced again") {
+                const size_t num_dirty = std::count_if(zs.begin(), zs.end(), [](float z) { return z >= 5.f && z <= 7.f; });
+                REQUIRE(num_dirty > 0);
+                REQUIRE(cache.misses == num_dirty);
+                REQUIRE(cache.hits == zs.size() - num_dirty);
+            }
+        }
+        THEN( "The memory held by the cache is accounted for") {
+            REQUIRE(cache.memory_used() > cache.layers.size() * sizeof(MeshSlicingCache::Layer));
+        }
+        THEN( "The cache keeps the expolygons only, not the loops they were made of") {
+            REQUIRE(std::all_of(cache.layers.begin(), cache.layers.end(),
+                [](const MeshSlicingCache::Layer &layer) { return layer.expolygons_valid && layer.loops.empty(); }));
+        }
+        WHEN( "The same layers are sliced with a different closing radius") {
+            params.closing_radius = 0.1f;
+            slice_mesh_ex(sphere.its, zs, params, cache);
+            THEN( "All the layers are sliced again") {
+                REQUIRE(cache.hits == 0);
+                REQUIRE(cache.misses == zs.size());
+            }
+        }
+        WHEN( "The transformation changes") {
+            params.trafo = Transform3d(Eigen::Translation3d(0., 0., 9.));
+            slice_mesh_ex(sphere.its, zs, params, cache);
+            THEN( "All the layers are sliced again") {
+                REQUIRE(cache.hits == 0);
+            }
+        }
+        WHEN( "A new cache is given the slicing index of the previous one") {
+            MeshSlicingCache cache2;
+            cache2.index = cache.index;
+            std::vector<ExPolygons> layers2 = slice_mesh_ex(sphere.its, zs, params, cache2);
+            THEN( "The index is reused, the layers are sliced with it") {
+                REQUIRE(cache2.index == cache.index);
+                REQUIRE(cache2.misses == zs.size());
+                for (size_t i = 0; i < layers2.size(); ++ i)
+                    REQUIRE(area(layers2[i]) == Catch::Approx(area(layers[i])));
+            }
+        }
+        WHEN( "The layers are sliced with the index without a cache") {
+            std::vector<ExPolygons> layers2 = slice_mesh_ex(sphere.its, zs, params, *cache.index);
+            THEN( "The result matches slicing with the cache") {
+                REQUIRE(layers2.size() == layers.size());
+                for (size_t i = 0; i < layers2.size(); ++ i)
+                    REQUIRE(area(layers2[i]) == Catch::Approx(area(layers[i])));
+            }
+        }
+    }
+}
+
+TEST_CASE("FacetZIndex built in parallel matches a serial counting sort", "[TriangleMeshSlicer]") {
+    // About 130k facets, split into multiple blocks counted and scattered in parallel.
+    const TriangleMesh sphere = make_sphere(10., 2. * PI / 360.);
+    const std::vector<Vec3f> &vertices = sphere.its.vertices;
+    tbb::task_arena arena(4);
+    FacetZIndex index;
+    arena.execute([&]() { index = FacetZIndex(vertices, sphere.its.indices); });
+    REQUIRE(index.num_buckets() > 1);
+    // Each face is registered in each bucket its Z span overlaps, the faces of a bucket are sorted.
+    std::vector<std::vector<uint32_t>> reference(index.num_buckets());
+    for (size_t face_idx = 0; face_idx < sphere.its.indices.size(); ++ face_idx)
+        for (size_t bucket = index.bucket_of(index.face_min_z[face_idx]); bucket <= index.bucket_of(index.face_max_z[face_idx]); ++ bucket)
+            reference[bucket].emplace_back(uint32_t(face_idx));
+    for (size_t bucket = 0; bucket < index.num_buckets(); ++ bucket)
+        REQUIRE(std::vector<uint32_t>(index.bucket_faces.begin() + index.bucket_begin[bucket], index.bucket_faces.begin() + index.bucket_begin[bucket + 1]) == reference[bucket]);
+}
+
+TEST_CASE("Benchmark slicing a large mesh with the facet Z index", "[TriangleMeshSlicer][Benchmark][.]") {
+    // About 5.3M facets.
+    const TriangleMesh sphere = make_sphere(50., 2. * PI / 2300.);
+    MeshSlicingParamsEx params;
+    params.trafo = Transform3d(Eigen::Translation3d(0., 0., 50.));
+    std::vector<float> zs;
+    for (float z = 0.1f; z < 100.f; z += 0.2f)
+        zs.emplace_back(z);
+    // Ten layers in the middle moved, as if their height was edited.
+    std::vector<float> zs_edited = zs;
+    for (size_t i = zs.size() / 2; i < zs.size() / 2 + 10; ++ i)
+        zs_edited[i] += 0.05f;
+
+    const size_t num_threads = size_t(std::max(1, tbb::this_task_arena::max_concurrency()));
+    auto facets_per_second_per_core = [&sphere, num_threads](auto &&fn) {
+        auto t_start = std::chrono::high_resolution_clock::now();
+        fn();
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+        return double(sphere.its.indices.size()) / seconds / double(num_threads);
+    };
+    MeshSlicingCache cache;
+    double full   = facets_per_second_per_core([&]() { slice_mesh_ex(sphere.its, zs, params); });
+    double cached = facets_per_second_per_core([&]() { slice_mesh_ex(sphere.its, zs, params, cache); });
+    double edited = facets_per_second_per_core([&]() { slice_mesh_ex(sphere.its, zs_edited, params, cache); });
+    REQUIRE(cache.misses == 10);
+    WARN(sphere.its.indices.size() << " facets, " << zs.size() << " layers, " << num_threads << " threads, facets / s / core: "
+        << "full " << full << ", full into cache " << cached << ", 10 edited layers with the cached index " << edited);
+
+    BENCHMARK("slice_mesh_ex all layers") { return slice_mesh_ex(sphere.its, zs, params); };
+    bool toggle = false;
+    BENCHMARK("slice_mesh_ex with 10 edited layers, cached") {
+        toggle = ! toggle;
+        return slice_mesh_ex(sphere.its, toggle ? zs : zs_edited, params, cache);
+    };
+}
+
 SCENARIO( "make_xxx functions produce meshes.") {
     GIVEN("make_cube() function") {
         WHEN("make_cube() is called with arguments 20,20,20") {
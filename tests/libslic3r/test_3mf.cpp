@@ -1,11 +1,20 @@
 
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/3mf.hpp"
+#include "libslic3r/Format/bbs_3mf.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/miniz_extension.hpp"
 
+#include <chrono>
+#include <sstream>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
 
 #include <catch2/catch_tostring.hpp>
+#include <tbb/task_arena.h>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <type_traits> // for std::enable_if_t
@@ -133,6 +142,285 @@ SCENARIO("Export+Import geometry to/from 3mf file cycle", "[3mf]") {
     }
 }
 
+static bool store_bbs_3mf_model(const std::string &path, Model &model, SaveStrategy strategy = SaveStrategy::Default)
+{
+    DynamicPrintConfig config;
+    StoreParams        store_params;
+    store_params.path     = path.c_str();
+    store_params.model    = &model;
+    store_params.config   = &config;
+    store_params.strategy = SaveStrategy::Silence | SaveStrategy::SplitModel | SaveStrategy::SkipStatic | strategy;
+    return store_bbs_3mf(store_params);
+}
+
+static bool load_bbs_3mf_model(const std::string &path, Model &model)
+{
+    DynamicPrintConfig        config;
+    ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+    PlateDataPtrs             plate_data;
+    std::vector<Preset*>      project_presets;
+    bool                      is_bbl_3mf = false;
+    Semver                    file_version;
+    bool ret = load_bbs_3mf(path.c_str(), &config, &ctxt, &model, &plate_data, &project_presets, &is_bbl_3mf, &file_version, nullptr,
+        LoadStrategy::LoadModel | LoadStrategy::AddDefaultInstances);
+    release_PlateData_list(plate_data);
+    return ret;
+}
+
+SCENARIO("Export+Import geometry to/from BBS 3mf file cycle", "[3mf]") {
+    GIVEN("a sphere") {
+        Model src_model;
+        src_model.add_object("sphere", "", make_sphere(10., 2. * PI / 40.));
+        src_model.add_default_instances();
+
+        WHEN("model is saved+loaded to/from 3mf file") {
+            std::string test_file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.3mf")).string();
+            REQUIRE(store_bbs_3mf_model(test_file, src_model));
+            Model dst_model;
+            bool loaded = load_bbs_3mf_model(test_file, dst_model);
+            boost::filesystem::remove(test_file);
+
+            THEN("mesh decoded from the model file matches") {
+                REQUIRE(loaded);
+                TriangleMesh src_mesh = src_model.mesh();
+                TriangleMesh dst_mesh = dst_model.mesh();
+                REQUIRE(dst_mesh.its.indices.size() == src_mesh.its.indices.size());
+                REQUIRE(dst_mesh.its.vertices.size() == src_mesh.its.vertices.size());
+                for (size_t i = 0; i < dst_mesh.its.vertices.size(); ++ i)
+                    REQUIRE(dst_mesh.its.vertices[i].isApprox(src_mesh.its.vertices[i]));
+            }
+        }
+    }
+
+    GIVEN("a sphere with a model file of several deflate blocks") {
+        Model src_model;
+        src_model.add_object("sphere", "", make_sphere(10., 2. * PI / 400.));
+        src_model.add_default_instances();
+        SaveStrategy strategy = GENERATE(SaveStrategy::Default, SaveStrategy::FastCompression, SaveStrategy::MeshSidecar);
+
+        WHEN("model is saved+loaded to/from 3mf file by 4 threads") {
+            std::string test_file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.3mf")).string();
+            // The blocks are deflated in parallel only with more than one thread, whatever the number of cores of the test machine.
+            tbb::task_arena arena(4);
+            bool            stored = false;
+            arena.execute([&]() { stored = store_bbs_3mf_model(test_file, src_model, strategy); });
+            REQUIRE(stored);
+            Model dst_model;
+            bool loaded = false;
+            arena.execute([&]() { loaded = load_bbs_3mf_model(test_file, dst_model); });
+            boost::filesystem::remove(test_file);
+
+            THEN("mesh inflated from the blocks matches") {
+                REQUIRE(loaded);
+                TriangleMesh src_mesh = src_model.mesh();
+                TriangleMesh dst_mesh = dst_model.mesh();
+                REQUIRE(dst_mesh.its.indices == src_mesh.its.indices);
+                REQUIRE(dst_mesh.its.vertices.size() == src_mesh.its.vertices.size());
+                for (size_t i = 0; i < dst_mesh.its.vertices.size(); ++ i)
+                    REQUIRE(dst_mesh.its.vertices[i].isApprox(src_mesh.its.vertices[i]));
+            }
+        }
+    }
+}
+
+// Rewrite the entries of a 3mf file by modify(name, data), the binary mesh sidecars are stored, the other entries are deflated.
+static void modify_zip_entries(const std::string &path, const std::function<void(const std::string&, std::string&)> &modify)
+{
+    const std::string tmp_path = path + ".tmp";
+    mz_zip_archive src, dst;
+    mz_zip_zero_struct(&src);
+    mz_zip_zero_struct(&dst);
+    REQUIRE(open_zip_reader(&src, path));
+    REQUIRE(open_zip_writer(&dst, tmp_path));
+    for (mz_uint i = 0; i < mz_zip_reader_get_num_files(&src); ++ i) {
+        mz_zip_archive_file_stat stat;
+        REQUIRE(mz_zip_reader_file_stat(&src, i, &stat));
+        if (stat.m_is_directory)
+            continue;
+        std::string data(size_t(stat.m_uncomp_size), '\0');
+        if (! data.empty())
+            REQUIRE(mz_zip_reader_extract_to_mem(&src, i, data.data(), data.size(), 0));
+        modify(stat.m_filename, data);
+        REQUIRE(mz_zip_writer_add_mem(&dst, stat.m_filename, data.data(), data.size(),
+            boost::ends_with(stat.m_filename, ".mesh") ? MZ_NO_COMPRESSION : MZ_DEFAULT_COMPRESSION));
+    }
+    close_zip_reader(&src);
+    REQUIRE(mz_zip_writer_finalize_archive(&dst));
+    close_zip_writer(&dst);
+    boost::filesystem::rename(tmp_path, path);
+}
+
+// Collects the messages logged during its lifetime.
+class LogCapture
+{
+public:
+    LogCapture() : m_stream(boost::make_shared<std::ostringstream>())
+    {
+        auto backend = boost::make_shared<boost::log::sinks::text_ostream_backend>();
+        backend->add_stream(m_stream);
+        m_sink = boost::make_shared<Sink>(backend);
+        boost::log::core::get()->add_sink(m_sink);
+    }
+    ~LogCapture() { boost::log::core::get()->remove_sink(m_sink); }
+
+    std::string str() { m_sink->flush(); return m_stream->str(); }
+
+private:
+    using Sink = boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>;
+    boost::shared_ptr<std::ostringstream> m_stream;
+    boost::shared_ptr<Sink>               m_sink;
+};
+
+SCENARIO("Import of a BBS 3mf file with a malformed vertex", "[3mf]") {
+    GIVEN("a sphere saved to a 3mf file, a vertex in the middle of its model file broken") {
+        Model src_model;
+        src_model.add_object("sphere", "", make_sphere(10., 2. * PI / 200.));
+        src_model.add_default_instances();
+        std::string test_file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.3mf")).string();
+        REQUIRE(store_bbs_3mf_model(test_file, src_model));
+        const size_t num_vertices = src_model.objects.front()->volumes.front()->mesh().its.vertices.size();
+        size_t       error_line   = 0;
+        modify_zip_entries(test_file, [num_vertices, &error_line](const std::string &name, std::string &data) {
+            if (! boost::starts_with(name, "3D/Objects/"))
+                return;
+            size_t pos = data.find("<vertices>");
+            REQUIRE(pos != std::string::npos);
+            for (size_t i = 0; i < num_vertices / 2; ++ i)
+                pos = data.find("<vertex ", pos + 1);
+            REQUIRE(pos != std::string::npos);
+            // Missing quotes around the value of z.
+            data.replace(pos, data.find('>', pos) + 1 - pos, "<vertex x=\"1\" y=\"2\" z=3/>");
+            error_line = 1 + std::count(data.begin(), data.begin() + pos, '\n');
+        });
+
+        WHEN("the 3mf file is loaded") {
+            LogCapture log;
+            Model dst_model;
+            bool loaded = load_bbs_3mf_model(test_file, dst_model);
+            THEN("loading fails with the line of the broken vertex") {
+                REQUIRE(! loaded);
+                REQUIRE(error_line > 1000);
+                const std::string messages = log.str();
+                INFO(messages);
+                REQUIRE(messages.find("at line " + std::to_string(error_line) + " ") != std::string::npos);
+            }
+        }
+        boost::filesystem::remove(test_file);
+    }
+}
+
+SCENARIO("Import of a BBS 3mf file with a binary mesh sidecar", "[3mf]") {
+    GIVEN("a sphere saved to a 3mf file with a mesh sidecar, the first vertex moved in the sidecar only") {
+        Model src_model;
+        src_model.add_object("sphere", "", make_sphere(10., 2. * PI / 40.));
+        src_model.add_default_instances();
+        std::string test_file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.3mf")).string();
+        REQUIRE(store_bbs_3mf_model(test_file, src_model, SaveStrategy::MeshSidecar));
+        size_t num_sidecars = 0;
+        modify_zip_entries(test_file, [&num_sidecars](const std::string &name, std::string &data) {
+            if (boost::ends_with(name, ".model.mesh")) {
+                // 24 bytes of the header, the number of vertices and triangles of the first mesh, then x of its first vertex.
+                const size_t offset = 24 + 8;
+                REQUIRE(data.size() >= offset + sizeof(float));
+                float x;
+                memcpy(&x, data.data() + offset, sizeof(float));
+                x += 1.f;
+                memcpy(data.data() + offset, &x, sizeof(float));
+                ++ num_sidecars;
+            }
+        });
+        REQUIRE(num_sidecars == 1);
+        // Number of vertices of the loaded model not matching the saved model.
+        auto num_vertices_modified = [&src_model](const Model &dst_model) {
+            TriangleMesh src_mesh = src_model.mesh();
+            TriangleMesh dst_mesh = dst_model.mesh();
+            REQUIRE(dst_mesh.its.vertices.size() == src_mesh.its.vertices.size());
+            size_t num_modified = 0;
+            for (size_t i = 0; i < dst_mesh.its.vertices.size(); ++ i)
+                if (! dst_mesh.its.vertices[i].isApprox(src_mesh.its.vertices[i]))
+                    ++ num_modified;
+            return num_modified;
+        };
+
+        WHEN("the 3mf file is loaded") {
+            Model dst_model;
+            REQUIRE(load_bbs_3mf_model(test_file, dst_model));
+            THEN("the mesh is taken from the sidecar") {
+                REQUIRE(num_vertices_modified(dst_model) == 1);
+            }
+        }
+        WHEN("the model file is modified after the sidecar was written") {
+            modify_zip_entries(test_file, [](const std::string &name, std::string &data) {
+                if (boost::starts_with(name, "3D/Objects/") && boost::ends_with(name, ".model"))
+                    data += "\n";
+            });
+            Model dst_model;
+            REQUIRE(load_bbs_3mf_model(test_file, dst_model));
+            THEN("the stale sidecar is ignored, the mesh is decoded from the model file") {
+                REQUIRE(num_vertices_modified(dst_model) == 0);
+            }
+        }
+        WHEN("the sidecar is truncated") {
+            modify_zip_entries(test_file, [](const std::string &name, std::string &data) {
+                if (boost::ends_with(name, ".model.mesh"))
+                    data.resize(data.size() - sizeof(float));
+            });
+            Model dst_model;
+            REQUIRE(load_bbs_3mf_model(test_file, dst_model));
+            THEN("the damaged sidecar is ignored, the mesh is decoded from the model file") {
+                REQUIRE(num_vertices_modified(dst_model) == 0);
+            }
+        }
+        boost::filesystem::remove(test_file);
+    }
+}
+
+TEST_CASE("Benchmark loading a large BBS 3mf project", "[3mf][Benchmark][.]") {
+    // About 2M triangles.
+    Model src_model;
+    src_model.add_object("sphere", "", make_sphere(100., 2. * PI / 1400.));
+    src_model.add_default_instances();
+    const size_t num_triangles = src_model.objects.front()->volumes.front()->mesh().its.indices.size();
+    // With the binary mesh sidecar the XML runs of the vertices and triangles are skipped.
+    SaveStrategy strategy = GENERATE(SaveStrategy::Default, SaveStrategy::MeshSidecar);
+    std::string test_file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.3mf")).string();
+    REQUIRE(store_bbs_3mf_model(test_file, src_model, strategy));
+    const double size_mb = double(boost::filesystem::file_size(test_file)) / double(1 << 20);
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    Model dst_model;
+    REQUIRE(load_bbs_3mf_model(test_file, dst_model));
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+    WARN("load_bbs_3mf" << (strategy == SaveStrategy::MeshSidecar ? " with mesh sidecar" : "") << ": " << num_triangles << " triangles, " << size_mb << " MB, " << seconds << " s, "
+                          << double(num_triangles) / seconds << " triangles/s");
+
+    BENCHMARK("load_bbs_3mf") {
+        Model model;
+        return load_bbs_3mf_model(test_file, model);
+    };
+    boost::filesystem::remove(test_file);
+}
+
+TEST_CASE("Benchmark storing a large BBS 3mf project", "[3mf][Benchmark][.]") {
+    // About 2M triangles.
+    Model src_model;
+    src_model.add_object("sphere", "", make_sphere(100., 2. * PI / 1400.));
+    src_model.add_default_instances();
+    std::string test_file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.3mf")).string();
+
+    for (SaveStrategy strategy : { SaveStrategy::Default, SaveStrategy::FastCompression }) {
+        auto t_start = std::chrono::high_resolution_clock::now();
+        REQUIRE(store_bbs_3mf_model(test_file, src_model, strategy));
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+        WARN("store_bbs_3mf" << (strategy == SaveStrategy::FastCompression ? " (fast compression): " : ": ")
+                             << double(boost::filesystem::file_size(test_file)) / double(1 << 20) << " MB, " << seconds << " s");
+    }
+
+    BENCHMARK("store_bbs_3mf") { return store_bbs_3mf_model(test_file, src_model); };
+    BENCHMARK("store_bbs_3mf fast compression") { return store_bbs_3mf_model(test_file, src_model, SaveStrategy::FastCompression); };
+    boost::filesystem::remove(test_file);
+}
+
 SCENARIO("2D convex hull of sinking object", "[3mf][.]") {
     GIVEN("model") {
         // load a model
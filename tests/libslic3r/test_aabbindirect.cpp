@@ -4,6 +4,8 @@
 #include <libslic3r/TriangleMesh.hpp>
 #include <libslic3r/AABBTreeIndirect.hpp>
 
+#include <chrono>
+
 using namespace Slic3r;
 
 TEST_CASE("Building a tree over a box, ray caster and closest query", "[AABBIndirect]")
@@ -58,3 +60,125 @@ TEST_CASE("Building a tree over a box, ray caster and closest query", "[AABBIndi
     REQUIRE(closest_point.y() == Catch::Approx(0.5));
     REQUIRE(closest_point.z() == Catch::Approx(1.));
 }
+
+TEST_CASE("Ray packet over a box", "[AABBIndirect]")
+{
+    TriangleMesh tmesh = make_cube(1., 1., 1.);
+    auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(tmesh.its.vertices, tmesh.its.indices);
+
+    AABBTreeIndirect::RayPacket packet(Vec3f(0.5f, 0.5f, -5.f));
+    packet.push_back(Vec3f(0.f, 0.f, 1.f));
+    packet.push_back(Vec3f(0.f, 0.f, -1.f));
+    packet.push_back(Vec3f(0.f, 0.6f, 0.8f));
+    std::array<igl::Hit, AABBTreeIndirect::RayPacketSize> hits;
+    size_t num_hits = AABBTreeIndirect::intersect_ray_packet_first_hit(tmesh.its.vertices, tmesh.its.indices, tree, packet, hits);
+
+    REQUIRE(num_hits == 1);
+    REQUIRE(hits[0].id != -1);
+    REQUIRE(hits[0].t == Catch::Approx(5.));
+    REQUIRE(hits[1].id == -1);
+    REQUIRE(hits[2].id == -1);
+}
+
+// Rays cast from the triangle centroids into a hemisphere around the triangle normal, the same way SeamPlacer does.
+static std::vector<std::pair<Vec3f, std::vector<Vec3f>>> hemisphere_rays(const indexed_triangle_set &its, size_t num_origins)
+{
+    std::vector<Vec3f> local_dirs;
+    for (size_t x = 0; x < 5; ++ x)
+        for (size_t y = 0; y < 5; ++ y) {
+            float phi = 2.f * float(PI) * (0.2f * x + 0.1f);
+            float z   = 0.2f * y + 0.1f;
+            float r   = std::sqrt(1.f - z * z);
+            local_dirs.emplace_back(r * std::cos(phi), r * std::sin(phi), z);
+        }
+    std::vector<std::pair<Vec3f, std::vector<Vec3f>>> out;
+    const size_t step = std::max<size_t>(1, its.indices.size() / num_origins);
+    for (size_t face_idx = 0; face_idx < its.indices.size(); face_idx += step) {
+        const stl_triangle_vertex_indices &face = its.indices[face_idx];
+        Vec3f normal = its_face_normal(its, int(face_idx));
+        Vec3f tangent = normal.unitOrthogonal();
+        Vec3f bitangent = normal.cross(tangent);
+        Vec3f origin = (its.vertices[face(0)] + its.vertices[face(1)] + its.vertices[face(2)]) / 3.f + normal * 0.01f;
+        std::vector<Vec3f> dirs;
+        for (const Vec3f &d : local_dirs)
+            dirs.emplace_back(tangent * d.x() + bitangent * d.y() + normal * d.z());
+        out.emplace_back(origin, std::move(dirs));
+    }
+    return out;
+}
+
+TEST_CASE("Ray packets hit the same triangles as single rays", "[AABBIndirect]")
+{
+    TriangleMesh tmesh = load_model("extruder_idler.obj");
+    REQUIRE(! tmesh.empty());
+    const indexed_triangle_set &its = tmesh.its;
+    auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+
+    size_t num_rays = 0;
+    size_t num_hits = 0;
+    size_t num_different = 0;
+    for (const auto &[origin, dirs] : hemisphere_rays(its, 2000)) {
+        std::array<igl::Hit, AABBTreeIndirect::RayPacketSize> packet_hits;
+        for (size_t i = 0; i < dirs.size(); i += AABBTreeIndirect::RayPacketSize) {
+            AABBTreeIndirect::RayPacket packet(origin);
+            for (size_t j = i; j < std::min(dirs.size(), i + AABBTreeIndirect::RayPacketSize); ++ j)
+                packet.push_back(dirs[j]);
+            AABBTreeIndirect::intersect_ray_packet_first_hit(its.vertices, its.indices, tree, packet, packet_hits);
+            for (size_t j = 0; j < packet.size(); ++ j) {
+                igl::Hit hit;
+                bool intersected = AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, tree,
+                    Vec3d(origin.cast<double>()), Vec3d(packet.dir(j).cast<double>()), hit);
+                ++ num_rays;
+                num_hits += intersected;
+                // Single and double precision may disagree on rays grazing a shared edge.
+                num_different += (intersected ? hit.id : -1) != packet_hits[j].id;
+            }
+        }
+    }
+    REQUIRE(num_hits > 0);
+    REQUIRE(num_different * 1000 <= num_rays);
+}
+
+TEST_CASE("Benchmark ray packets vs. single rays", "[AABBIndirect][Benchmark][.]")
+{
+    for (const char *model : { "extruder_idler.obj", "frog_legs.obj" }) {
+        TriangleMesh tmesh = load_model(model);
+        const indexed_triangle_set &its = tmesh.its;
+        auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(its.vertices, its.indices);
+        auto rays = hemisphere_rays(its, 20000);
+        const size_t num_rays = rays.size() * rays.front().second.size();
+
+        auto single_rays = [&]() {
+            size_t cnt = 0;
+            for (const auto &[origin, dirs] : rays)
+                for (const Vec3f &dir : dirs) {
+                    igl::Hit hit;
+                    cnt += AABBTreeIndirect::intersect_ray_first_hit(its.vertices, its.indices, tree,
+                        Vec3d(origin.cast<double>()), Vec3d(dir.cast<double>()), hit);
+                }
+            return cnt;
+        };
+        auto ray_packets = [&]() {
+            size_t cnt = 0;
+            std::array<igl::Hit, AABBTreeIndirect::RayPacketSize> hits;
+            for (const auto &[origin, dirs] : rays)
+                for (size_t i = 0; i < dirs.size(); i += AABBTreeIndirect::RayPacketSize) {
+                    AABBTreeIndirect::RayPacket packet(origin);
+                    for (size_t j = i; j < std::min(dirs.size(), i + AABBTreeIndirect::RayPacketSize); ++ j)
+                        packet.push_back(dirs[j]);
+                    cnt += AABBTreeIndirect::intersect_ray_packet_first_hit(its.vertices, its.indices, tree, packet, hits);
+                }
+            return cnt;
+        };
+        auto rays_per_sec = [num_rays](auto &&fn) {
+            auto t_start = std::chrono::high_resolution_clock::now();
+            fn();
+            return double(num_rays) / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+        };
+        WARN(model << ": " << its.indices.size() << " triangles, " << num_rays << " rays, single rays: " << rays_per_sec(single_rays)
+                   << " rays/s, ray packets: " << rays_per_sec(ray_packets) << " rays/s");
+
+        BENCHMARK(std::string("single rays ") + model) { return single_rays(); };
+        BENCHMARK(std::string("ray packets ") + model) { return ray_packets(); };
+    }
+}
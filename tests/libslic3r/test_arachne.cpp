@@ -0,0 +1,99 @@
+#include <catch2/catch_all.hpp>
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/PrintConfig.hpp"
+#include "libslic3r/Arachne/WallToolPaths.hpp"
+
+#include <chrono>
+
+using namespace Slic3r;
+
+// Outlines of a layer of a star shaped gear with a hole, the teeth taper to a tip thinner than a single wall,
+// so that the walls transition between different bead counts.
+static Polygons gear_outline(size_t num_teeth, double outer_radius, double inner_radius, double hole_radius, double phase)
+{
+    Polygon contour;
+    for (size_t i = 0; i < 2 * num_teeth; ++ i) {
+        const double angle  = phase + PI * double(i) / double(num_teeth);
+        const double radius = i % 2 ? inner_radius : outer_radius;
+        contour.points.emplace_back(scaled<coord_t>(radius * std::cos(angle)), scaled<coord_t>(radius * std::sin(angle)));
+    }
+    Polygon hole;
+    for (size_t i = 0; i < 64; ++ i) {
+        const double angle = - 2. * PI * double(i) / 64.;
+        hole.points.emplace_back(scaled<coord_t>(hole_radius * std::cos(angle)), scaled<coord_t>(hole_radius * std::sin(angle)));
+    }
+    return { contour, hole };
+}
+
+// Layers of a gear twisting and shrinking along Z, each layer differs from the others.
+static std::vector<Polygons> gear_layers(size_t num_layers)
+{
+    std::vector<Polygons> layers;
+    for (size_t i = 0; i < num_layers; ++ i) {
+        const double t = double(i) / double(num_layers);
+        layers.emplace_back(gear_outline(12 + i % 5, 20. - 8. * t, 12. - 4. * t, 4. + 3. * t, 0.1 * double(i)));
+    }
+    return layers;
+}
+
+static std::vector<Arachne::VariableWidthLines> generate_walls(const Polygons &outline, size_t inset_count)
+{
+    const Arachne::WallToolPathsParams params = Arachne::make_paths_params(1, PrintObjectConfig(), PrintConfig());
+    Arachne::WallToolPaths wall_tool_paths(outline, scaled<coord_t>(0.42), scaled<coord_t>(0.45), inset_count, 0, 0.2, params);
+    return wall_tool_paths.generate();
+}
+
+static size_t count_junctions(const std::vector<Arachne::VariableWidthLines> &toolpaths)
+{
+    size_t num_junctions = 0;
+    for (const Arachne::VariableWidthLines &lines : toolpaths)
+        for (const Arachne::ExtrusionLine &line : lines)
+            num_junctions += line.junctions.size();
+    return num_junctions;
+}
+
+TEST_CASE("Arachne walls are generated deterministically", "[Arachne]") {
+    const Polygons outline = gear_outline(16, 15., 9., 3., 0.);
+    const std::vector<Arachne::VariableWidthLines> toolpaths = generate_walls(outline, 3);
+    REQUIRE(count_junctions(toolpaths) > 0);
+
+    // The graph storage released by the first run is reused by the following runs, which must not change the result.
+    generate_walls(gear_outline(8, 10., 6., 2., 0.5), 1);
+    const std::vector<Arachne::VariableWidthLines> other = generate_walls(outline, 3);
+    REQUIRE(other.size() == toolpaths.size());
+    for (size_t i = 0; i < toolpaths.size(); ++ i) {
+        REQUIRE(other[i].size() == toolpaths[i].size());
+        for (size_t j = 0; j < toolpaths[i].size(); ++ j) {
+            const Arachne::ExtrusionLine &l = toolpaths[i][j];
+            const Arachne::ExtrusionLine &r = other[i][j];
+            REQUIRE(l.inset_idx == r.inset_idx);
+            REQUIRE(l.is_odd == r.is_odd);
+            REQUIRE(l.is_closed == r.is_closed);
+            REQUIRE(l.junctions.size() == r.junctions.size());
+            for (size_t k = 0; k < l.junctions.size(); ++ k) {
+                REQUIRE(l.junctions[k].p == r.junctions[k].p);
+                REQUIRE(l.junctions[k].w == r.junctions[k].w);
+            }
+        }
+    }
+}
+
+TEST_CASE("Benchmark Arachne wall generation", "[Arachne][Benchmark][.]") {
+    const std::vector<Polygons> layers = gear_layers(200);
+
+    auto   t_start = std::chrono::high_resolution_clock::now();
+    size_t num_junctions = 0;
+    for (const Polygons &layer : layers)
+        num_junctions += count_junctions(generate_walls(layer, 3));
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+    WARN("WallToolPaths::generate: " << layers.size() << " layers, " << num_junctions << " junctions, " << seconds << " s");
+
+    BENCHMARK("WallToolPaths::generate") {
+        size_t n = 0;
+        for (const Polygons &layer : layers)
+            n += count_junctions(generate_walls(layer, 3));
+        return n;
+    };
+}
@@ -0,0 +1,365 @@
+#include <catch2/catch_all.hpp>
+
+#include <libslic3r/GCodeReader.hpp>
+#include <libslic3r/GCode/GCodeLines.hpp>
+#include <libslic3r/LocalesUtils.hpp>
+
+#include <fast_float/fast_float.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/fstream.hpp>
+
+using namespace Slic3r;
+
+static std::string write_temp_gcode(const std::string &gcode)
+{
+    std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.gcode")).string();
+    boost::nowide::ofstream os(path, std::ios::binary);
+    os << gcode;
+    return path;
+}
+
+static std::vector<std::string> parse_raw_lines(const std::string &path, std::vector<size_t> &lines_ends)
+{
+    std::vector<std::string> lines;
+    GCodeReader reader;
+    REQUIRE(reader.parse_file(path, [&lines](GCodeReader &, const GCodeReader::GCodeLine &line) { lines.emplace_back(line.raw()); }, lines_ends));
+    return lines;
+}
+
+TEST_CASE("GCodeReader parses a memory mapped file", "[GCodeReader]") {
+    CNumericLocalesSetter locales_setter;
+
+    SECTION("LF and CRLF line ends, last line without newline") {
+        const std::string gcode = "G1 X10 Y20 E0.5 ; move\n; comment\r\nM104 S200\n\nG1 Z0.3";
+        std::string path = write_temp_gcode(gcode);
+        std::vector<size_t> lines_ends;
+        std::vector<std::string> lines = parse_raw_lines(path, lines_ends);
+        boost::nowide::remove(path.c_str());
+
+        REQUIRE(lines == std::vector<std::string>{ "G1 X10 Y20 E0.5 ; move", "; comment", "M104 S200", "", "G1 Z0.3" });
+        REQUIRE(lines_ends == std::vector<size_t>{ 23, 34, 44, 45 });
+    }
+
+    SECTION("Axes are parsed from the mapped file and from a copy of the line") {
+        std::string path = write_temp_gcode("G1 X1.5 Y-2 F3000\nG1 E0.25\n");
+        GCodeReader reader;
+        std::vector<GCodeReader::GCodeLine> copies;
+        REQUIRE(reader.parse_file(path, [&copies](GCodeReader &, const GCodeReader::GCodeLine &line) { copies.emplace_back(line); }));
+        boost::nowide::remove(path.c_str());
+
+        REQUIRE(copies.size() == 2);
+        REQUIRE(copies.front().raw() == "G1 X1.5 Y-2 F3000");
+        REQUIRE(copies.front().cmd_is("G1"));
+        REQUIRE(copies.front().x() == Catch::Approx(1.5));
+        REQUIRE(copies.front().y() == Catch::Approx(-2.));
+        REQUIRE(copies.front().comment().empty());
+        float f = 0.f;
+        REQUIRE(copies.front().has_value('F', f));
+        REQUIRE(f == Catch::Approx(3000.));
+        REQUIRE(copies.back().has_e());
+        REQUIRE(copies.back().e() == Catch::Approx(0.25));
+        REQUIRE(reader.x() == Catch::Approx(1.5));
+    }
+
+    SECTION("Modified line owns its raw string") {
+        GCodeReader reader;
+        std::string result;
+        reader.parse_buffer("G1 X1 Y2 E0.5\n", [&result](GCodeReader &, const GCodeReader::GCodeLine &l) {
+            GCodeReader::GCodeLine line = l;
+            line.set(X, 3.f);
+            result = line.raw();
+        });
+        REQUIRE(result == "G1 X3.000 Y2 E0.5");
+    }
+
+    SECTION("Empty file") {
+        std::string path = write_temp_gcode(std::string());
+        std::vector<size_t> lines_ends;
+        std::vector<std::string> lines = parse_raw_lines(path, lines_ends);
+        boost::nowide::remove(path.c_str());
+        REQUIRE(lines.empty());
+        REQUIRE(lines_ends.empty());
+    }
+}
+
+TEST_CASE("GCodeReader replays a tokenized buffer", "[GCodeReader]") {
+    CNumericLocalesSetter locales_setter;
+
+    const std::string gcode = "G92 E0\nG1 Z0.2 F600\n;TYPE:Outer wall\nG1 X10 Y5 E0.5\n\nG1 X12.5 Y5 E0.1 ; comment\nM106 S255\nG0 X0 Y0\n";
+    auto collect = [](std::vector<std::string> &raw, std::vector<Vec3f> &positions) {
+        return [&raw, &positions](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+            raw.emplace_back(line.raw());
+            positions.emplace_back(line.new_X(reader), line.new_Y(reader), line.new_Z(reader));
+        };
+    };
+    GCodeReader              reader_text, reader_tokens;
+    std::vector<std::string> raw_text, raw_tokens;
+    std::vector<Vec3f>       pos_text, pos_tokens;
+    reader_text.parse_buffer(gcode, collect(raw_text, pos_text));
+    GCodeReader::TokenizedBuffer lines = GCodeReader::tokenize_buffer(gcode);
+    reader_tokens.parse_buffer(gcode, lines, collect(raw_tokens, pos_tokens));
+
+    REQUIRE(lines.size() == 8);
+    REQUIRE(raw_tokens == raw_text);
+    REQUIRE(pos_tokens == pos_text);
+    REQUIRE(reader_tokens.x() == reader_text.x());
+    REQUIRE(reader_tokens.z() == Catch::Approx(0.2));
+    REQUIRE(reader_tokens.e() == reader_text.e());
+}
+
+TEST_CASE("GCodeLines pass the lines kept by a filter by reference", "[GCodeReader]") {
+    CNumericLocalesSetter locales_setter;
+
+    const std::string gcode = "G92 E0\nG1 Z0.2 F600\ng1 x10 y5 e0.5\n\nG1 X12.5 Y5 E0.1 ; comment\nM106 S255";
+    GCodeLines lines{ std::string(gcode) };
+    REQUIRE(lines.size() == 6);
+    REQUIRE(lines.str() == gcode);
+    REQUIRE(lines.line(1) == "G1 Z0.2 F600");
+    REQUIRE(lines.line_with_eol(1) == "G1 Z0.2 F600\n");
+    REQUIRE(lines.tokens(1).axis[Z] == Catch::Approx(0.2));
+    REQUIRE((lines.tokens(1).mask & GCodeReader::GCodeLine::lower_case_word_mask) == 0);
+    // Lower case words are not parsed, but they are flagged.
+    REQUIRE((lines.tokens(2).mask & GCodeReader::GCodeLine::lower_case_word_mask) != 0);
+    REQUIRE((lines.tokens(2).mask & (1 << X)) == 0);
+
+    // A filter passing the lines through, modifying one of them and inserting another one.
+    GCodeLines out;
+    out.append(lines, 0, 2);
+    out.append_line("G1 X10 Y5 E0.5", lines, 2);
+    out.append("M107\n");
+    for (size_t i = 3; i < lines.size(); ++ i)
+        out.append_line(lines.line(i), lines, i);
+    REQUIRE(out.size() == 7);
+    REQUIRE(out.str() == "G92 E0\nG1 Z0.2 F600\nG1 X10 Y5 E0.5\nM107\n\nG1 X12.5 Y5 E0.1 ; comment\nM106 S255\n");
+    // The lines not modified share their text with the input.
+    REQUIRE(out.buffer(1) == lines.buffer(1));
+    REQUIRE(out.buffer(4) == lines.buffer(3));
+    REQUIRE(out.buffer(5) == lines.buffer(4));
+    // The modified lines are tokenized again.
+    REQUIRE(out.buffer(2) != lines.buffer(2));
+    REQUIRE(out.tokens(2).axis[X] == Catch::Approx(10.));
+    REQUIRE(out.buffer(6) != lines.buffer(5));
+
+    // Replaying the lines is equivalent to parsing their text.
+    std::vector<std::string> raw_text, raw_lines;
+    std::vector<Vec3f>       pos_text, pos_lines;
+    auto collect = [](std::vector<std::string> &raw, std::vector<Vec3f> &positions) {
+        return [&raw, &positions](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+            raw.emplace_back(line.raw());
+            positions.emplace_back(line.new_X(reader), line.new_Y(reader), line.new_Z(reader));
+        };
+    };
+    GCodeReader reader_text, reader_lines;
+    reader_text.parse_buffer(out.str(), collect(raw_text, pos_text));
+    reader_lines.parse_lines(out, collect(raw_lines, pos_lines));
+    REQUIRE(raw_lines == raw_text);
+    REQUIRE(pos_lines == pos_text);
+
+    // Lines may be removed from the end and appended again.
+    out.truncate(3);
+    out.append("M105\n");
+    REQUIRE(out.str() == "G92 E0\nG1 Z0.2 F600\nG1 X10 Y5 E0.5\nM105\n");
+}
+
+TEST_CASE("Benchmark GCodeReader::parse_file throughput", "[GCodeReader][Benchmark][.]") {
+    CNumericLocalesSetter locales_setter;
+
+    // About 100MB of typical extrusion moves, travels and comments.
+    std::string gcode;
+    gcode.reserve(size_t(110) << 20);
+    for (size_t i = 0; gcode.size() < (size_t(100) << 20); ++ i) {
+        gcode += "G1 X" + std::to_string(100. + 0.01 * double(i % 5000)) + " Y" + std::to_string(50. + 0.02 * double(i % 3000)) + " E0.03412\n";
+        if (i % 16 == 0)
+            gcode += ";WIDTH:0.45\nG1 F1800\n";
+        if (i % 64 == 0)
+            gcode += "G1 X120.5 Y80.25 F12000 ; travel\n";
+    }
+    std::string path = write_temp_gcode(gcode);
+    const double size_mb = double(gcode.size()) / double(1 << 20);
+    gcode.clear();
+    gcode.shrink_to_fit();
+
+    size_t num_lines = 0;
+    auto   t_start   = std::chrono::high_resolution_clock::now();
+    GCodeReader reader;
+    reader.parse_file(path, [&num_lines](GCodeReader &, const GCodeReader::GCodeLine &) { ++ num_lines; });
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+    WARN("parse_file: " << num_lines << " lines, " << size_mb / seconds << " MB/s");
+
+    BENCHMARK("parse_file") {
+        GCodeReader reader;
+        return reader.parse_file(path, [](GCodeReader &, const GCodeReader::GCodeLine &) {});
+    };
+    BENCHMARK("parse_file_raw") {
+        GCodeReader reader;
+        return reader.parse_file_raw(path, [](GCodeReader &, const char *, const char *) {});
+    };
+
+    boost::nowide::remove(path.c_str());
+}
+
+// GCodeReader::parse_buffer() before the end of line search was vectorized, copied from GCodeReader.cpp / .hpp.
+// The axis values are parsed by fast_float, the same as by the current reader, the rest of the line is scanned character by character.
+class BaselineGCodeReader {
+public:
+    struct GCodeLine {
+        void reset() { m_mask = 0; memset(m_axis, 0, sizeof(m_axis)); m_raw.clear(); }
+        bool has(size_t axis) const { return (m_mask & (1 << int(axis))) != 0; }
+
+        std::string m_raw;
+        float       m_axis[NUM_AXES];
+        uint32_t    m_mask;
+    };
+
+    BaselineGCodeReader() { memset(m_position, 0, sizeof(m_position)); }
+
+    template<typename Callback>
+    void parse_buffer(const std::string &buffer, Callback callback)
+    {
+        const char *ptr = buffer.c_str();
+        const char *end = ptr + buffer.size();
+        GCodeLine gline;
+        while (*ptr != 0) {
+            gline.reset();
+            std::pair<const char*, const char*> cmd;
+            ptr = parse_line_internal(ptr, end, gline, cmd);
+            callback(gline);
+            update_coordinates(gline, cmd);
+        }
+    }
+
+private:
+    const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+    {
+        // command and args
+        const char *c = ptr;
+        {
+            // Skip the whitespaces.
+            command.first = skip_whitespaces(c);
+            // Skip the command.
+            c = command.second = skip_word(command.first);
+            // Up to the end of line or comment.
+            while (! is_end_of_gcode_line(*c)) {
+                // Skip whitespaces.
+                c = skip_whitespaces(c);
+                if (is_end_of_gcode_line(*c))
+                    break;
+                // Check the name of the axis.
+                Axis axis = NUM_AXES_WITH_UNKNOWN;
+                switch (*c) {
+                case 'X': axis = X; break;
+                case 'Y': axis = Y; break;
+                case 'Z': axis = Z; break;
+                case 'F': axis = F; break;
+                case 'I': axis = I; break;
+                case 'J': axis = J; break;
+                case 'E': axis = E; break;
+                case 'P': axis = P; break;
+                default:
+                    if (*c >= 'A' && *c <= 'Z')
+                        // Unknown axis, but we still want to remember that such a axis was seen.
+                        axis = UNKNOWN_AXIS;
+                    break;
+                }
+                if (axis != NUM_AXES_WITH_UNKNOWN) {
+                    // Try to parse the numeric value.
+                    double v;
+                    auto [pend, ec] = fast_float::from_chars(++ c, end, v);
+                    if (pend != c && is_end_of_word(*pend)) {
+                        // The axis value has been parsed correctly.
+                        if (axis != UNKNOWN_AXIS)
+                            gline.m_axis[int(axis)] = float(v);
+                        gline.m_mask |= 1 << int(axis);
+                        c = pend;
+                    } else
+                        // Skip the rest of the word.
+                        c = skip_word(c);
+                } else
+                    // Skip the rest of the word.
+                    c = skip_word(c);
+            }
+        }
+
+        // Skip the rest of the line.
+        for (; ! is_end_of_line(*c); ++ c);
+
+        // Copy the raw string including the comment, without the trailing newlines.
+        if (c > ptr)
+            gline.m_raw.assign(ptr, c);
+
+        // Skip the trailing newlines.
+        if (*c == '\r')
+            ++ c;
+        if (*c == '\n')
+            ++ c;
+        return c;
+    }
+
+    void update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command)
+    {
+        if (*command.first == 'G') {
+            int cmd_len = int(command.second - command.first);
+            if ((cmd_len == 2 && (command.first[1] == '0' || command.first[1] == '1' || command.first[1] == '2' || command.first[1] == '3')) ||
+                (cmd_len == 3 &&  command.first[1] == '9' && command.first[2] == '2')) {
+                for (size_t i = 0; i < NUM_AXES; ++ i)
+                    if (gline.has(i))
+                        m_position[i] = gline.m_axis[i];
+            }
+        }
+    }
+
+    static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
+    static bool         is_end_of_line(char c)          { return c == '\r' || c == '\n' || c == 0; }
+    static bool         is_end_of_gcode_line(char c)    { return c == ';' || is_end_of_line(c); }
+    static bool         is_end_of_word(char c)          { return is_whitespace(c) || is_end_of_gcode_line(c); }
+    static const char*  skip_whitespaces(const char *c) { for (; is_whitespace(*c); ++ c) ; return c; }
+    static const char*  skip_word(const char *c)        { for (; ! is_end_of_word(*c); ++ c) ; return c; }
+
+    float m_position[NUM_AXES];
+};
+
+TEST_CASE("Benchmark GCodeReader tokenizer vs. the baseline reader", "[GCodeReader][Benchmark][.]") {
+    CNumericLocalesSetter locales_setter;
+
+    // Extrusion moves with long comments, so that both the axis parsing and the end of line search matter.
+    std::string gcode;
+    size_t      num_lines = 0;
+    for (; gcode.size() < (size_t(32) << 20); ++ num_lines) {
+        if (num_lines % 8 == 0)
+            gcode += "; stop printing object Cube_with_a_long_name_id:0 copy 0 and start the next one\n";
+        else
+            gcode += "G1 X" + std::to_string(12.345 + 0.001 * double(num_lines % 10000)) + " Y87.654 E0.03412 F1800\n";
+    }
+
+    auto lines_per_sec = [num_lines](auto &&fn) {
+        auto t_start = std::chrono::high_resolution_clock::now();
+        fn();
+        return double(num_lines) / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+    };
+    auto parse_baseline = [&gcode]() {
+        size_t cnt = 0;
+        BaselineGCodeReader r;
+        r.parse_buffer(gcode, [&cnt](const BaselineGCodeReader::GCodeLine &line) { cnt += line.has(X); });
+        return cnt;
+    };
+    auto parse_reader = [&gcode]() {
+        size_t cnt = 0;
+        GCodeReader r;
+        r.parse_buffer(gcode, [&cnt](GCodeReader &, const GCodeReader::GCodeLine &line) { cnt += line.has_x(); });
+        return cnt;
+    };
+    REQUIRE(parse_reader() == parse_baseline());
+
+    double baseline = lines_per_sec(parse_baseline);
+    double reader   = lines_per_sec(parse_reader);
+    // Only the end of line search differs, the lines with long comments profit from it.
+    WARN("baseline GCodeReader::parse_buffer: " << baseline << " lines/s, GCodeReader::parse_buffer: " << reader << " lines/s");
+
+    BENCHMARK("baseline GCodeReader::parse_buffer") { return parse_baseline(); };
+    BENCHMARK("GCodeReader::parse_buffer") { return parse_reader(); };
+}
@@ -0,0 +1,325 @@
+#include <catch2/catch_all.hpp>
+
+#include "libslic3r/AppConfig.hpp"
+#include "libslic3r/PresetBundle.hpp"
+#include "libslic3r/Utils.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <nlohmann/json.hpp>
+#include <tbb/task_arena.h>
+
+using namespace Slic3r;
+
+static const boost::filesystem::path bundled_profiles_dir()
+{
+    return boost::filesystem::path(TEST_DATA_DIR) / ".." / ".." / "resources" / "profiles";
+}
+
+// Data directory in the temp directory, active for the lifetime of this object.
+class TempDataDir
+{
+public:
+    TempDataDir() : m_path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("orca-%%%%-%%%%")), m_old_data_dir(data_dir())
+    {
+        boost::filesystem::create_directories(m_path);
+        set_data_dir(m_path.string());
+    }
+    ~TempDataDir()
+    {
+        set_data_dir(m_old_data_dir);
+        boost::filesystem::remove_all(m_path);
+    }
+
+    boost::filesystem::path system_dir() const { return m_path / PRESET_SYSTEM_DIR; }
+    boost::filesystem::path cache_file() const { return m_path / "cache" / "system_presets.cereal"; }
+
+    // Copy the vendor profile bundled with the application into the system directory.
+    void copy_vendor(const std::string &vendor) const
+    {
+        const boost::filesystem::path src = bundled_profiles_dir() / vendor;
+        const boost::filesystem::path dst = system_dir() / vendor;
+        boost::filesystem::create_directories(dst);
+        boost::filesystem::copy_file(bundled_profiles_dir() / (vendor + ".json"), system_dir() / (vendor + ".json"));
+        for (boost::filesystem::recursive_directory_iterator it(src), end; it != end; ++ it) {
+            boost::filesystem::path path = dst / it->path().lexically_relative(src);
+            if (boost::filesystem::is_directory(it->status()))
+                boost::filesystem::create_directories(path);
+            else
+                boost::filesystem::copy_file(it->path(), path);
+        }
+    }
+
+private:
+    boost::filesystem::path m_path;
+    std::string             m_old_data_dir;
+};
+
+static void load_presets(PresetBundle &bundle)
+{
+    AppConfig config;
+    bundle.load_presets(config, ForwardCompatibilitySubstitutionRule::EnableSilent);
+}
+
+static void require_same_system_presets(const PresetCollection &lhs, const PresetCollection &rhs)
+{
+    std::vector<const Preset*> lhs_presets, rhs_presets;
+    for (const Preset &preset : lhs)
+        if (preset.is_system)
+            lhs_presets.emplace_back(&preset);
+    for (const Preset &preset : rhs)
+        if (preset.is_system)
+            rhs_presets.emplace_back(&preset);
+    REQUIRE(lhs_presets.size() == rhs_presets.size());
+    for (size_t i = 0; i < lhs_presets.size(); ++ i) {
+        const Preset &l = *lhs_presets[i];
+        const Preset &r = *rhs_presets[i];
+        REQUIRE(l.name == r.name);
+        REQUIRE(l.file == r.file);
+        REQUIRE(l.alias == r.alias);
+        REQUIRE(l.inherits() == r.inherits());
+        REQUIRE(l.renamed_from == r.renamed_from);
+        REQUIRE(l.setting_id == r.setting_id);
+        REQUIRE(l.filament_id == r.filament_id);
+        REQUIRE(l.version == r.version);
+        REQUIRE(l.vendor != nullptr);
+        REQUIRE(r.vendor != nullptr);
+        REQUIRE(l.vendor->id == r.vendor->id);
+        REQUIRE(l.config == r.config);
+    }
+}
+
+TEST_CASE("System presets are restored from the binary cache", "[Preset]") {
+    TempDataDir data_dir;
+    data_dir.copy_vendor("Afinia");
+
+    PresetBundle from_json;
+    load_presets(from_json);
+    REQUIRE(boost::filesystem::exists(data_dir.cache_file()));
+    REQUIRE(from_json.vendors.count("Afinia") == 1);
+
+    SECTION("Unchanged profiles are loaded from the cache") {
+        PresetBundle from_cache;
+        load_presets(from_cache);
+        REQUIRE(from_cache.vendors.size() == from_json.vendors.size());
+        const VendorProfile &vendor = from_cache.vendors.at("Afinia");
+        REQUIRE(vendor.config_version == from_json.vendors.at("Afinia").config_version);
+        REQUIRE(vendor.models.size() == from_json.vendors.at("Afinia").models.size());
+        REQUIRE(vendor.models.front().variants.size() == from_json.vendors.at("Afinia").models.front().variants.size());
+        require_same_system_presets(from_cache.prints, from_json.prints);
+        require_same_system_presets(from_cache.filaments, from_json.filaments);
+        require_same_system_presets(from_cache.printers, from_json.printers);
+    }
+
+    SECTION("A modified profile invalidates the cache") {
+        const std::string name = "0.20mm Standard @Afinia H+1(HS)";
+        REQUIRE(from_json.prints.find_preset(name, false)->config.opt_int("top_shell_layers") == 5);
+        boost::filesystem::path path = data_dir.system_dir() / "Afinia" / "process" / (name + ".json");
+        std::string json;
+        {
+            boost::nowide::ifstream ifs(path.string());
+            json.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        }
+        const std::string old_value = "\"top_shell_layers\": \"5\"";
+        REQUIRE(json.find(old_value) != std::string::npos);
+        json.replace(json.find(old_value), old_value.size(), "\"top_shell_layers\": \"12\"");
+        {
+            boost::nowide::ofstream ofs(path.string());
+            ofs << json;
+        }
+
+        PresetBundle reloaded;
+        load_presets(reloaded);
+        REQUIRE(reloaded.prints.find_preset(name, false)->config.opt_int("top_shell_layers") == 12);
+    }
+}
+
+// Load the system presets of the given vendors into a fresh data directory.
+static void load_vendors(PresetBundle &bundle, const std::vector<const char*> &vendors)
+{
+    TempDataDir data_dir;
+    for (const char *vendor : vendors)
+        data_dir.copy_vendor(vendor);
+    load_presets(bundle);
+}
+
+static void require_presets_of_vendor(const PresetCollection &all, const PresetCollection &single, const std::string &vendor)
+{
+    size_t num_presets = 0;
+    for (const Preset &preset : single)
+        if (preset.is_system && preset.vendor->id == vendor) {
+            const Preset *other = all.find_preset(preset.name, false);
+            REQUIRE(other != nullptr);
+            REQUIRE(other->vendor->id == vendor);
+            REQUIRE(other->filament_id == preset.filament_id);
+            REQUIRE(other->alias == preset.alias);
+            REQUIRE(other->config == preset.config);
+            ++ num_presets;
+        }
+    REQUIRE(num_presets > 0);
+}
+
+TEST_CASE("Vendors loaded in parallel match the vendors loaded one by one", "[Preset]") {
+    PresetBundle all;
+    load_vendors(all, { PresetBundle::ORCA_FILAMENT_LIBRARY, "Afinia", "Comgrow", "Lulzbot" });
+    REQUIRE(all.vendors.size() == 4);
+    // The filament_id is inherited from the filament library.
+    REQUIRE(all.filaments.find_preset("Lulzbot 2.85mm PLA", false)->filament_id == "GFL99");
+
+    auto [vendor, dependencies] = GENERATE(table<std::string, std::vector<const char*>>({
+        { "Afinia",  { "Afinia" } },
+        { "Comgrow", { "Comgrow" } },
+        { "Lulzbot", { PresetBundle::ORCA_FILAMENT_LIBRARY, "Lulzbot" } } }));
+    PresetBundle single;
+    load_vendors(single, dependencies);
+    require_presets_of_vendor(all.prints, single.prints, vendor);
+    require_presets_of_vendor(all.filaments, single.filaments, vendor);
+    require_presets_of_vendor(all.printers, single.printers, vendor);
+}
+
+static nlohmann::json read_json(const boost::filesystem::path &path)
+{
+    boost::nowide::ifstream ifs(path.string());
+    nlohmann::json          json;
+    ifs >> json;
+    return json;
+}
+
+static void write_json(const boost::filesystem::path &path, const nlohmann::json &json)
+{
+    boost::nowide::ofstream ofs(path.string());
+    ofs << json.dump(4);
+}
+
+// Collects the messages logged with the error severity.
+class ErrorLog
+{
+public:
+    ErrorLog() : m_stream(boost::make_shared<std::ostringstream>())
+    {
+        auto backend = boost::make_shared<boost::log::sinks::text_ostream_backend>();
+        backend->add_stream(m_stream);
+        m_sink = boost::make_shared<Sink>(backend);
+        m_sink->set_filter(boost::log::trivial::severity >= boost::log::trivial::error);
+        boost::log::core::get()->add_sink(m_sink);
+    }
+    ~ErrorLog() { boost::log::core::get()->remove_sink(m_sink); }
+
+    // Sorted, because the vendors loaded in parallel report their errors in any order.
+    // The data directory is stripped from the paths, so that the messages of two data directories compare.
+    std::vector<std::string> messages(const std::string &data_dir)
+    {
+        m_sink->flush();
+        std::vector<std::string> out;
+        std::istringstream       iss(m_stream->str());
+        for (std::string line; std::getline(iss, line);)
+            out.emplace_back(boost::replace_all_copy(line, data_dir, "<data_dir>"));
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+private:
+    using Sink = boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend>;
+    boost::shared_ptr<std::ostringstream> m_stream;
+    boost::shared_ptr<Sink>               m_sink;
+};
+
+struct LoadedVendors
+{
+    // "preset: option old value -> new value" for each substitution, in the order reported.
+    std::vector<std::string> substitutions;
+    std::vector<std::string> errors;
+    bool                     has_errors;
+};
+
+// Load the system presets of the vendors bundled with the application, broken the same way on each load:
+// Afinia: a process preset with an invalid enum value and with a filament option.
+// Comgrow: the first process preset inherits from the last one, which is not loaded yet, the vendor is dropped.
+static LoadedVendors load_broken_vendors(PresetBundle &bundle)
+{
+    TempDataDir data_dir;
+    for (const char *vendor : { PresetBundle::ORCA_FILAMENT_LIBRARY, "Afinia", "Comgrow", "Lulzbot" })
+        data_dir.copy_vendor(vendor);
+
+    const boost::filesystem::path afinia_path = data_dir.system_dir() / "Afinia" / "process" / "0.20mm Standard @Afinia H+1(HS).json";
+    nlohmann::json                afinia      = read_json(afinia_path);
+    afinia["seam_position"] = "nonsense";
+    afinia["filament_type"] = { "PLA" };
+    write_json(afinia_path, afinia);
+
+    const nlohmann::json          comgrow_list = read_json(data_dir.system_dir() / "Comgrow.json")["process_list"];
+    const boost::filesystem::path comgrow_path = data_dir.system_dir() / "Comgrow" / comgrow_list.front()["sub_path"].get<std::string>();
+    nlohmann::json                comgrow      = read_json(comgrow_path);
+    comgrow["inherits"] = comgrow_list.back()["name"];
+    write_json(comgrow_path, comgrow);
+
+    LoadedVendors out;
+    ErrorLog      log;
+    AppConfig     config;
+    // The substitutions are only collected if they are not silent.
+    for (const PresetConfigSubstitutions &preset_substitutions : bundle.load_presets(config, ForwardCompatibilitySubstitutionRule::Enable))
+        for (const ConfigSubstitution &substitution : preset_substitutions.substitutions)
+            out.substitutions.emplace_back(preset_substitutions.preset_name + ": " + substitution.opt_def->opt_key + " " +
+                substitution.old_value + " -> " + substitution.new_value->serialize());
+    out.errors     = log.messages(Slic3r::data_dir());
+    out.has_errors = bundle.has_errors();
+    return out;
+}
+
+TEST_CASE("System presets loaded in parallel match a sequential load", "[Preset]") {
+    // A task arena of a single thread runs the parallel loops of the loader one item after another, in order.
+    PresetBundle  sequential;
+    LoadedVendors sequential_result;
+    tbb::task_arena arena(1);
+    arena.execute([&sequential, &sequential_result]() { sequential_result = load_broken_vendors(sequential); });
+
+    PresetBundle  parallel;
+    LoadedVendors parallel_result = load_broken_vendors(parallel);
+
+    REQUIRE(sequential.vendors.size() == 3);
+    REQUIRE(sequential.vendors.count("Comgrow") == 0);
+    REQUIRE(sequential.prints.find_preset("0.20mm Standard @Afinia H+1(HS)", false)->config.opt_serialize("seam_position") == "aligned");
+    REQUIRE(sequential_result.substitutions == std::vector<std::string>{ "0.20mm Standard @Afinia H+1(HS): seam_position nonsense -> aligned" });
+    REQUIRE(sequential_result.has_errors);
+    auto has_error = [&sequential_result](const std::string &text) {
+        return std::any_of(sequential_result.errors.begin(), sequential_result.errors.end(),
+            [&text](const std::string &message) { return message.find(text) != std::string::npos; });
+    };
+    REQUIRE(has_error("contains incorrect keys: filament_type"));
+    REQUIRE(has_error("can not find inherits 0.56mm SuperChunky @Comgrow T500 0.8 for fdm_process_common"));
+
+    REQUIRE(parallel.vendors.size() == sequential.vendors.size());
+    require_same_system_presets(parallel.prints, sequential.prints);
+    require_same_system_presets(parallel.filaments, sequential.filaments);
+    require_same_system_presets(parallel.printers, sequential.printers);
+    REQUIRE(parallel_result.substitutions == sequential_result.substitutions);
+    REQUIRE(parallel_result.errors == sequential_result.errors);
+    REQUIRE(parallel_result.has_errors == sequential_result.has_errors);
+}
+
+TEST_CASE("Benchmark loading the system presets", "[Preset][Benchmark][.]") {
+    // All the vendor profiles bundled with the application.
+    TempDataDir data_dir;
+    boost::filesystem::create_directory_symlink(boost::filesystem::canonical(bundled_profiles_dir()), data_dir.system_dir());
+
+    auto seconds_to_load = []() {
+        auto t_start = std::chrono::high_resolution_clock::now();
+        PresetBundle bundle;
+        load_presets(bundle);
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+    };
+    // Cold start: the json files are parsed and the cache is written.
+    double cold = seconds_to_load();
+    REQUIRE(boost::filesystem::exists(data_dir.cache_file()));
+    // Warm start: the presets are restored from the cache.
+    double warm = seconds_to_load();
+    WARN("load_presets: cold start " << cold << " s, warm start " << warm << " s");
+}
@@ -3,12 +3,14 @@
 #include <random>
 #include <numeric>
 #include <cstdint>
+#include <chrono>
 
 #include "sla_test_utils.hpp"
 
 #include <libslic3r/TriangleMeshSlicer.hpp>
 #include <libslic3r/SLA/SupportTreeMesher.hpp>
 #include <libslic3r/SLA/Concurrency.hpp>
+#include <libslic3r/SLA/RLERaster.hpp>
 
 namespace {
 
@@ -223,6 +225,100 @@ TEST_CASE("RasterizedPolygonAreaShouldMatch", "[SLARasterOutput]") {
 }
 
 
+// Square rings and circles scattered over the display, partially outside of it and overlapping each other.
+static ExPolygons raster_test_polygons(double disp_w, double disp_h, size_t count)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> pos_x(-10., disp_w + 10.), pos_y(-10., disp_h + 10.), size(1., 30.);
+    ExPolygons out;
+    for (size_t i = 0; i < count; ++ i) {
+        ExPolygon poly;
+        if (i % 2) {
+            poly = square_with_hole(size(rng));
+        } else {
+            const double r = size(rng) / 2.;
+            for (size_t j = 0; j < 100; ++ j)
+                poly.contour.points.emplace_back(scaled(r * std::cos(2. * PI * j / 100.)), scaled(r * std::sin(2. * PI * j / 100.)));
+        }
+        poly.translate(scaled(pos_x(rng)), scaled(pos_y(rng)));
+        out.emplace_back(std::move(poly));
+    }
+    return out;
+}
+
+TEST_CASE("RLERasterShouldMatchAGGRaster", "[SLARasterOutput]") {
+    double disp_w = 120., disp_h = 68.;
+    sla::Resolution res{1280, 720};
+    sla::PixelDim pixdim{disp_w / res.width_px, disp_h / res.height_px};
+    const ExPolygons polys = raster_test_polygons(disp_w, disp_h, 40);
+
+    sla::RasterBase::TMirroring mirrorings[] = {sla::RasterBase::NoMirror,
+                                                sla::RasterBase::MirrorX,
+                                                sla::RasterBase::MirrorY,
+                                                sla::RasterBase::MirrorXY};
+    for (auto orientation : {sla::RasterBase::roLandscape, sla::RasterBase::roPortrait})
+        for (auto &mirror : mirrorings)
+            for (double gamma : {1., 0.}) {
+                sla::RasterBase::Trafo trafo(orientation, mirror);
+                std::unique_ptr<sla::RasterBase> agg = sla::create_raster_grayscale_aa(res, pixdim, gamma, trafo);
+                std::unique_ptr<sla::RasterBase> rle = sla::create_raster_grayscale_rle(res, pixdim, gamma, trafo);
+                for (const ExPolygon &poly : polys) {
+                    agg->draw(poly);
+                    rle->draw(poly);
+                }
+
+                const auto &agg_raster = static_cast<const sla::RasterGrayscaleAA&>(*agg);
+                const auto &rle_raster = static_cast<const sla::RasterGrayscaleRLE&>(*rle);
+                long num_different = 0;
+                for (size_t y = 0; y < res.height_px; ++ y)
+                    for (size_t x = 0; x < res.width_px; ++ x)
+                        num_different += agg_raster.read_pixel(x, y) != rle_raster.read_pixel(x, y);
+                REQUIRE(num_different == 0);
+                REQUIRE(raster_pxsum(agg_raster) > 0);
+
+                // The PNG written row by row is the same as the one written from the frame buffer.
+                sla::EncodedRaster agg_png = agg->encode(sla::PNGRasterEncoder{});
+                sla::EncodedRaster rle_png = rle->encode(sla::PNGRasterEncoder{});
+                REQUIRE(agg_png.size() == rle_png.size());
+                REQUIRE(std::memcmp(agg_png.data(), rle_png.data(), agg_png.size()) == 0);
+
+                sla::EncodedRaster agg_ppm = agg->encode(sla::PPMRasterEncoder{});
+                sla::EncodedRaster rle_ppm = rle->encode(sla::PPMRasterEncoder{});
+                REQUIRE(agg_ppm.size() == rle_ppm.size());
+                REQUIRE(std::memcmp(agg_ppm.data(), rle_ppm.data(), agg_ppm.size()) == 0);
+            }
+}
+
+TEST_CASE("Benchmark RLE and AGG rasters at 8K resolution", "[SLARasterOutput][Benchmark][.]") {
+    // 8K mono LCD.
+    double disp_w = 218.88, disp_h = 123.12;
+    sla::Resolution res{7680, 4320};
+    sla::PixelDim pixdim{disp_w / res.width_px, disp_h / res.height_px};
+    const ExPolygons polys = raster_test_polygons(disp_w, disp_h, 20);
+    const size_t     num_layers = 200;
+
+    auto rasterize = [&](auto create_raster) {
+        std::vector<sla::EncodedRaster> layers(num_layers);
+        auto t_start = std::chrono::high_resolution_clock::now();
+        execution::for_each(ex_tbb, size_t(0), num_layers, [&](size_t idx) {
+            std::unique_ptr<sla::RasterBase> raster = create_raster(res, pixdim, 1., sla::RasterBase::Trafo{});
+            for (const ExPolygon &poly : polys)
+                raster->draw(poly);
+            layers[idx] = raster->encode(sla::PNGRasterEncoder{});
+        }, execution::max_concurrency(ex_tbb));
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t_start).count();
+    };
+    double agg_seconds = rasterize(sla::create_raster_grayscale_aa);
+    double rle_seconds = rasterize(sla::create_raster_grayscale_rle);
+
+    sla::RasterGrayscaleRLE rle(res, pixdim, {}, agg::gamma_power(1.));
+    for (const ExPolygon &poly : polys)
+        rle.draw(poly);
+    WARN("Rasterizing " << num_layers << " layers: AGG " << agg_seconds << " s, RLE " << rle_seconds << " s; memory of a layer: AGG "
+         << res.pixels() << " bytes, RLE " << rle.memory_used() << " bytes");
+}
+
+
 TEST_CASE("halfcone test", "[halfcone]") {
     sla::DiffBridge br{Vec3d{1., 1., 1.}, Vec3d{10., 10., 10.}, 0.25, 0.5};
 